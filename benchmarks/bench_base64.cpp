@@ -0,0 +1,65 @@
+//===- benchmarks/bench_base64.cpp ----------------------------------------===//
+//*  _                     _      *
+//* | |__   ___ _ __   ___| |__   *
+//* | '_ \ / _ \ '_ \ / __| '_ \  *
+//* | |_) |  __/ | | | (__| | | | *
+//* |_.__/ \___|_| |_|\___|_| |_| *
+//*                               *
+//*  _                     __   _  _    *
+//* | |__   __ _ ___  ___ / /_ | || |   *
+//* | '_ \ / _` / __|/ _ \ '_ \| || |_  *
+//* | |_) | (_| \__ \  __/ (_) |__   _| *
+//* |_.__/ \__,_|___/\___|\___/   |_|   *
+//*                                     *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_base64.cpp
+/// \brief Micro-benchmarks for the Base64 conversions used by the exchange format to carry
+/// section and debug line header data.
+
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "pstore/support/base64.hpp"
+
+namespace {
+
+  void base64_encode (benchmark::State & state) {
+    std::vector<std::uint8_t> buffer (static_cast<std::size_t> (state.range (0)));
+    std::iota (std::begin (buffer), std::end (buffer), std::uint8_t{0});
+    std::string out (pstore::base64_encoded_size (buffer.size ()), '\0');
+    for (auto _ : state) {
+      benchmark::DoNotOptimize (pstore::base64_encode (buffer.data (), buffer.size (), &out[0]));
+      benchmark::ClobberMemory ();
+    }
+    state.SetBytesProcessed (state.iterations () * state.range (0));
+  }
+
+  void base64_decode (benchmark::State & state) {
+    std::vector<std::uint8_t> buffer (static_cast<std::size_t> (state.range (0)));
+    std::iota (std::begin (buffer), std::end (buffer), std::uint8_t{0});
+    std::string encoded;
+    pstore::to_base64 (std::begin (buffer), std::end (buffer), std::back_inserter (encoded));
+    std::vector<std::uint8_t> out (pstore::base64_decoded_size (encoded.size ()));
+    for (auto _ : state) {
+      benchmark::DoNotOptimize (
+        pstore::base64_decode (encoded.data (), encoded.size (), out.data ()));
+      benchmark::ClobberMemory ();
+    }
+    state.SetBytesProcessed (state.iterations () * state.range (0));
+  }
+
+} // end anonymous namespace
+
+BENCHMARK (base64_encode)->ArgName ("bytes")->RangeMultiplier (16)->Range (16, 1 << 20);
+BENCHMARK (base64_decode)->ArgName ("bytes")->RangeMultiplier (16)->Range (16, 1 << 20);
@@ -0,0 +1,50 @@
+//===- benchmarks/bench_crc32.cpp -----------------------------------------===//
+//*  _                     _      *
+//* | |__   ___ _ __   ___| |__   *
+//* | '_ \ / _ \ '_ \ / __| '_ \  *
+//* | |_) |  __/ | | | (__| | | | *
+//* |_.__/ \___|_| |_|\___|_| |_| *
+//*                               *
+//*                _________   *
+//*   ___ _ __ ___|___ /___ \  *
+//*  / __| '__/ __| |_ \ __) | *
+//* | (__| | | (__ ___) / __/  *
+//*  \___|_|  \___|____/_____| *
+//*                            *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_crc32.cpp
+/// \brief Micro-benchmarks for the CRC32 function used to validate file headers and
+/// transaction trailers.
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "pstore/core/crc32.hpp"
+
+namespace {
+
+  void crc32 (benchmark::State & state) {
+    std::vector<std::uint8_t> buffer (static_cast<std::size_t> (state.range (0)));
+    std::iota (std::begin (buffer), std::end (buffer), std::uint8_t{0});
+    auto const span = pstore::gsl::make_span (buffer);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize (pstore::crc32 (span));
+    }
+    state.SetBytesProcessed (state.iterations () * state.range (0));
+  }
+
+} // end anonymous namespace
+
+// File header and trailer bodies are at the small end of this range; whole transaction
+// payloads at the large end.
+BENCHMARK (crc32)->ArgName ("bytes")->RangeMultiplier (16)->Range (16, 1 << 20);
@@ -0,0 +1,96 @@
+//===- benchmarks/bench_database.cpp --------------------------------------===//
+//*  _                     _           _       _        _                     *
+//* | |__   ___ _ __   ___| |__     __| | __ _| |_ __ _| |__   __ _ ___  ___  *
+//* | '_ \ / _ \ '_ \ / __| '_ \   / _` |/ _` | __/ _` | '_ \ / _` / __|/ _ \ *
+//* | |_) |  __/ | | | (__| | | | | (_| | (_| | || (_| | |_) | (_| \__ \  __/ *
+//* |_.__/ \___|_| |_|\___|_| |_|  \__,_|\__,_|\__\__,_|_.__/ \__,_|___/\___| *
+//*                                                                           *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_database.cpp
+/// \brief Micro-benchmarks for the database read functions (getro() and getrou()).
+
+#include <algorithm>
+#include <tuple>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_store.hpp"
+
+namespace {
+
+  enum class placement {
+    contained, ///< The data lies entirely within a single storage region.
+    spanning,  ///< The data crosses the boundary between two storage regions.
+  };
+
+  // Writes a block of \p size bytes to the store so that it is either contained
+  // within a region or straddles the boundary between two regions. Returns the
+  // address of the block.
+  pstore::address place_block (pstore::bench::store & store, placement const where,
+                               std::size_t const size) {
+    constexpr auto region_size = pstore::storage::min_region_size;
+    // The non-spanning block is placed at the start of the second region; the spanning
+    // block is centered on the boundary between the second and third.
+    std::uint64_t const start =
+      where == placement::contained ? region_size : region_size * 2U - size / 2U;
+
+    auto transaction = store.begin ();
+    auto const pos = store.db ().size ();
+    if (start > pos) {
+      transaction.allocate (start - pos, 1U);
+    }
+    auto addr = pstore::address::null ();
+    {
+      // The writable pointer must be released before the transaction is committed.
+      std::shared_ptr<void> ptr;
+      std::tie (ptr, addr) = transaction.alloc_rw (size, 1U);
+      auto * const first = static_cast<std::uint8_t *> (ptr.get ());
+      std::fill (first, first + size, std::uint8_t{0xA5});
+    }
+    transaction.commit ();
+    return addr;
+  }
+
+  void block_sizes (benchmark::internal::Benchmark * const b) {
+    b->ArgName ("bytes")->RangeMultiplier (16)->Range (16, 1 << 20);
+  }
+
+  template <placement Where>
+  void getro (benchmark::State & state) {
+    auto const size = static_cast<std::size_t> (state.range (0));
+    pstore::bench::store store;
+    auto const addr = place_block (store, Where, size);
+    pstore::database const & db = store.db ();
+    for (auto _ : state) {
+      std::shared_ptr<void const> ptr = db.getro (addr, size);
+      benchmark::DoNotOptimize (ptr.get ());
+    }
+    state.SetBytesProcessed (state.iterations () * state.range (0));
+  }
+
+  template <placement Where>
+  void getrou (benchmark::State & state) {
+    auto const size = static_cast<std::size_t> (state.range (0));
+    pstore::bench::store store;
+    auto const addr = place_block (store, Where, size);
+    pstore::database const & db = store.db ();
+    for (auto _ : state) {
+      pstore::unique_pointer<void const> ptr = db.getrou (addr, size);
+      benchmark::DoNotOptimize (ptr.get ());
+    }
+    state.SetBytesProcessed (state.iterations () * state.range (0));
+  }
+
+} // end anonymous namespace
+
+BENCHMARK_TEMPLATE (getro, placement::contained)->Apply (block_sizes);
+BENCHMARK_TEMPLATE (getro, placement::spanning)->Apply (block_sizes);
+BENCHMARK_TEMPLATE (getrou, placement::contained)->Apply (block_sizes);
+BENCHMARK_TEMPLATE (getrou, placement::spanning)->Apply (block_sizes);
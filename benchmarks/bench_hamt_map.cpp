@@ -0,0 +1,135 @@
+//===- benchmarks/bench_hamt_map.cpp --------------------------------------===//
+//*  _                     _       _                     _    *
+//* | |__   ___ _ __   ___| |__   | |__   __ _ _ __ ___ | |_  *
+//* | '_ \ / _ \ '_ \ / __| '_ \  | '_ \ / _` | '_ ` _ \| __| *
+//* | |_) |  __/ | | | (__| | | | | | | | (_| | | | | | | |_  *
+//* |_.__/ \___|_| |_|\___|_| |_| |_| |_|\__,_|_| |_| |_|\__| *
+//*                                                           *
+//*                         *
+//*  _ __ ___   __ _ _ __   *
+//* | '_ ` _ \ / _` | '_ \  *
+//* | | | | | | (_| | |_) | *
+//* |_| |_| |_|\__,_| .__/  *
+//*                 |_|     *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_hamt_map.cpp
+/// \brief Micro-benchmarks for hamt_map insertion and lookup.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/serialize/standard_types.hpp"
+
+#include "bench_store.hpp"
+
+namespace {
+
+  using map_type = pstore::index::hamt_map<pstore::index::digest, std::string,
+                                           pstore::index::u128_hash>;
+
+  // Key counts and value sizes (in bytes) used by the benchmarks below.
+  void key_count_and_value_size (benchmark::internal::Benchmark * const b) {
+    b->ArgNames ({"keys", "value"});
+    for (auto const keys : {1 << 10, 1 << 13, 1 << 16}) {
+      for (auto const value : {16, 256}) {
+        b->Args ({keys, value});
+      }
+    }
+  }
+
+  // Inserts keys into an empty hamt_map. Each iteration works on a new index; the
+  // transaction is rolled back afterwards so that the store does not grow without limit.
+  void hamt_map_insert (benchmark::State & state) {
+    auto const keys = pstore::bench::make_digests (static_cast<std::size_t> (state.range (0)));
+    std::string const value (static_cast<std::size_t> (state.range (1)), 'v');
+
+    pstore::bench::store store;
+    for (auto _ : state) {
+      state.PauseTiming ();
+      auto transaction = store.begin ();
+      auto index = std::make_unique<map_type> (store.db ());
+      state.ResumeTiming ();
+
+      for (auto const & key : keys) {
+        index->insert (transaction, std::make_pair (key, value));
+      }
+
+      state.PauseTiming ();
+      index.reset ();
+      transaction.rollback ();
+      state.ResumeTiming ();
+    }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+  }
+
+  // Inserts keys into an empty hamt_map as a single batch using insert_range().
+  void hamt_map_insert_range (benchmark::State & state) {
+    auto const keys = pstore::bench::make_digests (static_cast<std::size_t> (state.range (0)));
+    std::string const value (static_cast<std::size_t> (state.range (1)), 'v');
+    std::vector<std::pair<pstore::index::digest, std::string>> pairs;
+    pairs.reserve (keys.size ());
+    for (auto const & key : keys) {
+      pairs.emplace_back (key, value);
+    }
+
+    pstore::bench::store store;
+    for (auto _ : state) {
+      state.PauseTiming ();
+      auto transaction = store.begin ();
+      auto index = std::make_unique<map_type> (store.db ());
+      state.ResumeTiming ();
+
+      index->insert_range (transaction, std::begin (pairs), std::end (pairs));
+
+      state.PauseTiming ();
+      index.reset ();
+      transaction.rollback ();
+      state.ResumeTiming ();
+    }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+  }
+
+  // Looks up every key in an index which has been flushed to the store.
+  void hamt_map_find (benchmark::State & state) {
+    auto const keys = pstore::bench::make_digests (static_cast<std::size_t> (state.range (0)));
+    std::string const value (static_cast<std::size_t> (state.range (1)), 'v');
+
+    pstore::bench::store store;
+    auto root = pstore::typed_address<pstore::index::header_block>::null ();
+    {
+      auto transaction = store.begin ();
+      map_type index{store.db ()};
+      for (auto const & key : keys) {
+        index.insert (transaction, std::make_pair (key, value));
+      }
+      root = index.flush (transaction, store.db ().get_current_revision () + 1U);
+      transaction.commit ();
+    }
+
+    map_type const index{store.db (), root};
+    for (auto _ : state) {
+      for (auto const & key : keys) {
+        benchmark::DoNotOptimize (index.find (store.db (), key));
+      }
+    }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+  }
+
+} // end anonymous namespace
+
+BENCHMARK (hamt_map_insert)->Apply (key_count_and_value_size)->Unit (benchmark::kMillisecond);
+BENCHMARK (hamt_map_insert_range)
+  ->Apply (key_count_and_value_size)
+  ->Unit (benchmark::kMillisecond);
+BENCHMARK (hamt_map_find)->Apply (key_count_and_value_size)->Unit (benchmark::kMillisecond);
@@ -0,0 +1,74 @@
+//===- benchmarks/bench_store.cpp -----------------------------------------===//
+//*  _                     _           _                  *
+//* | |__   ___ _ __   ___| |__    ___| |_ ___  _ __ ___  *
+//* | '_ \ / _ \ '_ \ / __| '_ \  / __| __/ _ \| '__/ _ \ *
+//* | |_) |  __/ | | | (__| | | | \__ \ || (_) | | |  __/ *
+//* |_.__/ \___|_| |_|\___|_| |_| |___/\__\___/|_|  \___| *
+//*                                                       *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_store.cpp
+/// \brief An in-memory store which is shared by the pstore micro-benchmarks.
+
+#include "bench_store.hpp"
+
+#include <random>
+
+#include "pstore/core/region.hpp"
+#include "pstore/os/memory_mapper.hpp"
+
+namespace pstore {
+  namespace bench {
+
+    // (ctor)
+    // ~~~~~~
+    store::store () { this->reset (); }
+
+    // (dtor)
+    // ~~~~~~
+    store::~store () noexcept = default;
+
+    // ensure available
+    // ~~~~~~~~~~~~~~~~
+    void store::ensure_available (std::uint64_t const bytes) {
+      if (db_->size () + bytes > file_size) {
+        this->reset ();
+      }
+    }
+
+    // reset
+    // ~~~~~
+    void store::reset () {
+      // Destroy the existing database before its file.
+      db_.reset ();
+      buffer_ = aligned_valloc (file_size, 4096U);
+      file_ = std::make_shared<file::in_memory> (buffer_, file_size);
+      database::build_new_store (*file_);
+      db_ = std::make_unique<database> (
+        file_, std::make_unique<system_page_size> (),
+        region::get_factory (file_, storage::min_region_size, storage::min_region_size),
+        false /*access tick enabled*/);
+      db_->set_vacuum_mode (database::vacuum_mode::disabled);
+    }
+
+    // make digests
+    // ~~~~~~~~~~~~
+    std::vector<index::digest> make_digests (std::size_t const count) {
+      std::mt19937_64 generator{count};
+      std::vector<index::digest> result;
+      result.reserve (count);
+      for (auto ctr = std::size_t{0}; ctr < count; ++ctr) {
+        auto const high = generator ();
+        result.emplace_back (high, generator ());
+      }
+      return result;
+    }
+
+  } // end namespace bench
+} // end namespace pstore
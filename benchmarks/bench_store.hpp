@@ -0,0 +1,84 @@
+//===- benchmarks/bench_store.hpp -------------------------*- mode: C++ -*-===//
+//*  _                     _           _                  *
+//* | |__   ___ _ __   ___| |__    ___| |_ ___  _ __ ___  *
+//* | '_ \ / _ \ '_ \ / __| '_ \  / __| __/ _ \| '__/ _ \ *
+//* | |_) |  __/ | | | (__| | | | \__ \ || (_) | | |  __/ *
+//* |_.__/ \___|_| |_|\___|_| |_| |___/\__\___/|_|  \___| *
+//*                                                       *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_store.hpp
+/// \brief An in-memory store which is shared by the pstore micro-benchmarks.
+
+#ifndef PSTORE_BENCHMARKS_BENCH_STORE_HPP
+#define PSTORE_BENCHMARKS_BENCH_STORE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "pstore/core/database.hpp"
+#include "pstore/core/index_types.hpp"
+#include "pstore/core/transaction.hpp"
+
+namespace pstore {
+  namespace bench {
+
+    /// A do-nothing mutex: the benchmarks are single-threaded and have no need to take
+    /// the database's transaction lock.
+    struct null_mutex {
+      void lock () noexcept {}
+      void unlock () noexcept {}
+    };
+    using null_lock = std::unique_lock<null_mutex>;
+
+    /// An in-memory store together with a database which is attached to it. The store's
+    /// regions are all storage::min_region_size bytes so that reads which cross a region
+    /// boundary take the database's "spanning" path.
+    class store {
+    public:
+      static constexpr std::uint64_t file_size = std::uint64_t{256} * 1024U * 1024U;
+
+      store ();
+      store (store const &) = delete;
+      store (store &&) = delete;
+      ~store () noexcept;
+
+      store & operator= (store const &) = delete;
+      store & operator= (store &&) = delete;
+
+      database & db () noexcept { return *db_; }
+
+      /// Begins a new transaction on this store.
+      transaction<null_lock> begin () { return {*db_, null_lock{mutex_}}; }
+
+      /// Discards the current database and replaces it with a new, empty, store if fewer
+      /// than \p bytes bytes remain available.
+      void ensure_available (std::uint64_t bytes);
+
+      /// Discards the current database and replaces it with a new, empty, store.
+      void reset ();
+
+    private:
+
+      std::shared_ptr<std::uint8_t> buffer_;
+      std::shared_ptr<file::in_memory> file_;
+      std::unique_ptr<database> db_;
+      null_mutex mutex_;
+    };
+
+    /// Returns a pseudo-random sequence of digests. The sequence is always the same for
+    /// a given value of \p count.
+    std::vector<index::digest> make_digests (std::size_t count);
+
+  } // end namespace bench
+} // end namespace pstore
+
+#endif // PSTORE_BENCHMARKS_BENCH_STORE_HPP
@@ -0,0 +1,101 @@
+//===- benchmarks/bench_transaction.cpp -----------------------------------===//
+//*  _                     _      *
+//* | |__   ___ _ __   ___| |__   *
+//* | '_ \ / _ \ '_ \ / __| '_ \  *
+//* | |_) |  __/ | | | (__| | | | *
+//* |_.__/ \___|_| |_|\___|_| |_| *
+//*                               *
+//*  _                                  _   _              *
+//* | |_ _ __ __ _ _ __  ___  __ _  ___| |_(_) ___  _ __   *
+//* | __| '__/ _` | '_ \/ __|/ _` |/ __| __| |/ _ \| '_ \  *
+//* | |_| | | (_| | | | \__ \ (_| | (__| |_| | (_) | | | | *
+//*  \__|_|  \__,_|_| |_|___/\__,_|\___|\__|_|\___/|_| |_| *
+//*                                                        *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file bench_transaction.cpp
+/// \brief Micro-benchmarks for transaction commit and index flushing.
+
+#include <benchmark/benchmark.h>
+
+#include "pstore/core/hamt_map.hpp"
+
+#include "bench_store.hpp"
+
+namespace {
+
+  // A generous upper bound on the number of bytes of store consumed by each fragment
+  // index entry (leaf, extent and a share of the index branches).
+  constexpr auto bytes_per_entry = std::uint64_t{256};
+
+  // Adds the given number of entries to the fragment index as part of the transaction
+  // \p t. The values are extents which refer to a (rather small) block of data in the
+  // same transaction.
+  template <typename Transaction>
+  void populate_fragment_index (Transaction & t,
+                                std::vector<pstore::index::digest> const & keys) {
+    auto const index =
+      pstore::index::get_index<pstore::trailer::indices::fragment> (t.db (), true);
+    auto const addr = t.allocate (16U, 16U);
+    auto const value =
+      make_extent (pstore::typed_address<pstore::repo::fragment> (addr), std::uint64_t{16});
+    for (auto const & key : keys) {
+      index->insert_or_assign (t, key, value);
+    }
+  }
+
+  void entry_counts (benchmark::internal::Benchmark * const b) {
+    b->ArgName ("entries")->RangeMultiplier (16)->Range (1, 1 << 16);
+  }
+
+  // Measures transaction_base::commit() including the flush of a modified fragment index.
+  void transaction_commit (benchmark::State & state) {
+    auto const keys = pstore::bench::make_digests (static_cast<std::size_t> (state.range (0)));
+    pstore::bench::store store;
+    for (auto _ : state) {
+      state.PauseTiming ();
+      store.ensure_available (keys.size () * bytes_per_entry + pstore::storage::min_region_size);
+      auto transaction = store.begin ();
+      populate_fragment_index (transaction, keys);
+      state.ResumeTiming ();
+
+      transaction.commit ();
+    }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+  }
+
+  // Measures index::flush_indices() on its own. Once flushed, the indices belong to the
+  // next revision and the transaction can't be rolled back so each iteration starts with
+  // a new store.
+  void flush_indices (benchmark::State & state) {
+    auto const keys = pstore::bench::make_digests (static_cast<std::size_t> (state.range (0)));
+    pstore::bench::store store;
+    for (auto _ : state) {
+      state.PauseTiming ();
+      store.reset ();
+      auto transaction = store.begin ();
+      populate_fragment_index (transaction, keys);
+      auto locations = store.db ().get_footer ()->a.index_records;
+      auto const generation = store.db ().get_current_revision () + 1U;
+      state.ResumeTiming ();
+
+      pstore::index::flush_indices (transaction, &locations, generation);
+      benchmark::DoNotOptimize (locations);
+
+      state.PauseTiming ();
+      transaction.rollback ();
+      state.ResumeTiming ();
+    }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+  }
+
+} // end anonymous namespace
+
+BENCHMARK (transaction_commit)->Apply (entry_counts)->Unit (benchmark::kMicrosecond);
+BENCHMARK (flush_indices)->Apply (entry_counts)->Unit (benchmark::kMicrosecond);
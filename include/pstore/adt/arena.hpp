@@ -0,0 +1,156 @@
+//===- include/pstore/adt/arena.hpp -----------------------*- mode: C++ -*-===//
+//*                              *
+//*   __ _ _ __ ___ _ __   __ _  *
+//*  / _` | '__/ _ \ '_ \ / _` | *
+//* | (_| | | |  __/ | | | (_| | *
+//*  \__,_|_|  \___|_| |_|\__,_| *
+//*                              *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file arena.hpp
+/// \brief Defines a region-based memory allocator.
+///
+/// An arena hands out memory by bumping a pointer through large blocks ("chunks") which it
+/// obtains from the global allocator. Individual allocations cannot be freed: the memory is
+/// reclaimed en masse by clear() or when the arena is destroyed.
+#ifndef PSTORE_ADT_ARENA_HPP
+#define PSTORE_ADT_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "pstore/support/aligned.hpp"
+#include "pstore/support/assert.hpp"
+
+namespace pstore {
+
+  //*                              *
+  //*   __ _ _ __ ___ _ __   __ _  *
+  //*  / _` | '__/ _ \ '_ \ / _` | *
+  //* | (_| | | |  __/ | | | (_| | *
+  //*  \__,_|_|  \___|_| |_|\__,_| *
+  //*                              *
+  /// A region allocator for objects of varying size which share a lifetime. Chunks grow
+  /// geometrically from \p initial_chunk_size up to max_chunk_size so that a small arena
+  /// remains small whilst a busy one makes few calls to the global allocator.
+  ///
+  /// The arena never runs destructors: it is intended for trivially destructible objects.
+  class arena {
+  public:
+    /// The largest chunk that the arena will allocate unless a single request is larger.
+    static constexpr std::size_t max_chunk_size = std::size_t{1} << 20U;
+
+    explicit arena (std::size_t const initial_chunk_size = 4096) noexcept
+            : next_chunk_size_{initial_chunk_size} {
+      PSTORE_ASSERT (initial_chunk_size > 0U && initial_chunk_size <= max_chunk_size);
+    }
+    arena (arena const &) = delete;
+    arena (arena &&) noexcept = delete;
+
+    ~arena () noexcept = default;
+
+    arena & operator= (arena const &) = delete;
+    arena & operator= (arena &&) noexcept = delete;
+
+    /// Returns storage for \p size bytes aligned to \p align. The storage remains valid until
+    /// the arena is cleared or destroyed.
+    ///
+    /// \param size  The number of bytes required.
+    /// \param align  The alignment required for the storage. Must be a power of 2.
+    void * allocate (std::size_t size, std::size_t align);
+
+    /// Releases every allocation made by the arena. The most recently allocated chunk is retained
+    /// to satisfy future requests.
+    void clear () noexcept;
+
+    /// Returns the total number of bytes that the arena has obtained from the global
+    /// allocator.
+    std::size_t capacity () const noexcept;
+
+  private:
+    struct chunk {
+      std::unique_ptr<std::byte[]> memory;
+      std::size_t size;
+    };
+
+    /// Allocates a new chunk from which a request for \p size bytes aligned to \p align
+    /// can be satisfied.
+    void * allocate_slow (std::size_t size, std::size_t align);
+
+    /// The size of the next chunk to be allocated.
+    std::size_t next_chunk_size_;
+    std::vector<chunk> chunks_;
+    /// The first unused byte of the current chunk.
+    std::byte * ptr_ = nullptr;
+    /// The end of the current chunk.
+    std::byte * end_ = nullptr;
+  };
+
+  // allocate
+  // ~~~~~~~~
+  inline void * arena::allocate (std::size_t const size, std::size_t const align) {
+    PSTORE_ASSERT (is_power_of_two (align));
+    if (ptr_ != nullptr) {
+      auto * const result = ptr_ + calc_alignment (reinterpret_cast<std::uintptr_t> (ptr_), align);
+      if (result <= end_ && static_cast<std::size_t> (end_ - result) >= size) {
+        ptr_ = result + size;
+        return result;
+      }
+    }
+    return this->allocate_slow (size, align);
+  }
+
+  // allocate slow
+  // ~~~~~~~~~~~~~
+  inline void * arena::allocate_slow (std::size_t const size, std::size_t const align) {
+    // Allow for the worst-case padding needed to align the result.
+    std::size_t const required = size + align - 1U;
+    std::size_t const chunk_size = std::max (next_chunk_size_, required);
+    chunks_.push_back (
+      chunk{std::unique_ptr<std::byte[]>{new std::byte[chunk_size]}, chunk_size});
+    next_chunk_size_ = std::min (next_chunk_size_ * 2U, max_chunk_size);
+
+    ptr_ = chunks_.back ().memory.get ();
+    end_ = ptr_ + chunk_size;
+    auto * const result = ptr_ + calc_alignment (reinterpret_cast<std::uintptr_t> (ptr_), align);
+    ptr_ = result + size;
+    PSTORE_ASSERT (ptr_ <= end_);
+    return result;
+  }
+
+  // clear
+  // ~~~~~
+  inline void arena::clear () noexcept {
+    if (chunks_.empty ()) {
+      return;
+    }
+    if (chunks_.size () > 1U) {
+      std::swap (chunks_.front (), chunks_.back ());
+      chunks_.erase (std::begin (chunks_) + 1, std::end (chunks_));
+    }
+    ptr_ = chunks_.front ().memory.get ();
+    end_ = ptr_ + chunks_.front ().size;
+  }
+
+  // capacity
+  // ~~~~~~~~
+  inline std::size_t arena::capacity () const noexcept {
+    std::size_t result = 0;
+    for (chunk const & c : chunks_) {
+      result += c.size;
+    }
+    return result;
+  }
+
+} // end namespace pstore
+
+#endif // PSTORE_ADT_ARENA_HPP
@@ -20,35 +20,28 @@
 #define PSTORE_BROKER_COMMAND_HPP
 
 #include <cstring>
+#include <variant>
 
 // pstore includes
 #include "pstore/broker/message_queue.hpp"
 #include "pstore/broker/parser.hpp"
 #include "pstore/brokerface/fifo_path.hpp"
 #include "pstore/brokerface/pubsub.hpp"
-#include "pstore/http/server_status.hpp"
 #include "pstore/os/signal_cv.hpp"
 
 namespace pstore::broker {
 
   class recorder;
-  class scavenger;
 
   /// A class which is responsible for managing the command queue and which provides the
   /// thread_entry() function for pulling commands from the queue and executing them.
   class command_processor {
   public:
-    /// \param num_read_threads  The number of threads listening to the command pipe.
-    /// \param http_status  A pointer to an object which can be used to tell the http server
-    ///   to exit.
-    /// \param uptime_done  A pointer to a bool which, when set, will tell the
-    ///   uptime thread to exit.
     /// \param scavenge_threshold  The time for which messages are
     ///   allowed to wait in the message queue before the scavenger will delete them.
-    command_processor (unsigned num_read_threads,
-                       gsl::not_null<std::optional<http::server_status> *> const http_status,
-                       gsl::not_null<std::atomic<bool> *> uptime_done,
-                       std::chrono::seconds scavenge_threshold);
+    /// \param num_command_threads  The number of threads which will call thread_entry().
+    explicit command_processor (std::chrono::seconds scavenge_threshold,
+                                unsigned num_command_threads = 1U);
     // No copying or assignment.
     command_processor (command_processor const &) = delete;
     command_processor (command_processor &&) noexcept = delete;
@@ -59,9 +52,14 @@ namespace pstore::broker {
     command_processor & operator= (command_processor const &) = delete;
     command_processor & operator= (command_processor &&) noexcept = delete;
 
+    /// Pulls commands from the queue and executes them until told to exit. May be run by
+    /// more than one thread: the commands are independent of one another so, although each
+    /// is started in the order that it was queued, they may complete in any order.
     void thread_entry (brokerface::fifo_path const & fifo);
 
-    void attach_scavenger (std::shared_ptr<scavenger> & scav) { scavenger_.set (scav); }
+    /// The number of threads which run thread_entry(). At shutdown time this is used to
+    /// instruct each of them to exit.
+    unsigned num_command_threads () const noexcept { return num_command_threads_; }
 
     /// Pushes a command onto the end of the command queue. The command is recorded if
     /// `record_file` is not null.
@@ -69,6 +67,9 @@ namespace pstore::broker {
     /// command queue.
     /// \param record_file  If not null, this object is used to record the command.
     void push_command (brokerface::message_ptr && cmd, recorder * record_file);
+    /// Pushes a complete command, such as one received through the shared-memory ring buffer,
+    /// onto the end of the command queue. The command is recorded if `record_file` is not null.
+    void push_command (std::unique_ptr<broker_command> && cmd, recorder * record_file);
     void clear_queue ();
 
     void scavenge ();
@@ -77,53 +78,29 @@ namespace pstore::broker {
     void process_command (brokerface::fifo_path const & fifo, brokerface::message_type const & msg);
 
   private:
-    template <typename T>
-    class atomic_weak_ptr {
-    public:
-      std::shared_ptr<T> get () {
-        std::scoped_lock<decltype (mut_)> const lock{mut_};
-        return ptr_.lock ();
-      }
-
-      void set (std::shared_ptr<T> const & t) {
-        std::scoped_lock<decltype (mut_)> const lock{mut_};
-        ptr_ = t;
-      }
-      void set (std::weak_ptr<T> & t) {
-        std::scoped_lock<decltype (mut_)> const lock{mut_};
-        ptr_ = t;
-      }
-
-    private:
-      std::mutex mut_;
-      std::weak_ptr<T> ptr_;
-    };
-
     std::atomic<bool> commands_done_{false};
 
-    /// A pointer to an object which can be used to tell the http server to exit.
-    gsl::not_null<std::optional<http::server_status> *> const http_status_;
-    /// A pointer to a bool which, when set, will tell the uptime thread to exit.
-    gsl::not_null<std::atomic<bool> *> uptime_done_;
     /// The time for which messages are allowed to wait in the message queue before the
     /// scavenger will delete them.
     std::chrono::seconds delete_threshold_;
 
-    atomic_weak_ptr<scavenger> scavenger_;
-
-    message_queue<brokerface::message_ptr> messages_;
+    /// An entry in the command queue: either one part of a command from the FIFO or a
+    /// complete command.
+    using queued_command = std::variant<brokerface::message_ptr, std::unique_ptr<broker_command>>;
+    message_queue<queued_command> messages_;
 
     std::mutex cmds_mut_;
     partial_cmds cmds_;
 
-    /// The number of read threads running. At shutdown time this is used to instruct each
-    /// of them to exit safely.
-    unsigned const num_read_threads_;
+    /// The number of threads running thread_entry().
+    unsigned const num_command_threads_;
 
     /// The nuber of commit ("GC") commands processed.
-    unsigned commits_ = 0;
+    std::atomic<unsigned> commits_{0U};
 
     auto parse (brokerface::message_type const & msg) -> std::unique_ptr<broker_command>;
+    /// Calls the handler for the verb of command \p c.
+    void execute (brokerface::fifo_path const & fifo, broker_command const & c);
 
     using handler = std::function<void (command_processor *, brokerface::fifo_path const & fifo,
                                         broker_command const &)>;
@@ -147,7 +124,7 @@ namespace pstore::broker {
     /// ::shutdown().
     virtual void quit (brokerface::fifo_path const & fifo, broker_command const & c);
 
-    /// Calling this function causes the command_processor thread to exit.
+    /// Calling this function causes the command_processor thread which executes it to exit.
     virtual void cquit (brokerface::fifo_path const & fifo, broker_command const & c);
 
     /// Starts the garbage collection for a path (specified in the command path) if not
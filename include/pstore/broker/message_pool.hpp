@@ -26,25 +26,33 @@
 /// read from the named pipe.
 /// - If the buffer pool is exhausted, then a new command buffer instance is allocated.
 /// - Once the asynchronous read has completed, the message buffer is moved to the command queue.
-/// - The command thread draws
+/// - A command thread pops the message buffer from the queue, processes it, and returns it to the
+/// pool.
+/// - If the pool is already holding as many buffers as it can, the returned buffer is freed.
+///
+/// The pool is a bounded lock-free queue so that neither the read loop nor the command threads
+/// contend for a lock in order to draw or return a buffer.
 ///
 /// \image html buffer_life_cycle.svg
 
 #ifndef PSTORE_BROKER_MESSAGE_POOL_HPP
 #define PSTORE_BROKER_MESSAGE_POOL_HPP
 
-#include <condition_variable>
-#include <mutex>
-#include <queue>
 #include <utility>
 
+#include "pstore/broker/message_queue.hpp"
 #include "pstore/brokerface/message_type.hpp"
 
 namespace pstore::broker {
 
   class message_pool {
   public:
-    message_pool () = default;
+    /// The maximum number of idle buffers held by the pool.
+    static constexpr std::size_t default_capacity =
+      message_queue<brokerface::message_ptr>::default_capacity;
+
+    explicit message_pool (std::size_t capacity = default_capacity)
+            : queue_{capacity} {}
     message_pool (message_pool const &) = delete;
     message_pool (message_pool &&) = delete;
 
@@ -57,25 +65,22 @@ namespace pstore::broker {
     brokerface::message_ptr get_from_pool ();
 
   private:
-    std::mutex mut_;
-    std::queue<brokerface::message_ptr> queue_;
+    message_queue<brokerface::message_ptr> queue_;
   };
 
   inline void message_pool::return_to_pool (brokerface::message_ptr && ptr) {
-    std::unique_lock<std::mutex> const lock (mut_);
     PSTORE_ASSERT (ptr.get () != nullptr);
-    queue_.push (std::move (ptr));
+    if (!queue_.try_push (std::move (ptr))) {
+      // The pool is full: free the buffer.
+      ptr.reset ();
+    }
   }
 
   inline brokerface::message_ptr message_pool::get_from_pool () {
-    std::unique_lock<std::mutex> lock (mut_);
-    if (queue_.empty ()) {
-      lock.unlock ();
+    brokerface::message_ptr res;
+    if (!queue_.try_pop (&res)) {
       return std::make_unique<brokerface::message_type> ();
     }
-
-    auto res = std::move (queue_.front ());
-    queue_.pop ();
     return res;
   }
 
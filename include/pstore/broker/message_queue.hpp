@@ -14,51 +14,272 @@
 //
 //===----------------------------------------------------------------------===//
 /// \file message_queue.hpp
+/// \brief A bounded, lock-free, multi-producer, multi-consumer queue.
+///
+/// The queue is an array of cells, each of which carries a sequence number that tells producers
+/// and consumers whether the cell is free to be written or ready to be read. Threads claim a
+/// cell by advancing the shared enqueue or dequeue position with a compare-and-swap, so no lock
+/// is taken while the queue is neither empty nor full. (The design follows Dmitry Vyukov's
+/// bounded MPMC queue.) A thread which finds the queue empty (or full) spins briefly before
+/// falling back to blocking on a condition variable.
 
 #ifndef PSTORE_BROKER_MESSAGE_QUEUE_HPP
 #define PSTORE_BROKER_MESSAGE_QUEUE_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <thread>
 #include <utility>
 
+#include "pstore/support/gsl.hpp"
+#include "pstore/support/round2.hpp"
+
 namespace pstore::broker {
 
+  namespace details {
+
+    constexpr std::size_t cache_line_size = 64;
+
+    //*      _                            *
+    //*  ___| | ___  ___ _ __   ___ _ __  *
+    //* / __| |/ _ \/ _ \ '_ \ / _ \ '__| *
+    //* \__ \ |  __/  __/ |_) |  __/ |    *
+    //* |___/_|\___|\___| .__/ \___|_|    *
+    //*                 |_|               *
+    /// Blocks threads which are waiting for a queue to become non-empty (or non-full) without
+    /// the threads on the other side having to take a lock unless somebody is actually asleep.
+    class sleeper {
+    public:
+      /// Calls \p op until it returns true. The first \p spin_count failures are followed by
+      /// a brief backoff; subsequent failures block the calling thread until notify() is
+      /// called.
+      template <typename Operation>
+      void run (Operation op, unsigned spin_count);
+
+      /// Wakes any threads which are blocked in run().
+      void notify ();
+
+    private:
+      /// The number of spins which retry the operation immediately before the backoff starts
+      /// to yield the processor.
+      static constexpr unsigned busy_spins = 16U;
+
+      std::atomic<unsigned> sleepers_{0U};
+      std::mutex mut_;
+      std::condition_variable cv_;
+    };
+
+    template <typename Operation>
+    void sleeper::run (Operation op, unsigned const spin_count) {
+      for (auto spin = 0U; spin < spin_count; ++spin) {
+        if (op ()) {
+          return;
+        }
+        if (spin >= busy_spins) {
+          std::this_thread::yield ();
+        }
+      }
+
+      std::unique_lock<decltype (mut_)> lock{mut_};
+      // Registering as a sleeper and the notifier's check for sleepers are both
+      // read-modify-write operations on the same atomic, so one is ordered before the other:
+      // either the retry of the operation below sees the notifier's change or the notifier
+      // sees that we are about to sleep (and must wait for the lock that we hold).
+      sleepers_.fetch_add (1U, std::memory_order_acq_rel);
+      while (!op ()) {
+        cv_.wait (lock);
+      }
+      sleepers_.fetch_sub (1U, std::memory_order_relaxed);
+    }
+
+    inline void sleeper::notify () {
+      // See run() for the reason why this is a read-modify-write rather than a load.
+      if (sleepers_.fetch_add (0U, std::memory_order_acq_rel) > 0U) {
+        // Taking the lock guarantees that a thread which has registered as a sleeper is
+        // already waiting on the condition variable.
+        { std::scoped_lock<decltype (mut_)> const lock{mut_}; }
+        cv_.notify_all ();
+      }
+    }
+
+  } // end namespace details
+
+  //*                                                                          *
+  //*  _ __ ___   ___  ___ ___  __ _  __ _  ___    __ _ _   _  ___ _   _  ___  *
+  //* | '_ ` _ \ / _ \/ __/ __|/ _` |/ _` |/ _ \  / _` | | | |/ _ \ | | |/ _ \ *
+  //* | | | | | |  __/\__ \__ \ (_| | (_| |  __/ | (_| | |_| |  __/ |_| |  __/ *
+  //* |_| |_| |_|\___||___/___/\__,_|\__, |\___|  \__, |\__,_|\___|\__,_|\___| *
+  //*                                |___/           |_|                       *
+  /// A bounded queue which may be used by any number of producer and consumer threads.
+  ///
+  /// \tparam T  The type of the queued values. Must be default-constructible and
+  ///   move-assignable.
   template <typename T>
   class message_queue {
   public:
+    /// The number of values that a default-constructed queue can hold.
+    static constexpr std::size_t default_capacity = 1024;
+    /// The number of times that push() or pop() retry before blocking.
+    static constexpr unsigned default_spin_count = 64U;
+
+    /// \param capacity  The maximum number of values held by the queue. Rounded up to a power
+    ///   of 2.
+    /// \param spin_count  The number of times that a blocking push() or pop() will retry before
+    ///   putting the calling thread to sleep. Zero disables spinning.
+    explicit message_queue (std::size_t capacity = default_capacity,
+                            unsigned spin_count = default_spin_count);
+    // No copying or assignment.
+    message_queue (message_queue const &) = delete;
+    message_queue (message_queue &&) = delete;
+
+    ~message_queue () noexcept = default;
+
+    message_queue & operator= (message_queue const &) = delete;
+    message_queue & operator= (message_queue &&) = delete;
+
+    std::size_t capacity () const noexcept { return mask_ + 1U; }
+
+    /// Appends a value to the queue, blocking whilst the queue is full.
     void push (T && message);
+    /// Removes the oldest value from the queue, blocking whilst the queue is empty.
     T pop ();
+
+    /// Appends a value to the queue if there is space for it.
+    /// \param message  The value to be added. It is moved from only if the function succeeds.
+    /// \returns  True if the value was added, false if the queue was full.
+    bool try_push (T && message);
+    /// Removes the oldest value from the queue if there is one.
+    /// \param out  On success, receives the value which was removed.
+    /// \returns  True if a value was removed, false if the queue was empty.
+    bool try_pop (gsl::not_null<T *> out);
+
+    /// Discards all of the values in the queue.
     void clear ();
 
   private:
-    std::mutex mut_;
-    std::condition_variable cv;
-    std::queue<T> queue_;
+    struct cell {
+      /// Equal to the cell's index when it is free for the producer whose position has that
+      /// value; equal to one more than that when it holds a value for the consumer at that
+      /// position.
+      std::atomic<std::size_t> sequence;
+      T value;
+    };
+
+    /// Returns the number of cells needed for a queue of the requested capacity.
+    static std::size_t round_capacity (std::size_t const capacity) noexcept {
+      return static_cast<std::size_t> (
+        round_to_power_of_2 (static_cast<std::uint64_t> (std::max (capacity, std::size_t{2}))));
+    }
+
+    std::unique_ptr<cell[]> const cells_;
+    std::size_t const mask_;
+    unsigned const spin_count_;
+
+    alignas (details::cache_line_size) std::atomic<std::size_t> enqueue_pos_{0U};
+    alignas (details::cache_line_size) std::atomic<std::size_t> dequeue_pos_{0U};
+
+    details::sleeper not_empty_;
+    details::sleeper not_full_;
   };
 
+  // (ctor)
+  // ~~~~~~
+  template <typename T>
+  message_queue<T>::message_queue (std::size_t const capacity, unsigned const spin_count)
+          : cells_{std::make_unique<cell[]> (round_capacity (capacity))}
+          , mask_{round_capacity (capacity) - 1U}
+          , spin_count_{spin_count} {
+    for (auto ctr = std::size_t{0}; ctr <= mask_; ++ctr) {
+      cells_[ctr].sequence.store (ctr, std::memory_order_relaxed);
+    }
+  }
+
+  // try push
+  // ~~~~~~~~
+  template <typename T>
+  bool message_queue<T>::try_push (T && message) {
+    cell * c = nullptr;
+    std::size_t pos = enqueue_pos_.load (std::memory_order_relaxed);
+    for (;;) {
+      c = &cells_[pos & mask_];
+      std::size_t const seq = c->sequence.load (std::memory_order_acquire);
+      auto const diff = static_cast<std::ptrdiff_t> (seq) - static_cast<std::ptrdiff_t> (pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak (pos, pos + 1U, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // The queue is full.
+      } else {
+        pos = enqueue_pos_.load (std::memory_order_relaxed);
+      }
+    }
+    c->value = std::move (message);
+    c->sequence.store (pos + 1U, std::memory_order_release);
+    return true;
+  }
+
+  // try pop
+  // ~~~~~~~
+  template <typename T>
+  bool message_queue<T>::try_pop (gsl::not_null<T *> const out) {
+    cell * c = nullptr;
+    std::size_t pos = dequeue_pos_.load (std::memory_order_relaxed);
+    for (;;) {
+      c = &cells_[pos & mask_];
+      std::size_t const seq = c->sequence.load (std::memory_order_acquire);
+      auto const diff = static_cast<std::ptrdiff_t> (seq) - static_cast<std::ptrdiff_t> (pos + 1U);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak (pos, pos + 1U, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // The queue is empty.
+      } else {
+        pos = dequeue_pos_.load (std::memory_order_relaxed);
+      }
+    }
+    *out = std::move (c->value);
+    // Leave a moved-from (rather than default-constructed) value in the cell: the next producer
+    // to use it will overwrite it.
+    c->sequence.store (pos + mask_ + 1U, std::memory_order_release);
+    return true;
+  }
+
+  // push
+  // ~~~~
   template <typename T>
   void message_queue<T>::push (T && message) {
-    std::unique_lock<decltype (mut_)> lock (mut_);
-    queue_.push (std::move (message));
-    cv.notify_one ();
+    not_full_.run ([this, &message] () { return this->try_push (std::move (message)); },
+                   spin_count_);
+    not_empty_.notify ();
   }
 
+  // pop
+  // ~~~
   template <typename T>
   T message_queue<T>::pop () {
-    std::unique_lock<decltype (mut_)> lock (mut_);
-    cv.wait (lock, [this] () { return !queue_.empty (); });
-    T res = std::move (queue_.front ());
-    queue_.pop ();
+    T res{};
+    not_empty_.run ([this, &res] () { return this->try_pop (&res); }, spin_count_);
+    not_full_.notify ();
     return res;
   }
 
+  // clear
+  // ~~~~~
   template <typename T>
   void message_queue<T>::clear () {
-    std::unique_lock<decltype (mut_)> lock (mut_);
-    while (!queue_.empty ()) {
-      queue_.pop ();
+    bool removed = false;
+    for (T discard{}; this->try_pop (&discard);) {
+      removed = true;
+    }
+    if (removed) {
+      not_full_.notify ();
     }
   }
 
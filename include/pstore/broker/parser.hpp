@@ -91,8 +91,14 @@ namespace pstore::broker {
 
   using partial_cmds = std::unordered_map<size_pair, pieces>;
 
+  /// Adds a message part to the collection of partial commands.
+  ///
+  /// \returns  The command if \p msg was the final part needed to complete it, otherwise null.
   std::unique_ptr<broker_command> parse (brokerface::message_type const & msg, partial_cmds & cmds);
 
+  /// Splits a complete command into its verb and path.
+  std::unique_ptr<broker_command> parse (std::string const & command);
+
 } // end namespace pstore::broker
 
 #endif // PSTORE_BROKER_PARSER_HPP
@@ -18,10 +18,17 @@
 #ifndef PSTORE_BROKER_READ_LOOP_HPP
 #define PSTORE_BROKER_READ_LOOP_HPP
 
+#include <chrono>
 #include <memory>
 
 #include "pstore/brokerface/fifo_path.hpp"
 
+namespace pstore::brokerface {
+
+  class ring_buffer;
+
+} // end namespace pstore::brokerface
+
 namespace pstore::broker {
 
   class command_processor;
@@ -30,12 +37,20 @@ namespace pstore::broker {
   namespace details {
 
     constexpr unsigned timeout_seconds = 60U;
+    /// The longest time for which the ring buffer reader will sleep before checking whether
+    /// the broker is shutting down.
+    constexpr auto ring_wait_timeout = std::chrono::milliseconds{250};
 
   } // end namespace details
 
   void read_loop (brokerface::fifo_path & path, std::shared_ptr<recorder> & record_file,
                   std::shared_ptr<command_processor> cp);
 
+  /// Pulls commands from the shared-memory ring buffer and pushes them onto the command queue
+  /// until the broker is shut down.
+  void ring_read_loop (brokerface::ring_buffer & ring, std::shared_ptr<recorder> & record_file,
+                       std::shared_ptr<command_processor> cp);
+
 } // end namespace pstore::broker
 
 #endif // PSTORE_BROKER_READ_LOOP_HPP
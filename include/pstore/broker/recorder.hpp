@@ -28,6 +28,8 @@
 
 namespace pstore::broker {
 
+  class broker_command;
+
   class recorder {
   public:
     explicit recorder (std::string path);
@@ -42,10 +44,15 @@ namespace pstore::broker {
     recorder & operator= (recorder &&) noexcept = delete;
 
     void record (brokerface::message_type const & cmd);
+    /// Records a complete command. The command is split into message parts in the same way as
+    /// a client writing to the FIFO so that it can be played back.
+    void record (broker_command const & cmd);
 
   private:
     std::mutex mut_;
     file::file_handle file_;
+    /// The ID of the next message synthesized by record(broker_command const &).
+    std::uint32_t message_id_ = 0;
   };
 
   class player {
@@ -27,6 +27,10 @@ namespace pstore::broker {
   extern descriptor_condition_variable uptime_cv;
   extern brokerface::channel<descriptor_condition_variable> uptime_channel;
 
+  /// Carries a JSON snapshot of the process's performance metrics once per uptime tick.
+  extern descriptor_condition_variable metrics_cv;
+  extern brokerface::channel<descriptor_condition_variable> metrics_channel;
+
   void uptime (gsl::not_null<std::atomic<bool> *> done);
 
 } // end namespace pstore::broker
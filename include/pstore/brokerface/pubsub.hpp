@@ -19,21 +19,114 @@
 /// This module provides a means for one part of a program to "publish" information to which other
 /// parts can subscribe. There can be multiple "channels" of information representing different
 /// groups of data.
+///
+/// A published message is held in a single immutable, reference-counted buffer which is shared
+/// by every subscriber to which it is delivered. Each subscriber has its own lock-free queue of
+/// these buffers.
 #ifndef PSTORE_BROKERFACE_PUBSUB_HPP
 #define PSTORE_BROKERFACE_PUBSUB_HPP
 
+#include <atomic>
+#include <memory>
 #include <mutex>
-#include <optional>
-#include <queue>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
+#include "pstore/support/assert.hpp"
 #include "pstore/support/gsl.hpp"
 
 namespace pstore::brokerface {
 
+  /// A message published on a channel. The same buffer is delivered to all of the channel's
+  /// subscribers.
+  using shared_message = std::shared_ptr<std::string const>;
+
   template <typename ConditionVariable>
   class channel;
 
+  namespace details {
+
+    // message list
+    // ~~~~~~~~~~~~
+    /// An unbounded queue of messages into which any number of threads may push but from
+    /// which only one thread at a time may pop. A push is a single atomic exchange. (The design
+    /// follows Dmitry Vyukov's non-intrusive MPSC queue.)
+    class message_list {
+    public:
+      message_list ()
+              : head_{&stub_}
+              , tail_{&stub_} {}
+      message_list (message_list const &) = delete;
+      message_list (message_list &&) noexcept = delete;
+      ~message_list () noexcept;
+
+      message_list & operator= (message_list const &) = delete;
+      message_list & operator= (message_list &&) noexcept = delete;
+
+      /// Appends a message to the queue. May be called by any thread.
+      void push (shared_message message);
+      /// Removes the oldest message from the queue. Must not be called concurrently with
+      /// another call to pop().
+      ///
+      /// \returns  The message or null if the queue is empty.
+      shared_message pop ();
+
+    private:
+      struct node {
+        std::atomic<node *> next{nullptr};
+        shared_message message;
+      };
+
+      /// The most recently pushed node.
+      std::atomic<node *> head_;
+      /// The node before the oldest message. Owned by the consumer.
+      node * tail_;
+      /// A placeholder node which allows the list to be empty without head_ or tail_ being
+      /// null.
+      node stub_;
+    };
+
+    // (dtor)
+    // ~~~~~~
+    inline message_list::~message_list () noexcept {
+      while (this->pop () != nullptr) {
+      }
+      if (tail_ != &stub_) {
+        delete tail_;
+      }
+    }
+
+    // push
+    // ~~~~
+    inline void message_list::push (shared_message message) {
+      auto * const n = new node;
+      n->message = std::move (message);
+      // Swing the head to the new node and then link the previous head to it. Until the link
+      // is made the consumer sees the queue as ending at the previous node.
+      node * const prev = head_.exchange (n, std::memory_order_acq_rel);
+      prev->next.store (n, std::memory_order_release);
+    }
+
+    // pop
+    // ~~~
+    inline shared_message message_list::pop () {
+      node * const tail = tail_;
+      node * const next = tail->next.load (std::memory_order_acquire);
+      if (next == nullptr) {
+        return {};
+      }
+      // 'next' becomes the new placeholder; the old one is freed.
+      tail_ = next;
+      shared_message result = std::move (next->message);
+      if (tail != &stub_) {
+        delete tail;
+      }
+      return result;
+    }
+
+  } // end namespace details
+
   //*          _               _ _              *
   //*  ____  _| |__ ___ __ _ _(_) |__  ___ _ _  *
   //* (_-< || | '_ (_-</ _| '_| | '_ \/ -_) '_| *
@@ -57,9 +150,18 @@ namespace pstore::brokerface {
     /// Blocks waiting for a message to be published on the owning channel or for the
     /// subscription to be cancelled.
     ///
-    /// \returns An optional holding a message published to the owning channel or with no value
-    /// indicating that the subscription has been cancelled.
-    std::optional<std::string> listen ();
+    /// \returns A message published to the owning channel or null indicating that the
+    /// subscription has been cancelled.
+    shared_message listen ();
+
+    /// Blocks waiting for one or more messages to be published on the owning channel or for the
+    /// subscription to be cancelled. All of the messages that are waiting are delivered in one
+    /// go.
+    ///
+    /// \param messages  The messages published to the owning channel are appended to this
+    ///   container.
+    /// \returns False if the subscription has been cancelled, true otherwise.
+    bool listen (gsl::not_null<std::vector<shared_message> *> messages);
 
     /// Cancels a subscription.
     ///
@@ -71,20 +173,19 @@ namespace pstore::brokerface {
     /// \returns A reference to the owning channel.
     [[nodiscard]] channel<ConditionVariable> const & owner () const noexcept { return *owner_; }
 
-    /// Removes a single message from the subscription queue if available.
-    std::optional<std::string> pop ();
+    /// Removes a single message from the subscription queue if available. Does not block and
+    /// does not take the channel's lock.
+    ///
+    /// \note Messages must be removed from a subscription by one thread at a time.
+    /// \returns The message or null if there were no messages waiting.
+    shared_message pop () { return queue_.pop (); }
 
   private:
     explicit constexpr subscriber (gsl::not_null<channel<ConditionVariable> *> c) noexcept
             : owner_{c} {}
 
     /// The queue of published messages waiting to be delivered to a listening subscriber.
-    ///
-    /// \note This is a queue of strings. If there are multiple subscribers to this channel
-    /// then the strings will be duplicated in each which could be very inefficient. An
-    /// alternative would be to store shared_ptr<string>. For the moment I'm leaving it like
-    /// this on the assumption that there will typically be just a single subscriber.
-    std::queue<std::string> queue_;
+    details::message_list queue_;
 
     /// The channel with which this subscription is associated.
     channel<ConditionVariable> * const owner_;
@@ -143,7 +244,8 @@ namespace pstore::brokerface {
     std::unique_ptr<subscriber_type> new_subscriber ();
 
   private:
-    std::optional<std::string> listen (subscriber_type & sub);
+    shared_message listen (subscriber_type & sub);
+    bool listen (subscriber_type & sub, gsl::not_null<std::vector<shared_message> *> messages);
 
     /// Cancels a subscription.
     ///
@@ -180,21 +282,13 @@ namespace pstore::brokerface {
   // listen
   // ~~~~~~
   template <typename ConditionVariable>
-  inline std::optional<std::string> subscriber<ConditionVariable>::listen () {
+  inline shared_message subscriber<ConditionVariable>::listen () {
     return owner_->listen (*this);
   }
-
-  // pop
-  // ~~~
   template <typename ConditionVariable>
-  std::optional<std::string> subscriber<ConditionVariable>::pop () {
-    std::unique_lock<std::mutex> const lock{this->owner ().mut_};
-    if (queue_.empty ()) {
-      return std::nullopt;
-    }
-    std::string const message = std::move (queue_.front ());
-    queue_.pop ();
-    return message;
+  inline bool
+  subscriber<ConditionVariable>::listen (gsl::not_null<std::vector<shared_message> *> messages) {
+    return owner_->listen (*this, messages);
   }
 
   //*     _                       _  *
@@ -227,8 +321,10 @@ namespace pstore::brokerface {
   void channel<ConditionVariable>::publish (MessageFunction f, Args &&... args) {
     if (this->have_listeners ()) {
       // Note that f() is called without the lock held.
-      std::string const message = f (std::forward<Args> (args)...);
+      auto const message = std::make_shared<std::string const> (f (std::forward<Args> (args)...));
 
+      // The lock keeps the set of subscribers stable and ensures that a subscriber cannot miss
+      // the notification between checking its queue and waiting.
       std::scoped_lock<std::mutex> const lock{mut_};
       for (auto & sub : subscribers_) {
         sub->queue_.push (message);
@@ -259,18 +355,33 @@ namespace pstore::brokerface {
   // listen
   // ~~~~~~
   template <typename ConditionVariable>
-  std::optional<std::string> channel<ConditionVariable>::listen (subscriber_type & sub) {
+  shared_message channel<ConditionVariable>::listen (subscriber_type & sub) {
     std::unique_lock<std::mutex> lock{mut_};
     while (sub.active_) {
-      if (sub.queue_.size () == 0) {
-        cv_->wait (lock);
-      } else {
-        std::string const message = std::move (sub.queue_.front ());
-        sub.queue_.pop ();
+      if (shared_message message = sub.queue_.pop ()) {
         return message;
       }
+      cv_->wait (lock);
+    }
+    return {};
+  }
+
+  template <typename ConditionVariable>
+  bool channel<ConditionVariable>::listen (subscriber_type & sub,
+                                           gsl::not_null<std::vector<shared_message> *> messages) {
+    std::unique_lock<std::mutex> lock{mut_};
+    while (sub.active_) {
+      if (shared_message message = sub.queue_.pop ()) {
+        lock.unlock ();
+        // Gather anything else that is waiting without holding the channel's lock.
+        do {
+          messages->push_back (std::move (message));
+        } while ((message = sub.queue_.pop ()) != nullptr);
+        return true;
+      }
+      cv_->wait (lock);
     }
-    return std::nullopt;
+    return false;
   }
 
   // new subscriber
@@ -0,0 +1,126 @@
+//===- include/pstore/brokerface/ring_buffer.hpp ----------*- mode: C++ -*-===//
+//*       _                _            __  __            *
+//*  _ __(_)_ __   __ _   | |__  _   _ / _|/ _| ___ _ __  *
+//* | '__| | '_ \ / _` |  | '_ \| | | | |_| |_ / _ \ '__| *
+//* | |  | | | | | (_| |  | |_) | |_| |  _|  _|  __/ |    *
+//* |_|  |_|_| |_|\__, |  |_.__/ \__,_|_| |_|  \___|_|    *
+//*               |___/                                   *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file ring_buffer.hpp
+/// \brief A multi-producer, single-consumer queue of variable-length records which can be
+/// placed in memory that is shared between processes.
+///
+/// Producers reserve space by advancing a shared "head" counter and then publish their record
+/// by setting a flag in its header; the consumer reads records in reservation order and hands
+/// the space back by advancing the "tail" counter. A record which would straddle the end of the
+/// buffer is preceded by a padding record so that every payload is contiguous.
+
+#ifndef PSTORE_BROKERFACE_RING_BUFFER_HPP
+#define PSTORE_BROKERFACE_RING_BUFFER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "pstore/support/gsl.hpp"
+
+namespace pstore::brokerface {
+
+  //*       _                _            __  __            *
+  //*  _ __(_)_ __   __ _   | |__  _   _ / _|/ _| ___ _ __  *
+  //* | '__| | '_ \ / _` |  | '_ \| | | | |_| |_ / _ \ '__| *
+  //* | |  | | | | | (_| |  | |_) | |_| |  _|  _|  __/ |    *
+  //* |_|  |_|_| |_|\__, |  |_.__/ \__,_|_| |_|  \___|_|    *
+  //*               |___/                                   *
+  /// A view of a ring buffer which lives in a caller-supplied region of memory. Any number of
+  /// threads or processes may push records into the buffer concurrently but only a single
+  /// thread may pop them.
+  ///
+  /// \note A producer which dies between reserving space for a record and publishing it will
+  /// stall the consumer at that record.
+  class ring_buffer {
+  public:
+    /// The smallest permitted buffer capacity.
+    static constexpr std::size_t min_capacity = 4096;
+    /// The largest permitted buffer capacity.
+    static constexpr std::size_t max_capacity = std::size_t{1} << 30U;
+
+    /// Returns the number of bytes of memory needed for a buffer which can hold \p capacity
+    /// bytes of records.
+    ///
+    /// \param capacity  The capacity of the buffer. Must be a power of 2 in the range
+    ///   [min_capacity, max_capacity].
+    static std::size_t region_size (std::size_t capacity) noexcept;
+
+    /// Formats a region of memory as an empty ring buffer.
+    ///
+    /// \param region  The memory to be used. Must be aligned to at least 64 bytes and contain
+    ///   at least region_size(capacity) bytes.
+    /// \param capacity  The capacity of the buffer. Must be a power of 2 in the range
+    ///   [min_capacity, max_capacity].
+    static ring_buffer create (gsl::not_null<void *> region, std::size_t capacity);
+
+    /// Connects to a ring buffer which has already been formatted by create(). Raises
+    /// error_code::ring_buffer_corrupt if the region does not contain a valid buffer.
+    ///
+    /// \param region  The memory containing the buffer.
+    /// \param size  The number of bytes available at \p region.
+    static ring_buffer attach (gsl::not_null<void *> region, std::size_t size);
+
+    /// Returns the number of bytes of records that the buffer can hold.
+    std::size_t capacity () const noexcept;
+    /// Returns the size of the largest record that may be pushed.
+    std::size_t max_record_size () const noexcept;
+
+    /// Appends a record to the buffer. May be called by any number of producers concurrently.
+    /// Raises error_code::ring_record_too_large if the payload is larger than
+    /// max_record_size().
+    ///
+    /// \param payload  The contents of the record.
+    /// \returns  False if there was not enough free space for the record, true otherwise.
+    bool try_push (std::string_view payload);
+
+    /// Removes the oldest record from the buffer. Must only be called by the consumer. Raises
+    /// error_code::ring_buffer_corrupt if the record's header describes a record which does not
+    /// fit in the buffer.
+    ///
+    /// \param out  On return, the payload of the record which was removed.
+    /// \returns  False if no record was available, true otherwise.
+    bool try_pop (gsl::not_null<std::string *> out);
+
+    /// Returns true if there is no published record waiting to be popped.
+    bool empty () const noexcept;
+
+    /// Blocks the consumer until a record may be available or \p timeout has elapsed.
+    void wait (std::chrono::milliseconds timeout);
+
+  private:
+    struct control;
+
+    ring_buffer (control * ctrl, std::uint8_t * data, std::size_t capacity) noexcept
+            : ctrl_{ctrl}
+            , data_{data}
+            , capacity_{capacity} {}
+
+    /// Wakes the consumer if it is blocked in wait().
+    void notify () noexcept;
+
+    control * ctrl_;
+    std::uint8_t * data_;
+    /// The capacity validated by create() or attach(). The copy in the control block is
+    /// shared with other processes so is never read again.
+    std::size_t capacity_;
+  };
+
+} // end namespace pstore::brokerface
+
+#endif // PSTORE_BROKERFACE_RING_BUFFER_HPP
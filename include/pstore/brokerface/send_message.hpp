@@ -20,6 +20,7 @@
 #ifndef PSTORE_BROKERFACE_SEND_MESSAGE_HPP
 #define PSTORE_BROKERFACE_SEND_MESSAGE_HPP
 
+#include <chrono>
 #include <cstdint>
 
 #include "pstore/brokerface/writer.hpp"
@@ -43,6 +44,24 @@ namespace pstore::brokerface {
   ///   broker command. Pass nullptr if no parameter is required for the command.
   void send_message (writer & wr, bool error_on_timeout, gsl::czstring verb, gsl::czstring path);
 
+  class ring_buffer;
+
+  /// Sends a message consisting of a "verb" and optional "path" to the pstore broker through
+  /// its shared-memory ring buffer. The message is sent as a single record regardless of its
+  /// length.
+  ///
+  /// \param ring  The broker's ring buffer.
+  /// \param error_on_timeout  If true, an error will be raised if the ring buffer remains full
+  ///   for longer than \p timeout. If false, this condition is silently ignored.
+  /// \param verb  A null-terminated character string which contains the command that the
+  ///   broker should execute.
+  /// \param path  A null-terminated character string which contains the parameter for the
+  ///   broker command. Pass nullptr if no parameter is required for the command.
+  /// \param timeout  The time for which to wait for space to become available in the ring
+  ///   buffer.
+  void send_message (ring_buffer & ring, bool error_on_timeout, gsl::czstring verb,
+                     gsl::czstring path, std::chrono::milliseconds timeout);
+
 } // end namespace pstore::brokerface
 
 #endif // PSTORE_BROKERFACE_SEND_MESSAGE_HPP
@@ -0,0 +1,92 @@
+//===- include/pstore/brokerface/shared_ring.hpp ----------*- mode: C++ -*-===//
+//*      _                        _         _              *
+//*  ___| |__   __ _ _ __ ___  __| |   _ __(_)_ __   __ _  *
+//* / __| '_ \ / _` | '__/ _ \/ _` |  | '__| | '_ \ / _` | *
+//* \__ \ | | | (_| | | |  __/ (_| |  | |  | | | | | (_| | *
+//* |___/_| |_|\__,_|_|  \___|\__,_|  |_|  |_|_| |_|\__, | *
+//*                                                 |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file shared_ring.hpp
+/// \brief Places a broker ring buffer in a named shared memory object so that it can be used
+/// as an alternative to the broker's FIFO.
+
+#ifndef PSTORE_BROKERFACE_SHARED_RING_HPP
+#define PSTORE_BROKERFACE_SHARED_RING_HPP
+
+#include <optional>
+#include <string>
+
+#include "pstore/brokerface/fifo_path.hpp"
+#include "pstore/brokerface/ring_buffer.hpp"
+
+namespace pstore::brokerface {
+
+#ifndef _WIN32
+
+  //*      _                        _         _              *
+  //*  ___| |__   __ _ _ __ ___  __| |   _ __(_)_ __   __ _  *
+  //* / __| '_ \ / _` | '__/ _ \/ _` |  | '__| | '_ \ / _` | *
+  //* \__ \ | | | (_| | | |  __/ (_| |  | |  | | | | | (_| | *
+  //* |___/_| |_|\__,_|_|  \___|\__,_|  |_|  |_|_| |_|\__, | *
+  //*                                                 |___/  *
+  /// Owns a mapping of the shared memory object which holds the ring buffer associated with a
+  /// broker FIFO. The broker creates the object; clients open it and push their messages into
+  /// it in preference to writing to the FIFO.
+  class shared_ring {
+  public:
+    /// The default capacity of a broker's ring buffer.
+    static constexpr std::size_t default_capacity = std::size_t{1} << 20U;
+
+    /// Creates the shared memory object associated with \p fifo, replacing any left behind by
+    /// an earlier broker instance. The object is removed when the returned instance is
+    /// destroyed. (Used by the broker.)
+    ///
+    /// \param fifo  The FIFO with which the ring buffer is associated.
+    /// \param capacity  The capacity of the ring buffer. Must be a power of 2 in the range
+    ///   [ring_buffer::min_capacity, ring_buffer::max_capacity].
+    static shared_ring create (fifo_path const & fifo, std::size_t capacity = default_capacity);
+
+    /// Opens the shared memory object associated with \p fifo. (Used by clients.)
+    ///
+    /// \param fifo  The FIFO with which the ring buffer is associated.
+    /// \returns  The ring buffer or nothing if the broker has not made one available.
+    static std::optional<shared_ring> open (fifo_path const & fifo);
+
+    /// Returns the name of the shared memory object associated with \p fifo.
+    static std::string name (fifo_path const & fifo);
+
+    shared_ring (shared_ring const &) = delete;
+    shared_ring (shared_ring && rhs) noexcept;
+    ~shared_ring () noexcept;
+
+    shared_ring & operator= (shared_ring const &) = delete;
+    shared_ring & operator= (shared_ring && rhs) noexcept = delete;
+
+    ring_buffer & ring () noexcept { return ring_; }
+
+  private:
+    shared_ring (std::string name, void * ptr, std::size_t size, ring_buffer ring,
+                 bool owner) noexcept;
+
+    /// The name of the shared memory object.
+    std::string name_;
+    /// The base address and size of the mapping.
+    void * ptr_;
+    std::size_t size_;
+    ring_buffer ring_;
+    /// True if the shared memory object should be removed when this instance is destroyed.
+    bool owner_;
+  };
+
+#endif // _WIN32
+
+} // end namespace pstore::brokerface
+
+#endif // PSTORE_BROKERFACE_SHARED_RING_HPP
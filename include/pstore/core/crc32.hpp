@@ -18,7 +18,6 @@
 #ifndef PSTORE_CORE_CRC32_HPP
 #define PSTORE_CORE_CRC32_HPP
 
-#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -28,16 +27,44 @@
 namespace pstore {
 
   namespace details {
-    extern std::array<std::uint32_t, 256> const crc32_tab;
+
+    /// Updates the CRC register \p crc with the \p length bytes starting at \p data. The
+    /// register is neither pre- nor post-conditioned. Uses a carry-less multiply
+    /// implementation on processors that support it and a slice-by-8 table otherwise.
+    std::uint32_t crc32_update (std::uint32_t crc, void const * data, std::size_t length) noexcept;
+
   } // end namespace details
 
+  /// Computes the CRC of a sequence of buffers. The result is identical to that of calling
+  /// crc32() for a single buffer containing their concatenation. This enables, for example,
+  /// the pieces of a scatter_view or a transaction's payload to be checksummed without first
+  /// gathering them into contiguous memory.
+  class crc32_accumulator {
+  public:
+    /// Adds the \p length bytes starting at \p data to the CRC. \p data is not accessed if
+    /// \p length is 0.
+    crc32_accumulator & append (void const * data, std::size_t length) noexcept {
+      if (length > 0U) {
+        crc_ = details::crc32_update (crc_, data, length);
+      }
+      return *this;
+    }
+    /// Adds the contents of \p buf to the CRC.
+    template <typename SpanType>
+    crc32_accumulator & append (SpanType buf) noexcept {
+      return this->append (buf.data (), static_cast<std::size_t> (buf.size_bytes ()));
+    }
+
+    /// Returns the CRC of the bytes appended so far.
+    std::uint32_t get () const noexcept { return crc_ ^ ~0U; }
+
+  private:
+    std::uint32_t crc_ = 0;
+  };
+
   template <typename SpanType>
   std::uint32_t crc32 (SpanType buf) noexcept {
-    auto crc = std::uint32_t{0};
-    for (auto b : gsl::span{reinterpret_cast<std::byte const *> (buf.data ()), buf.size_bytes ()}) {
-      crc = details::crc32_tab[(crc ^ std::to_integer<std::uint32_t> (b)) & 0xFF] ^ (crc >> 8);
-    }
-    return crc ^ ~0U;
+    return crc32_accumulator{}.append (buf).get ();
   }
 
 } // end namespace pstore
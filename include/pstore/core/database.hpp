@@ -23,6 +23,8 @@
 #include "pstore/adt/sstring_view.hpp"
 #include "pstore/core/file_header.hpp"
 #include "pstore/core/hamt_map_fwd.hpp"
+#include "pstore/core/index_snapshot_cache.hpp"
+#include "pstore/core/scatter_view.hpp"
 #include "pstore/core/storage.hpp"
 #include "pstore/core/vacuum_intf.hpp"
 #include "pstore/support/head_revision.hpp"
@@ -95,7 +97,20 @@ namespace pstore {
     /// \param am  The requested access mode. If the file does not exist and writable access is
     /// requested, a new empty database is created. If read-only access is requested and the
     /// file does not exist, an error is raised.
-    explicit database (std::string const & path, access_mode am, bool access_tick_enabled = true);
+    explicit database (std::string const & path, access_mode am, bool access_tick_enabled = true)
+            : database (path, am, mapping_policy{}, access_tick_enabled) {}
+
+    /// Creates a database instance give the path of the file to use and the hints which control
+    /// the way in which that file is memory-mapped. A tool which will scan the entire store
+    /// (such as an exporter) might request sequential access; one which performs many index
+    /// lookups might request random access.
+    ///
+    /// \param path  The path of the file containing the database.
+    /// \param am  The requested access mode.
+    /// \param policy  Hints controlling the memory-mapping of the database file.
+    /// \param access_tick_enabled  Is the access tick enabled?
+    database (std::string const & path, access_mode am, mapping_policy const & policy,
+              bool access_tick_enabled = true);
 
     /// Create a database from a pre-opened file. This interface is intended to enable
     /// the database class to be unit tested.
@@ -150,7 +165,21 @@ namespace pstore {
     ///
     /// \note This is a const member function and therefore cannot "see" revisions later than
     /// the old currently synced because to do so may require additional space to be mapped.
-    typed_address<trailer> older_revision_footer_pos (unsigned revision) const;
+    typed_address<trailer> older_revision_footer_pos (unsigned revision) const {
+      return this->older_revision_footer_pos (this->footer_pos (), revision);
+    }
+
+    /// \brief Returns the address of the footer of a specified revision by searching backwards
+    /// from the footer at \p start.
+    ///
+    /// The search follows the trailers' skip pointers where they are available and therefore
+    /// visits O(log n) footers.
+    ///
+    /// \param start  The address of the footer from which the search begins.
+    /// \param revision  The revision number. Must not be greater than the revision of the footer
+    ///   at \p start, in which case an unknown_revision error is raised.
+    typed_address<trailer> older_revision_footer_pos (typed_address<trailer> start,
+                                                      unsigned revision) const;
 
     static constexpr bool small_files_enabled () noexcept { return region::small_files_enabled (); }
 
@@ -174,6 +203,42 @@ namespace pstore {
       return is_spanning (ex.addr.to_address (), ex.size);
     }
 
+    ///@{
+    /// Returns a read-only view of the \p size bytes of data starting at address \p addr.
+    /// Unlike getro(), this never allocates a temporary block for data which spans more than
+    /// one memory-mapped region: instead, the view records each of the contiguous pieces.
+    ///
+    /// \param addr The starting address of the data.
+    /// \param size The number of bytes covered by the view.
+    /// \return A view of the data.
+    scatter_view getro_view (address addr, std::size_t size) const;
+
+    /// Returns a read-only view of the data whose address and size are specified by \p ex.
+    ///
+    /// \param ex The extent of the data. Note that ex.size is a number of bytes.
+    /// \return A view of the data.
+    template <typename T>
+    scatter_view getro_view (extent<T> const & ex) const {
+      return this->getro_view (ex.addr.to_address (), ex.size);
+    }
+    ///@}
+
+    /// The kind of hint issued by prefetch().
+    enum class prefetch_hint {
+      cache, ///< Ask the processor to load the data into its cache.
+      page,  ///< Ask the operating system to read the data's pages from disk.
+    };
+
+    /// Hints that the \p size bytes of data starting at address \p addr will shortly be read.
+    /// This does not wait for the data to arrive and has no visible effect: any part of the
+    /// range which lies outside the store is ignored.
+    ///
+    /// \param addr The starting address of the data.
+    /// \param size The number of bytes that will be read.
+    /// \param hint The kind of prefetch to be performed.
+    void prefetch (address addr, std::size_t size,
+                   prefetch_hint hint = prefetch_hint::cache) const noexcept;
+
     ///@{
     /// Load a block of data starting at address \p addr and of \p size bytes.
     ///
@@ -390,6 +455,12 @@ namespace pstore {
     get_mutable_index (enum pstore::trailer::indices const which) const {
       return indices_[static_cast<std::underlying_type_t<decltype (which)>> (which)];
     }
+    /// \brief Returns the cache of read-only index snapshots.
+    ///
+    /// Unlike get_mutable_index(), the snapshot cache may be used by multiple threads
+    /// concurrently. See index::get_index_snapshot().
+    index::snapshot_cache & get_index_snapshots () const noexcept { return index_snapshots_; }
+
     std::shared_ptr<trailer const> get_footer () const { return this->getro (this->footer_pos ()); }
 
   private:
@@ -447,6 +518,9 @@ namespace pstore {
     mutable std::array<std::shared_ptr<index::index_base>,
                        static_cast<unsigned> (trailer::indices::last)>
       indices_;
+    /// Immutable index instances keyed by location. Entries remain valid across sync() since
+    /// the data to which they refer is never modified.
+    mutable index::snapshot_cache index_snapshots_;
     std::string sync_name_;
     static constexpr auto const sync_name_length = std::size_t{20};
 
@@ -111,7 +111,7 @@ namespace pstore {
     std::array<std::uint16_t, 2> const & version () const noexcept { return a.version; }
 
     static constexpr std::uint16_t major_version = 1;
-    static constexpr std::uint16_t minor_version = 13;
+    static constexpr std::uint16_t minor_version = 14;
 
     static std::array<std::uint8_t, 4> const file_signature1;
     static std::uint32_t const file_signature2 = 0x0507FFFF;
@@ -227,6 +227,19 @@ namespace pstore {
     /// Computes the trailer's CRC value.
     std::uint32_t get_crc () const noexcept;
 
+    /// Returns the number of the generation to which the skip_generation field of the trailer
+    /// for \p generation refers. Together with prev_generation, these pointers form a
+    /// deterministic skip list which allows any earlier generation to be reached in
+    /// O(log n) steps.
+    static constexpr unsigned skip_target (unsigned const generation) noexcept {
+      // Clears the least-significant set bit of n.
+      auto const clear_lowest = [] (unsigned const n) { return n & (n - 1U); };
+      if (generation < 2U) {
+        return 0U;
+      }
+      return (generation & 1U) != 0U ? clear_lowest (clear_lowest (generation - 1U)) + 1U
+                                     : clear_lowest (generation);
+    }
 
 #define X(a) a,
     // Note that the first enum member must have the value 0 or flush_indices() will need to
@@ -257,8 +270,10 @@ namespace pstore {
       typed_address<trailer> prev_generation = typed_address<trailer>::null ();
 
       index_records_array index_records;
-      std::uint32_t unused2{0};
-      std::uint32_t unused3{0};
+
+      /// A pointer to the generation given by skip_target(generation). Null in stores whose
+      /// history predates these pointers: in that case only prev_generation may be followed.
+      typed_address<trailer> skip_generation = typed_address<trailer>::null ();
     };
 
 
@@ -283,8 +298,7 @@ namespace pstore {
   PSTORE_STATIC_ASSERT (offsetof (trailer::body, time) == 24);
   PSTORE_STATIC_ASSERT (offsetof (trailer::body, prev_generation) == 32);
   PSTORE_STATIC_ASSERT (offsetof (trailer::body, index_records) == 40);
-  PSTORE_STATIC_ASSERT (offsetof (trailer::body, unused2) == 88);
-  PSTORE_STATIC_ASSERT (offsetof (trailer::body, unused3) == 92);
+  PSTORE_STATIC_ASSERT (offsetof (trailer::body, skip_generation) == 88);
   PSTORE_STATIC_ASSERT (alignof (trailer::body) == 8);
   PSTORE_STATIC_ASSERT (sizeof (trailer::body) == 96);
 
@@ -19,7 +19,12 @@
 #ifndef PSTORE_CORE_HAMT_MAP_HPP
 #define PSTORE_CORE_HAMT_MAP_HPP
 
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <optional>
 #include <variant>
+#include <vector>
 
 #include "pstore/core/hamt_map_types.hpp"
 #include "pstore/serialize/standard_types.hpp"
@@ -60,6 +65,14 @@ namespace pstore {
                                                         serialize::is_compatible_v<ValueType, V>> {
       };
 
+      /// A helper class which provides a member constant `value` which is equal to true if
+      /// T is a std::pair<> whose member types have a serialized representation which is
+      /// compatible with KeyType and ValueType respectively. Otherwise `value` is false.
+      template <typename T>
+      struct is_compatible_pair : std::false_type {};
+      template <typename K, typename V>
+      struct is_compatible_pair<std::pair<K, V>> : pair_types_compatible<K, V> {};
+
       /// Inner class that describes both const- and non-const iterator.
       template <bool IsConstIterator = true>
       class iterator_base;
@@ -89,7 +102,7 @@ namespace pstore {
       hamt_map (hamt_map const &) = delete;
       hamt_map (hamt_map &&) noexcept = delete;
 
-      ~hamt_map () override { this->clear (); }
+      ~hamt_map () override = default;
 
       hamt_map & operator= (hamt_map const &) = delete;
       hamt_map & operator= (hamt_map &&) noexcept = delete;
@@ -187,6 +200,42 @@ namespace pstore {
                   pair_types_compatible<OtherKeyType, OtherValueType>::value>>
       auto insert_or_assign (transaction_base & transaction, OtherKeyType const & key,
                              OtherValueType const & value) -> std::pair<iterator, bool>;
+
+      /// Inserts a batch of key-value pairs into the hamt_map. Any element whose key is
+      /// already present in the container, or which appears earlier in the batch, is not
+      /// inserted. All iterators are invalidated.
+      ///
+      /// The batch is sorted by hash and merged into the trie in a single pass so that each
+      /// branch and linear node is visited (and, if necessary, copied to the heap) at most
+      /// once for the whole batch rather than once per key. This is considerably faster
+      /// than repeated calls to insert() when adding a large number of keys.
+      ///
+      /// \tparam ForwardIterator  An iterator whose value type is a std::pair<> with types
+      /// whose serialized representations are compatible with KeyType and ValueType.
+      /// \param transaction  The transaction to which new data will be appended.
+      /// \param first  The start of the range of key-value pairs to be inserted.
+      /// \param last  The end of the range of key-value pairs to be inserted.
+      /// \result The number of elements that were added to the container.
+      template <typename ForwardIterator>
+      std::size_t insert_range (transaction_base & transaction, ForwardIterator first,
+                                ForwardIterator last);
+
+      /// Inserts or updates a batch of key-value pairs. For each element, if an equivalent
+      /// key already exists in the container then its mapped value is replaced, otherwise
+      /// the element is inserted. If the batch contains more than one element with the same
+      /// key, the last of them wins. All iterators are invalidated.
+      ///
+      /// Like insert_range(), the batch is merged into the trie in a single pass.
+      ///
+      /// \tparam ForwardIterator  An iterator whose value type is a std::pair<> with types
+      /// whose serialized representations are compatible with KeyType and ValueType.
+      /// \param transaction  The transaction to which new data will be appended.
+      /// \param first  The start of the range of key-value pairs to be inserted or updated.
+      /// \param last  The end of the range of key-value pairs to be inserted or updated.
+      /// \result The number of elements that were added to the container.
+      template <typename ForwardIterator>
+      std::size_t insert_or_assign_range (transaction_base & transaction, ForwardIterator first,
+                                          ForwardIterator last);
       ///@}
 
       /// \name Lookup
@@ -216,6 +265,49 @@ namespace pstore {
       bool contains (database const & db, OtherKeyType const & key) const {
         return this->find (db, key) != this->end (db);
       }
+
+      /// Finds the elements with keys equivalent to each of the keys in the range [first,
+      /// last). The result is the same as calling find() for each key in turn but the descents
+      /// of several keys through the tree are interleaved. Each time that a lookup computes the
+      /// location of the next node that it must visit, a prefetch of that node is issued and
+      /// the lookup is set aside while the others make progress. This hides much of the
+      /// latency of loading nodes which are not in the processor's cache or, with
+      /// database::prefetch_hint::page, are not yet in memory.
+      ///
+      /// \tparam ForwardIterator  An iterator whose value type has a serialized
+      ///   representation which is compatible with KeyType.
+      /// \tparam OutputIterator  An output iterator to which const_iterator instances may be
+      ///   written.
+      /// \param db  The database to which the index belongs.
+      /// \param first  The start of the range of keys to be found.
+      /// \param last  The end of the range of keys to be found.
+      /// \param out  For each key in turn, an iterator to the matching element or the
+      ///   past-the-end iterator is written to \p out.
+      /// \param hint  The kind of prefetch to be issued for each node.
+      /// \result The value of \p out after the last result has been written.
+      template <typename ForwardIterator, typename OutputIterator>
+      OutputIterator find_many (database const & db, ForwardIterator first, ForwardIterator last,
+                                OutputIterator out,
+                                database::prefetch_hint hint = database::prefetch_hint::cache) const;
+
+      /// Finds the mapped values associated with each of a collection of keys. Unlike the
+      /// iterator-based find_many(), no iterators are constructed. The keys are sorted into
+      /// trie order so that lookups which share a path through the tree decode each of its
+      /// branch and linear nodes only once.
+      ///
+      /// \tparam OtherKeyType  A type whose serialized representation is compatible with
+      ///   KeyType.
+      /// \param db  The database to which the index belongs.
+      /// \param keys  The keys to be found.
+      /// \param values  Must have the same number of members as \p keys. On return, each
+      ///   member holds the value mapped to the corresponding key or std::nullopt if the key
+      ///   is not present.
+      /// \result The number of keys that were found.
+      template <typename OtherKeyType,
+                typename = typename std::enable_if_t<
+                  serialize::is_compatible_v<std::remove_const_t<OtherKeyType>, KeyType>>>
+      std::size_t find_many (database const & db, gsl::span<OtherKeyType> keys,
+                             gsl::span<std::optional<mapped_type>> values) const;
       ///@}
 
       /// Flush any modified index nodes to the store.
@@ -223,7 +315,29 @@ namespace pstore {
       /// \param transaction  The transaction to which the map will be written.
       /// \param generation The generation number to which the map will be written.
       /// \returns The address of the index root node.
-      typed_address<header_block> flush (transaction_base & transaction, unsigned generation);
+      typed_address<header_block> flush (transaction_base & transaction, unsigned generation) {
+        return this->flush (transaction, this->reserve_flush (transaction), generation);
+      }
+
+      /// Allocates the store space that will be needed to flush the index. The space is
+      /// populated by a subsequent call to flush(). Separating allocation from writing
+      /// means that several indices can be written concurrently whilst keeping the
+      /// resulting store layout independent of the order in which those writes complete.
+      ///
+      /// \param transaction  The transaction to which the map will be written.
+      /// \returns A description of the allocated space. This must be passed to flush().
+      flush_reservation reserve_flush (transaction_base & transaction) const;
+
+      /// Flush any modified index nodes to space previously allocated by reserve_flush().
+      /// No other modifications may be made to the index between the two calls.
+      ///
+      /// \param transaction  The transaction to which the map will be written.
+      /// \param reservation  The space allocated by reserve_flush().
+      /// \param generation The generation number to which the map will be written.
+      /// \returns The address of the index root node.
+      typed_address<header_block> flush (transaction_base & transaction,
+                                         flush_reservation const & reservation,
+                                         unsigned generation);
 
       /// \name Accessors
       /// Provide access to index internals.
@@ -240,25 +354,33 @@ namespace pstore {
       static constexpr std::array<std::uint8_t, 8> index_signature{
         {'I', 'n', 'd', 'x', 'H', 'e', 'd', 'r'}};
 
+      /// Writes a key/value data pair to the store and returns its address.
+      template <typename OtherValueType>
+      address write_leaf (transaction_base & transaction, OtherValueType const & v);
+
       /// Stores a key/value data pair.
       template <typename OtherValueType>
       address store_leaf (transaction_base & transaction, OtherValueType const & v,
                           gsl::not_null<parent_stack *> parents);
 
-      /// If the \p node is a heap branch, clear its children and itself.
-      void clear (index_pointer node, unsigned shifts);
-
-      /// Clear the hamt_map when transaction::rollback() function is called.
+      /// Clear the hamt_map when transaction::rollback() function is called. All of the
+      /// in-heap nodes are released.
       void clear () {
         if (root_.is_heap ()) {
-          this->clear (root_, 0 /*shifts*/);
           root_.clear ();
         }
+        internals_container_->clear ();
+        linear_nodes_.clear ();
       }
 
       /// Read a key from a store.
       key_type get_key (database const & db, address addr) const;
 
+      /// Issues a prefetch for the tree node or leaf referenced by \p node. Nothing is done
+      /// for heap-resident nodes.
+      static void prefetch_node (database const & db, index_pointer node,
+                                 database::prefetch_hint hint) noexcept;
+
       /// Called when the trie's top-level loop has descended as far as a leaf node. We need
       /// to convert that to a branch.
       template <typename OtherValueType>
@@ -317,21 +439,85 @@ namespace pstore {
       std::pair<iterator, bool> insert_or_upsert (transaction_base & transaction,
                                                   OtherValueType const & value, bool is_upsert);
 
-      /// Frees memory consumed by a heap-allocated tree node.
+      /// An element of the batch built by insert_range() and insert_or_assign_range(): a
+      /// key's hash and an iterator which references the corresponding key/value pair.
+      template <typename Iterator>
+      using bulk_entry = std::pair<hash_type, Iterator>;
+      template <typename Iterator>
+      using bulk_span = gsl::span<bulk_entry<Iterator> const>;
+
+      /// Returns true if a key with hash \p a is reached before one with hash \p b in a
+      /// depth-first traversal of the trie. Since each level consumes hash_index_bits of the
+      /// hash starting from the least-significant end, this compares the first differing
+      /// group of bits.
+      static bool trie_order (hash_type a, hash_type b) noexcept;
+
+      /// An element of the batch built by the span-based find_many(): a key's hash and its
+      /// index within the keys and values spans.
+      using lookup_entry = std::pair<hash_type, std::ptrdiff_t>;
+      using lookup_span = gsl::span<lookup_entry const>;
+
+      /// Finds a sorted batch of keys in the sub-trie rooted at \p node.
       ///
-      /// \param node  The tree node to be deleted.
+      /// \param db  The database to which the index belongs.
+      /// \param node  The node to be searched.
+      /// \param entries  The batch of keys. Must not be empty. All of the members share the
+      ///   hash bits consumed by the levels above \p node and are in trie order.
+      /// \param shifts  The number of bits by which the hash value is shifted to reach the
+      ///   current tree level.
+      /// \param keys  The keys passed to find_many().
+      /// \param values  The values passed to find_many().
+      /// \result The number of keys in \p entries that were found.
+      template <typename OtherKeyType>
+      std::size_t find_many_node (database const & db, index_pointer node,
+                                  lookup_span entries, unsigned shifts,
+                                  gsl::span<OtherKeyType> keys,
+                                  gsl::span<std::optional<mapped_type>> values) const;
+
+      /// The implementation of insert_range() and insert_or_assign_range().
+      template <typename ForwardIterator>
+      std::size_t bulk_insert (transaction_base & transaction, ForwardIterator first,
+                               ForwardIterator last, bool is_upsert);
+
+      /// Merges a sorted batch of key/value pairs into a node.
+      ///
+      /// \param transaction  The transaction to which new data will be appended.
+      /// \param node  The node into which the batch is to be merged. May be empty, a leaf, a
+      ///   branch, or a linear node (depending on \p shifts), either in-heap or in-store.
+      /// \param entries  The batch of key/value pairs. Must not be empty. All of the members
+      ///   share the hash bits consumed by the levels above \p node and are in trie order.
       /// \param shifts  The number of bits by which the hash value is shifted to reach the
-      /// current tree level. This is used to determine whether the reference is to a
-      /// branch or linear node.
-      void delete_node (index_pointer node, unsigned shifts);
+      ///   current tree level.
+      /// \param is_upsert  True if existing keys should be updated, false otherwise.
+      /// \param inserted  Incremented for each new key added to the trie.
+      /// \result  The new node. This is equal to \p node if it was not modified or was
+      ///   modified in place.
+      template <typename Iterator>
+      index_pointer bulk_insert_node (transaction_base & transaction, index_pointer node,
+                                      bulk_span<Iterator> entries, unsigned shifts,
+                                      bool is_upsert, gsl::not_null<std::size_t *> inserted);
+
+      template <typename Iterator>
+      index_pointer bulk_insert_into_branch (transaction_base & transaction, index_pointer node,
+                                             bulk_span<Iterator> entries, unsigned shifts,
+                                             bool is_upsert,
+                                             gsl::not_null<std::size_t *> inserted);
+
+      template <typename Iterator>
+      index_pointer bulk_insert_into_linear (transaction_base & transaction, index_pointer node,
+                                             bulk_span<Iterator> entries, bool is_upsert,
+                                             gsl::not_null<std::size_t *> inserted);
 
       /// \brief Write the index header.
       /// The index header simply holds a check signature, the tree root, and remembers the
       /// tree size for us on restore.
       ///
       /// \param transaction  The transaction to which the header block will be written.
+      /// \param pos  The address at which the header block is to be written. Updated to
+      ///   point just beyond it.
       /// \result  The address at which the header block was written.
-      typed_address<header_block> write_header_block (transaction_base & transaction);
+      typed_address<header_block> write_header_block (transaction_base & transaction,
+                                                      gsl::not_null<address *> pos);
 
       static constexpr auto branches_per_chunk = std::size_t{256} * 1024 / sizeof (branch);
 
@@ -351,6 +537,10 @@ namespace pstore {
         chunked_sequence<branch, branches_per_chunk, branch::size_bytes (details::hash_size)>;
       std::unique_ptr<branch_container> internals_container_ =
         std::make_unique<branch_container> ();
+      /// In-heap linear nodes vary in size so they are allocated from an arena. A node
+      /// which outgrows its capacity is replaced by a larger copy and the original is simply
+      /// abandoned; the memory is reclaimed in bulk by flush() or clear().
+      arena linear_nodes_;
 
       unsigned revision_;
       index_pointer root_;
@@ -574,6 +764,10 @@ namespace pstore {
         [this, &parent] (auto & arg) {
           using T = std::decay_t<decltype (arg)>;
           if constexpr (std::is_same_v<T, branch const *>) {
+            // Start to load the next of this branch's children while we walk this one.
+            if (auto const next = parent.position + 1U; next < arg->size ()) {
+              prefetch_node (db_, (*arg)[next], database::prefetch_hint::cache);
+            }
             index_pointer const child = (*arg)[parent.position];
             if (child.is_branch ()) {
               this->move_to_left_most_child (child);
@@ -648,24 +842,6 @@ namespace pstore {
       }
     }
 
-    // clear
-    // ~~~~~
-    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
-    void hamt_map<KeyType, ValueType, Hash, KeyEqual>::clear (index_pointer node, unsigned shifts) {
-      PSTORE_ASSERT (node.is_heap () && !node.is_leaf ());
-      if (details::depth_is_branch (shifts)) {
-        auto const * const internal = node.untag<branch *> ();
-        // Recursively release the children of this internal node.
-        for (auto p : *internal) {
-          if (p.is_heap ()) {
-            this->clear (p, shifts + details::hash_index_bits);
-          }
-        }
-      }
-
-      this->delete_node (node, shifts);
-    }
-
     // load leaf node
     // ~~~~~~~~~~~~~~
     template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
@@ -689,14 +865,13 @@ namespace pstore {
       return serialize::read<KeyType> (reader);
     }
 
-    // store leaf
+    // write leaf
     // ~~~~~~~~~~
     template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
     template <typename OtherValueType>
-    address hamt_map<KeyType, ValueType, Hash, KeyEqual>::store_leaf (
-      transaction_base & transaction, OtherValueType const & v,
-      gsl::not_null<parent_stack *> const parents) {
-
+    address
+    hamt_map<KeyType, ValueType, Hash, KeyEqual>::write_leaf (transaction_base & transaction,
+                                                              OtherValueType const & v) {
       // Make sure the alignment of leaf node is 4 to ensure that the two LSB are guaranteed
       // 0. If 'v' has greater alignment, serialize::write() will add additional padding.
       constexpr auto aligned_to = std::size_t{4};
@@ -708,8 +883,19 @@ namespace pstore {
       auto writer = serialize::archive::make_writer (transaction);
       address const result = serialize::write (writer, v);
       PSTORE_ASSERT ((result.absolute () & (aligned_to - 1U)) == 0U);
-      parents->push (details::parent_type{index_pointer{result}});
+      return result;
+    }
+
+    // store leaf
+    // ~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename OtherValueType>
+    address hamt_map<KeyType, ValueType, Hash, KeyEqual>::store_leaf (
+      transaction_base & transaction, OtherValueType const & v,
+      gsl::not_null<parent_stack *> const parents) {
 
+      address const result = this->write_leaf (transaction, v);
+      parents->push (details::parent_type{index_pointer{result}});
       return result;
     }
 
@@ -757,30 +943,12 @@ namespace pstore {
 
       // We ran out of hash bits: create a new linear node.
       auto const linear_ptr =
-        index_pointer{linear_node::allocate (existing_leaf.to_address (),
-                                             this->store_leaf (transaction, new_leaf, parents))
-                        .release ()};
+        index_pointer{linear_node::allocate (linear_nodes_, existing_leaf.to_address (),
+                                             this->store_leaf (transaction, new_leaf, parents))};
       parents->push (details::parent_type{linear_ptr, 1U});
       return linear_ptr;
     }
 
-    // delete node
-    // ~~~~~~~~~~~
-    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
-    void hamt_map<KeyType, ValueType, Hash, KeyEqual>::delete_node (index_pointer const node,
-                                                                    unsigned const shifts) {
-      if (node.is_heap ()) {
-        PSTORE_ASSERT (!node.is_leaf ());
-        if (details::depth_is_branch (shifts)) {
-          // Branches are owned by internals_container_. Don't delete them here. If
-          // this ever changes, then add something like: delete
-          // node.untag<branch *> ();
-        } else {
-          delete node.untag<linear_node *> ();
-        }
-      }
-    }
-
     // insert into branch
     // ~~~~~~~~~~~~~~~~~~
     template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
@@ -814,15 +982,11 @@ namespace pstore {
         this->insert_node (transaction, child_slot, value, hash, shifts, parents, is_upsert);
 
       // If the insertion resulted in our child node being reallocated, then this node needs
-      // to be heap-allocated and the child reference updated. The original child pointer may
-      // also need to be freed.
+      // to be heap-allocated and the child reference updated. A previous heap-allocated
+      // child is owned by internals_container_ or linear_nodes_ so it isn't freed here.
       if (new_child != child_slot) {
         branch * const wb = branch::make_writable (internals_container_.get (), node, *b);
-
-        // Release a previous heap-allocated instance.
-        index_pointer & child = (*wb)[index];
-        this->delete_node (child, shifts);
-        child = new_child;
+        (*wb)[index] = new_child;
         node = wb;
       }
 
@@ -856,29 +1020,26 @@ namespace pstore {
         // The key wasn't present in the node so we simply append it.
         // TODO: keep these entries sorted?
 
-        // Load into memory with space for 1 new child node.
-        std::unique_ptr<linear_node> new_node = linear_node::allocate_from (*orig_node, 1U);
         index = orig_node->size ();
-        (*new_node)[index] = this->store_leaf (transaction, value, parents);
-        result = new_node.release ();
+        address const leaf = this->store_leaf (transaction, value, parents);
+        // A heap node with spare capacity is extended in place. Otherwise, load into memory
+        // with space for at least 1 new child node.
+        linear_node * lnode = node.is_heap () ? node.untag<linear_node *> () : nullptr;
+        if (lnode == nullptr || !lnode->try_push_back (leaf)) {
+          lnode = linear_node::allocate_from (linear_nodes_, *orig_node, 1U);
+          (*lnode)[index] = leaf;
+        }
+        result = lnode;
       } else {
         key_exists = true;
         if (is_upsert) {
-          std::unique_ptr<linear_node> new_node;
-          linear_node * lnode = nullptr;
-
-          if (node.is_heap ()) {
-            // If the node is already on the heap then there's no need to reallocate it.
-            lnode = node.untag<linear_node *> ();
-            result = node;
-          } else {
-            // Load into memory but no extra space.
-            new_node = linear_node::allocate_from (*orig_node, 0U);
-            lnode = new_node.get ();
-            result = lnode;
-          }
+          // If the node is already on the heap then there's no need to reallocate it.
+          // Otherwise load into memory but no extra space.
+          linear_node * const lnode =
+            node.is_heap () ? node.untag<linear_node *> ()
+                            : linear_node::allocate_from (linear_nodes_, *orig_node, 0U);
+          result = lnode;
           (*lnode)[index] = this->store_leaf (transaction, value, parents);
-          new_node.release ();
         } else {
           parents->push (details::parent_type{index_pointer{(*orig_node)[index]}});
 
@@ -1000,31 +1161,332 @@ namespace pstore {
       return this->insert_or_assign (transaction, std::make_pair (key, value));
     }
 
+    // trie order
+    // ~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    bool hamt_map<KeyType, ValueType, Hash, KeyEqual>::trie_order (hash_type const a,
+                                                                   hash_type const b) noexcept {
+      hash_type const diff = a ^ b;
+      if (diff == 0U) {
+        return false;
+      }
+      // Find the group of hash_index_bits containing the least-significant differing bit.
+      unsigned const shifts =
+        bit_count::ctz (diff) / details::hash_index_bits * details::hash_index_bits;
+      return ((a >> shifts) & details::hash_index_mask) <
+             ((b >> shifts) & details::hash_index_mask);
+    }
+
+    // bulk insert
+    // ~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename ForwardIterator>
+    std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::bulk_insert (
+      transaction_base & transaction, ForwardIterator first, ForwardIterator const last,
+      bool const is_upsert) {
+
+      static_assert (
+        is_compatible_pair<typename std::iterator_traits<ForwardIterator>::value_type>::value,
+        "The range must contain pairs compatible with KeyType and ValueType");
+
+      if (revision_ != transaction.db ().get_current_revision ()) {
+        raise (error_code::index_not_latest_revision);
+      }
+      if (first == last) {
+        return 0U;
+      }
+
+      std::vector<bulk_entry<ForwardIterator>> entries;
+      entries.reserve (static_cast<std::size_t> (std::distance (first, last)));
+      for (; first != last; ++first) {
+        entries.emplace_back (static_cast<hash_type> (hash_ (first->first)), first);
+      }
+      // Sort the batch into the order in which its members will be visited as we descend
+      // the trie. The sort is stable so that members with equal keys retain their relative
+      // order.
+      std::stable_sort (std::begin (entries), std::end (entries),
+                        [] (bulk_entry<ForwardIterator> const & a,
+                            bulk_entry<ForwardIterator> const & b) {
+                          return trie_order (a.first, b.first);
+                        });
+
+      // Remove duplicate keys from the batch. Equal keys must have equal hashes and are
+      // therefore adjacent. For an insert, the first of a set of duplicates is kept; for an
+      // upsert, the value of the last is used.
+      auto out = std::begin (entries);
+      for (auto run = std::begin (entries), end = std::end (entries); run != end;) {
+        auto const run_hash = run->first;
+        auto const kept = out;
+        for (; run != end && run->first == run_hash; ++run) {
+          auto const pos = std::find_if (kept, out, [this, run] (auto const & e) {
+            return equal_ (run->second->first, e.second->first);
+          });
+          if (pos == out) {
+            *(out++) = *run;
+          } else if (is_upsert) {
+            pos->second = run->second;
+          }
+        }
+      }
+      entries.erase (out, std::end (entries));
+
+      auto inserted = std::size_t{0};
+      root_ = this->bulk_insert_node (
+        transaction, root_,
+        bulk_span<ForwardIterator>{entries.data (),
+                                   static_cast<std::ptrdiff_t> (entries.size ())},
+        0U /*shifts*/, is_upsert, &inserted);
+      size_ += inserted;
+      return inserted;
+    }
+
+    // bulk insert node
+    // ~~~~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename Iterator>
+    auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::bulk_insert_node (
+      transaction_base & transaction, index_pointer const node,
+      bulk_span<Iterator> const entries, unsigned const shifts, bool const is_upsert,
+      gsl::not_null<std::size_t *> const inserted) -> index_pointer {
+
+      PSTORE_ASSERT (!entries.empty ());
+      if (node.is_empty () && entries.size () == 1) {
+        ++*inserted;
+        return index_pointer{this->write_leaf (transaction, *entries[0].second)};
+      }
+      if (details::depth_is_branch (shifts)) {
+        return this->bulk_insert_into_branch (transaction, node, entries, shifts, is_upsert,
+                                              inserted);
+      }
+      return this->bulk_insert_into_linear (transaction, node, entries, is_upsert, inserted);
+    }
+
+    // bulk insert into branch
+    // ~~~~~~~~~~~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename Iterator>
+    auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::bulk_insert_into_branch (
+      transaction_base & transaction, index_pointer const node,
+      bulk_span<Iterator> const entries, unsigned const shifts, bool const is_upsert,
+      gsl::not_null<std::size_t *> const inserted) -> index_pointer {
+
+      // Work out the existing children of this node. A leaf is treated as though it were a
+      // branch with a single child.
+      auto existing_bitmap = hash_type{0};
+      gsl::span<index_pointer const> existing_children;
+      std::shared_ptr<branch const> store_branch;
+      if (node.is_leaf ()) {
+        if (!node.is_empty ()) {
+          key_type const existing_key = this->get_key (transaction.db (), node.to_address ());
+          if (entries.size () == 1 && equal_ (entries[0].second->first, existing_key)) {
+            return is_upsert ? index_pointer{this->write_leaf (transaction, *entries[0].second)}
+                             : node;
+          }
+          existing_bitmap = hash_type{1}
+                            << ((static_cast<hash_type> (hash_ (existing_key)) >> shifts) &
+                                details::hash_index_mask);
+          existing_children = gsl::span<index_pointer const>{&node, 1};
+        }
+      } else {
+        branch const * b = nullptr;
+        std::tie (store_branch, b) = branch::get_node (transaction.db (), node);
+        PSTORE_ASSERT (b != nullptr);
+        existing_bitmap = b->get_bitmap ();
+        existing_children = gsl::span<index_pointer const>{b->begin (), b->end ()};
+      }
+
+      // Merge the existing children with the batch members, one hash slot at a time.
+      std::array<index_pointer, details::hash_size> children;
+      auto num_children = std::size_t{0};
+      auto bitmap = hash_type{0};
+      auto modified = false;
+      auto existing_index = std::ptrdiff_t{0};
+      auto entry_index = std::ptrdiff_t{0};
+      auto const num_entries = entries.size ();
+      auto const child_shifts = shifts + details::hash_index_bits;
+      for (auto slot = hash_type{0}; slot < details::hash_size; ++slot) {
+        auto const bit_pos = hash_type{1} << slot;
+        index_pointer child;
+        if ((existing_bitmap & bit_pos) != 0U) { //! OCLINT(PH - bitwise in conditional is ok)
+          child = existing_children[existing_index++];
+        }
+
+        auto group_end = entry_index;
+        while (group_end < num_entries &&
+               ((entries[group_end].first >> shifts) & details::hash_index_mask) == slot) {
+          ++group_end;
+        }
+        if (group_end > entry_index) {
+          index_pointer const new_child = this->bulk_insert_node (
+            transaction, child, entries.subspan (entry_index, group_end - entry_index),
+            child_shifts, is_upsert, inserted);
+          if (new_child != child) {
+            child = new_child;
+            modified = true;
+          }
+          entry_index = group_end;
+        }
+
+        if (!child.is_empty ()) {
+          children[num_children++] = child;
+          bitmap |= bit_pos;
+        }
+      }
+      PSTORE_ASSERT (entry_index == num_entries);
+      PSTORE_ASSERT (existing_index == existing_children.size ());
+
+      if (!modified) {
+        return node;
+      }
+      auto const span = gsl::make_span (children.data (), static_cast<std::ptrdiff_t> (num_children));
+      if (node.is_heap ()) {
+        // A heap branch has room for every child so it can be updated in place.
+        node.untag<branch *> ()->assign (bitmap, span);
+        return node;
+      }
+      return index_pointer{branch::allocate (internals_container_.get (), bitmap, span)};
+    }
+
+    // bulk insert into linear
+    // ~~~~~~~~~~~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename Iterator>
+    auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::bulk_insert_into_linear (
+      transaction_base & transaction, index_pointer const node,
+      bulk_span<Iterator> const entries, bool const is_upsert,
+      gsl::not_null<std::size_t *> const inserted) -> index_pointer {
+
+      database const & db = transaction.db ();
+
+      // Gather the existing leaves. At this depth, every key has the same hash and we must
+      // compare the keys themselves.
+      std::vector<address> leaves;
+      if (node.is_leaf ()) {
+        if (!node.is_empty ()) {
+          leaves.push_back (node.to_address ());
+        }
+      } else {
+        auto const [lptr, orig_node] = linear_node::get_node (db, node);
+        (void) lptr;
+        PSTORE_ASSERT (orig_node != nullptr);
+        leaves.assign (orig_node->begin (), orig_node->end ());
+      }
+
+      auto const num_existing = leaves.size ();
+      auto const existing_end = [&leaves, num_existing] () {
+        return std::begin (leaves) + static_cast<std::ptrdiff_t> (num_existing);
+      };
+      auto modified = false;
+      for (auto const & entry : entries) {
+        auto const & value = *entry.second;
+        auto const pos = std::find_if (std::begin (leaves), existing_end (),
+                                       [this, &db, &value] (address const addr) {
+                                         return equal_ (value.first, this->get_key (db, addr));
+                                       });
+        if (pos == existing_end ()) {
+          leaves.push_back (this->write_leaf (transaction, value));
+          ++*inserted;
+          modified = true;
+        } else if (is_upsert) {
+          *pos = this->write_leaf (transaction, value);
+          modified = true;
+        }
+      }
+
+      if (!modified) {
+        return node;
+      }
+      if (leaves.size () == 1U) {
+        return index_pointer{leaves.front ()};
+      }
+      auto const span =
+        gsl::make_span (leaves.data (), static_cast<std::ptrdiff_t> (leaves.size ()));
+      if (node.is_heap () && node.untag<linear_node *> ()->try_assign (span)) {
+        // A heap node with sufficient capacity can be updated in place.
+        return node;
+      }
+      return index_pointer{linear_node::allocate (linear_nodes_, span)};
+    }
+
+    // insert range
+    // ~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename ForwardIterator>
+    std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_range (
+      transaction_base & transaction, ForwardIterator first, ForwardIterator last) {
+      return this->bulk_insert (transaction, first, last, false /*is_upsert*/);
+    }
+
+    // insert or assign range
+    // ~~~~~~~~~~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename ForwardIterator>
+    std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_or_assign_range (
+      transaction_base & transaction, ForwardIterator first, ForwardIterator last) {
+      return this->bulk_insert (transaction, first, last, true /*is_upsert*/);
+    }
+
+    // reserve flush
+    // ~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    flush_reservation hamt_map<KeyType, ValueType, Hash, KeyEqual>::reserve_flush (
+      transaction_base & transaction) const {
+      if (revision_ != transaction.db ().get_current_revision ()) {
+        raise (error_code::index_not_latest_revision);
+      }
+      // All of the records written by flush() have the same alignment and a size which is
+      // a multiple of it so the reservation can be carved into consecutive records without
+      // any padding.
+      PSTORE_STATIC_ASSERT (alignof (branch) == alignof (header_block));
+      PSTORE_STATIC_ASSERT (alignof (linear_node) == alignof (header_block));
+      PSTORE_STATIC_ASSERT (sizeof (header_block) % alignof (header_block) == 0U);
+
+      std::uint64_t size = 0;
+      if (!root_.is_address ()) {
+        PSTORE_ASSERT (root_.is_branch ());
+        size += root_.untag<branch const *> ()->flush_size (0 /*shifts*/);
+      }
+      if (this->size () > 0U) {
+        size += sizeof (header_block);
+      }
+      if (size == 0U) {
+        return {};
+      }
+      return {transaction.allocate (size, alignof (header_block)), size};
+    }
+
     // flush
     // ~~~~~
     template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
-    typed_address<header_block>
-    hamt_map<KeyType, ValueType, Hash, KeyEqual>::flush (transaction_base & transaction,
-                                                         unsigned const generation) {
+    typed_address<header_block> hamt_map<KeyType, ValueType, Hash, KeyEqual>::flush (
+      transaction_base & transaction, flush_reservation const & reservation,
+      unsigned const generation) {
       if (revision_ != transaction.db ().get_current_revision ()) {
         raise (error_code::index_not_latest_revision);
       }
 
+      address pos = reservation.first;
       // If the root is a leaf, there's nothing to do. If not, we start to recursively flush
-      // the tree.
+      // the tree. Large trees are written with the sub-tries of the root node being
+      // processed concurrently.
       if (!root_.is_address ()) {
         PSTORE_ASSERT (root_.is_branch ());
-        root_ = root_.untag<branch *> ()->flush (transaction, 0 /*shifts*/);
+        auto * const root = root_.untag<branch *> ();
+        root_ = reservation.size >= details::parallel_flush_threshold
+                  ? root->flush_concurrently (transaction, &pos, 0 /*shifts*/)
+                  : root->flush (transaction, &pos, 0 /*shifts*/);
         PSTORE_ASSERT (root_.is_address ());
         // Don't delete the branch node here. They are owned by internals_container_. If
         // this ever changes, then use something like 'delete internal' here.
       }
 
-      auto const header_addr = this->size () > 0U ? this->write_header_block (transaction)
+      auto const header_addr = this->size () > 0U ? this->write_header_block (transaction, &pos)
                                                   : typed_address<header_block>::null ();
+      PSTORE_ASSERT (pos == reservation.first + reservation.size);
 
       // Release all of the in-heap internal nodes that we have now flushed.
       internals_container_->clear ();
+      linear_nodes_.clear ();
 
       // Update the revision number into which the index will be flushed.
       revision_ = generation;
@@ -1036,13 +1498,15 @@ namespace pstore {
     // ~~~~~~~~~~~~~~~~~~
     template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
     typed_address<header_block> hamt_map<KeyType, ValueType, Hash, KeyEqual>::write_header_block (
-      transaction_base & transaction) {
+      transaction_base & transaction, gsl::not_null<address *> const pos) {
       PSTORE_ASSERT (this->root ().is_address ());
-      auto [header, address] = transaction.alloc_rw<header_block> ();
+      auto const addr = typed_address<header_block>::make (*pos);
+      auto header = transaction.getrw (addr);
       header->signature = index_signature;
       header->size = this->size ();
       header->root = this->root ().to_address ();
-      return address;
+      *pos += sizeof (header_block);
+      return addr;
     }
 
     // find
@@ -1097,6 +1561,223 @@ namespace pstore {
       return this->cend (db);
     }
 
+    // find many
+    // ~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename ForwardIterator, typename OutputIterator>
+    OutputIterator hamt_map<KeyType, ValueType, Hash, KeyEqual>::find_many (
+      database const & db, ForwardIterator first, ForwardIterator last, OutputIterator out,
+      database::prefetch_hint const hint) const {
+
+      // The state of a single lookup.
+      struct cursor {
+        ForwardIterator key;
+        hash_type hash = 0;
+        unsigned shifts = 0;
+        index_pointer node;
+        parent_stack parents;
+        bool done = false;
+        bool found = false;
+      };
+
+      // Moves a lookup one level further down the tree.
+      auto const step = [this, &db, hint] (cursor & c) {
+        if (c.node.is_leaf ()) {
+          c.done = true;
+          c.found = equal_ (get_key (db, c.node.to_address ()), *c.key);
+          if (c.found) {
+            c.parents.push (details::parent_type{c.node});
+          }
+          return;
+        }
+
+        index_pointer child_node;
+        auto index = std::size_t{0};
+        if (details::depth_is_branch (c.shifts)) {
+          auto const [store_node, internal] = branch::get_node (db, c.node);
+          std::tie (child_node, index) = internal->lookup (c.hash & details::hash_index_mask);
+        } else {
+          auto const [store_node, linear] = linear_node::get_node (db, c.node);
+          std::tie (child_node, index) = linear->template lookup<KeyType> (db, *c.key, equal_);
+        }
+        if (index == details::not_found) {
+          c.done = true;
+          return;
+        }
+        c.parents.push (details::parent_type{c.node, index});
+        c.node = child_node;
+        c.shifts += details::hash_index_bits;
+        c.hash >>= details::hash_index_bits;
+        // Start loading the node that this lookup will visit next.
+        prefetch_node (db, c.node, hint);
+      };
+
+      std::array<cursor, details::find_many_width> cursors;
+      while (first != last) {
+        // Start a group of lookups.
+        auto num_cursors = std::size_t{0};
+        for (; num_cursors < cursors.size () && first != last; ++num_cursors, ++first) {
+          cursor & c = cursors[num_cursors];
+          c.key = first;
+          c.hash = static_cast<hash_type> (hash_ (*first));
+          c.shifts = 0U;
+          c.node = root_;
+          c.parents = parent_stack{};
+          c.done = root_.is_empty ();
+          c.found = false;
+        }
+
+        // Advance each of the lookups by one level in turn until all of them are complete.
+        for (bool more = true; more;) {
+          more = false;
+          for (auto ctr = std::size_t{0}; ctr < num_cursors; ++ctr) {
+            cursor & c = cursors[ctr];
+            if (!c.done) {
+              step (c);
+              more = more || !c.done;
+            }
+          }
+        }
+
+        for (auto ctr = std::size_t{0}; ctr < num_cursors; ++ctr) {
+          cursor & c = cursors[ctr];
+          *out = c.found ? const_iterator (db, std::move (c.parents), this) : this->cend (db);
+          ++out;
+        }
+      }
+      return out;
+    }
+
+    // find many
+    // ~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename OtherKeyType, typename>
+    std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::find_many (
+      database const & db, gsl::span<OtherKeyType> const keys,
+      gsl::span<std::optional<mapped_type>> const values) const {
+
+      PSTORE_ASSERT (keys.size () == values.size ());
+      std::fill (std::begin (values), std::end (values), std::nullopt);
+      if (this->empty () || keys.empty ()) {
+        return 0U;
+      }
+
+      std::vector<lookup_entry> entries;
+      entries.reserve (static_cast<std::size_t> (keys.size ()));
+      for (auto index = std::ptrdiff_t{0}, size = keys.size (); index < size; ++index) {
+        entries.emplace_back (static_cast<hash_type> (hash_ (keys[index])), index);
+      }
+      // Sort the batch into the order in which its members will be visited as we descend the
+      // trie so that keys which share a path through the tree are adjacent.
+      std::sort (std::begin (entries), std::end (entries),
+                 [] (lookup_entry const & a, lookup_entry const & b) {
+                   return trie_order (a.first, b.first);
+                 });
+      return this->find_many_node (
+        db, root_,
+        lookup_span{entries.data (), static_cast<std::ptrdiff_t> (entries.size ())},
+        0U /*shifts*/, keys, values);
+    }
+
+    // find many node
+    // ~~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    template <typename OtherKeyType>
+    std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::find_many_node (
+      database const & db, index_pointer const node, lookup_span const entries,
+      unsigned const shifts, gsl::span<OtherKeyType> const keys,
+      gsl::span<std::optional<mapped_type>> const values) const {
+
+      PSTORE_ASSERT (!entries.empty ());
+      // Reads the key of the leaf at 'addr' once and compares it with each of the keys in
+      // 'batch'. The value is only loaded if at least one of them matches.
+      auto const match_leaf = [&] (address const addr, lookup_span const batch) {
+        auto matches = std::size_t{0};
+        key_type const existing_key = this->get_key (db, addr);
+        std::optional<mapped_type> value;
+        for (lookup_entry const & entry : batch) {
+          if (equal_ (existing_key, keys[entry.second])) {
+            if (!value) {
+              value.emplace (this->load_leaf (db, addr).second);
+            }
+            values[entry.second] = value;
+            ++matches;
+          }
+        }
+        return matches;
+      };
+
+      if (node.is_leaf ()) {
+        return node.is_empty () ? std::size_t{0} : match_leaf (node.to_address (), entries);
+      }
+
+      auto found = std::size_t{0};
+      if (!details::depth_is_branch (shifts)) {
+        // A linear node. The hash bits are exhausted so the whole batch is compared with each
+        // of the node's leaves in turn.
+        auto const [store_node, linear] = linear_node::get_node (db, node);
+        auto const size = static_cast<std::size_t> (entries.size ());
+        for (auto it = linear->begin (), end = linear->end (); it != end && found < size; ++it) {
+          found += match_leaf (*it, entries);
+        }
+        return found;
+      }
+
+      // A branch. Split the batch into groups which share the same child and start the load
+      // of each of those children before descending into any of them.
+      struct group {
+        index_pointer child;
+        std::ptrdiff_t first;
+        std::ptrdiff_t last;
+      };
+      std::array<group, details::hash_size> groups;
+      auto num_groups = std::size_t{0};
+      {
+        auto const [store_node, internal] = branch::get_node (db, node);
+        for (auto first = std::ptrdiff_t{0}, size = entries.size (); first < size;) {
+          auto const slot = (entries[first].first >> shifts) & details::hash_index_mask;
+          auto last = first + 1;
+          while (last < size &&
+                 ((entries[last].first >> shifts) & details::hash_index_mask) == slot) {
+            ++last;
+          }
+          auto const [child, child_index] = internal->lookup (slot);
+          if (child_index != details::not_found) {
+            prefetch_node (db, child, database::prefetch_hint::cache);
+            groups[num_groups++] = group{child, first, last};
+          }
+          first = last;
+        }
+      }
+      auto const child_shifts = shifts + details::hash_index_bits;
+      for (auto ctr = std::size_t{0}; ctr < num_groups; ++ctr) {
+        group const & g = groups[ctr];
+        found += this->find_many_node (db, g.child, entries.subspan (g.first, g.last - g.first),
+                                       child_shifts, keys, values);
+      }
+      return found;
+    }
+
+    // prefetch node
+    // ~~~~~~~~~~~~~
+    template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+    void hamt_map<KeyType, ValueType, Hash, KeyEqual>::prefetch_node (
+      database const & db, index_pointer const node, database::prefetch_hint const hint) noexcept {
+      if (node.is_empty () || node.is_heap ()) {
+        return;
+      }
+      if (node.is_leaf ()) {
+        // The key is at the start of the leaf.
+        db.prefetch (node.to_address (), sizeof (key_type), hint);
+        return;
+      }
+      // The number of children in a branch isn't known until its bitmap has been read, so we
+      // fetch enough to cover the largest possible node. Linear nodes are handled in the same
+      // way.
+      db.prefetch (node.untag_address<branch> ().to_address (),
+                   branch::size_bytes (details::hash_size), hint);
+    }
+
     // make begin iterator
     // ~~~~~~~~~~~~~~~~~~~
     template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
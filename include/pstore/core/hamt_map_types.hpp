@@ -26,6 +26,7 @@
 #include "peejay/arrayvec.hpp"
 
 // pstore
+#include "pstore/adt/arena.hpp"
 #include "pstore/adt/chunked_sequence.hpp"
 #include "pstore/core/db_archive.hpp"
 
@@ -110,10 +111,29 @@ namespace pstore {
     PSTORE_STATIC_ASSERT (offsetof (header_block, size) == 8);
     PSTORE_STATIC_ASSERT (offsetof (header_block, root) == 16);
 
+    /// Describes the store space that has been set aside for a pending index flush. An
+    /// instance is returned by hamt_map::reserve_flush() and is consumed by the matching
+    /// call to hamt_map::flush().
+    struct flush_reservation {
+      /// The address of the first byte of the reserved space.
+      address first = address::null ();
+      /// The number of bytes reserved.
+      std::uint64_t size = 0;
+    };
+
     namespace details {
 
       constexpr std::size_t not_found = std::numeric_limits<std::size_t>::max ();
 
+      /// Index flushes which will write at least this number of bytes are performed using
+      /// multiple threads. Smaller flushes are not worth the cost of starting them.
+      constexpr std::uint64_t parallel_flush_threshold = std::uint64_t{256} * 1024;
+
+      /// The number of lookups whose descents of the tree are interleaved by
+      /// hamt_map::find_many(). This is enough to keep several memory requests in flight
+      /// without the per-lookup state overflowing the processor's cache.
+      constexpr std::size_t find_many_width = 8;
+
       class branch;
       class linear_node;
 
@@ -305,7 +325,7 @@ namespace pstore {
         using const_iterator = address const *;
 
         void * operator new (std::size_t) = delete;
-        void operator delete (void * p);
+        void operator delete (void * p) = delete;
 
         linear_node (linear_node && rhs) noexcept = delete;
 
@@ -314,41 +334,55 @@ namespace pstore {
         linear_node & operator= (linear_node && rhs) noexcept = delete;
 
         /// \name Construction
+        /// In-heap linear nodes are allocated from an arena which is owned by the index.
+        /// They are never individually freed: the arena releases them en masse once the index
+        /// has been flushed.
         ///@{
 
         /// \brief Allocates a new linear node in memory and copy the contents of an
         /// existing node into it. The new node is allocated with sufficient storage for the
         /// child of the supplied node plus the number passed in the 'extra_children'
-        /// parameter.
+        /// parameter. If extra_children is non-zero, the node's capacity is grown
+        /// geometrically so that subsequent insertions can usually be made in place.
         ///
+        /// \param storage  The arena from which the new node is allocated.
         /// \param orig_node  A node whose contents will be copied into the newly allocated
         /// linear node.
         /// \param extra_children  The number of extra child for which space will be
         /// allocated. This number is added to the number of children in 'orig_node' in
         /// calculating the amount of storage to be allocated.
         /// \result  A pointer to the newly allocated linear node.
-        static std::unique_ptr<linear_node> allocate_from (linear_node const & orig_node,
-                                                           std::size_t extra_children);
+        static linear_node * allocate_from (arena & storage, linear_node const & orig_node,
+                                            std::size_t extra_children);
 
         /// \brief Allocates a new in-memory linear node based on the contents of an
         /// existing store node.
         ///
+        /// \param storage  The arena from which the new node is allocated.
         /// \param db The database from which the source node should be loaded.
         /// \param node A reference to the source node which may be either in-heap or
         /// in-store.
         /// \param extra_children The number of additional child nodes for which storage
         /// should be allocated.
         /// \result  A pointer to the newly allocated linear node.
-        static std::unique_ptr<linear_node>
-        allocate_from (database const & db, index_pointer const node, std::size_t extra_children);
+        static linear_node * allocate_from (arena & storage, database const & db,
+                                            index_pointer const node, std::size_t extra_children);
 
         /// \brief Allocates a new linear node in memory with sufficient space for two leaf
         /// addresses.
         ///
+        /// \param storage  The arena from which the new node is allocated.
         /// \param a  The first leaf address for the new linear node.
         /// \param b  The second leaf address for the new linear node.
         /// \result  A pointer to the newly allocated linear node.
-        static std::unique_ptr<linear_node> allocate (address a, address b);
+        static linear_node * allocate (arena & storage, address a, address b);
+
+        /// \brief Allocates a new linear node in memory containing the given leaf addresses.
+        ///
+        /// \param storage  The arena from which the new node is allocated.
+        /// \param leaves  The leaf addresses for the new linear node.
+        /// \result  A pointer to the newly allocated linear node.
+        static linear_node * allocate (arena & storage, gsl::span<address const> leaves);
 
         /// \brief Returns a pointer to a linear node which may be in-heap or in-store.
         ///
@@ -400,6 +434,21 @@ namespace pstore {
         bool empty () const { return size_ == 0; }
         /// Returns the number of elements.
         std::size_t size () const { return size_; }
+        /// Returns the number of elements for which storage is available. Must only be
+        /// called on an in-heap node.
+        std::size_t capacity () const noexcept;
+        ///@}
+
+        /// \name Modifiers
+        /// These functions must only be called on an in-heap node.
+        ///@{
+
+        /// Appends \p leaf to the node if its capacity permits.
+        /// \returns True if the leaf was added, false if the node is full.
+        bool try_push_back (address leaf) noexcept;
+        /// Replaces the node's children with \p leaves if its capacity permits.
+        /// \returns True if the node was updated, false if its capacity is too small.
+        bool try_assign (gsl::span<address const> leaves) noexcept;
         ///@}
 
         /// \name Storage
@@ -416,11 +465,13 @@ namespace pstore {
         }
         ///@}
 
-        /// Write this linear node to the store.
+        /// Write this linear node to previously allocated storage.
         ///
-        /// \param transaction The transaction to which the linear node will be appended.
+        /// \param transaction The transaction to which the linear node will be written.
+        /// \param pos  On entry, the address at which the node will be written. On exit, the
+        ///   address immediately following it.
         /// \result The address at which the node was written.
-        address flush (transaction_base & transaction) const;
+        address flush (transaction_base & transaction, gsl::not_null<address *> pos) const;
 
         /// Search the linear node and return the child slot if the key exists.
         /// Otherwise, return the {nullptr, not_found} pair.
@@ -446,34 +497,39 @@ namespace pstore {
         using signature_type = std::array<std::uint8_t, 8>;
         static signature_type const node_signature_;
 
-        /// A placement-new implementation which allocates sufficient storage for a linear
-        /// node with the number of children given by the size parameter.
-        void * operator new (std::size_t s, nchildren size);
+        /// A placement-new implementation which allocates storage from an arena for a
+        /// linear node with the number of children given by the capacity parameter. The
+        /// capacity is recorded immediately before the node itself.
+        void * operator new (std::size_t s, arena & storage, nchildren capacity);
         // Non-allocating placement allocation functions.
         void * operator new (std::size_t const size, void * const ptr) noexcept {
           return ::operator new (size, ptr);
         }
 
-        void operator delete (void * p, nchildren size);
+        // Storage obtained from an arena is reclaimed when the arena is cleared.
+        void operator delete (void * /*p*/, arena & /*storage*/, nchildren /*capacity*/) noexcept {
+        }
         void operator delete (void * const p, void * const ptr) noexcept {
           ::operator delete (p, ptr);
         }
 
-        /// \param size The capacity of this linear node.
+        /// \param size The number of children of this linear node.
         explicit linear_node (std::size_t size);
         linear_node (linear_node const & rhs);
 
         /// Allocates a new linear node in memory.
         ///
-        /// \param num_children Sufficient space is allocated for the number of child nodes
-        ///   specified in this parameter.
+        /// \param storage  The arena from which the new node is allocated.
+        /// \param num_children The number of children in the new node.
+        /// \param capacity Sufficient space is allocated for the number of child nodes
+        ///   specified in this parameter. Must be at least \p num_children.
         /// \param from_node A node whose contents will be copied into the new node. If the
         ///   number of children requested is greater than the number of children in
         ///   from_node, the remaining entries are zeroed; if less then the child node
         ///   collection is truncated after the specified number of entries.
         /// \result A pointer to the newly allocated linear node.
-        static std::unique_ptr<linear_node> allocate (std::size_t num_children,
-                                                      linear_node const & from_node);
+        static linear_node * allocate (arena & storage, std::size_t num_children,
+                                       std::size_t capacity, linear_node const & from_node);
 
         signature_type signature_ = node_signature_;
         std::uint64_t size_;
@@ -516,6 +572,8 @@ namespace pstore {
         /// Construct the branch with two children.
         branch (index_pointer const & existing_leaf, index_pointer const & new_leaf,
                 hash_type existing_hash, hash_type new_hash);
+        /// Construct a branch from a bitmap and the corresponding collection of children.
+        branch (hash_type bitmap, gsl::span<index_pointer const> children);
 
         branch (branch const & rhs);
         branch (branch && rhs) = delete;
@@ -576,6 +634,22 @@ namespace pstore {
           return &container->emplace_back (existing_leaf, new_leaf, existing_hash, new_hash);
         }
 
+        /// Construct a branch with an arbitrary collection of children.
+        ///
+        /// \tparam SequenceContainer A container of branch instances which supports
+        ///   emplace_back().
+        /// \param container Points to the container which will own the new branch instance.
+        /// \param bitmap  The bitmap of occupied child slots. Must not be 0.
+        /// \param children  The child nodes. There must be one entry for each bit set in
+        ///   \p bitmap.
+        /// \returns A new instance of branch which is owned by *container.
+        template <typename SequenceContainer, typename = typename std::enable_if_t<std::is_same_v<
+                                                typename SequenceContainer::value_type, branch>>>
+        static branch * allocate (SequenceContainer * container, hash_type const bitmap,
+                                  gsl::span<index_pointer const> const children) {
+          return &container->emplace_back (bitmap, children);
+        }
+
         /// Return a pointer to a branch. If the node is in-store, it is loaded and
         /// the internal heap node pointer if \p node is a heap branch.
         /// Otherwise return the pointer which is pointed to the store node.
@@ -654,8 +728,38 @@ namespace pstore {
         void insert_child (hash_type const hash, index_pointer const leaf,
                            gsl::not_null<parent_stack *> parents);
 
-        /// Write an internal node and its children into a store.
-        address flush (transaction_base & transaction, unsigned shifts);
+        /// Replaces the bitmap and children of this internal node. The node must be
+        /// heap-resident (and thus have capacity for hash_size children).
+        ///
+        /// \param bitmap  The bitmap of occupied child slots. Must not be 0.
+        /// \param children  The child nodes. There must be one entry for each bit set in
+        ///   \p bitmap.
+        void assign (hash_type bitmap, gsl::span<index_pointer const> children);
+
+        /// Returns the number of bytes of store that a call to flush() will write for this
+        /// node and all of its heap-resident descendants.
+        ///
+        /// \param shifts  The number of hash bits consumed by the parents of this node.
+        std::uint64_t flush_size (unsigned shifts) const;
+
+        /// Write an internal node and its children into previously allocated storage.
+        /// Children are written before their parent so that the node itself is the last
+        /// record written.
+        ///
+        /// \param transaction  The transaction to which the nodes will be written.
+        /// \param pos  On entry, the address at which the first node will be written. On
+        ///   exit, the address immediately following the last node written. At least
+        ///   flush_size() bytes must have been allocated starting at this address.
+        /// \param shifts  The number of hash bits consumed by the parents of this node.
+        /// \result The (tagged) address of this node in the store.
+        address flush (transaction_base & transaction, gsl::not_null<address *> pos,
+                       unsigned shifts);
+
+        /// Equivalent to flush() except that the sub-tries rooted at each of this node's
+        /// heap-resident children are written concurrently. The layout of the resulting
+        /// data is identical to that produced by flush().
+        address flush_concurrently (transaction_base & transaction,
+                                    gsl::not_null<address *> pos, unsigned shifts);
 
 
         index_pointer const & operator[] (std::size_t const i) const {
@@ -688,9 +792,10 @@ namespace pstore {
       private:
         static bool validate_after_load (branch const & internal, typed_address<branch> const addr);
 
-        /// Appends the internal node (which refers to a node in heap memory) to the
-        /// store. Returns a new (in-store) internal store address.
-        address store_node (transaction_base & transaction) const;
+        /// Writes the internal node (which refers to a node in heap memory) to the
+        /// store at *pos and advances pos beyond it. Returns the new (in-store) internal
+        /// store address.
+        address store_node (transaction_base & transaction, gsl::not_null<address *> pos) const;
 
         using signature_type = std::array<std::uint8_t, 8>;
         static signature_type const node_signature_;
@@ -163,6 +163,24 @@ namespace pstore {
         return map_.flush (transaction, generation);
       }
 
+      /// Allocates the store space that will be needed to flush the set. See
+      /// hamt_map::reserve_flush().
+      flush_reservation reserve_flush (transaction_base & transaction) const {
+        return map_.reserve_flush (transaction);
+      }
+
+      /// Flush any modified index nodes to space previously allocated by reserve_flush().
+      ///
+      /// \param transaction  The transaction to which the set will be written.
+      /// \param reservation  The space allocated by reserve_flush().
+      /// \param generation The generation number to which the set will be written.
+      /// \returns The address of the index root node.
+      typed_address<header_block> flush (transaction_base & transaction,
+                                         flush_reservation const & reservation,
+                                         unsigned generation) {
+        return map_.flush (transaction, reservation, generation);
+      }
+
       /// \name Accessors
       /// Provide access to index internals.
       ///@{
@@ -0,0 +1,139 @@
+//===- include/pstore/core/index_snapshot_cache.hpp -------*- mode: C++ -*-===//
+//*  _           _                                       _           _    *
+//* (_)_ __   __| | _____  __  ___ _ __   __ _ _ __  ___| |__   ___ | |_  *
+//* | | '_ \ / _` |/ _ \ \/ / / __| '_ \ / _` | '_ \/ __| '_ \ / _ \| __| *
+//* | | | | | (_| |  __/>  <  \__ \ | | | (_| | |_) \__ \ | | | (_) | |_  *
+//* |_|_| |_|\__,_|\___/_/\_\ |___/_| |_|\__,_| .__/|___/_| |_|\___/ \__| *
+//*                                           |_|                         *
+//*                 _           *
+//*   ___ __ _  ___| |__   ___  *
+//*  / __/ _` |/ __| '_ \ / _ \ *
+//* | (_| (_| | (__| | | |  __/ *
+//*  \___\__,_|\___|_| |_|\___| *
+//*                             *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file index_snapshot_cache.hpp
+/// \brief A bounded cache of read-only index instances keyed by their location in the store.
+///
+/// The database's regular index cache (see database::get_mutable_index()) holds a single,
+/// mutable, instance of each index for the current revision and is not safe for concurrent
+/// use. This cache instead holds immutable index instances. Because the store is append-only,
+/// the address of an index's header block uniquely identifies its contents: that address is
+/// used as the key. Readers at any revision may share a database instance and query the
+/// cache concurrently without taking a lock.
+///
+/// Each loaded index owns a chunk of memory for its in-memory nodes, so the cache holds only
+/// a small number of instances of each index kind. When it is full, an instance which has not
+/// been found since the previous eviction is discarded (the "CLOCK" approximation of least
+/// recently used). An evicted instance remains valid for as long as a caller holds a
+/// reference to it.
+
+#ifndef PSTORE_CORE_INDEX_SNAPSHOT_CACHE_HPP
+#define PSTORE_CORE_INDEX_SNAPSHOT_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "pstore/core/file_header.hpp"
+#include "pstore/core/hamt_map_fwd.hpp"
+
+namespace pstore::index {
+
+  class snapshot_cache {
+  public:
+    /// The default number of instances of each index kind that are held by the cache.
+    static constexpr std::size_t default_capacity = 8U;
+
+    /// \param capacity  The maximum number of instances of each index kind held by the cache.
+    explicit snapshot_cache (std::size_t capacity = default_capacity);
+    snapshot_cache (snapshot_cache const &) = delete;
+    snapshot_cache (snapshot_cache &&) = delete;
+    ~snapshot_cache () noexcept = default;
+
+    snapshot_cache & operator= (snapshot_cache const &) = delete;
+    snapshot_cache & operator= (snapshot_cache &&) = delete;
+
+    /// Searches the cache for the index of kind \p which whose header block is at \p location.
+    /// May be called concurrently with other calls to find() and insert(). Takes no lock.
+    ///
+    /// \param which  The kind of index to be found.
+    /// \param location  The address of the index's header block.
+    /// \returns The cached index instance or nullptr if there is none.
+    std::shared_ptr<index_base const> find (trailer::indices which, address location) const;
+
+    /// Adds an index to the cache, evicting an instance of the same kind which has not recently
+    /// been found if the cache is full. If another thread has concurrently added an index for
+    /// the same location, that instance is retained and returned: all callers therefore agree
+    /// on a single instance for each location while it is cached. May be called concurrently
+    /// with other calls to find() and insert().
+    ///
+    /// \param which  The kind of index being added.
+    /// \param location  The address of the index's header block.
+    /// \param index  The index instance to be cached.
+    /// \returns The instance held by the cache for \p location.
+    std::shared_ptr<index_base const> insert (trailer::indices which, address location,
+                                              std::shared_ptr<index_base const> index);
+
+    /// Discards all of the cached instances. Must not be called concurrently with any other
+    /// member function.
+    void clear () noexcept;
+
+  private:
+    /// An entry in the cache. Nodes are owned by the cache and are reused rather than freed
+    /// so that a reader which loads a pointer to a node from a slot may safely access it even
+    /// if the node is concurrently evicted.
+    struct node {
+      /// The address of the index's header block. Atomic so that readers can compare it before
+      /// they have established that the node is in a slot.
+      std::atomic<address> location{address::null ()};
+      /// The index instance. Written by insert() only whilst the node is in no slot and has no
+      /// readers.
+      std::shared_ptr<index_base const> index;
+      /// Set by find() when it returns this node; cleared by insert() as it looks for a node to
+      /// evict.
+      mutable std::atomic<bool> referenced{false};
+      /// The number of calls to find() which are reading this node.
+      mutable std::atomic<unsigned> readers{0U};
+      /// True if the node is in a slot. Guarded by insert_mut_.
+      bool in_slot = false;
+    };
+
+    /// The cache entries for one index kind.
+    struct kind {
+      /// The nodes which may be found. Only insert() stores to a slot.
+      std::vector<std::atomic<node *>> slots;
+      /// Owns the nodes used by this kind: those in a slot and those available for reuse.
+      /// Guarded by insert_mut_.
+      std::vector<std::unique_ptr<node>> pool;
+      /// The slot at which the next search for a node to evict starts. Guarded by insert_mut_.
+      std::size_t hand = 0;
+    };
+
+    /// Returns the index held by the node in \p k with the given location or nullptr if there
+    /// is none.
+    static std::shared_ptr<index_base const> search (kind const & k, address location);
+    /// Returns a node from the pool of \p k which is in no slot and has no readers, creating
+    /// one if necessary. Discards the indices held by evicted nodes which have no readers.
+    static node * spare_node (kind & k);
+
+    std::array<kind, static_cast<unsigned> (trailer::indices::last)> kinds_;
+    /// Serializes calls to insert() so that the check for an existing node and the choice of
+    /// the node to be evicted are made atomically.
+    std::mutex insert_mut_;
+  };
+
+} // end namespace pstore::index
+
+#endif // PSTORE_CORE_INDEX_SNAPSHOT_CACHE_HPP
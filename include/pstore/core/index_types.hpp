@@ -93,11 +93,10 @@ namespace pstore {
     using fragment_index = hamt_map<digest, extent<repo::fragment>, u128_hash>;
     using write_index = hamt_map<std::string, extent<char>>;
 
+    /// The hash function used by the name and path indices. Each leaf of these indices
+    /// records the hash of its string so that the string body need not be read to compute it.
     struct fnv_64a_hash_indirect_string {
-      std::uint64_t operator() (indirect_string const & indir) const {
-        shared_sstring_view owner;
-        return fnv_64a_hash () (indir.as_string_view (&owner));
-      }
+      std::uint64_t operator() (indirect_string const & indir) const { return indir.hash (); }
     };
 
     using name_index = hamt_set<indirect_string, fnv_64a_hash_indirect_string>;
@@ -118,6 +117,9 @@ namespace pstore {
 
     /// Returns a pointer to a index, loading it from the store on first access. If 'create' is
     /// false and the index does not already exist then nullptr is returned.
+    ///
+    /// \note The database holds a single mutable instance of each index. This function is not
+    /// thread-safe: concurrent readers should use get_index_snapshot() instead.
     template <pstore::trailer::indices Index, typename Database = pstore::database,
               typename Return = inherit_const_t<Database, typename enum_to_index<Index>::type>>
     std::shared_ptr<Return> get_index (Database & db, bool const create = true) {
@@ -146,6 +148,53 @@ namespace pstore {
       return std::static_pointer_cast<Return> (dx);
     }
 
+    /// Returns a read-only instance of an index as it was in the revision whose trailer is at
+    /// \p footer_pos. Instances are shared through the database's snapshot cache, so this
+    /// function may be called concurrently by many threads using the same database object
+    /// (unlike get_index() which returns the database's single mutable index instance).
+    ///
+    /// \tparam Index  The kind of index to be returned.
+    /// \param db  The owning database.
+    /// \param footer_pos  The address of the trailer of the revision to be read. This may be
+    ///   obtained from database::older_revision_footer_pos().
+    /// \returns The index or nullptr if the revision does not contain an index of this kind.
+    template <pstore::trailer::indices Index>
+    std::shared_ptr<typename enum_to_index<Index>::type const>
+    get_index_snapshot (database const & db, typed_address<trailer> const footer_pos) {
+      using index_type = typename enum_to_index<Index>::type;
+      std::shared_ptr<trailer const> const footer = db.getro (footer_pos);
+      typed_address<index::header_block> const location = footer->a.index_records.at (
+        static_cast<typename std::underlying_type_t<decltype (Index)>> (Index));
+      if (location == decltype (location)::null ()) {
+        return nullptr;
+      }
+
+      snapshot_cache & cache = db.get_index_snapshots ();
+      std::shared_ptr<index_base const> snapshot = cache.find (Index, location.to_address ());
+      if (snapshot == nullptr) {
+        // Load the index. If another thread races us to do the same, insert() returns the
+        // instance that won.
+        snapshot = cache.insert (Index, location.to_address (),
+                                 std::make_shared<index_type const> (db, location));
+      }
+#ifdef PSTORE_CPP_RTTI
+      PSTORE_ASSERT (dynamic_cast<index_type const *> (snapshot.get ()) != nullptr);
+#endif
+      return std::static_pointer_cast<index_type const> (snapshot);
+    }
+
+    /// Returns a read-only instance of an index as it is in the database's current revision.
+    /// May be called concurrently by many threads using the same database object.
+    ///
+    /// \tparam Index  The kind of index to be returned.
+    /// \param db  The owning database.
+    /// \returns The index or nullptr if the revision does not contain an index of this kind.
+    template <pstore::trailer::indices Index>
+    std::shared_ptr<typename enum_to_index<Index>::type const>
+    get_index_snapshot (database const & db) {
+      return get_index_snapshot<Index> (db, db.footer_pos ());
+    }
+
     /// Write out any indices that have changed. Any that haven't will
     /// continue to point at their previous incarnation. Update the
     /// members of the 'locations' array.
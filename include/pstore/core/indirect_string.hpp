@@ -21,6 +21,7 @@
 
 #include "pstore/core/sstring_view_archive.hpp"
 #include "pstore/core/database.hpp"
+#include "pstore/support/fnv.hpp"
 
 namespace pstore {
 
@@ -42,6 +43,11 @@ namespace pstore {
   ///
   /// The use of the LBS of the address field to distinguish between in-heap and in-store
   /// addresses means that the in-store string bodies must be 2-byte aligned.
+  ///
+  /// When an indirect_string is written to the store (as a name or path index leaf), the
+  /// FNV-1a hash of its body is recorded immediately after the address. Instances read from
+  /// the store carry this hash so that index lookups can reject a mismatched leaf and compute
+  /// its hash without reading the string body.
   class indirect_string {
     friend struct serialize::serializer<indirect_string>;
 
@@ -50,11 +56,13 @@ namespace pstore {
             : db_{db}
             , is_pointer_{false}
             , address_{addr.absolute ()} {}
-    constexpr indirect_string (database const & db,
-                               gsl::not_null<raw_sstring_view const *> const str) noexcept
+    indirect_string (database const & db,
+                     gsl::not_null<raw_sstring_view const *> const str) noexcept
             : db_{db}
             , is_pointer_{true}
-            , str_{str} {
+            , has_hash_{true}
+            , str_{str}
+            , hash_{fnv_64a_hash () (*str)} {
       PSTORE_ASSERT ((reinterpret_cast<std::uintptr_t> (str.get ()) & in_heap_mask) == 0);
     }
 
@@ -66,6 +74,16 @@ namespace pstore {
 
     std::size_t length () const;
 
+    /// Returns the FNV-1a hash of the string body. The body is only read if the hash was not
+    /// recorded when this instance was created.
+    std::uint64_t hash () const {
+      if (has_hash_) {
+        return hash_;
+      }
+      shared_sstring_view owner;
+      return fnv_64a_hash () (this->as_string_view (&owner));
+    }
+
     /// When it is known that the string body is a store address use this function to carry out
     /// additional checks that the address is reasonable.
     raw_sstring_view as_db_string_view (gsl::not_null<shared_sstring_view *> const owner) const {
@@ -108,6 +126,15 @@ namespace pstore {
 
   private:
     static constexpr std::uint64_t in_heap_mask = 0x01;
+
+    constexpr indirect_string (database const & db, address const addr,
+                               std::uint64_t const hash) noexcept
+            : db_{db}
+            , is_pointer_{false}
+            , has_hash_{true}
+            , address_{addr.absolute ()}
+            , hash_{hash} {}
+
     bool equal_contents (indirect_string const & rhs) const;
 
     database const & db_;
@@ -116,10 +143,13 @@ namespace pstore {
     /// address_ field points to the string body in the store unless (address_ & in_heap_mask)
     /// in which case it is the heap address of the string.
     bool is_pointer_;
+    /// True if hash_ holds the hash of the string body.
+    bool has_hash_ = false;
     union {
       address::value_type address_;  ///< The in-store/in-heap string address.
       raw_sstring_view const * str_; ///< The address of the in-heap string.
     };
+    std::uint64_t hash_ = 0;
   };
 
   template <typename OStream>
@@ -133,12 +163,20 @@ namespace pstore {
 
     /// \brief A serializer for indirect_string.
     ///
-    /// Note that this reads and writes an address: the body of the string must be read and
-    /// written separately. For writing, see indirect_string::write_body_and_patch_address().
+    /// Note that this reads and writes an address and the hash of the string body: the body
+    /// of the string must be read and written separately. For writing, see
+    /// indirect_string::write_body_and_patch_address().
     template <>
     struct serializer<indirect_string> {
       using value_type = indirect_string;
 
+      /// The in-store representation of an indirect_string. The address must come first:
+      /// a typed_address<indirect_string> is read as a pointer to the string body.
+      struct record {
+        address body;
+        std::uint64_t hash;
+      };
+
       /// \brief Writes an instance of `indirect_string` to an archiver.
       ///
       /// \param archive  The Archiver to which the string will be written.
@@ -170,14 +208,17 @@ namespace pstore {
         constexpr auto mask = indirect_string::in_heap_mask;
         PSTORE_ASSERT (!(reinterpret_cast<std::uintptr_t> (value.str_) & mask));
 
-        return archive.put (address{reinterpret_cast<std::uintptr_t> (value.str_) | mask});
+        PSTORE_ASSERT (value.has_hash_);
+        return archive.put (
+          record{address{reinterpret_cast<std::uintptr_t> (value.str_) | mask}, value.hash_});
       }
 
       template <typename DBArchive>
       static void read_string_address (DBArchive & archive, value_type & value) {
         database const & db = archive.get_db ();
-        new (&value)
-          value_type (db, *db.getrou (typed_address<address>::make (archive.get_address ())));
+        std::shared_ptr<record const> const r =
+          db.getrou (typed_address<record>::make (archive.get_address ()));
+        new (&value) value_type (db, r->body, r->hash);
       }
     };
 
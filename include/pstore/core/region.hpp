@@ -53,8 +53,11 @@ namespace pstore::region {
     /// \param full_size The number of bytes in a "full size" memory-mapped region.
     /// \param minimum_size The number of bytes in a "minimum size" memory-mapped
     /// region.
+    /// \param policy The hints passed to each memory mapper that is created. Ignored if
+    /// MemoryMapper does not accept a mapping policy.
     region_builder (std::shared_ptr<File> file, std::uint64_t full_size,
-                    std::uint64_t minimum_size) noexcept;
+                    std::uint64_t minimum_size,
+                    mapping_policy const & policy = mapping_policy{}) noexcept;
     // No assignment or copying.
     region_builder (region_builder const &) = delete;
     region_builder (region_builder &&) noexcept = delete;
@@ -99,6 +102,8 @@ namespace pstore::region {
     std::uint64_t const full_size_;
     ///< The number of bytes in a "minimum size" memory-mapped region.
     std::uint64_t const minimum_size_;
+    /// The hints used when memory-mapping the file.
+    mapping_policy const policy_;
   };
 
   // region builder
@@ -106,10 +111,12 @@ namespace pstore::region {
   template <typename File, typename MemoryMapper>
   region_builder<File, MemoryMapper>::region_builder (std::shared_ptr<File> file,
                                                       std::uint64_t const full_size,
-                                                      std::uint64_t const minimum_size) noexcept
+                                                      std::uint64_t const minimum_size,
+                                                      mapping_policy const & policy) noexcept
           : file_ (file)
           , full_size_ (full_size)
-          , minimum_size_ (minimum_size) {
+          , minimum_size_ (minimum_size)
+          , policy_ (policy) {
 
     PSTORE_ASSERT (full_size >= minimum_size && full_size_ % minimum_size_ == 0);
   }
@@ -160,8 +167,14 @@ namespace pstore::region {
     PSTORE_ASSERT (size >= minimum_size_);
     // (Note that we separately make pages read-only to guard against writing to committed
     // transactions: that's done by database::protect() rather than here.)
-    regions->push_back (
-      std::make_shared<MemoryMapper> (*file_, file_->is_writable (), offset, size));
+    if constexpr (std::is_constructible_v<MemoryMapper, File &, bool, std::uint64_t,
+                                          std::uint64_t, mapping_policy const &>) {
+      regions->push_back (std::make_shared<MemoryMapper> (*file_, file_->is_writable (), offset,
+                                                          size, policy_));
+    } else {
+      regions->push_back (
+        std::make_shared<MemoryMapper> (*file_, file_->is_writable (), offset, size));
+    }
   }
 
   // check regions are contiguous
@@ -233,12 +246,15 @@ namespace pstore::region {
     }
 
     template <typename File, typename MemoryMapper>
-    auto create (std::shared_ptr<File> file) const -> std::vector<memory_mapper_ptr>;
+    auto create (std::shared_ptr<File> file,
+                 mapping_policy const & policy = mapping_policy{}) const
+      -> std::vector<memory_mapper_ptr>;
 
     template <typename File, typename MemoryMapper>
     void append (std::shared_ptr<File> file,
                  gsl::not_null<std::vector<memory_mapper_ptr> *> regions,
-                 std::uint64_t original_size, std::uint64_t new_size) const;
+                 std::uint64_t original_size, std::uint64_t new_size,
+                 mapping_policy const & policy = mapping_policy{}) const;
 
   private:
     std::uint64_t const full_size_;
@@ -248,14 +264,16 @@ namespace pstore::region {
   // create
   // ~~~~~~
   template <typename File, typename MemoryMapper>
-  auto factory::create (std::shared_ptr<File> file) const -> std::vector<memory_mapper_ptr> {
+  auto factory::create (std::shared_ptr<File> file, mapping_policy const & policy) const
+    -> std::vector<memory_mapper_ptr> {
 
     // There's no lock on the file when we call the size() method here. However, the file
     // is only allowed to grow so if it changes then the worst outcome is that we end up
     // memory mapping more of it beyond the logical size.
 
     std::uint64_t const file_size = file->size ();
-    region_builder<File, MemoryMapper> builder (file, this->full_size (), this->min_size ());
+    region_builder<File, MemoryMapper> builder (file, this->full_size (), this->min_size (),
+                                                policy);
     return builder (file_size);
   }
 
@@ -264,12 +282,13 @@ namespace pstore::region {
   template <typename File, typename MemoryMapper>
   void factory::append (std::shared_ptr<File> file,
                         gsl::not_null<std::vector<memory_mapper_ptr> *> regions,
-                        std::uint64_t original_size, std::uint64_t new_size) const {
+                        std::uint64_t original_size, std::uint64_t new_size,
+                        mapping_policy const & policy) const {
 
     PSTORE_ASSERT (new_size >= original_size);
 
     auto const min_size = this->min_size ();
-    region_builder<File, MemoryMapper> builder (file, this->full_size (), min_size);
+    region_builder<File, MemoryMapper> builder (file, this->full_size (), min_size, policy);
 
     new_size = round_up (new_size, min_size);
     if (!small_files_enabled ()) {
@@ -289,8 +308,10 @@ namespace pstore::region {
     /// \param file An open file containing the data to be memory-mapped.
     /// \param full_size  The size of the largest memory-mapped file region.
     /// \param min_size  The size of the smallest memory-mapped file region.
+    /// \param policy  Hints controlling the way in which the file is memory-mapped.
     explicit file_based_factory (std::shared_ptr<file::file_handle> file, std::uint64_t full_size,
-                                 std::uint64_t min_size);
+                                 std::uint64_t min_size,
+                                 mapping_policy const & policy = mapping_policy{});
 
     std::vector<memory_mapper_ptr> init () override;
     void add (gsl::not_null<std::vector<memory_mapper_ptr> *> regions, std::uint64_t original_size,
@@ -300,6 +321,7 @@ namespace pstore::region {
 
   private:
     std::shared_ptr<file::file_handle> file_;
+    mapping_policy const policy_;
   };
 
 
@@ -328,7 +350,8 @@ namespace pstore::region {
 
 
   std::unique_ptr<factory> get_factory (std::shared_ptr<file::file_handle> const & file,
-                                        std::uint64_t full_size, std::uint64_t min_size);
+                                        std::uint64_t full_size, std::uint64_t min_size,
+                                        mapping_policy const & policy = mapping_policy{});
 
   std::unique_ptr<factory> get_factory (std::shared_ptr<file::in_memory> const & file,
                                         std::uint64_t full_size, std::uint64_t min_size);
@@ -0,0 +1,151 @@
+//===- include/pstore/core/scatter_view.hpp ---------------*- mode: C++ -*-===//
+//*                _   _                    _                *
+//*  ___  ___ __ _| |_| |_ ___ _ __  __   _(_) _____      __ *
+//* / __|/ __/ _` | __| __/ _ \ '__| \ \ / / |/ _ \ \ /\ / / *
+//* \__ \ (_| (_| | |_| ||  __/ |     \ V /| |  __/\ V  V /  *
+//* |___/\___\__,_|\__|\__\___|_|      \_/ |_|\___| \_/\_/   *
+//*                                                          *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file scatter_view.hpp
+/// \brief A read-only view of store data which may be split across memory-mapped regions.
+
+#ifndef PSTORE_CORE_SCATTER_VIEW_HPP
+#define PSTORE_CORE_SCATTER_VIEW_HPP
+
+#include <cstring>
+#include <iterator>
+
+#include "pstore/adt/small_vector.hpp"
+#include "pstore/support/assert.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore {
+
+  /// A read-only view of a range of bytes in the store. Unlike the pointers returned by
+  /// database::getro(), which must copy data that spans more than one memory-mapped region
+  /// into a temporary heap block, a scatter_view simply records the contiguous pieces of the
+  /// range. Constructing and using a view does not allocate unless the range spans more than
+  /// two regions.
+  ///
+  /// \note A view does not own the memory to which it refers. It remains valid for as long as
+  /// the database from which it was obtained is open.
+  class scatter_view {
+  public:
+    using span_type = gsl::span<std::uint8_t const>;
+    using container = small_vector<span_type, 2>;
+    using const_iterator = container::const_iterator;
+
+    class byte_iterator;
+
+    /// Appends a piece to the end of the view.
+    void append (span_type const s) {
+      PSTORE_ASSERT (s.size () > 0);
+      spans_.push_back (s);
+      size_ += static_cast<std::size_t> (s.size ());
+    }
+
+    /// \name Pieces
+    /// Iteration over the contiguous pieces that make up the view.
+    ///@{
+    const_iterator begin () const noexcept { return spans_.begin (); }
+    const_iterator end () const noexcept { return spans_.end (); }
+    /// Returns the number of contiguous pieces that make up the view.
+    std::size_t pieces () const noexcept { return spans_.size (); }
+    ///@}
+
+    /// \name Bytes
+    /// Iteration over the individual bytes of the view.
+    ///@{
+    byte_iterator bytes_begin () const noexcept;
+    byte_iterator bytes_end () const noexcept;
+    ///@}
+
+    /// Returns the total number of bytes covered by the view.
+    std::size_t size () const noexcept { return size_; }
+    /// Returns true if the view is empty.
+    bool empty () const noexcept { return size_ == 0U; }
+    /// Returns true if the view consists of no more than a single piece.
+    bool is_contiguous () const noexcept { return spans_.size () <= 1U; }
+
+    /// Copies the contents of the view to the memory starting at \p dest which must be at least
+    /// size() bytes long.
+    void copy (void * const dest) const noexcept {
+      auto * out = static_cast<std::uint8_t *> (dest);
+      for (span_type const & s : spans_) {
+        std::memcpy (out, s.data (), static_cast<std::size_t> (s.size ()));
+        out += s.size ();
+      }
+    }
+
+  private:
+    container spans_;
+    std::size_t size_ = 0;
+  };
+
+  //*  _         _         _ _                _             *
+  //* | |__ _  _| |_ ___  (_) |_ ___ _ _ __ _| |_ ___ _ _   *
+  //* | '_ \ || |  _/ -_) | |  _/ -_) '_/ _` |  _/ _ \ '_|  *
+  //* |_.__/\_, |\__\___| |_|\__\___|_| \__,_|\__\___/_|    *
+  //*       |__/                                            *
+  /// A forward iterator which visits each of the bytes in a scatter_view in turn.
+  class scatter_view::byte_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::uint8_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::uint8_t const *;
+    using reference = std::uint8_t const &;
+
+    byte_iterator () noexcept = default;
+    byte_iterator (const_iterator const it, const_iterator const end) noexcept
+            : it_{it}
+            , end_{end} {}
+
+    bool operator== (byte_iterator const & rhs) const noexcept {
+      return it_ == rhs.it_ && pos_ == rhs.pos_;
+    }
+    bool operator!= (byte_iterator const & rhs) const noexcept { return !operator== (rhs); }
+
+    reference operator* () const noexcept {
+      PSTORE_ASSERT (it_ != end_ && pos_ < it_->size ());
+      return (*it_)[pos_];
+    }
+    pointer operator-> () const noexcept { return &operator* (); }
+
+    byte_iterator & operator++ () noexcept {
+      PSTORE_ASSERT (it_ != end_);
+      if (++pos_ >= it_->size ()) {
+        ++it_;
+        pos_ = 0;
+      }
+      return *this;
+    }
+    byte_iterator operator++ (int) noexcept {
+      auto const prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+  private:
+    const_iterator it_{};
+    const_iterator end_{};
+    span_type::index_type pos_ = 0;
+  };
+
+  inline auto scatter_view::bytes_begin () const noexcept -> byte_iterator {
+    return {spans_.begin (), spans_.end ()};
+  }
+  inline auto scatter_view::bytes_end () const noexcept -> byte_iterator {
+    return {spans_.end (), spans_.end ()};
+  }
+
+} // end namespace pstore
+
+#endif // PSTORE_CORE_SCATTER_VIEW_HPP
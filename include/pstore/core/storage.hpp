@@ -74,11 +74,12 @@ namespace pstore {
             , regions_{region_factory_->init ()} {}
 
     template <typename File>
-    explicit storage (std::shared_ptr<File> const & file)
+    explicit storage (std::shared_ptr<File> const & file,
+                      mapping_policy const & policy = mapping_policy{})
             : file_{std::static_pointer_cast<file::file_base> (file)}
             , region_factory_{region::get_factory (
                 std::static_pointer_cast<file::file_handle> (file), full_region_size,
-                min_region_size)}
+                min_region_size, policy)}
             , regions_{region_factory_->init ()} {}
 
     file::file_base * file () noexcept { return file_.get (); }
@@ -131,6 +132,17 @@ namespace pstore {
     void copy (address addr, std::size_t size, typename Traits::temp_pointer p,
                Function copier) const;
 
+    /// Breaks the address range [addr, addr+size) into the largest possible pieces each of which
+    /// lies within a single memory-mapped region and calls \p fn for each of them in order.
+    ///
+    /// \tparam InStorePointer  Either std::uint8_t * or std::uint8_t const *.
+    /// \param addr  The store address of the first byte of the range.
+    /// \param size  The number of bytes in the range.
+    /// \param fn  A function which will be called with two arguments: an InStorePointer to the
+    ///   start of a piece of the range and an std::uint64_t giving its size in bytes.
+    template <typename InStorePointer, typename Function>
+    void for_each_region (address addr, std::size_t size, Function fn) const;
+
     /// \brief Returns true if the given address range "spans" more than one region.
     ///
     /// \note The PSTORE_ALWAYS_SPANNING configure-time setting can cause this function to
@@ -304,9 +316,21 @@ namespace pstore {
   // copy
   // ~~~~
   template <typename Traits, typename Function>
-  void storage::copy (address const addr, std::size_t size, typename Traits::temp_pointer p,
+  void storage::copy (address const addr, std::size_t const size, typename Traits::temp_pointer p,
                       Function copier) const {
+    this->for_each_region<typename Traits::in_store_pointer> (
+      addr, size,
+      [&p, &copier] (typename Traits::in_store_pointer const in_store_ptr,
+                     std::uint64_t const copy_size) {
+        copier (in_store_ptr, p, copy_size);
+        p += copy_size;
+      });
+  }
 
+  // for each region
+  // ~~~~~~~~~~~~~~~
+  template <typename InStorePointer, typename Function>
+  void storage::for_each_region (address const addr, std::size_t size, Function fn) const {
     PSTORE_STATIC_ASSERT (std::numeric_limits<std::size_t>::max () <=
                           std::numeric_limits<std::uint64_t>::max ());
     address::segment_type segment = addr.segment ();
@@ -315,11 +339,8 @@ namespace pstore {
     PSTORE_ASSERT (segment_pointer.value != nullptr && segment_pointer.region != nullptr &&
                    segment_pointer.is_valid ());
 
-    auto in_store_ptr =
-      static_cast<typename Traits::in_store_pointer> (segment_pointer.value.get ()) +
-      addr.offset ();
-    auto region_base =
-      static_cast<typename Traits::in_store_pointer> (segment_pointer.region->data ().get ());
+    auto in_store_ptr = static_cast<InStorePointer> (segment_pointer.value.get ()) + addr.offset ();
+    auto region_base = static_cast<InStorePointer> (segment_pointer.region->data ().get ());
     PSTORE_ASSERT (in_store_ptr >= region_base &&
                    in_store_ptr <= region_base + segment_pointer.region->size ());
 
@@ -330,14 +351,12 @@ namespace pstore {
                    "size_t must not be larger than uint64!");
     copy_size = std::min (copy_size, std::uint64_t{size});
 
-    // An initial copy for the tail of the first of the regions covered by the addr..addr+size
-    // range.
-    copier (in_store_ptr, p, copy_size);
-
-    // Now copy the subsequent region(s).
-    for (p += copy_size, size -= copy_size; size > 0; p += copy_size, size -= copy_size) {
+    // The tail of the first of the regions covered by the addr..addr+size range.
+    fn (in_store_ptr, copy_size);
 
-      // We copied all of the necessary data to the previous region. Now move to the next
+    // Now the subsequent region(s).
+    for (size -= copy_size; size > 0; size -= copy_size) {
+      // We've visited all of the necessary data in the previous region. Now move to the next
       // region and do the same.
       std::uint64_t const inc = (copy_size + address::segment_size - 1) / address::segment_size;
       PSTORE_ASSERT (inc < std::numeric_limits<address::segment_type>::max ());
@@ -348,8 +367,8 @@ namespace pstore {
       PSTORE_ASSERT (region != nullptr);
 
       copy_size = std::min (static_cast<std::uint64_t> (size), region->size ());
-      in_store_ptr = static_cast<typename Traits::in_store_pointer> (region->data ().get ());
-      copier (in_store_ptr, p, copy_size);
+      in_store_ptr = static_cast<InStorePointer> (region->data ().get ());
+      fn (in_store_ptr, copy_size);
     }
   }
 
@@ -154,6 +154,42 @@ namespace pstore {
     }
     ///@}
 
+    ///@{
+    /// Allocates storage in the transaction and fills it with bytes copied from another file or
+    /// store. Where the operating system and file system permit, the data is moved by the
+    /// kernel (see file::copy_range()) without passing through user space. Otherwise, or for
+    /// whatever remains, the bytes are streamed directly into the newly allocated storage.
+
+    /// Copies \p size bytes starting at \p offset in \p file.
+    ///
+    /// \param file  The file from which the data is to be copied.
+    /// \param offset  The offset within \p file of the first byte to be copied.
+    /// \param size  The number of bytes to be copied.
+    /// \param align  The alignment of the newly allocated storage. Must be a power of 2.
+    /// \returns  The address of the copied data.
+    address copy_from (file::file_base & file, std::uint64_t offset, std::uint64_t size,
+                       unsigned align);
+
+    /// Copies the \p size bytes at \p addr in the \p source database.
+    ///
+    /// \param source  The database from which the data is to be copied.
+    /// \param addr  The address in \p source of the first byte to be copied.
+    /// \param size  The number of bytes to be copied.
+    /// \param align  The alignment of the newly allocated storage. Must be a power of 2.
+    /// \returns  The address of the copied data.
+    address copy_from (database const & source, address addr, std::uint64_t size,
+                       unsigned align);
+
+    /// Copies the data described by extent \p ex from the \p source database.
+    template <typename T>
+    extent<T> copy_from (database const & source, extent<T> const & ex,
+                         unsigned const align = alignof (T)) {
+      return make_extent (
+        typed_address<T>::make (this->copy_from (source, ex.addr.to_address (), ex.size, align)),
+        ex.size);
+    }
+    ///@}
+
     /// Returns the number of bytes allocated in this transaction.
     std::uint64_t size () const noexcept { return size_; }
 
@@ -0,0 +1,193 @@
+//===- include/pstore/exchange/binary_format.hpp ----------*- mode: C++ -*-===//
+//*  _     _                            __                            _    *
+//* | |__ (_)_ __   __ _ _ __ _   _    / _| ___  _ __ _ __ ___   __ _| |_  *
+//* | '_ \| | '_ \ / _` | '__| | | |  | |_ / _ \| '__| '_ ` _ \ / _` | __| *
+//* | |_) | | | | | (_| | |  | |_| |  |  _| (_) | |  | | | | | | (_| | |_  *
+//* |_.__/|_|_| |_|\__,_|_|   \__, |  |_|  \___/|_|  |_| |_| |_|\__,_|\__| *
+//*                           |___/                                        *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file binary_format.hpp
+/// \brief The layout of the binary exchange format.
+///
+/// The binary exchange format carries the same content as the JSON produced by
+/// export_ns::emit_database() but without the need to generate or parse text or to Base64
+/// encode section data. A file begins with a file_header and is followed by a sequence of
+/// records each of which is a record_header followed by its payload. The payload is padded with
+/// zeros to a multiple of record_alignment bytes so that a reader can consume the records in
+/// place from a memory-mapped file.
+///
+/// Each transaction is bracketed by transaction_begin and transaction_end records. Between them
+/// come, in order and each optional, the transaction's names, paths, debug line headers,
+/// fragments, and compilations. The last record in the file is an end record.
+///
+/// Values are stored in the byte order of the host which wrote the file: the header's
+/// signature2 field enables a reader to detect a mismatch.
+
+#ifndef PSTORE_EXCHANGE_BINARY_FORMAT_HPP
+#define PSTORE_EXCHANGE_BINARY_FORMAT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "pstore/core/index_types.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/generic_section.hpp"
+
+namespace pstore::exchange::binary {
+
+  constexpr std::array<std::uint8_t, 4> signature1{{'p', 'X', 'c', 'h'}};
+  constexpr std::uint32_t signature2 = 0x0507FFFF;
+  constexpr std::uint16_t version = 1;
+
+  /// The payload of each record is padded to a multiple of this number of bytes.
+  constexpr std::uint64_t record_alignment = 8U;
+
+  /// Returns \p size rounded up to the next multiple of record_alignment.
+  constexpr std::uint64_t padded_size (std::uint64_t const size) noexcept {
+    return (size + record_alignment - 1U) & ~(record_alignment - 1U);
+  }
+
+  struct file_header {
+    std::array<std::uint8_t, 4> signature1;
+    /// Written as binary::signature2. A file written on a host with different endianness will
+    /// produce a different value when read.
+    std::uint32_t signature2;
+    std::uint16_t version;
+    std::uint16_t padding1;
+    std::uint32_t padding2;
+    /// The ID of the exported database.
+    uuid::container_type id;
+  };
+  PSTORE_STATIC_ASSERT (offsetof (file_header, signature1) == 0);
+  PSTORE_STATIC_ASSERT (offsetof (file_header, signature2) == 4);
+  PSTORE_STATIC_ASSERT (offsetof (file_header, version) == 8);
+  PSTORE_STATIC_ASSERT (offsetof (file_header, padding1) == 10);
+  PSTORE_STATIC_ASSERT (offsetof (file_header, padding2) == 12);
+  PSTORE_STATIC_ASSERT (offsetof (file_header, id) == 16);
+  PSTORE_STATIC_ASSERT (sizeof (file_header) == 32);
+
+  enum class record_kind : std::uint32_t {
+    /// Begins a transaction. The payload is empty.
+    transaction_begin,
+    /// The strings added to the name index. The payload is a std::uint64_t count followed by
+    /// that number of strings. Each string is a std::uint64_t length followed by its bytes
+    /// padded to record_alignment. Other records refer to a name by its index in the
+    /// concatenation of all names records.
+    names,
+    /// The strings added to the path index. The payload has the same layout as a names record.
+    paths,
+    /// A debug line header: a digest followed by the header's bytes.
+    debug_line_header,
+    /// A fragment: a digest, a std::uint64_t section count, then each section as described by
+    /// section_header.
+    fragment,
+    /// A compilation: a digest, the std::uint64_t name index of the triple, a std::uint64_t
+    /// count, then that number of definition records.
+    compilation,
+    /// Ends a transaction and commits it. The payload is empty.
+    transaction_end,
+    /// Marks the end of the file. The payload is empty.
+    end,
+  };
+
+  struct record_header {
+    record_kind kind;
+    std::uint32_t padding;
+    /// The number of bytes in the payload, excluding any padding.
+    std::uint64_t size;
+  };
+  PSTORE_STATIC_ASSERT (offsetof (record_header, kind) == 0);
+  PSTORE_STATIC_ASSERT (offsetof (record_header, padding) == 4);
+  PSTORE_STATIC_ASSERT (offsetof (record_header, size) == 8);
+  PSTORE_STATIC_ASSERT (sizeof (record_header) == 16);
+
+  /// A digest stored as two 64-bit values. Unlike index::digest this type has no alignment
+  /// requirement beyond that of the payload.
+  struct digest {
+    digest () noexcept = default;
+    explicit constexpr digest (index::digest const & d) noexcept
+            : high{d.high ()}
+            , low{d.low ()} {}
+    constexpr index::digest get () const noexcept { return {high, low}; }
+
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+  };
+  PSTORE_STATIC_ASSERT (sizeof (digest) == 16);
+
+  /// Describes one section of a fragment. A section_header is followed by:
+  /// - for a debug line section, the digest of its header;
+  /// - for all but bss and linked-definitions sections, size bytes of data padded to
+  ///   record_alignment;
+  /// - num_ifixups instances of repo::internal_fixup;
+  /// - num_xfixups instances of binary::external_fixup;
+  /// - for a linked-definitions section, size instances of binary::linked_definition.
+  struct section_header {
+    repo::section_kind kind;
+    std::uint8_t padding1;
+    std::uint16_t padding2;
+    std::uint32_t align;
+    std::uint32_t num_ifixups;
+    std::uint32_t num_xfixups;
+    /// The number of bytes of data (or the size of a bss section, or the number of entries in
+    /// a linked-definitions section).
+    std::uint64_t size;
+  };
+  PSTORE_STATIC_ASSERT (offsetof (section_header, kind) == 0);
+  PSTORE_STATIC_ASSERT (offsetof (section_header, align) == 4);
+  PSTORE_STATIC_ASSERT (offsetof (section_header, num_ifixups) == 8);
+  PSTORE_STATIC_ASSERT (offsetof (section_header, num_xfixups) == 12);
+  PSTORE_STATIC_ASSERT (offsetof (section_header, size) == 16);
+  PSTORE_STATIC_ASSERT (sizeof (section_header) == 24);
+
+  /// An external fixup with its name replaced by an index into the names records.
+  struct external_fixup {
+    std::uint64_t name;
+    repo::relocation_type type;
+    std::uint8_t is_weak;
+    std::uint16_t padding1;
+    std::uint32_t padding2;
+    std::uint64_t offset;
+    std::int64_t addend;
+  };
+  PSTORE_STATIC_ASSERT (offsetof (external_fixup, name) == 0);
+  PSTORE_STATIC_ASSERT (offsetof (external_fixup, type) == 8);
+  PSTORE_STATIC_ASSERT (offsetof (external_fixup, is_weak) == 9);
+  PSTORE_STATIC_ASSERT (offsetof (external_fixup, offset) == 16);
+  PSTORE_STATIC_ASSERT (offsetof (external_fixup, addend) == 24);
+  PSTORE_STATIC_ASSERT (sizeof (external_fixup) == 32);
+
+  struct linked_definition {
+    digest compilation;
+    std::uint32_t index;
+    std::uint32_t padding;
+  };
+  PSTORE_STATIC_ASSERT (offsetof (linked_definition, compilation) == 0);
+  PSTORE_STATIC_ASSERT (offsetof (linked_definition, index) == 16);
+  PSTORE_STATIC_ASSERT (sizeof (linked_definition) == 24);
+
+  struct definition {
+    digest fragment;
+    std::uint64_t name;
+    repo::linkage linkage;
+    repo::visibility visibility;
+    std::uint16_t padding1;
+    std::uint32_t padding2;
+  };
+  PSTORE_STATIC_ASSERT (offsetof (definition, fragment) == 0);
+  PSTORE_STATIC_ASSERT (offsetof (definition, name) == 16);
+  PSTORE_STATIC_ASSERT (offsetof (definition, linkage) == 24);
+  PSTORE_STATIC_ASSERT (offsetof (definition, visibility) == 25);
+  PSTORE_STATIC_ASSERT (sizeof (definition) == 32);
+
+} // end namespace pstore::exchange::binary
+
+#endif // PSTORE_EXCHANGE_BINARY_FORMAT_HPP
@@ -28,6 +28,15 @@ namespace pstore::exchange::export_ns {
   // "namespace" to work around this restriction.
   void emit_database (database & db, ostream & os, bool comments);
 
+  /// Produces the same output as emit_database() but divides the work between a pool of
+  /// worker threads. \p db must be synced to the revision to be exported.
+  void emit_database_parallel (database const & db, ostream & os, bool comments);
+
+  /// Writes the contents of \p db to \p os using the binary exchange format. The output
+  /// carries the same content as emit_database() but is far smaller and faster to produce and
+  /// consume.
+  void emit_database_binary (database const & db, ostream_base & os);
+
 } // end namespace pstore::exchange::export_ns
 
 #endif // PSTORE_EXCHANGE_EXPORT_HPP
@@ -0,0 +1,107 @@
+//===- include/pstore/exchange/export_binary.hpp ----------*- mode: C++ -*-===//
+//*                             _    *
+//*   _____  ___ __   ___  _ __| |_  *
+//*  / _ \ \/ / '_ \ / _ \| '__| __| *
+//* |  __/>  <| |_) | (_) | |  | |_  *
+//*  \___/_/\_\ .__/ \___/|_|   \__| *
+//*           |_|                    *
+//*  _     _                         *
+//* | |__ (_)_ __   __ _ _ __ _   _  *
+//* | '_ \| | '_ \ / _` | '__| | | | *
+//* | |_) | | | | | (_| | |  | |_| | *
+//* |_.__/|_|_| |_|\__,_|_|   \__, | *
+//*                           |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file export_binary.hpp
+/// \brief Writes a database using the binary exchange format.
+
+#ifndef PSTORE_EXCHANGE_EXPORT_BINARY_HPP
+#define PSTORE_EXCHANGE_EXPORT_BINARY_HPP
+
+#include <vector>
+
+#include "pstore/exchange/binary_format.hpp"
+#include "pstore/exchange/export_ostream.hpp"
+#include "pstore/exchange/export_strings.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+
+namespace pstore::exchange::export_ns {
+
+  //*  _     _                                         _ _             *
+  //* | |__ (_)_ __   __ _ _ __ _   _   __      ___ __(_) |_ ___ _ __  *
+  //* | '_ \| | '_ \ / _` | '__| | | |  \ \ /\ / / '__| | __/ _ \ '__| *
+  //* | |_) | | | | | (_| | |  | |_| |   \ V  V /| |  | | ||  __/ |    *
+  //* |_.__/|_|_| |_|\__,_|_|   \__, |    \_/\_/ |_|  |_|\__\___|_|    *
+  //*                           |___/                                  *
+  /// Writes the contents of a database to an output stream using the binary exchange format
+  /// described in binary_format.hpp. The output is produced incrementally: the file header is
+  /// written by the constructor, each call to add_transaction() writes the records for a single
+  /// transaction, and finish() writes the record which marks the end of the file.
+  class binary_writer {
+  public:
+    binary_writer (database const & db, ostream_base & os);
+    binary_writer (binary_writer const &) = delete;
+    binary_writer (binary_writer &&) = delete;
+
+    ~binary_writer () noexcept = default;
+
+    binary_writer & operator= (binary_writer const &) = delete;
+    binary_writer & operator= (binary_writer &&) = delete;
+
+    /// Writes the records for the transaction whose trailer is at \p footer_pos. Transactions
+    /// must be added in order, starting with generation 1.
+    void add_transaction (typed_address<trailer> footer_pos);
+    /// Writes the end record.
+    void finish ();
+
+  private:
+    /// Writes a record whose payload is held in payload_.
+    void write_record (binary::record_kind kind);
+    /// Writes the header of a record whose payload is \p size bytes long.
+    void write_record_header (binary::record_kind kind, std::uint64_t size);
+    /// Writes the zero bytes which follow a payload of \p size bytes.
+    void write_padding (std::uint64_t size);
+
+    template <trailer::indices Index>
+    void write_strings (binary::record_kind kind, typed_address<trailer> footer_pos,
+                        unsigned generation, string_mapping * table);
+    void write_debug_line_headers (typed_address<trailer> footer_pos, unsigned generation);
+    void write_fragments (typed_address<trailer> footer_pos, unsigned generation);
+    void write_compilations (typed_address<trailer> footer_pos, unsigned generation);
+
+    void append_fragment (repo::fragment const & fragment);
+    void append_section (repo::section_kind kind, repo::generic_section const & section);
+    void append_section (repo::section_kind kind, repo::bss_section const & section);
+    void append_section (repo::section_kind kind, repo::debug_line_section const & section);
+    void append_section (repo::section_kind kind, repo::linked_definitions const & section);
+    void append_section_header (repo::section_kind kind, unsigned align, std::uint64_t size,
+                                std::size_t num_ifixups, std::size_t num_xfixups);
+    /// Appends the data and fixups of a generic or debug line section.
+    void append_contents (repo::container<std::uint8_t> const & data,
+                          repo::container<repo::internal_fixup> const & ifixups,
+                          repo::container<repo::external_fixup> const & xfixups);
+
+    template <typename T>
+    void append (T const & t);
+    void append_bytes (void const * ptr, std::size_t size);
+    void append_padding ();
+
+    database const & db_;
+    ostream_base & os_;
+    string_mapping names_;
+    string_mapping paths_;
+    /// The payload of the record being written. Retained between records to avoid repeated
+    /// allocations.
+    std::vector<std::byte> payload_;
+  };
+
+} // end namespace pstore::exchange::export_ns
+
+#endif // PSTORE_EXCHANGE_EXPORT_BINARY_HPP
@@ -53,6 +53,11 @@ namespace pstore {
         os.write (sp.data (), sp.length ());
       }
 
+      /// Returns a pointer to the first character in the range [first, last) which must be
+      /// escaped when written as part of a JSON string or \p last if there is no such
+      /// character. Where the host CPU allows, the search examines many characters at once.
+      char const * find_escape (char const * first, char const * last) noexcept;
+
     } // end namespace details
 
 
@@ -95,24 +100,24 @@ namespace pstore {
 
     void emit_digest (ostream_base & os, uint128 d);
 
+    void emit_string (ostream_base & os, char const * first, char const * last);
+
+    /// \tparam Iterator  A contiguous iterator whose value type is char.
     template <typename Iterator>
     void emit_string (ostream_base & os, Iterator first, Iterator last) {
-      os << '"';
-      auto pos = first;
-      while ((pos = std::find_if (first, last,
-                                  [] (char const c) { return c == '"' || c == '\\'; })) != last) {
-        details::write_span (os, gsl::make_span (&*first, pos - first));
-        os << '\\' << *pos;
-        first = pos + 1;
+      if (first == last) {
+        os << R"("")";
+        return;
       }
-      if (first != last) {
-        details::write_span (os, gsl::make_span (&*first, last - first));
-      }
-      os << '"';
+      char const * const begin = &*first;
+      emit_string (os, begin, begin + std::distance (first, last));
     }
 
     void emit_string (ostream_base & os, raw_sstring_view const & view);
 
+    /// Writes the bytes [first, last) to \p os as Base64.
+    void emit_base64 (ostream_base & os, std::uint8_t const * first, std::uint8_t const * last);
+
     /// If \p comments is true, emits a comment containing the body of the string at address
     /// \p addr.
     ///
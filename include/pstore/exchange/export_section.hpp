@@ -51,6 +51,18 @@ namespace pstore::exchange::export_ns {
       using type = ostream_inserter;
     };
 
+    /// Writes \p payload to \p os as Base64. The pstore output streams take a fast path which
+    /// encodes the data in bulk.
+    template <typename OStream>
+    void write_base64 (OStream & os, repo::container<std::uint8_t> const & payload) {
+      if constexpr (std::is_base_of_v<ostream_base, OStream>) {
+        emit_base64 (os, payload.data (), payload.data () + payload.size ());
+      } else {
+        using iterator = typename output_iterator<OStream, char>::type;
+        to_base64 (std::begin (payload), std::end (payload), iterator{os});
+      }
+    }
+
     template <typename Content>
     class section_content_exporter;
     template <>
@@ -79,9 +91,7 @@ namespace pstore::exchange::export_ns {
         }
         {
           os << separator << ind << R"("data":")";
-          repo::container<std::uint8_t> const payload = content.payload ();
-          using output_iterator = typename details::output_iterator<OStream, char>::type;
-          to_base64 (std::begin (payload), std::end (payload), output_iterator{os});
+          details::write_base64 (os, content.payload ());
           os << '"';
         }
         if (repo::container<repo::internal_fixup> const ifx = content.ifixups (); !ifx.empty ()) {
@@ -146,9 +156,7 @@ namespace pstore::exchange::export_ns {
       template <typename OStream>
       static void write_data (OStream & os, indent const ind, dls const & content) {
         os << ind << R"("data":")";
-        repo::container<std::uint8_t> const payload = content.payload ();
-        using output_iterator = typename details::output_iterator<OStream, char>::type;
-        to_base64 (std::begin (payload), std::end (payload), output_iterator{os});
+        details::write_base64 (os, content.payload ());
         os << "\",\n";
       }
 
@@ -80,13 +80,14 @@ namespace pstore::exchange::export_ns {
   //* / -_) '  \| |  _| (_-<  _| '_| | ' \/ _` (_-< *
   //* \___|_|_|_|_|\__| /__/\__|_| |_|_||_\__, /__/ *
   //*                                     |___/     *
-  /// Writes the array of strings added to the index given by \p Index in transaction \p
-  /// generation to the output stream \p os.
+  /// Writes the array of strings added to \p names_index in transaction \p generation to the
+  /// output stream \p os.
   ///
   /// \tparam Index  The index in which the strings are defined.
   /// \p os  The stream to which output is written.
   /// \p ind  The indentation of the output.
   /// \p db  The database instance whose strings are to be dumped.
+  /// \p names_index  The index as it was at revision \p generation.
   /// \p generation  The database generation number whose strings are to be dumped.
   /// \p prefix  A string prefix emitted before the array.
   /// \p string_table  The string table accumulates the address-to-index mapping of each
@@ -95,16 +96,12 @@ namespace pstore::exchange::export_ns {
   /// \returns True if one or more string were emitted, false otherwise.
   template <typename trailer::indices Index>
   bool emit_strings (ostream_base & os, indent const ind, database const & db,
+                     typename index::enum_to_index<Index>::type const & names_index,
                      unsigned const generation, std::string const & prefix,
                      string_mapping * const string_table, bool const comments) {
     if (generation == 0U) {
       return false;
     }
-    auto const names_index = index::get_index<Index> (db, false /*create*/);
-    if (names_index == nullptr) {
-      return false;
-    }
-
     bool first = true;
     std::string comment;
     auto const member_indent = ind.next ();
@@ -117,7 +114,7 @@ namespace pstore::exchange::export_ns {
       }
       os << '\n' << member_indent;
 
-      indirect_string const str = names_index->load_leaf (db, addr);
+      indirect_string const str = names_index.load_leaf (db, addr);
       shared_sstring_view owner;
       raw_sstring_view const view = str.as_db_string_view (&owner);
       emit_string (os, view);
@@ -126,13 +123,41 @@ namespace pstore::exchange::export_ns {
         comment = " // #" + std::to_string (index);
       }
     };
-    diff (db, *names_index, generation - 1U, make_diff_out (&out_fn));
+    diff (db, names_index, generation - 1U, make_diff_out (&out_fn));
     if (!first) {
       os << comment << '\n' << ind << ']';
     }
     return !first;
   }
 
+  /// Writes the array of strings added to the index given by \p Index in transaction \p
+  /// generation to the output stream \p os. The database must be synced to \p generation.
+  ///
+  /// \tparam Index  The index in which the strings are defined.
+  /// \p os  The stream to which output is written.
+  /// \p ind  The indentation of the output.
+  /// \p db  The database instance whose strings are to be dumped.
+  /// \p generation  The database generation number whose strings are to be dumped.
+  /// \p prefix  A string prefix emitted before the array.
+  /// \p string_table  The string table accumulates the address-to-index mapping of each
+  ///   string as it is dumped.
+  /// \p comments  Emit comments to the output.
+  /// \returns True if one or more string were emitted, false otherwise.
+  template <typename trailer::indices Index>
+  bool emit_strings (ostream_base & os, indent const ind, database const & db,
+                     unsigned const generation, std::string const & prefix,
+                     string_mapping * const string_table, bool const comments) {
+    if (generation == 0U) {
+      return false;
+    }
+    auto const names_index = index::get_index<Index> (db, false /*create*/);
+    if (names_index == nullptr) {
+      return false;
+    }
+    return emit_strings<Index> (os, ind, db, *names_index, generation, prefix, string_table,
+                                comments);
+  }
+
 } // end namespace pstore::exchange::export_ns
 
 #endif // PSTORE_EXCHANGE_EXPORT_STRINGS_HPP
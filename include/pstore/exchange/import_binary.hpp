@@ -0,0 +1,154 @@
+//===- include/pstore/exchange/import_binary.hpp ----------*- mode: C++ -*-===//
+//*  _                            _    *
+//* (_)_ __ ___  _ __   ___  _ __| |_  *
+//* | | '_ ` _ \| '_ \ / _ \| '__| __| *
+//* | | | | | | | |_) | (_) | |  | |_  *
+//* |_|_| |_| |_| .__/ \___/|_|   \__| *
+//*             |_|                    *
+//*  _     _                         *
+//* | |__ (_)_ __   __ _ _ __ _   _  *
+//* | '_ \| | '_ \ / _` | '__| | | | *
+//* | |_) | | | | | (_| | |  | |_| | *
+//* |_.__/|_|_| |_|\__,_|_|   \__, | *
+//*                           |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file import_binary.hpp
+/// \brief A streaming reader for the binary exchange format.
+
+#ifndef PSTORE_EXCHANGE_IMPORT_BINARY_HPP
+#define PSTORE_EXCHANGE_IMPORT_BINARY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include "pstore/core/uuid.hpp"
+#include "pstore/exchange/binary_format.hpp"
+#include "pstore/exchange/import_error.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore {
+  class database;
+  namespace repo {
+    struct section_content;
+  } // end namespace repo
+} // end namespace pstore
+
+namespace pstore::exchange::import_ns {
+
+  /// Returns true if the bytes [first, last) begin with the signature of the binary exchange
+  /// format.
+  bool is_binary_input (std::byte const * first, std::byte const * last) noexcept;
+
+  //*  _     _                                                           *
+  //* | |__ (_)_ __   __ _ _ __ _   _    _ __   __ _ _ __ ___  ___ _ __  *
+  //* | '_ \| | '_ \ / _` | '__| | | |  | '_ \ / _` | '__/ __|/ _ \ '__| *
+  //* | |_) | | | | | (_| | |  | |_| |  | |_) | (_| | |  \__ \  __/ |    *
+  //* |_.__/|_|_| |_|\__,_|_|   \__, |  | .__/ \__,_|_|  |___/\___|_|    *
+  //*                           |___/   |_|                              *
+  /// Imports the binary exchange format produced by export_ns::binary_writer.
+  ///
+  /// Input may be supplied in pieces of any size. Records which lie wholly within a piece are
+  /// consumed in place, so passing the entire contents of a memory-mapped file in a single call
+  /// avoids copying; only a record which straddles two pieces is assembled in an internal
+  /// buffer.
+  ///
+  /// The work is divided into two stages. The first decodes and validates each record; the
+  /// second allocates its contents in the store, adds it to the indices, and commits each
+  /// transaction once it is complete. In store_mode::background the second stage runs on a
+  /// separate thread so that decoding the input overlaps with writing to the store.
+  class binary_parser {
+  public:
+    enum class store_mode {
+      immediate,  ///< Records are stored by the thread which calls input().
+      background, ///< Records are stored by a separate thread.
+    };
+
+    /// \param db  The database to which the imported data will be added.
+    /// \param mode  Selects whether records are stored by the calling thread or a separate
+    ///   thread.
+    /// \param max_queued  In store_mode::background, the maximum number of bytes of decoded
+    ///   records waiting to be stored or zero for no limit. input() blocks while this limit is
+    ///   reached.
+    explicit binary_parser (gsl::not_null<database *> db, store_mode mode = store_mode::immediate,
+                            std::size_t max_queued = 0);
+    binary_parser (binary_parser const &) = delete;
+    binary_parser (binary_parser &&) = delete;
+
+    ~binary_parser () noexcept;
+
+    binary_parser & operator= (binary_parser const &) = delete;
+    binary_parser & operator= (binary_parser &&) = delete;
+
+    /// Consumes the bytes [first, last).
+    binary_parser & input (std::byte const * first, std::byte const * last);
+    /// Signals the end of the input. In store_mode::background, waits for all of the records
+    /// to be stored.
+    binary_parser & eof ();
+
+    bool has_error () const noexcept { return static_cast<bool> (error_); }
+    std::error_code last_error () const noexcept { return error_; }
+    /// Returns the offset of the first byte of the record being processed when an error
+    /// occurred or the number of bytes consumed otherwise.
+    std::uint64_t pos () const noexcept { return pos_; }
+
+  private:
+    struct record;
+    class payload_reader;
+    class store;
+    class background;
+
+    /// Returns the number of bytes occupied by the next item in the input (either the file
+    /// header or a record) given the \p available bytes at \p first. If fewer bytes are
+    /// available than are needed to determine the size then the value returned is the number
+    /// needed to do so.
+    std::uint64_t item_size (std::byte const * first, std::size_t available) const noexcept;
+    /// Processes the complete item occupying [first, last).
+    std::error_code item (std::byte const * first, std::byte const * last);
+    /// Records an error. In store_mode::background, an error raised by an earlier record
+    /// which has yet to be reported by the storage thread takes precedence.
+    void fail (std::error_code erc);
+    /// In store_mode::background, waits for the storage thread to store the records that it
+    /// has been given and then stops it.
+    void wait_for_store ();
+
+    std::error_code file_header (std::byte const * first);
+    std::error_code decode (binary::record_kind kind, payload_reader & payload);
+    std::error_code strings (payload_reader & payload, bool is_path, record * r);
+    std::error_code debug_line_header (payload_reader & payload, record * r);
+    std::error_code fragment (payload_reader & payload, record * r);
+    std::error_code section_contents (payload_reader & payload,
+                                      binary::section_header const & header,
+                                      repo::section_content * content,
+                                      std::vector<std::uint64_t> * xfixup_names) const;
+    std::error_code compilation (payload_reader & payload, record * r);
+    /// Passes a decoded record to the storage stage.
+    std::error_code emit (record && r);
+
+    std::unique_ptr<store> store_;
+    std::unique_ptr<background> background_;
+
+    std::error_code error_;
+    std::uint64_t pos_ = 0;
+    bool seen_header_ = false;
+    bool seen_end_ = false;
+    bool in_transaction_ = false;
+    uuid id_;
+    /// The number of names that have been decoded.
+    std::uint64_t num_names_ = 0;
+
+    /// Holds the start of an item which was not complete at the end of a call to input().
+    std::vector<std::byte> buffer_;
+  };
+
+} // end namespace pstore::exchange::import_ns
+
+#endif // PSTORE_EXCHANGE_IMPORT_BINARY_HPP
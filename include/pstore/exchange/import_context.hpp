@@ -19,28 +19,11 @@
 #include <list>
 #include <stack>
 
-#include "pstore/support/gsl.hpp"
+#include "pstore/exchange/import_patcher.hpp"
 
 namespace pstore {
-  class database;
-  class transaction_base;
-
   namespace exchange::import_ns {
 
-    class patcher {
-    public:
-      patcher () noexcept = default;
-      patcher (patcher const & rhs) noexcept = default;
-      patcher (patcher && rhs) noexcept = default;
-
-      virtual ~patcher () noexcept = default;
-
-      patcher & operator= (patcher const & rhs) noexcept = default;
-      patcher & operator= (patcher && rhs) noexcept = default;
-
-      virtual std::error_code operator() (transaction_base * t) = 0;
-    };
-
     class rule;
 
     struct context {
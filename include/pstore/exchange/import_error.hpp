@@ -70,6 +70,12 @@ namespace pstore::exchange::import_ns {
     index_out_of_range,
     debug_line_header_digest_not_found,
     number_too_large,
+
+    bad_signature,
+    unsupported_version,
+    bad_record,
+    unexpected_record,
+    unexpected_end_of_input,
   };
 
 
@@ -25,34 +25,12 @@
 #ifndef PSTORE_EXCHANGE_IMPORT_FRAGMENT_HPP
 #define PSTORE_EXCHANGE_IMPORT_FRAGMENT_HPP
 
+#include "pstore/exchange/import_patcher.hpp"
 #include "pstore/exchange/import_section_to_importer.hpp"
 #include "pstore/mcrepo/fragment.hpp"
 
 namespace pstore::exchange::import_ns {
 
-  //*          _    _                            _      _     *
-  //*  __ _ __| |__| |_ _ ___ ______  _ __  __ _| |_ __| |_   *
-  //* / _` / _` / _` | '_/ -_|_-<_-< | '_ \/ _` |  _/ _| ' \  *
-  //* \__,_\__,_\__,_|_| \___/__/__/ | .__/\__,_|\__\__|_||_| *
-  //*                                |_|                      *
-  class address_patch final : public patcher {
-  public:
-    address_patch (gsl::not_null<database *> db, extent<repo::fragment> const & ex) noexcept;
-    address_patch (address_patch const &) = delete;
-    address_patch (address_patch &&) = delete;
-
-    ~address_patch () noexcept override = default;
-
-    address_patch & operator= (address_patch const &) = delete;
-    address_patch & operator= (address_patch &&) = delete;
-
-    std::error_code operator() (transaction_base * transaction) override;
-
-  private:
-    gsl::not_null<database *> const db_;
-    extent<repo::fragment> const fragment_extent_;
-  };
-
   //*   __                             _                _   _              *
   //*  / _|_ _ __ _ __ _ _ __  ___ _ _| |_   ___ ___ __| |_(_)___ _ _  ___ *
   //* |  _| '_/ _` / _` | '  \/ -_) ' \  _| (_-</ -_) _|  _| / _ \ ' \(_-< *
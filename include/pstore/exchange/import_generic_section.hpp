@@ -125,9 +125,16 @@ namespace pstore::exchange::import_ns {
     }
     content_->kind = kind_;
     content_->align = static_cast<align_type> (align_);
-    if (!from_base64 (std::begin (data_), std::end (data_), std::back_inserter (content_->data))) {
+    // Decode directly into the section's data buffer then trim it to the decoded size.
+    auto & data = content_->data;
+    auto const old_size = data.size ();
+    data.resize (old_size + base64_decoded_size (data_.size ()));
+    std::optional<std::uint8_t *> const end =
+      base64_decode (data_.data (), data_.size (), data.data () + old_size);
+    if (!end) {
       return return_type{error::bad_base64_data};
     }
+    data.resize (static_cast<std::size_t> (*end - data.data ()));
     return return_type{content_};
   }
 
@@ -0,0 +1,87 @@
+//===- include/pstore/exchange/import_patcher.hpp ---------*- mode: C++ -*-===//
+//*  _                            _    *
+//* (_)_ __ ___  _ __   ___  _ __| |_  *
+//* | | '_ ` _ \| '_ \ / _ \| '__| __| *
+//* | | | | | | | |_) | (_) | |  | |_  *
+//* |_|_| |_| |_| .__/ \___/|_|   \__| *
+//*             |_|                    *
+//*              _       _                *
+//*  _ __   __ _| |_ ___| |__   ___ _ __  *
+//* | '_ \ / _` | __/ __| '_ \ / _ \ '__| *
+//* | |_) | (_| | || (__| | | |  __/ |    *
+//* | .__/ \__,_|\__\___|_| |_|\___|_|    *
+//* |_|                                   *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file import_patcher.hpp
+/// \brief Patches which are applied to imported data once a transaction's contents are complete.
+
+#ifndef PSTORE_EXCHANGE_IMPORT_PATCHER_HPP
+#define PSTORE_EXCHANGE_IMPORT_PATCHER_HPP
+
+#include <system_error>
+
+#include "pstore/core/address.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore {
+
+  class database;
+  class transaction_base;
+
+  namespace repo {
+    class fragment;
+  } // end namespace repo
+
+  namespace exchange::import_ns {
+
+    class patcher {
+    public:
+      patcher () noexcept = default;
+      patcher (patcher const & rhs) noexcept = default;
+      patcher (patcher && rhs) noexcept = default;
+
+      virtual ~patcher () noexcept = default;
+
+      patcher & operator= (patcher const & rhs) noexcept = default;
+      patcher & operator= (patcher && rhs) noexcept = default;
+
+      virtual std::error_code operator() (transaction_base * t) = 0;
+    };
+
+    //*          _    _                            _      _     *
+    //*  __ _ __| |__| |_ _ ___ ______  _ __  __ _| |_ __| |_   *
+    //* / _` / _` / _` | '_/ -_|_-<_-< | '_ \/ _` |  _/ _| ' \  *
+    //* \__,_\__,_\__,_|_| \___/__/__/ | .__/\__,_|\__\__|_||_| *
+    //*                                |_|                      *
+    /// Sets the address of each of the definitions referenced by a fragment's linked-definitions
+    /// section. These can only be resolved once the compilations that contain them have been
+    /// imported.
+    class address_patch final : public patcher {
+    public:
+      address_patch (gsl::not_null<database *> db, extent<repo::fragment> const & ex) noexcept;
+      address_patch (address_patch const &) = delete;
+      address_patch (address_patch &&) = delete;
+
+      ~address_patch () noexcept override = default;
+
+      address_patch & operator= (address_patch const &) = delete;
+      address_patch & operator= (address_patch &&) = delete;
+
+      std::error_code operator() (transaction_base * transaction) override;
+
+    private:
+      gsl::not_null<database *> const db_;
+      extent<repo::fragment> const fragment_extent_;
+    };
+
+  } // end namespace exchange::import_ns
+} // end namespace pstore
+
+#endif // PSTORE_EXCHANGE_IMPORT_PATCHER_HPP
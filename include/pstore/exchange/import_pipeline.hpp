@@ -0,0 +1,193 @@
+//===- include/pstore/exchange/import_pipeline.hpp --------*- mode: C++ -*-===//
+//*  _                            _    *
+//* (_)_ __ ___  _ __   ___  _ __| |_  *
+//* | | '_ ` _ \| '_ \ / _ \| '__| __| *
+//* | | | | | | | |_) | (_) | |  | |_  *
+//* |_|_| |_| |_| .__/ \___/|_|   \__| *
+//*             |_|                    *
+//*        _            _ _             *
+//*  _ __ (_)_ __   ___| (_)_ __   ___  *
+//* | '_ \| | '_ \ / _ \ | | '_ \ / _ \ *
+//* | |_) | | |_) |  __/ | | | | |  __/ *
+//* | .__/|_| .__/ \___|_|_|_| |_|\___| *
+//* |_|     |_|                         *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file import_pipeline.hpp
+/// \brief Components used to connect the stages of a multi-threaded import.
+
+#ifndef PSTORE_EXCHANGE_IMPORT_PIPELINE_HPP
+#define PSTORE_EXCHANGE_IMPORT_PIPELINE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "pstore/support/assert.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore::exchange::import_ns {
+
+  //*  _                           _          _                                 *
+  //* | |__   ___  _   _ _ __   __| | ___  __| |    __ _ _   _  ___ _   _  ___  *
+  //* | '_ \ / _ \| | | | '_ \ / _` |/ _ \/ _` |   / _` | | | |/ _ \ | | |/ _ \ *
+  //* | |_) | (_) | |_| | | | | (_| |  __/ (_| |  | (_| | |_| |  __/ |_| |  __/ *
+  //* |_.__/ \___/ \__,_|_| |_|\__,_|\___|\__,_|   \__, |\__,_|\___|\__,_|\___| *
+  //*                                                 |_|                       *
+  /// A queue which carries work from one stage of the import pipeline to the next. Each item
+  /// has a size (typically the number of bytes that it occupies) and the producer is blocked
+  /// while the total size of the queued items would exceed the queue's capacity. This bounds
+  /// the memory used by a fast producer paired with a slow consumer.
+  template <typename T>
+  class bounded_queue {
+  public:
+    /// \param capacity  The maximum total size of the items in the queue or zero if the
+    ///   queue is unbounded.
+    explicit bounded_queue (std::size_t const capacity) noexcept
+            : capacity_{capacity} {}
+    bounded_queue (bounded_queue const &) = delete;
+    bounded_queue (bounded_queue &&) = delete;
+
+    ~bounded_queue () noexcept = default;
+
+    bounded_queue & operator= (bounded_queue const &) = delete;
+    bounded_queue & operator= (bounded_queue &&) = delete;
+
+    /// Adds an item whose size is \p size to the back of the queue, waiting until there is
+    /// room for it. An item which is larger than the queue's capacity is accepted once the
+    /// queue is empty. Returns false if the consumer has cancelled the queue.
+    bool push (T && item, std::size_t size);
+    /// Waits for an item to be available then removes it from the front of the queue.
+    /// Returns std::nullopt once the queue has been closed and is empty or if it has been
+    /// cancelled.
+    std::optional<T> pop ();
+
+    /// Called by the producer to signal that no more items will be pushed.
+    void close ();
+    /// Called by the consumer to signal that it will pop no more items. Any items in the
+    /// queue are discarded and subsequent calls to push() fail.
+    void cancel ();
+
+  private:
+    std::size_t const capacity_;
+    std::mutex mut_;
+    std::condition_variable cv_;
+    std::deque<std::pair<T, std::size_t>> queue_;
+    std::size_t size_ = 0;
+    bool closed_ = false;
+    bool cancelled_ = false;
+  };
+
+  // push
+  // ~~~~
+  template <typename T>
+  bool bounded_queue<T>::push (T && item, std::size_t const size) {
+    std::unique_lock<decltype (mut_)> lock{mut_};
+    PSTORE_ASSERT (!closed_);
+    cv_.wait (lock, [this, size] () {
+      return cancelled_ || capacity_ == 0U || queue_.empty () || size_ + size <= capacity_;
+    });
+    if (cancelled_) {
+      return false;
+    }
+    queue_.emplace_back (std::move (item), size);
+    size_ += size;
+    cv_.notify_all ();
+    return true;
+  }
+
+  // pop
+  // ~~~
+  template <typename T>
+  std::optional<T> bounded_queue<T>::pop () {
+    std::unique_lock<decltype (mut_)> lock{mut_};
+    cv_.wait (lock, [this] () { return cancelled_ || closed_ || !queue_.empty (); });
+    if (cancelled_ || queue_.empty ()) {
+      return std::nullopt;
+    }
+    auto & front = queue_.front ();
+    std::optional<T> result{std::move (front.first)};
+    size_ -= front.second;
+    queue_.pop_front ();
+    cv_.notify_all ();
+    return result;
+  }
+
+  // close
+  // ~~~~~
+  template <typename T>
+  void bounded_queue<T>::close () {
+    std::unique_lock<decltype (mut_)> const lock{mut_};
+    closed_ = true;
+    cv_.notify_all ();
+  }
+
+  // cancel
+  // ~~~~~~
+  template <typename T>
+  void bounded_queue<T>::cancel () {
+    std::unique_lock<decltype (mut_)> const lock{mut_};
+    cancelled_ = true;
+    queue_.clear ();
+    size_ = 0;
+    cv_.notify_all ();
+  }
+
+  //*                     _          _                    _  *
+  //*  _ __ ___  __ _  __| |    __ _| |__   ___  __ _  __| | *
+  //* | '__/ _ \/ _` |/ _` |   / _` | '_ \ / _ \/ _` |/ _` | *
+  //* | | |  __/ (_| | (_| |  | (_| | | | |  __/ (_| | (_| | *
+  //* |_|  \___|\__,_|\__,_|   \__,_|_| |_|\___|\__,_|\__,_| *
+  //*                                                        *
+  /// The first stage of the import pipeline: reads a stream on a separate thread so that
+  /// reading the input overlaps with parsing it.
+  class read_ahead {
+  public:
+    /// \param file  The stream to be read. It must remain open for the lifetime of this
+    ///   object.
+    /// \param chunk_size  The number of bytes requested by each read of the stream.
+    /// \param max_chunks  The maximum number of chunks that have been read but not yet
+    ///   consumed.
+    read_ahead (gsl::not_null<std::FILE *> file, std::size_t chunk_size, std::size_t max_chunks);
+    read_ahead (read_ahead const &) = delete;
+    read_ahead (read_ahead &&) = delete;
+
+    /// Stops the reader thread and waits for it to exit.
+    ~read_ahead () noexcept;
+
+    read_ahead & operator= (read_ahead const &) = delete;
+    read_ahead & operator= (read_ahead &&) = delete;
+
+    /// Returns the next chunk of the input. The chunk remains valid until the next call. An
+    /// empty chunk marks the end of the input.
+    ///
+    /// \throws std::system_error  An error occurred reading the input.
+    gsl::span<std::byte const> next ();
+
+  private:
+    void reader (gsl::not_null<std::FILE *> file, std::size_t chunk_size);
+
+    bounded_queue<std::vector<std::byte>> queue_;
+    /// The chunk most recently returned by next().
+    std::vector<std::byte> current_;
+    /// Records an error encountered by the reader thread. Written before the queue is closed.
+    std::error_code error_;
+    std::thread thread_;
+  };
+
+} // end namespace pstore::exchange::import_ns
+
+#endif // PSTORE_EXCHANGE_IMPORT_PIPELINE_HPP
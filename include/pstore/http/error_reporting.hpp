@@ -16,8 +16,12 @@
 /// \file error_reporting.hpp
 /// \brief Reporting HTTP server errors to the client.
 
+#ifndef PSTORE_HTTP_ERROR_REPORTING_HPP
+#define PSTORE_HTTP_ERROR_REPORTING_HPP
+
 #include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include "pstore/http/http_date.hpp"
 #include "pstore/http/send.hpp"
@@ -109,7 +113,7 @@ namespace pstore::http {
     }};
 
     // Send the three parts: the response line, the headers, and the HTML content.
-    return send (sender, io, status_line + crlf) >>= [&] (IO io2) {
+    return send (sender, io, status_line) >>= [&] (IO io2) {
       return send (sender, io2, build_headers (std::begin (h), std::end (h))) >>=
              [&] (IO io3) { return send (sender, io3, content_str); };
     };
@@ -120,5 +124,11 @@ namespace pstore::http {
   /// Here we bridge from the std::error_code world to HTTP status codes.
   void report_error (std::error_code const error, request_info const & request,
                      socket_descriptor & socket);
+  /// Appends the response which reports \p error to \p output rather than sending it to a
+  /// socket.
+  void report_error (std::error_code const error, request_info const & request,
+                     std::vector<std::uint8_t> & output);
 
 } // end namespace pstore::http
+
+#endif // PSTORE_HTTP_ERROR_REPORTING_HPP
@@ -0,0 +1,100 @@
+//===- include/pstore/http/event_server.hpp ---------------*- mode: C++ -*-===//
+//*                       _                                    *
+//*   _____   _____ _ __ | |_    ___  ___ _ ____   _____ _ __  *
+//*  / _ \ \ / / _ \ '_ \| __|  / __|/ _ \ '__\ \ / / _ \ '__| *
+//* |  __/\ V /  __/ | | | |_   \__ \  __/ |   \ V /  __/ |    *
+//*  \___| \_/ \___|_| |_|\__|  |___/\___|_|    \_/ \___|_|    *
+//*                                                            *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file event_server.hpp
+/// \brief An event-driven implementation of the HTTP server's connection handling.
+///
+/// A single thread waits for activity on the listening socket, on every client connection,
+/// and on the channels to which WebSocket clients may subscribe. Work is handed to a small,
+/// fixed pool of worker threads so that the number of threads does not grow with the number
+/// of connected clients.
+
+#ifndef PSTORE_HTTP_EVENT_SERVER_HPP
+#define PSTORE_HTTP_EVENT_SERVER_HPP
+
+#include <chrono>
+#include <system_error>
+#include <vector>
+
+#include "pstore/config/config.hpp"
+#include "pstore/http/ws_server.hpp"
+#include "pstore/os/descriptor.hpp"
+#include "pstore/romfs/romfs.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore::http {
+
+  class server_status;
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+  /// Settings which control the event server's treatment of idle connections.
+  struct event_server_options {
+    /// The time for which a persistent HTTP connection may be idle before the server closes
+    /// it.
+    std::chrono::milliseconds keep_alive_timeout = std::chrono::seconds{30};
+    /// The interval between checks for idle connections.
+    std::chrono::milliseconds idle_check_interval = std::chrono::seconds{5};
+  };
+
+  //*                       _                                    *
+  //*   _____   _____ _ __ | |_    ___  ___ _ ____   _____ _ __  *
+  //*  / _ \ \ / / _ \ '_ \| __|  / __|/ _ \ '__\ \ / / _ \ '__| *
+  //* |  __/\ V /  __/ | | | |_   \__ \  __/ |   \ V /  __/ |    *
+  //*  \___| \_/ \___|_| |_|\__|  |___/\___|_|    \_/ \___|_|    *
+  //*                                                            *
+  class event_server {
+  public:
+    /// \param file_system  The file system from which static content is served.
+    /// \param channels  The channels to which WebSocket clients may subscribe.
+    /// \param options  Settings which control the treatment of idle connections.
+    event_server (romfs::romfs & file_system, channel_container const & channels,
+                  event_server_options const & options = event_server_options{});
+    event_server (event_server const &) = delete;
+    event_server (event_server &&) noexcept = delete;
+    ~event_server () noexcept = default;
+
+    event_server & operator= (event_server const &) = delete;
+    event_server & operator= (event_server &&) noexcept = delete;
+
+    /// Adds a client whose connection has already been established. Must be called before
+    /// run().
+    ///
+    /// \param client  A connected stream socket.
+    /// \returns  An error if the socket could not be made non-blocking.
+    std::error_code add_client (socket_descriptor && client);
+
+    /// Serves the HTTP and WebSocket clients which connect to \p listener, together with
+    /// those passed to add_client(), until the server status is changed to closing. Any
+    /// remaining WebSocket clients are then sent a close frame and all connections are
+    /// closed.
+    ///
+    /// \param listener  A socket which is bound and listening for connections or an invalid
+    ///   descriptor if only the clients passed to add_client() are to be served.
+    /// \param status  The server's state.
+    /// \returns  An error if the event loop could not be started or failed.
+    std::error_code run (socket_descriptor const & listener,
+                         gsl::not_null<server_status *> status);
+
+  private:
+    romfs::romfs & file_system_;
+    channel_container const & channels_;
+    event_server_options const options_;
+    std::vector<socket_descriptor> clients_;
+  };
+#endif // PSTORE_HAVE_SYS_EPOLL_H
+
+} // end namespace pstore::http
+
+#endif // PSTORE_HTTP_EVENT_SERVER_HPP
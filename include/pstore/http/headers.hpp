@@ -16,6 +16,7 @@
 #ifndef PSTORE_HTTP_HEADERS_HPP
 #define PSTORE_HTTP_HEADERS_HPP
 
+#include <cstdint>
 #include <string>
 
 #include "pstore/support/maybe.hpp"
@@ -28,10 +29,31 @@ namespace pstore::http {
 
     bool upgrade_to_websocket = false;
     bool connection_upgrade = false;
+    /// True if the "connection" header includes the "keep-alive" option.
+    bool connection_keep_alive = false;
+    /// True if the "connection" header includes the "close" option.
+    bool connection_close = false;
     pstore::maybe<std::string> websocket_key;
     pstore::maybe<unsigned> websocket_version;
+    /// The size of the request body as given by the "content-length" header.
+    pstore::maybe<std::uint64_t> content_length;
+    /// True if a "content-length" header could not be parsed or if there was more than one
+    /// and their values differ. The end of the request body cannot then be found: the request
+    /// must be rejected and the connection closed.
+    bool bad_content_length = false;
+    /// True if a "transfer-encoding" header was present. The length of such a body can only
+    /// be found by decoding it.
+    bool transfer_encoding = false;
 
     header_info handler (std::string const & key, std::string const & value);
+
+    /// Returns true if the connection should persist after the response to a request with
+    /// these headers has been sent. HTTP/1.1 connections persist unless the client asks for
+    /// them to be closed; earlier versions of the protocol close unless the client asks for
+    /// the connection to be kept alive.
+    ///
+    /// \param version  The HTTP version string from the request line (e.g. "HTTP/1.1").
+    bool keep_alive (std::string const & version) const;
   };
 
 } // end namespace pstore::http
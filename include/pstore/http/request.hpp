@@ -22,12 +22,14 @@
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <system_error>
 #include <utility>
 
 #include "pstore/adt/error_or.hpp"
+#include "pstore/support/gsl.hpp"
 #include "pstore/support/maybe.hpp"
 
 namespace pstore::http {
@@ -159,6 +161,31 @@ namespace pstore::http {
     };
   }
 
+  // request size
+  // ~~~~~~~~~~~~
+  /// Looks for the empty line which terminates the request line and headers of an HTTP
+  /// request. This allows a server which receives data without blocking to determine whether
+  /// a complete request has arrived before it starts to parse it.
+  ///
+  /// \param input  The bytes received from the client.
+  /// \returns  The number of bytes occupied by the request line and headers, including the
+  ///   empty line which ends them, or nothing if the empty line has not yet been received.
+  inline maybe<std::size_t> request_size (gsl::span<std::uint8_t const> const & input) {
+    auto const first = input.begin ();
+    auto const last = input.end ();
+    auto line_start = first;
+    for (auto it = std::find (first, last, std::uint8_t{'\n'}); it != last;
+         it = std::find (it + 1, last, std::uint8_t{'\n'})) {
+      // An empty line is either a lone LF or CR LF.
+      auto const length = it - line_start;
+      if (length == 0 || (length == 1 && *line_start == '\r')) {
+        return just (static_cast<std::size_t> (it - first + 1));
+      }
+      line_start = it + 1;
+    }
+    return nothing<std::size_t> ();
+  }
+
 } // end namespace pstore::http
 
 #endif // PSTORE_HTTP_REQUEST_HPP
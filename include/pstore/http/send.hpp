@@ -30,6 +30,12 @@ namespace pstore::http {
   static constexpr auto crlf = "\r\n";
   static constexpr auto server_name = "pstore-http";
 
+  /// Returns the value of the "Connection" response header: "keep-alive" if the server will
+  /// accept further requests on the connection, otherwise "close".
+  constexpr gsl::czstring connection_option (bool const keep_alive) noexcept {
+    return keep_alive ? "keep-alive" : "close";
+  }
+
   template <typename Sender, typename IO>
   error_or<IO> send (Sender sender, IO io, gsl::span<std::uint8_t const> const & s) {
     return sender (io, s);
@@ -43,6 +43,7 @@
 #include "pstore/http/quit.hpp"
 #include "pstore/http/send.hpp"
 #include "pstore/support/array_elements.hpp"
+#include "pstore/support/metrics.hpp"
 
 namespace pstore::http {
 
@@ -51,7 +52,8 @@ namespace pstore::http {
   using query_container = std::unordered_map<std::string, std::string>;
 
   template <typename Sender, typename IO>
-  pstore::error_or<IO> handle_version (Sender sender, IO io, query_container const &) {
+  pstore::error_or<IO> handle_version (Sender sender, IO io, query_container const &,
+                                       bool const keep_alive) {
     auto version_string = [] () {
       std::ostringstream os;
       os << R"({ "version": ")" << header::major_version << '.' << header::minor_version << "\" }";
@@ -62,7 +64,7 @@ namespace pstore::http {
 
     std::ostringstream os;
     os << "HTTP/1.1 200 OK" << crlf                                         //
-       << "Connection: close" << crlf                                       //
+       << "Connection: " << connection_option (keep_alive) << crlf          //
        << "Content-length: " << version.length () << crlf                   //
        << "Content-type: application/json" << crlf                          //
        << "Date: " << http_date (std::chrono::system_clock::now ()) << crlf //
@@ -73,6 +75,24 @@ namespace pstore::http {
     return pstore::http::send (sender, io, os.str ());
   }
 
+  template <typename Sender, typename IO>
+  pstore::error_or<IO> handle_metrics (Sender sender, IO io, query_container const &,
+                                       bool const keep_alive) {
+    std::string const metrics = pstore::metrics::to_json (pstore::metrics::collect ());
+
+    std::ostringstream os;
+    os << "HTTP/1.1 200 OK" << crlf                                         //
+       << "Cache-Control: no-store" << crlf                                 //
+       << "Connection: " << connection_option (keep_alive) << crlf          //
+       << "Content-length: " << metrics.length () << crlf                   //
+       << "Content-type: application/json" << crlf                          //
+       << "Date: " << http_date (std::chrono::system_clock::now ()) << crlf //
+       << "Server: " << server_name << crlf                                 //
+       << crlf                                                              // End of headers
+       << metrics;
+    return pstore::http::send (sender, io, os.str ());
+  }
+
 
   namespace details {
 
@@ -98,15 +118,16 @@ namespace pstore::http {
     template <typename Sender, typename IO>
     struct commands_helper {
       using return_type = error_or<IO>;
-      using function_type = std::function<return_type (Sender, IO, query_container const &)>;
+      using function_type =
+        std::function<return_type (Sender, IO, query_container const &, bool)>;
 
-      using container = std::array<std::pair<std::string, function_type>, 1>;
+      using container = std::array<std::pair<std::string, function_type>, 2>;
     };
 
     template <typename Sender, typename IO>
     typename commands_helper<Sender, IO>::container const & get_commands () {
       static typename commands_helper<Sender, IO>::container const commands = {
-        {{"version", handle_version<Sender, IO>}},
+        {{"metrics", handle_metrics<Sender, IO>}, {"version", handle_version<Sender, IO>}},
       };
       return commands;
     }
@@ -114,8 +135,14 @@ namespace pstore::http {
   } // end namespace details
 
 
+  /// \param sender  The function used to send data to the client.
+  /// \param io  The state passed to \p sender.
+  /// \param uri  The request URI. It must start with dynamic_path.
+  /// \param keep_alive  True if the server will accept further requests on the connection
+  ///   after this response has been sent.
   template <typename Sender, typename IO>
-  error_or<IO> serve_dynamic_content (Sender sender, IO io, std::string uri) {
+  error_or<IO> serve_dynamic_content (Sender sender, IO io, std::string uri,
+                                      bool const keep_alive = false) {
 
     // Remove the common path prefix from the URI.
     PSTORE_ASSERT (details::starts_with (uri, dynamic_path));
@@ -142,14 +169,16 @@ namespace pstore::http {
     auto const lb = std::lower_bound (
       std::begin (commands), std::end (commands),
       value_type{command,
-                 [] (Sender, IO io2, query_container const &) { return error_or<IO>{io2}; }},
+                 [] (Sender, IO io2, query_container const &, bool) {
+                   return error_or<IO>{io2};
+                 }},
       compare);
     if (lb == std::end (commands) || std::get<0> (*lb) != command) {
       return error_or<IO>{error_code::bad_request};
     }
 
     // Yep, this is a command we understand. Call it.
-    return std::get<1> (*lb) (sender, io, arguments);
+    return std::get<1> (*lb) (sender, io, arguments, keep_alive);
   }
 
 } // end namespace pstore::http
@@ -50,9 +50,16 @@ namespace pstore::http {
 
   } // end namespace details
 
+  /// \param sender  The function used to send data to the client.
+  /// \param io  The state passed to \p sender.
+  /// \param path  The path of the requested file.
+  /// \param file_system  The file system from which the file is read.
+  /// \param keep_alive  True if the server will accept further requests on the connection
+  ///   after this response has been sent.
   template <typename Sender, typename IO>
   error_or<IO> serve_static_content (Sender sender, IO io, std::string path,
-                                     romfs::romfs const & file_system) {
+                                     romfs::romfs const & file_system,
+                                     bool const keep_alive = false) {
     if (path.empty ()) {
       path = "/";
     }
@@ -64,11 +71,11 @@ namespace pstore::http {
       return file_system.open (path.c_str ()) >>= [&] (romfs::descriptor fd) {
         // Send the response header.
         std::ostringstream os;
-        os << "HTTP/1.0 200 OK" << crlf                                         //
+        os << "HTTP/1.1 200 OK" << crlf                                         //
            << "Server: " << server_name << crlf                                 //
            << "Content-length: " << stat.size << crlf                           //
            << "Content-type: " << http::media_type_from_filename (path) << crlf //
-           << "Connection: close" << crlf // TODO remove this when we support persistent connections
+           << "Connection: " << connection_option (keep_alive) << crlf          //
            << "Date: " << http_date (std::chrono::system_clock::now ()) << crlf //
            << "Last-Modified: " << http_date (stat.mtime) << crlf               //
            << crlf;
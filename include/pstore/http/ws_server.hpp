@@ -16,8 +16,10 @@
 #ifndef PSTORE_HTTP_WS_SERVER_HPP
 #define PSTORE_HTTP_WS_SERVER_HPP
 
+#include <array>
 #include <cstdint>
 #include <limits>
+#include <string>
 #include <unordered_map>
 
 #ifdef _WIN32
@@ -32,10 +34,16 @@
 #include "pstore/http/block_for_input.hpp"
 #include "pstore/http/buffered_reader.hpp"
 #include "pstore/http/endian.hpp"
+#include "pstore/http/error.hpp"
+#include "pstore/http/error_reporting.hpp"
+#include "pstore/http/headers.hpp"
+#include "pstore/http/http_date.hpp"
 #include "pstore/http/send.hpp"
+#include "pstore/http/wskey.hpp"
 #include "pstore/os/descriptor.hpp"
 #include "pstore/os/signal_cv.hpp"
 #include "pstore/support/bit_field.hpp"
+#include "pstore/support/maybe.hpp"
 #include "pstore/support/utf.hpp"
 
 namespace pstore::http {
@@ -331,6 +339,44 @@ namespace pstore::http {
   }
 
 
+  // frame size
+  // ~~~~~~~~~~
+  /// Decodes enough of the header of the WebSocket frame at the start of \p input to
+  /// determine the frame's total size. This allows a server which receives data without
+  /// blocking to determine whether a complete frame has arrived before it starts to parse it.
+  ///
+  /// \param input  The bytes received from the client.
+  /// \returns  The number of bytes occupied by the frame header and its payload or nothing if
+  ///   too little of the header has been received. A size which cannot be represented by
+  ///   std::uint64_t is returned as the maximum value of that type.
+  inline maybe<std::uint64_t> frame_size (gsl::span<std::uint8_t const> const & input) {
+    constexpr auto fixed_length = sizeof (frame_fixed_layout);
+    if (static_cast<std::size_t> (input.size ()) < fixed_length) {
+      return nothing<std::uint64_t> ();
+    }
+    frame_fixed_layout part1{};
+    part1.raw = static_cast<std::uint16_t> ((unsigned{input[0]} << 8U) | unsigned{input[1]});
+
+    auto const base_length = part1.payload_length ();
+    std::size_t const extended_length = base_length < 126U ? 0U : base_length == 126U ? 2U : 8U;
+    std::size_t const header_length =
+      fixed_length + extended_length + (part1.mask () ? std::size_t{4} : std::size_t{0});
+    if (static_cast<std::size_t> (input.size ()) < fixed_length + extended_length) {
+      return nothing<std::uint64_t> ();
+    }
+    std::uint64_t payload_length = base_length;
+    if (extended_length > 0U) {
+      // Multibyte length quantities are expressed in network byte order.
+      payload_length = 0U;
+      for (auto ctr = std::size_t{0}; ctr < extended_length; ++ctr) {
+        payload_length =
+          (payload_length << 8U) | input[static_cast<std::ptrdiff_t> (fixed_length + ctr)];
+      }
+    }
+    constexpr auto max = std::numeric_limits<std::uint64_t>::max ();
+    return just (payload_length > max - header_length ? max : payload_length + header_length);
+  }
+
   namespace details {
 
     template <typename LengthType, typename Sender, typename IO>
@@ -589,6 +635,65 @@ namespace pstore::http {
                gsl::not_null<descriptor_condition_variable *>>;
   using channel_container = std::unordered_map<std::string, channel_container_entry>;
 
+  // accept upgrade
+  // ~~~~~~~~~~~~~~
+  /// Validates a client's request to upgrade its HTTP connection to the WebSocket protocol
+  /// and, if the request is acceptable, sends the server's handshake response.
+  template <typename Sender, typename IO>
+  error_or<IO> accept_upgrade (Sender const sender, IO const io,
+                               header_info const & header_contents) {
+    using priority = logger::priority;
+    PSTORE_ASSERT (header_contents.connection_upgrade && header_contents.upgrade_to_websocket);
+
+    log (priority::info, "WebSocket upgrade requested");
+    // Validate the request headers
+    if (!header_contents.websocket_key || !header_contents.websocket_version) {
+      log (priority::error, "Missing WebSockets upgrade key or version header.");
+      return error_or<IO>{error_code::bad_request};
+    }
+    if (*header_contents.websocket_version != ws_version) {
+      log (priority::error, "Bad Websocket version number requested");
+      return error_or<IO>{error_code::bad_websocket_version};
+    }
+
+    // Send back the server handshake response.
+    log (priority::info, "Accepting WebSockets upgrade");
+
+    std::string const date = http_date (std::chrono::system_clock::now ());
+    std::string const accept = source_key (*header_contents.websocket_key);
+
+    std::array<czstring_pair, 5> headers{{
+      {"Upgrade", "WebSocket"},
+      {"Connection", "Upgrade"},
+      {"Sec-WebSocket-Accept", accept.c_str ()},
+      {"Date", date.c_str ()},
+      {"Last-Modified", date.c_str ()},
+    }};
+
+    auto const status_line =
+      build_status_line (http_status_code::switching_protocols, "Switching Protocols");
+    return send (sender, io, status_line) >>= [&] (IO io2) {
+      return send (sender, io2, build_headers (std::begin (headers), std::end (headers)));
+    };
+  }
+
+  // find channel
+  // ~~~~~~~~~~~~
+  /// Returns the channel named by the URI of a WebSocket upgrade request or nullptr if there
+  /// is no such channel.
+  inline channel_container_entry const * find_channel (channel_container const & channels,
+                                                       std::string const & uri) {
+    if (uri.length () > 0 && uri[0] == '/') {
+      std::string const name = uri.substr (1);
+      auto const pos = channels.find (name);
+      if (pos != channels.end ()) {
+        return &pos->second;
+      }
+      log (logger::priority::error, "No channel named: ", name);
+    }
+    return nullptr;
+  }
+
   // ws_server_loop
   // ~~~~~~~~~~~~~~
   template <typename Reader, typename Sender, typename IO>
@@ -599,15 +704,9 @@ namespace pstore::http {
     std::unique_ptr<brokerface::subscriber<descriptor_condition_variable>> subscription;
     descriptor_condition_variable * cv = nullptr;
 
-    if (uri.length () > 0 && uri[0] == '/') {
-      std::string const name = uri.substr (1);
-      auto const pos = channels.find (name);
-      if (pos != channels.end ()) {
-        subscription = std::get<0> (pos->second)->new_subscriber ();
-        cv = std::get<1> (pos->second);
-      } else {
-        log (logger::priority::error, "No channel named: ", name);
-      }
+    if (channel_container_entry const * const entry = find_channel (channels, uri)) {
+      subscription = std::get<0> (*entry)->new_subscriber ();
+      cv = std::get<1> (*entry);
     }
 
     bool done = false;
@@ -622,7 +721,7 @@ namespace pstore::http {
         PSTORE_ASSERT (cv != nullptr);
         cv->reset ();
         if (subscription) {
-          while (std::optional<std::string> const message = subscription->pop ()) {
+          while (brokerface::shared_message const message = subscription->pop ()) {
             log (logger::priority::info, "sending:", *message);
             error_or<IO> const eo3 =
               send_message (sender, io, opcode::text, as_bytes (gsl::make_span (*message)));
@@ -50,6 +50,13 @@ namespace pstore {
       index::digest const & header_digest () const noexcept { return header_digest_; }
       extent<std::uint8_t> const & header_extent () const noexcept { return header_; }
       generic_section const & generic () const noexcept { return g_; }
+      generic_section & generic () noexcept { return g_; }
+
+      /// Changes the extent of the CU header data. Used when the section is copied to a store
+      /// in which the header lives at a different address.
+      void set_header_extent (extent<std::uint8_t> const & header_extent) noexcept {
+        header_ = header_extent;
+      }
 
       unsigned align () const noexcept { return g_.align (); }
       // \returns The section's data payload.
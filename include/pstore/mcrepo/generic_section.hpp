@@ -218,6 +218,13 @@ namespace pstore {
         auto const * const begin = aligned_ptr<external_fixup> (ifixups ().end ());
         return {begin, begin + num_xfixups_};
       }
+      /// Provides mutable access to the external fixups so that the names to which they
+      /// refer can be relocated when the section is copied to a different store.
+      gsl::span<external_fixup> xfixups_span () {
+        // 'this' is non-const, so neither is the array that follows it.
+        container<external_fixup> const x = this->xfixups ();
+        return {const_cast<external_fixup *> (x.data ()), static_cast<std::ptrdiff_t> (x.size ())};
+      }
 
       ///@{
       /// \brief A group of member functions which return the number of bytes
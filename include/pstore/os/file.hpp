@@ -159,6 +159,8 @@ namespace pstore {
     };
 
 
+    class file_handle;
+
     /// \brief An abstract file class. Provides the interface for file access.
     class file_base {
     public:
@@ -195,6 +197,15 @@ namespace pstore {
 
       virtual std::time_t latest_time () const = 0;
 
+      /// \brief If this object is backed by a physical file, returns it. Otherwise nullptr.
+      ///
+      /// Allows callers to use operating system facilities (such as copy_range()) which operate
+      /// directly on a file descriptor without requiring run-time type information.
+      virtual file_handle * as_file_handle () noexcept { return nullptr; }
+      file_handle const * as_file_handle () const noexcept {
+        return const_cast<file_base *> (this)->as_file_handle ();
+      }
+
       ///@{
       /// \brief Reads instances of a standard-layout type from the file.
 
@@ -632,6 +643,8 @@ namespace pstore {
       bool rename (std::string const & new_name);
 
       std::time_t latest_time () const override;
+      file_handle * as_file_handle () noexcept override { return this; }
+      using file_base::as_file_handle;
 
       bool lock (std::uint64_t offset, std::size_t size, lock_kind kind,
                  blocking_mode block) override;
@@ -747,6 +760,24 @@ namespace pstore {
     /// \param allow_noent  If true, do not raise an error if the file did not exist.
     void unlink (std::string const & path, bool allow_noent = false);
 
+    /// \brief Asks the operating system to copy a range of bytes from one file to another
+    /// without passing the data through user space.
+    ///
+    /// Where the host and file system support it (for example, copy_file_range() on Linux), the
+    /// kernel may implement the copy by sharing the underlying storage extents (a "reflink") or
+    /// by copying within the page cache. Neither file's position indicator is changed.
+    ///
+    /// \param src  The file from which data is to be copied.
+    /// \param src_offset  The offset within \p src of the first byte to be copied.
+    /// \param dest  The file to which data is to be copied. Must be writable.
+    /// \param dest_offset  The offset within \p dest at which the data will be written.
+    /// \param size  The number of bytes to be copied.
+    /// \returns The number of bytes that were copied. This may be less than \p size if the
+    ///   facility is unavailable for these files or \p src ends before \p size bytes were
+    ///   copied; the caller is responsible for copying the remainder by other means.
+    std::uint64_t copy_range (file_handle const & src, std::uint64_t src_offset,
+                              file_handle & dest, std::uint64_t dest_offset, std::uint64_t size);
+
   } // end namespace file
 } // end namespace pstore
 
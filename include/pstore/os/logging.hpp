@@ -18,7 +18,9 @@
 #ifndef PSTORE_OS_LOGGING_HPP
 #define PSTORE_OS_LOGGING_HPP
 
+#include <chrono>
 #include <fstream>
+#include <memory>
 #include <mutex>
 
 #include "pstore/os/file.hpp"
@@ -68,6 +70,11 @@ namespace pstore {
     priority get_priority () const noexcept { return priority_; }
 
     virtual void log (priority p, std::string const & message) = 0;
+    /// Writes a message which was logged at time \p when, which may be a little before this
+    /// call. Loggers which record the time of each message override this; by default, the
+    /// time is ignored.
+    virtual void log (priority p, std::string const & message,
+                      std::chrono::system_clock::time_point when);
 
     virtual void log (priority p, gsl::czstring message, int d);
     virtual void log (priority p, gsl::czstring message, unsigned d);
@@ -111,7 +118,10 @@ namespace pstore {
                                     gsl::span<char, time_buffer_size> const & buffer);
 
     using logger::log;
+    /// Writes a message stamped with the current time.
     void log (priority p, std::string const & message) final;
+    void log (priority p, std::string const & message,
+              std::chrono::system_clock::time_point when) final;
 
   private:
     virtual void log_impl (std::string const & message) = 0;
@@ -168,6 +178,69 @@ namespace pstore {
     stderr_logger & operator= (stderr_logger &&) noexcept = delete;
   };
 
+  //*                                _                              *
+  //*   __ _ ___ _   _ _ __   ___   | | ___   __ _  __ _  ___ _ __  *
+  //*  / _` / __| | | | '_ \ / __|  | |/ _ \ / _` |/ _` |/ _ \ '__| *
+  //* | (_| \__ \ |_| | | | | (__   | | (_) | (_| | (_| |  __/ |    *
+  //*  \__,_|___/\__, |_| |_|\___|  |_|\___/ \__, |\__, |\___|_|    *
+  //*            |___/                       |___/ |___/            *
+  /// Hands each message to a background thread which writes it to the wrapped logger so that the
+  /// calling thread does not wait for the write (or for other threads' writes) to complete.
+  ///
+  /// Messages are formatted by the calling thread and placed in a bounded ring buffer which
+  /// belongs to that thread. The background thread started by start_async_logging() drains the
+  /// rings of all threads in batches. If the background thread is not running, messages are
+  /// written synchronously.
+  ///
+  /// \note The wrapped logger is called by the background thread. The time at which each
+  ///   message was logged is recorded and passed to the wrapped logger so that its timestamp is
+  ///   not delayed by the queue.
+  class async_logger final : public logger {
+  public:
+    explicit async_logger (std::unique_ptr<logger> && target);
+    async_logger (async_logger const &) = delete;
+    async_logger (async_logger &&) noexcept = delete;
+
+    /// Waits for any queued messages for the wrapped logger to be written.
+    ~async_logger () noexcept override;
+
+    async_logger & operator= (async_logger const &) = delete;
+    async_logger & operator= (async_logger &&) noexcept = delete;
+
+    using logger::log;
+    void log (priority p, std::string const & message) override;
+    void log (priority p, std::string const & message,
+              std::chrono::system_clock::time_point when) override;
+
+  private:
+    std::unique_ptr<logger> target_;
+  };
+
+  /// What a thread should do when it logs a message but its ring buffer is full.
+  enum class log_overflow {
+    drop, ///< Discard the message. The number of messages discarded is logged later.
+    block ///< Wait for the background thread to make space.
+  };
+
+  /// Starts the background thread which writes the messages queued by async_logger instances.
+  /// Once it is running, create_log_stream() wraps each of the destinations that it creates in
+  /// an async_logger. Does nothing if the thread is already running.
+  ///
+  /// \param ring_capacity  The number of messages that each thread may queue. Rounded up to a
+  ///   power of 2.
+  /// \param overflow  The action taken when a thread's ring buffer is full.
+  void start_async_logging (std::size_t ring_capacity = 1024,
+                            log_overflow overflow = log_overflow::drop);
+
+  /// Writes all of the queued messages and stops the background thread. Messages logged after
+  /// this call are written synchronously.
+  void stop_async_logging ();
+
+  /// Returns true if the background thread started by start_async_logging() is running.
+  bool async_logging_enabled () noexcept;
+
+  /// Blocks until every message that was queued before the call has been written.
+  void flush_log ();
 
 
   struct file_system_traits {
@@ -196,7 +269,7 @@ namespace pstore {
   namespace details {
 
     using logger_collection = std::vector<std::unique_ptr<logger>>;
-    extern thread_local logger_collection * log_destinations;
+    extern thread_local std::unique_ptr<logger_collection> log_destinations;
 
   } // end namespace details
 
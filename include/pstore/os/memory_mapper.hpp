@@ -65,6 +65,32 @@ namespace pstore {
   };
 
 
+  /// Hints which control the way in which a file is memory-mapped. These are advisory: a
+  /// host which does not support a particular feature ignores it.
+  struct mapping_policy {
+    /// The expected pattern of access to the mapped memory.
+    enum class access_pattern {
+      normal,     ///< No special treatment.
+      random,     ///< Expect page references in random order (e.g. index lookups).
+      sequential, ///< Expect page references in sequential order (e.g. export or vacuum).
+    };
+    access_pattern access = access_pattern::normal;
+    /// If true, ask the kernel to back the mapping with huge pages to reduce TLB pressure
+    /// (Linux transparent huge pages).
+    bool huge_pages = false;
+    /// If true, pre-fault the mapped pages so that first access does not incur page-faults
+    /// (Linux MAP_POPULATE).
+    bool populate = false;
+  };
+
+  /// Advises the operating system that the pages covering the range of memory given by \p addr
+  /// and \p len will be accessed in the near future. For a memory-mapped file this can start
+  /// reading the data before it is referenced. This is a hint: errors are ignored.
+  ///
+  /// \param addr  The start of the range of memory.
+  /// \param len  The number of bytes in the range.
+  void will_need (void const * addr, std::size_t len) noexcept;
+
   class memory_mapper_base {
   public:
     virtual ~memory_mapper_base () = 0;
@@ -163,14 +189,16 @@ namespace pstore {
     /// \param offset         The starting offset within the file for the mapped region. This
     ///                       value must be correctly aligned for the host OS.
     /// \param length         The number of bytes to be mapped.
+    /// \param policy         Hints controlling the way that the file is mapped.
 
     memory_mapper (file::file_handle & file, bool write_enabled, std::uint64_t offset,
-                   std::uint64_t length);
+                   std::uint64_t length, mapping_policy const & policy = mapping_policy{});
     ~memory_mapper () noexcept override;
 
   private:
     static std::shared_ptr<void> mmap (file::file_handle & file, bool write_enabled,
-                                       std::uint64_t offset, std::uint64_t length);
+                                       std::uint64_t offset, std::uint64_t length,
+                                       mapping_policy const & policy);
   };
 
 
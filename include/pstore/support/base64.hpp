@@ -17,6 +17,7 @@
 #define PSTORE_SUPPORT_BASE64_HPP
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -137,6 +138,39 @@ namespace pstore {
     return first == last ? std::optional<OutputIterator>{out} : std::optional<OutputIterator>{};
   }
 
+  /// Returns the number of characters produced by converting \p size bytes to Base64.
+  constexpr std::size_t base64_encoded_size (std::size_t const size) noexcept {
+    return (size + 2U) / 3U * 4U;
+  }
+
+  /// Returns the maximum number of bytes produced by decoding \p size Base64 characters.
+  constexpr std::size_t base64_decoded_size (std::size_t const size) noexcept {
+    return (size + 3U) / 4U * 3U;
+  }
+
+  /// Converts a contiguous array of bytes to Base64. The result is identical to that of
+  /// to_base64() but, where the host CPU allows, the bulk of the input is converted using
+  /// vector instructions.
+  ///
+  /// \param first  The first of the bytes to be converted.
+  /// \param size  The number of bytes to be converted.
+  /// \param out  A buffer which will receive the encoded characters. It must have space for at
+  ///   least base64_encoded_size(size) characters.
+  /// \returns A pointer one past the last character written to \p out.
+  char * base64_encode (std::uint8_t const * first, std::size_t size, char * out) noexcept;
+
+  /// Decodes a contiguous array of Base64 characters. The result is identical to that of
+  /// from_base64() but, where the host CPU allows, the bulk of the input is converted using
+  /// vector instructions.
+  ///
+  /// \param first  The first of the characters to be decoded.
+  /// \param size  The number of characters to be decoded.
+  /// \param out  A buffer which will receive the decoded bytes. It must have space for at
+  ///   least base64_decoded_size(size) bytes.
+  /// \returns A pointer one past the last byte written to \p out or std::nullopt if the input
+  ///   contained a character that is not part of the Base64 alphabet.
+  std::optional<std::uint8_t *> base64_decode (char const * first, std::size_t size,
+                                               std::uint8_t * out) noexcept;
 
 } // end namespace pstore
 
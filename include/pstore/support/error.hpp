@@ -58,7 +58,9 @@ namespace pstore {
   X (bad_message_part_number)                                                                      \
   X (unable_to_open_named_pipe)                                                                    \
   X (pipe_write_timeout)                                                                           \
-  X (write_failed)
+  X (write_failed)                                                                                 \
+  X (ring_buffer_corrupt)   /* shared memory did not contain a valid broker ring buffer */         \
+  X (ring_record_too_large) /* a record was too large for the broker ring buffer */
 
   // Add more error values here
 
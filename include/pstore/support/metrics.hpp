@@ -0,0 +1,183 @@
+//===- include/pstore/support/metrics.hpp -----------------*- mode: C++ -*-===//
+//*                 _        _           *
+//*  _ __ ___   ___| |_ _ __(_) ___ ___  *
+//* | '_ ` _ \ / _ \ __| '__| |/ __/ __| *
+//* | | | | | |  __/ |_| |  | | (__\__ \ *
+//* |_| |_| |_|\___|\__|_|  |_|\___|___/ *
+//*                                      *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file metrics.hpp
+/// \brief Performance counters and histograms for pstore's hot paths.
+///
+/// Each thread records its measurements in a block of counters which belongs to that thread,
+/// so recording a value never contends with another thread. The blocks of all of the running
+/// threads, together with the totals left by threads which have exited, are summed when a
+/// snapshot is taken.
+
+#ifndef PSTORE_SUPPORT_METRICS_HPP
+#define PSTORE_SUPPORT_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "pstore/support/bit_count.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore::metrics {
+
+  enum class counter : unsigned {
+    regions_mapped,     ///< Memory-mapped regions added by storage::map_bytes().
+    bytes_mapped,       ///< The total size of the regions added by storage::map_bytes().
+    spanning_reads,     ///< Calls to database::get_spanning().
+    spanning_bytes,     ///< The number of bytes copied by database::get_spanning().
+    hamt_node_loads,    ///< HAMT branch and linear nodes read from the store.
+    index_cache_hits,   ///< Index snapshots found in a database's snapshot cache.
+    index_cache_misses, ///< Index snapshots which were not in the snapshot cache.
+    broker_commands,    ///< Messages executed by the broker's command processor.
+    last
+  };
+
+  enum class histogram : unsigned {
+    allocation_bytes,  ///< The number of bytes reserved by transaction_base::allocate().
+    commit_indices_ns, ///< The time taken by a commit to write the modified indices.
+    commit_trailer_ns, ///< The time taken by a commit to write the new trailer.
+    commit_publish_ns, ///< The time taken by a commit to make the new revision visible.
+    commit_protect_ns, ///< The time taken by a commit to make its data read-only.
+    last
+  };
+
+  constexpr auto num_counters = static_cast<unsigned> (counter::last);
+  constexpr auto num_histograms = static_cast<unsigned> (histogram::last);
+  /// Bucket 0 of a histogram counts the values equal to 0; bucket n counts the values in the
+  /// range [2^(n-1), 2^n).
+  constexpr auto num_buckets = 65U;
+
+  gsl::czstring name (counter c) noexcept;
+  gsl::czstring name (histogram h) noexcept;
+
+  namespace details {
+
+    struct thread_histogram {
+      std::atomic<std::uint64_t> count{0U};
+      std::atomic<std::uint64_t> sum{0U};
+      std::array<std::atomic<std::uint64_t>, num_buckets> buckets{};
+    };
+
+    /// The measurements recorded by one thread.
+    struct thread_block {
+      std::array<std::atomic<std::uint64_t>, num_counters> counters{};
+      std::array<thread_histogram, num_histograms> histograms{};
+
+      /// Links in the list of the blocks of running threads. Guarded by the registry mutex.
+      thread_block * prev = nullptr;
+      thread_block * next = nullptr;
+    };
+
+    /// Returns the calling thread's block, registering it if this is the thread's first
+    /// measurement.
+    thread_block & this_thread () noexcept;
+
+    /// Adds \p n to a value which is written only by its owning thread. A plain load and store
+    /// are sufficient and cheaper than a read-modify-write.
+    inline void add (std::atomic<std::uint64_t> & value, std::uint64_t const n) noexcept {
+      value.store (value.load (std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /// Returns the index of the histogram bucket which counts \p value.
+    inline unsigned bucket (std::uint64_t const value) noexcept {
+      return value == 0U ? 0U : 64U - bit_count::clz (value);
+    }
+
+  } // end namespace details
+
+  /// Adds \p n to counter \p c.
+  inline void increment (counter const c, std::uint64_t const n = 1U) noexcept {
+    details::add (details::this_thread ().counters[static_cast<unsigned> (c)], n);
+  }
+
+  /// Adds \p value to histogram \p h.
+  inline void record (histogram const h, std::uint64_t const value) noexcept {
+    details::thread_histogram & th =
+      details::this_thread ().histograms[static_cast<unsigned> (h)];
+    details::add (th.count, 1U);
+    details::add (th.sum, value);
+    details::add (th.buckets[details::bucket (value)], 1U);
+  }
+
+  //*      _                           _       _      *
+  //*  ___| |_ ___  _ ____      ____ _| |_ ___| |__   *
+  //* / __| __/ _ \| '_ \ \ /\ / / _` | __/ __| '_ \  *
+  //* \__ \ || (_) | |_) \ V  V / (_| | || (__| | | | *
+  //* |___/\__\___/| .__/ \_/\_/ \__,_|\__\___|_| |_| *
+  //*              |_|                                *
+  /// Measures the durations of a sequence of phases.
+  class stopwatch {
+  public:
+    stopwatch () noexcept
+            : start_{clock::now ()} {}
+
+    /// Records the number of nanoseconds since the stopwatch was created (or since the
+    /// previous call to lap()) in histogram \p h.
+    void lap (histogram const h) noexcept {
+      auto const now = clock::now ();
+      auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds> (now - start_);
+      record (h, static_cast<std::uint64_t> (ns.count ()));
+      start_ = now;
+    }
+
+  private:
+    using clock = std::chrono::steady_clock;
+    clock::time_point start_;
+  };
+
+  //*                            _           _    *
+  //*  ___ _ __   __ _ _ __  ___| |__   ___ | |_  *
+  //* / __| '_ \ / _` | '_ \/ __| '_ \ / _ \| __| *
+  //* \__ \ | | | (_| | |_) \__ \ | | | (_) | |_  *
+  //* |___/_| |_|\__,_| .__/|___/_| |_|\___/ \__| *
+  //*                 |_|                         *
+  struct histogram_snapshot {
+    std::uint64_t count = 0U;
+    std::uint64_t sum = 0U;
+    std::array<std::uint64_t, num_buckets> buckets{};
+  };
+
+  /// The totals of every thread's measurements at the time that collect() was called.
+  struct snapshot {
+    std::array<std::uint64_t, num_counters> counters{};
+    std::array<histogram_snapshot, num_histograms> histograms{};
+
+    std::uint64_t operator[] (counter const c) const noexcept {
+      return counters[static_cast<unsigned> (c)];
+    }
+    histogram_snapshot const & operator[] (histogram const h) const noexcept {
+      return histograms[static_cast<unsigned> (h)];
+    }
+  };
+
+  /// Sums the measurements recorded by all threads.
+  snapshot collect ();
+
+  /// Converts a snapshot to a JSON object of the form:
+  ///
+  ///     { "counters": { "regions_mapped": 1, ... },
+  ///       "histograms": { "allocation_bytes": { "count": 2, "sum": 24,
+  ///                                             "buckets": { "8": 1, "16": 1 } }, ... } }
+  ///
+  /// Only the histogram buckets with a non-zero count are included. Each is keyed by the
+  /// smallest value that it counts.
+  std::string to_json (snapshot const & s);
+
+} // end namespace pstore::metrics
+
+#endif // PSTORE_SUPPORT_METRICS_HPP
@@ -124,6 +124,14 @@ namespace pstore {
 #  define PSTORE_UNLIKELY(expr) (expr)
 #endif
 
+/// A macro which is a wrapper around __builtin_prefetch() which is available with both GCC and
+/// Clang to hint that the cache line containing the given address will shortly be read.
+#if __has_builtin(__builtin_prefetch)
+#  define PSTORE_PREFETCH(addr) __builtin_prefetch ((addr))
+#else
+#  define PSTORE_PREFETCH(addr) ((void) (addr))
+#endif
+
 
 // Specifies that the function does not return.
 #if __has_cpp_attribute(noreturn)
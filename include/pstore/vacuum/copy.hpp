@@ -21,6 +21,11 @@
 #define VACUUM_COPY_HPP (1)
 
 #include <memory>
+#include <mutex>
+#include <string>
+
+#include "pstore/os/file.hpp"
+#include "pstore/vacuum/incremental.hpp"
 
 namespace pstore {
   class database;
@@ -28,7 +33,54 @@ namespace pstore {
 namespace vacuum {
   struct status;
   struct user_options;
-  void copy (std::shared_ptr<pstore::database> source, status * const st, user_options const & opt);
+
+  /// Replaces the source store with the vacuumed copy at \p destination_path provided that
+  /// the source's head revision is \p revision. The check and the rename are made whilst
+  /// holding \p lock so that no other process can add a revision in between. On success, the
+  /// watch thread is stopped and \p source is reset.
+  ///
+  /// \param source  The store being vacuumed.
+  /// \param lock  The source's exclusive vacuum lock (see database::upgrade_to_write_lock()).
+  /// \param destination_path  The path of the vacuumed copy.
+  /// \param revision  The source revision that was copied.
+  /// \param st  The vacuum status.
+  /// \returns True if the source was replaced, false if it has been modified since
+  ///   \p revision or is open in another process.
+  bool replace_source (std::shared_ptr<pstore::database> & source,
+                       std::unique_lock<pstore::file::range_lock> & lock,
+                       std::string const & destination_path, unsigned revision, status * st);
+
+  /// Brings the store at \p destination_path up to date with the source's head revision,
+  /// resuming the copy recorded by its checkpoint file if there is one.
+  ///
+  /// \param source  The store being vacuumed.
+  /// \param destination_path  The path of the vacuumed copy.
+  /// \param st  The vacuum status. The copy is interrupted if the watch thread sets its
+  ///   'modified' flag or the vacuum is stopped.
+  /// \param cp  Receives the progress of the copy.
+  /// \returns True if the destination holds cp->target_revision, which was the source's head
+  ///   revision when last checked, false if the copy was interrupted.
+  bool copy_incremental (std::shared_ptr<pstore::database> const & source,
+                         std::string const & destination_path, status * st, checkpoint * cp);
+
+  /// Replaces the source with the store built by copy_incremental(). A copy of the vacuumed
+  /// store and a checkpoint recording that all of its revisions have been copied are left at
+  /// \p destination_path so that the next incremental vacuum copies only later revisions.
+  ///
+  /// \param source  The store being vacuumed.
+  /// \param lock  The source's exclusive vacuum lock.
+  /// \param destination_path  The path of the vacuumed copy.
+  /// \param cp  The checkpoint produced by copy_incremental().
+  /// \param st  The vacuum status.
+  /// \returns True if the source was replaced.
+  bool replace_source_incremental (std::shared_ptr<pstore::database> & source,
+                                   std::unique_lock<pstore::file::range_lock> & lock,
+                                   std::string const & destination_path, checkpoint const & cp,
+                                   status * st);
+
+  void copy (std::shared_ptr<pstore::database> source,
+             std::unique_lock<pstore::file::range_lock> & lock, status * const st,
+             user_options const & opt);
 } // namespace vacuum
 
 #endif // VACUUM_COPY_HPP
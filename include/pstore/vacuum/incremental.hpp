@@ -0,0 +1,146 @@
+//===- include/pstore/vacuum/incremental.hpp --------------*- mode: C++ -*-===//
+//*  _                                          _        _  *
+//* (_)_ __   ___ _ __ ___ _ __ ___   ___ _ __ | |_ __ _| | *
+//* | | '_ \ / __| '__/ _ \ '_ ` _ \ / _ \ '_ \| __/ _` | | *
+//* | | | | | (__| | |  __/ | | | | |  __/ | | | || (_| | | *
+//* |_|_| |_|\___|_|  \___|_| |_| |_|\___|_| |_|\__\__,_|_| *
+//*                                                         *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file incremental.hpp
+/// \brief Generational copying of a store's indices.
+///
+/// Rather than rewriting the entire store on every pass, an incremental vacuum copies only the
+/// index entries that were added by revisions newer than those that it has already copied.
+/// Progress is recorded in a small checkpoint file which lives alongside the destination store
+/// so that a pass which is interrupted -- because the source was modified or the process was
+/// stopped -- resumes from where it left off rather than starting again.
+
+#ifndef PSTORE_VACUUM_INCREMENTAL_HPP
+#define PSTORE_VACUUM_INCREMENTAL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "pstore/core/uuid.hpp"
+
+namespace pstore {
+  class database;
+}
+
+namespace vacuum {
+
+  /// The stages of an incremental copy. Each stage copies the entries that were added to one
+  /// of the source's indices. The order matters: fragments and compilations refer to names, and
+  /// fragments refer to debug line headers. Fragments and compilations may refer to each other
+  /// so either stage may copy members of the other's index.
+  enum class phase : std::uint32_t {
+    names,
+    paths,
+    debug_line_headers,
+    write,
+    fragments,
+    compilations,
+    complete,
+  };
+
+  /// The persistent state of an incremental vacuum.
+  struct checkpoint {
+    static constexpr std::array<std::uint8_t, 8> file_signature{
+      {'p', 'V', 'a', 'c', 'C', 'k', 'p', 't'}};
+
+    checkpoint () noexcept = default;
+    explicit checkpoint (pstore::uuid const & id) noexcept
+            : source_id{id.array ()} {}
+
+    std::array<std::uint8_t, 8> signature = file_signature;
+    /// The ID of the store being copied.
+    pstore::uuid::container_type source_id{};
+    /// All of the source revisions up to and including base_revision have been copied.
+    std::uint32_t base_revision = 0;
+    /// The source revision to which the destination is being brought up to date.
+    std::uint32_t target_revision = 0;
+    /// The destination's revision when the copy of the current target began.
+    std::uint32_t destination_revision = 0;
+    /// The stage of the copy that is in progress.
+    phase stage = phase::complete;
+    /// The number of entries of the current stage that have already been copied.
+    std::uint64_t done = 0;
+    std::uint32_t crc = 0;
+    std::uint32_t padding2 = 0;
+
+    /// Computes the CRC of the checkpoint's contents (excluding the crc field itself).
+    std::uint32_t get_crc () const noexcept;
+    /// Returns true if the signature and CRC fields are correct.
+    bool is_valid () const noexcept;
+  };
+
+  static_assert (std::is_standard_layout_v<checkpoint>, "checkpoint must be standard-layout");
+  static_assert (offsetof (checkpoint, crc) == 48, "crc offset differs from expected value");
+  static_assert (sizeof (checkpoint) == 56, "checkpoint size differs from expected value");
+
+  /// \param destination_path  The path of the store being built by the vacuum.
+  /// \returns The path of the checkpoint file which accompanies \p destination_path.
+  std::string checkpoint_path (std::string const & destination_path);
+
+  /// Reads a checkpoint file.
+  ///
+  /// \param path  The path of the checkpoint file.
+  /// \param source_id  The ID of the store being vacuumed.
+  /// \returns The checkpoint or nothing if the file does not exist, is corrupt, or records
+  ///   the progress of a different store.
+  std::optional<checkpoint> read_checkpoint (std::string const & path,
+                                             pstore::uuid const & source_id);
+
+  /// Writes a checkpoint file, replacing any previous contents.
+  void write_checkpoint (std::string const & path, checkpoint const & cp);
+
+  /// Starts a new generation: everything up to the previous target revision has been copied
+  /// and the next copy will bring the destination up to the source's current revision.
+  ///
+  /// \param cp  The checkpoint to be updated. Its stage must be phase::complete.
+  /// \param source  The store being vacuumed.
+  /// \param destination  The store into which data is copied.
+  void start_generation (checkpoint * cp, pstore::database const & source,
+                         pstore::database const & destination);
+
+  /// The default number of index entries copied by each destination transaction.
+  constexpr auto default_batch_size = std::size_t{4096};
+
+  /// Copies to \p destination the index entries that were added to \p source by revisions
+  /// after cp->base_revision up to and including cp->target_revision. Addresses held by the
+  /// copied data -- names referenced by fixups and compilations, debug line headers, fragment
+  /// extents, and linked definitions -- are relocated to refer to their copies.
+  ///
+  /// The destination is committed after every \p batch_size entries and \p cp is updated and
+  /// passed to \p save so that the work is not lost if the copy is interrupted. Copying an
+  /// entry more than once is harmless because every destination index entry is inserted by
+  /// key.
+  ///
+  /// \param source  The store being vacuumed. It must be synced to cp->target_revision.
+  /// \param destination  The store into which data is copied.
+  /// \param cp  The progress of the copy. Updated as batches are committed.
+  /// \param save  Called after each batch is committed to record \p cp.
+  /// \param interrupted  Polled between entries. If it returns true, the current batch is
+  ///   committed and the function returns.
+  /// \param batch_size  The number of entries copied by each destination transaction.
+  /// \returns True if the copy reached cp->target_revision, false if it was interrupted.
+  bool copy_generations (pstore::database const & source, pstore::database & destination,
+                         checkpoint * cp, std::function<void (checkpoint const &)> const & save,
+                         std::function<bool ()> const & interrupted,
+                         std::size_t batch_size = default_batch_size);
+
+} // end namespace vacuum
+
+#endif // PSTORE_VACUUM_INCREMENTAL_HPP
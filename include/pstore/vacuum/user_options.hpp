@@ -23,6 +23,9 @@ namespace vacuum {
 
   struct user_options {
     bool daemon_mode = false;
+    /// If true, copy only the data added since the previous vacuum, resuming from the
+    /// checkpoint left by an interrupted run.
+    bool incremental = false;
     std::string src_path;
   };
 
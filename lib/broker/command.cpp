@@ -35,6 +35,7 @@
 #include "pstore/brokerface/writer.hpp"
 #include "pstore/os/logging.hpp"
 #include "pstore/os/time.hpp"
+#include "pstore/support/metrics.hpp"
 
 namespace {
 
@@ -78,14 +79,11 @@ namespace pstore::broker {
 
   // ctor
   // ~~~~
-  command_processor::command_processor (
-    unsigned num_read_threads,
-    gsl::not_null<std::optional<http::server_status> *> const http_status,
-    gsl::not_null<std::atomic<bool> *> uptime_done, std::chrono::seconds scavenge_threshold)
-          : http_status_{http_status}
-          , uptime_done_{uptime_done}
-          , delete_threshold_{scavenge_threshold}
-          , num_read_threads_{num_read_threads} {
+  command_processor::command_processor (std::chrono::seconds const scavenge_threshold,
+                                        unsigned const num_command_threads)
+          : delete_threshold_{scavenge_threshold}
+          , num_command_threads_{num_command_threads} {
+    PSTORE_ASSERT (num_command_threads > 0U);
     PSTORE_ASSERT (
       std::is_sorted (std::begin (commands_), std::end (commands_), command_entry_compare));
   }
@@ -93,8 +91,10 @@ namespace pstore::broker {
   // suicide
   // ~~~~~~~
   void command_processor::suicide (brokerface::fifo_path const &, broker_command const &) {
-    std::shared_ptr<scavenger> const scav = scavenger_.get ();
-    shutdown (this, scav.get (), sig_self_quit, num_read_threads_, http_status_, uptime_done_);
+    // Shutting down pushes commands onto the (bounded) command queue. We're running on a
+    // command thread so doing that here could block forever if the queue were full: hand the
+    // job to the quit thread instead.
+    notify_quit_thread ();
   }
 
   // quit
@@ -126,10 +126,10 @@ namespace pstore::broker {
   void command_processor::gc (brokerface::fifo_path const &, broker_command const & c) {
     start_vacuum (c.path);
 
-    ++commits_;
-    commits_channel.publish ([this] () {
+    unsigned const commits = ++commits_;
+    commits_channel.publish ([commits] () {
       std::ostringstream os;
-      os << "{ \"commits\": " << commits_ << " }";
+      os << "{ \"commits\": " << commits << " }";
       std::string const & str = os.str ();
       PSTORE_ASSERT (is_valid_json (str));
       return str;
@@ -200,15 +200,22 @@ namespace pstore::broker {
                                            brokerface::message_type const & msg) {
     auto const command = this->parse (msg);
     if (broker_command const * const c = command.get ()) {
-      this->log (*c);
-      auto const pos =
-        std::lower_bound (std::begin (commands_), std::end (commands_),
-                          command_entry (c->verb.c_str (), nullptr), command_entry_compare);
-      if (pos != std::end (commands_) && c->verb == std::get<gsl::czstring> (*pos)) {
-        std::get<handler> (*pos) (this, fifo, *c);
-      } else {
-        this->unknown (*c);
-      }
+      this->execute (fifo, *c);
+    }
+  }
+
+  // execute
+  // ~~~~~~~
+  void command_processor::execute (brokerface::fifo_path const & fifo, broker_command const & c) {
+    metrics::increment (metrics::counter::broker_commands);
+    this->log (c);
+    auto const pos =
+      std::lower_bound (std::begin (commands_), std::end (commands_),
+                        command_entry (c.verb.c_str (), nullptr), command_entry_compare);
+    if (pos != std::end (commands_) && c.verb == std::get<gsl::czstring> (*pos)) {
+      std::get<handler> (*pos) (this, fifo, c);
+    } else {
+      this->unknown (c);
     }
   }
 
@@ -226,10 +233,16 @@ namespace pstore::broker {
     try {
       pstore::log (priority::info, "Waiting for commands");
       while (!commands_done_) {
-        brokerface::message_ptr msg = messages_.pop ();
-        PSTORE_ASSERT (msg);
-        this->process_command (fifo, *msg);
-        pool.return_to_pool (std::move (msg));
+        queued_command cmd = messages_.pop ();
+        if (auto * const msg = std::get_if<brokerface::message_ptr> (&cmd)) {
+          PSTORE_ASSERT (*msg);
+          this->process_command (fifo, **msg);
+          pool.return_to_pool (std::move (*msg));
+        } else {
+          auto const & c = std::get<std::unique_ptr<broker_command>> (cmd);
+          PSTORE_ASSERT (c);
+          this->execute (fifo, *c);
+        }
       }
     } catch (std::exception const & ex) {
       pstore::log (priority::error, "An error occurred: ", ex.what ());
@@ -246,7 +259,15 @@ namespace pstore::broker {
     if (record_file != nullptr) {
       record_file->record (*cmd);
     }
-    messages_.push (std::move (cmd));
+    messages_.push (queued_command{std::move (cmd)});
+  }
+
+  void command_processor::push_command (std::unique_ptr<broker_command> && cmd,
+                                        recorder * const record_file) {
+    if (record_file != nullptr) {
+      record_file->record (*cmd);
+    }
+    messages_.push (queued_command{std::move (cmd)});
   }
 
   // clear queue
@@ -104,15 +104,18 @@ namespace pstore::broker {
         }
 
         cmds.erase (it);
-
-        auto end = std::end (complete_command);
-        auto const verb_parts = extract_word (std::begin (complete_command), end);
-        auto const path_parts = std::make_pair (skip_ws (verb_parts.second, end), end);
-        return std::make_unique<broker_command> (substr (verb_parts), substr (path_parts));
+        return parse (complete_command);
       }
     }
 
     return nullptr;
   }
 
+  std::unique_ptr<broker_command> parse (std::string const & command) {
+    auto end = std::end (command);
+    auto const verb_parts = extract_word (std::begin (command), end);
+    auto const path_parts = std::make_pair (skip_ws (verb_parts.second, end), end);
+    return std::make_unique<broker_command> (substr (verb_parts), substr (path_parts));
+  }
+
 } // end namespace pstore::broker
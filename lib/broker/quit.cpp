@@ -71,7 +71,8 @@ namespace pstore {
                    not_null<std::atomic<bool> *> const uptime_done) {
 
       // Set the global "done" flag unless we're already shutting down. The latter condition
-      // happens if a "SUICIDE" command is received and the quit thread is woken in response.
+      // happens if playback of a recording completes and the quit thread is woken in
+      // response.
       bool expected = false;
       if (done.compare_exchange_strong (expected, true)) {
         std::cerr << "pstore broker is exiting.\n";
@@ -89,8 +90,10 @@ namespace pstore {
           for (auto ctr = 0U; ctr < num_read_threads; ++ctr) {
             push (cp, read_loop_quit_command);
           }
-          // Finally ask the command loop thread to exit.
-          push (cp, command_loop_quit_command);
+          // Finally ask the command loop threads to exit.
+          for (auto ctr = 0U; ctr < cp->num_command_threads (); ++ctr) {
+            push (cp, command_loop_quit_command);
+          }
         }
 
         pstore::http::quit (http_status);
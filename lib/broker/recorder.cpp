@@ -19,7 +19,10 @@
 
 #include "pstore/broker/recorder.hpp"
 
+#include <algorithm>
+
 #include "pstore/broker/message_pool.hpp"
+#include "pstore/broker/parser.hpp"
 #include "pstore/support/utf.hpp"
 
 namespace pstore::broker {
@@ -48,6 +51,33 @@ namespace pstore::broker {
     file_.write (cmd);
   }
 
+  void recorder::record (broker_command const & cmd) {
+    using brokerface::message_type;
+    std::string payload = cmd.verb;
+    if (!cmd.path.empty ()) {
+      payload += ' ';
+      payload += cmd.path;
+    }
+    auto const num_parts = std::max (
+      std::size_t{1}, (payload.length () + message_type::payload_chars - 1U) /
+                        message_type::payload_chars);
+    if (num_parts > std::numeric_limits<std::uint16_t>::max ()) {
+      raise (error_code::bad_message_part_number);
+    }
+
+    std::unique_lock<decltype (mut_)> const lock (mut_);
+    std::uint32_t const mid = message_id_++;
+    auto first = std::begin (payload);
+    for (auto part = std::size_t{0}; part < num_parts; ++part) {
+      auto const last = first + static_cast<std::string::difference_type> (std::min (
+                                  message_type::payload_chars,
+                                  static_cast<std::size_t> (std::end (payload) - first)));
+      file_.write (message_type{mid, static_cast<std::uint16_t> (part),
+                                static_cast<std::uint16_t> (num_parts), first, last});
+      first = last;
+    }
+  }
+
 
   //*       _                    *
   //*  _ __| |__ _ _  _ ___ _ _  *
@@ -0,0 +1,57 @@
+//===- lib/broker/ring_read_loop.cpp --------------------------------------===//
+//*       _                                   _    _                    *
+//*  _ __(_)_ __   __ _    _ __ ___  __ _  __| |  | | ___   ___  _ __   *
+//* | '__| | '_ \ / _` |  | '__/ _ \/ _` |/ _` |  | |/ _ \ / _ \| '_ \  *
+//* | |  | | | | | (_| |  | | |  __/ (_| | (_| |  | | (_) | (_) | |_) | *
+//* |_|  |_|_| |_|\__, |  |_|  \___|\__,_|\__,_|  |_|\___/ \___/| .__/  *
+//*               |___/                                         |_|     *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file ring_read_loop.cpp
+
+#include "pstore/broker/read_loop.hpp"
+
+#include <string>
+
+#include "pstore/broker/command.hpp"
+#include "pstore/broker/globals.hpp"
+#include "pstore/broker/quit.hpp"
+#include "pstore/brokerface/ring_buffer.hpp"
+#include "pstore/os/logging.hpp"
+
+namespace pstore::broker {
+
+  // ring read loop
+  // ~~~~~~~~~~~~~~
+  void ring_read_loop (brokerface::ring_buffer & ring, std::shared_ptr<recorder> & record_file,
+                       std::shared_ptr<command_processor> const cp) {
+    using priority = logger::priority;
+    try {
+      log (priority::notice, "listening to ring buffer");
+      std::string command;
+      while (!done) {
+        if (ring.try_pop (&command)) {
+          cp->push_command (parse (command), record_file.get ());
+        } else {
+          ring.wait (details::ring_wait_timeout);
+        }
+      }
+    } catch (std::exception const & ex) {
+      log (priority::error, "error: ", ex.what ());
+      exit_code = EXIT_FAILURE;
+      notify_quit_thread ();
+    } catch (...) {
+      log (priority::error, "unknown error");
+      exit_code = EXIT_FAILURE;
+      notify_quit_thread ();
+    }
+    log (priority::notice, "exiting ring read loop");
+  }
+
+} // end namespace pstore::broker
@@ -50,7 +50,9 @@ namespace pstore::broker {
       } catch (...) {
         log (priority::error, "fork unknown error");
       }
-      std::exit (EXIT_FAILURE);
+      // Don't run the parent's exit-time handlers and static destructors in the child: they
+      // would, for example, flush copies of the parent's buffered output.
+      ::_exit (EXIT_FAILURE);
     }
     default:
       // When fork() returns a positive number, we are in the parent process
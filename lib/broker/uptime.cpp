@@ -27,6 +27,7 @@
 // pstore
 #include "pstore/os/logging.hpp"
 #include "pstore/os/thread.hpp"
+#include "pstore/support/metrics.hpp"
 
 namespace {
 
@@ -45,6 +46,8 @@ namespace pstore::broker {
 
   descriptor_condition_variable uptime_cv;
   brokerface::channel<descriptor_condition_variable> uptime_channel (&uptime_cv);
+  descriptor_condition_variable metrics_cv;
+  brokerface::channel<descriptor_condition_variable> metrics_channel (&metrics_cv);
 
   void uptime (gsl::not_null<std::atomic<bool> *> const done) {
     log (logger::priority::info, "uptime 1 second tick starting");
@@ -63,6 +66,11 @@ namespace pstore::broker {
         PSTORE_ASSERT (is_valid_json (str));
         return str;
       });
+      metrics_channel.publish ([] () {
+        std::string str = metrics::to_json (metrics::collect ());
+        PSTORE_ASSERT (is_valid_json (str));
+        return str;
+      });
     }
 
     log (logger::priority::info, "uptime thread exiting");
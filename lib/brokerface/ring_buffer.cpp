@@ -0,0 +1,294 @@
+//===- lib/brokerface/ring_buffer.cpp -------------------------------------===//
+//*       _                _            __  __            *
+//*  _ __(_)_ __   __ _   | |__  _   _ / _|/ _| ___ _ __  *
+//* | '__| | '_ \ / _` |  | '_ \| | | | |_| |_ / _ \ '__| *
+//* | |  | | | | | (_| |  | |_) | |_| |  _|  _|  __/ |    *
+//* |_|  |_|_| |_|\__, |  |_.__/ \__,_|_| |_|  \___|_|    *
+//*               |___/                                   *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file ring_buffer.cpp
+/// \brief Implements the multi-producer, single-consumer ring buffer used by the broker's
+/// shared-memory transport.
+
+#include "pstore/brokerface/ring_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include "pstore/config/config.hpp"
+#include "pstore/support/aligned.hpp"
+#include "pstore/support/assert.hpp"
+#include "pstore/support/error.hpp"
+
+#ifdef PSTORE_HAVE_LINUX_FUTEX_H
+#  include <climits>
+#  include <ctime>
+
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+
+  constexpr std::size_t cache_line_size = 64;
+
+  /// The value stored in the first word of a buffer's control block.
+  constexpr std::uint64_t ring_magic = UINT64_C (0x31676e6952747370); // "pstRing1"
+
+  // Each record starts with a 32-bit state word followed by 32 bits of padding so that the
+  // payload is 8-byte aligned. The state word is zero until the record is published.
+  constexpr std::size_t record_header_size = 8;
+  constexpr std::uint32_t published_flag = UINT32_C (1) << 31U;
+  constexpr std::uint32_t padding_flag = UINT32_C (1) << 30U;
+  constexpr std::uint32_t length_mask = padding_flag - 1U;
+
+  static_assert (pstore::brokerface::ring_buffer::max_capacity <= length_mask + std::size_t{1},
+                 "The length of a padding record must be representable in its state word");
+
+  /// Returns the number of bytes of buffer occupied by a record with \p length bytes of
+  /// payload.
+  constexpr std::size_t record_span (std::size_t const length) noexcept {
+    return pstore::aligned (record_header_size + length, record_header_size);
+  }
+
+  std::atomic<std::uint32_t> & state_word (std::uint8_t * const record) noexcept {
+    return *reinterpret_cast<std::atomic<std::uint32_t> *> (record);
+  }
+
+#ifdef PSTORE_HAVE_LINUX_FUTEX_H
+  // The futex operations deliberately omit FUTEX_PRIVATE_FLAG: the word that they use may be
+  // shared with other processes.
+  void futex_wait (std::atomic<std::uint32_t> * const word, std::uint32_t const expected,
+                   std::chrono::milliseconds const timeout) noexcept {
+    auto const secs = std::chrono::duration_cast<std::chrono::seconds> (timeout);
+    timespec ts{};
+    ts.tv_sec = static_cast<std::time_t> (secs.count ());
+    ts.tv_nsec = static_cast<long> (
+      std::chrono::duration_cast<std::chrono::nanoseconds> (timeout - secs).count ());
+    ::syscall (SYS_futex, reinterpret_cast<std::uint32_t *> (word), FUTEX_WAIT, expected, &ts,
+               nullptr, 0);
+  }
+
+  void futex_wake (std::atomic<std::uint32_t> * const word) noexcept {
+    ::syscall (SYS_futex, reinterpret_cast<std::uint32_t *> (word), FUTEX_WAKE, INT_MAX, nullptr,
+               nullptr, 0);
+  }
+#endif // PSTORE_HAVE_LINUX_FUTEX_H
+
+} // end anonymous namespace
+
+namespace pstore::brokerface {
+
+  struct ring_buffer::control {
+    /// Always equal to ring_magic in a correctly formatted buffer.
+    std::atomic<std::uint64_t> magic;
+    /// The number of bytes of record storage which follow the control block.
+    std::uint64_t capacity;
+
+    /// The total number of bytes reserved by producers.
+    alignas (cache_line_size) std::atomic<std::uint64_t> head;
+    /// The total number of bytes released by the consumer.
+    alignas (cache_line_size) std::atomic<std::uint64_t> tail;
+
+    /// Incremented each time that a record is published. The consumer sleeps on this word.
+    alignas (cache_line_size) std::atomic<std::uint32_t> signal;
+    /// Non-zero whilst the consumer is sleeping (or about to sleep) in wait().
+    std::atomic<std::uint32_t> waiting;
+  };
+
+  static_assert (std::atomic<std::uint64_t>::is_always_lock_free &&
+                   std::atomic<std::uint32_t>::is_always_lock_free,
+                 "Atomics in shared memory must be lock free");
+  static_assert (std::is_standard_layout_v<std::atomic<std::uint32_t>> &&
+                   sizeof (std::atomic<std::uint32_t>) == sizeof (std::uint32_t),
+                 "A record state word must be a plain 32-bit value");
+
+  // region size
+  // ~~~~~~~~~~~
+  std::size_t ring_buffer::region_size (std::size_t const capacity) noexcept {
+    return aligned (sizeof (control), cache_line_size) + capacity;
+  }
+
+  // create
+  // ~~~~~~
+  ring_buffer ring_buffer::create (gsl::not_null<void *> const region,
+                                   std::size_t const capacity) {
+    PSTORE_ASSERT (is_power_of_two (capacity) && capacity >= min_capacity &&
+                   capacity <= max_capacity);
+    PSTORE_ASSERT (reinterpret_cast<std::uintptr_t> (region.get ()) % cache_line_size == 0U);
+
+    auto * const base = static_cast<std::uint8_t *> (region.get ());
+    std::memset (base, 0, region_size (capacity));
+    auto * const ctrl = new (base) control;
+    ctrl->capacity = capacity;
+    ctrl->head.store (0U, std::memory_order_relaxed);
+    ctrl->tail.store (0U, std::memory_order_relaxed);
+    ctrl->signal.store (0U, std::memory_order_relaxed);
+    ctrl->waiting.store (0U, std::memory_order_relaxed);
+    // Write the magic number last so that a client cannot attach to a half-formatted buffer.
+    ctrl->magic.store (ring_magic, std::memory_order_release);
+    return {ctrl, base + aligned (sizeof (control), cache_line_size), capacity};
+  }
+
+  // attach
+  // ~~~~~~
+  ring_buffer ring_buffer::attach (gsl::not_null<void *> const region, std::size_t const size) {
+    auto * const base = static_cast<std::uint8_t *> (region.get ());
+    if (size < region_size (min_capacity)) {
+      raise (error_code::ring_buffer_corrupt);
+    }
+    auto * const ctrl = reinterpret_cast<control *> (base);
+    if (ctrl->magic.load (std::memory_order_acquire) != ring_magic) {
+      raise (error_code::ring_buffer_corrupt);
+    }
+    std::uint64_t const capacity = ctrl->capacity;
+    if (!is_power_of_two (capacity) || capacity < min_capacity || capacity > max_capacity ||
+        region_size (capacity) > size) {
+      raise (error_code::ring_buffer_corrupt);
+    }
+    return {ctrl, base + aligned (sizeof (control), cache_line_size),
+            static_cast<std::size_t> (capacity)};
+  }
+
+  // capacity
+  // ~~~~~~~~
+  std::size_t ring_buffer::capacity () const noexcept { return capacity_; }
+
+  // max record size
+  // ~~~~~~~~~~~~~~~
+  std::size_t ring_buffer::max_record_size () const noexcept {
+    // Limiting a record to half of the buffer guarantees that it will fit once the buffer has
+    // drained, however much padding is needed to reach the start of the buffer.
+    return this->capacity () / 2U - record_header_size;
+  }
+
+  // try push
+  // ~~~~~~~~
+  bool ring_buffer::try_push (std::string_view const payload) {
+    if (payload.length () > this->max_record_size ()) {
+      raise (error_code::ring_record_too_large);
+    }
+    std::uint64_t const capacity = capacity_;
+    std::uint64_t const span = record_span (payload.length ());
+
+    // Reserve space for the record (and any padding needed to keep it contiguous).
+    std::uint64_t head = ctrl_->head.load (std::memory_order_relaxed);
+    std::uint64_t offset = 0;
+    std::uint64_t total = 0;
+    do {
+      offset = head & (capacity - 1U);
+      std::uint64_t const contiguous = capacity - offset;
+      total = span <= contiguous ? span : contiguous + span;
+      if (head + total - ctrl_->tail.load (std::memory_order_acquire) > capacity) {
+        return false;
+      }
+    } while (!ctrl_->head.compare_exchange_weak (head, head + total, std::memory_order_relaxed,
+                                                 std::memory_order_relaxed));
+
+    if (total != span) {
+      // Fill the space up to the end of the buffer with a padding record.
+      auto const padding = static_cast<std::uint32_t> (capacity - offset);
+      state_word (data_ + offset).store (published_flag | padding_flag | padding,
+                                         std::memory_order_release);
+      offset = 0;
+    }
+
+    std::uint8_t * const record = data_ + offset;
+    std::copy (std::begin (payload), std::end (payload), record + record_header_size);
+    state_word (record).store (published_flag | static_cast<std::uint32_t> (payload.length ()),
+                               std::memory_order_release);
+    this->notify ();
+    return true;
+  }
+
+  // try pop
+  // ~~~~~~~
+  bool ring_buffer::try_pop (gsl::not_null<std::string *> const out) {
+    std::uint64_t tail = ctrl_->tail.load (std::memory_order_relaxed);
+    for (;;) {
+      // The control block and the records are shared with the producers so nothing that they
+      // contain is trusted: a misbehaving producer must not be able to make the consumer read
+      // or write outside of the buffer.
+      if (tail % record_header_size != 0U) {
+        raise (error_code::ring_buffer_corrupt);
+      }
+      auto const offset = static_cast<std::size_t> (tail & (capacity_ - 1U));
+      std::uint8_t * const record = data_ + offset;
+      std::uint32_t const state = state_word (record).load (std::memory_order_acquire);
+      if ((state & published_flag) == 0U) {
+        return false;
+      }
+      std::size_t const length = state & length_mask;
+      bool const is_padding = (state & padding_flag) != 0U;
+      // Padding always runs to the end of the buffer. A record is no larger than
+      // max_record_size() and never straddles the end of the buffer.
+      std::size_t const span = is_padding ? length : record_span (length);
+      if (is_padding ? (length == 0U || length != capacity_ - offset)
+                     : (length > this->max_record_size () || offset + span > capacity_)) {
+        raise (error_code::ring_buffer_corrupt);
+      }
+      if (!is_padding) {
+        out->assign (reinterpret_cast<char const *> (record + record_header_size), length);
+      }
+      // Zero the record so that its state word reads as unpublished when the space is next
+      // reserved. Releasing the tail makes the cleared memory visible to the producers.
+      std::memset (record, 0, span);
+      tail += span;
+      ctrl_->tail.store (tail, std::memory_order_release);
+      if (!is_padding) {
+        return true;
+      }
+    }
+  }
+
+  // empty
+  // ~~~~~
+  bool ring_buffer::empty () const noexcept {
+    std::uint64_t const tail = ctrl_->tail.load (std::memory_order_relaxed);
+    std::uint8_t * const record = data_ + (tail & (capacity_ - 1U));
+    return (state_word (record).load (std::memory_order_acquire) & published_flag) == 0U;
+  }
+
+  // wait
+  // ~~~~
+  void ring_buffer::wait (std::chrono::milliseconds const timeout) {
+    ctrl_->waiting.store (1U, std::memory_order_seq_cst);
+    std::uint32_t const signal = ctrl_->signal.load (std::memory_order_seq_cst);
+    if (this->empty ()) {
+#ifdef PSTORE_HAVE_LINUX_FUTEX_H
+      futex_wait (&ctrl_->signal, signal, timeout);
+#else
+      // Without a cross-process wait primitive, poll at a modest rate.
+      (void) signal;
+      std::this_thread::sleep_for (std::min (timeout, std::chrono::milliseconds{1}));
+#endif
+    }
+    ctrl_->waiting.store (0U, std::memory_order_relaxed);
+  }
+
+  // notify
+  // ~~~~~~
+  void ring_buffer::notify () noexcept {
+    // The increment of the signal word must be ordered before the load of the waiting flag.
+    // This pairs with the store and load in wait() so that either the consumer sees the new
+    // record or the producer sees that the consumer is sleeping.
+    ctrl_->signal.fetch_add (1U, std::memory_order_seq_cst);
+    if (ctrl_->waiting.load (std::memory_order_seq_cst) != 0U) {
+#ifdef PSTORE_HAVE_LINUX_FUTEX_H
+      futex_wake (&ctrl_->signal);
+#endif
+    }
+  }
+
+} // end namespace pstore::brokerface
@@ -19,27 +19,33 @@
 
 #include <iterator>
 #include <string>
+#include <thread>
 
 #include "pstore/brokerface/message_type.hpp"
+#include "pstore/brokerface/ring_buffer.hpp"
 #include "pstore/brokerface/writer.hpp"
 
 namespace {
 
   std::atomic<std::uint32_t> message_id{0};
 
-} // end anonymous namespace
-
-namespace pstore::brokerface {
-
-  void send_message (writer & wr, bool const error_on_timeout, gsl::czstring const verb,
-                     gsl::czstring const path) {
+  std::string make_payload (pstore::gsl::czstring const verb, pstore::gsl::czstring const path) {
     PSTORE_ASSERT (verb != nullptr);
-
     auto payload = std::string{verb};
     if (path != nullptr && path[0] != '\0') {
       payload.append (" ");
       payload.append (path);
     }
+    return payload;
+  }
+
+} // end anonymous namespace
+
+namespace pstore::brokerface {
+
+  void send_message (writer & wr, bool const error_on_timeout, gsl::czstring const verb,
+                     gsl::czstring const path) {
+    auto const payload = make_payload (verb, path);
 
     // Work out the number of pieces into which we need to break this payload.
     using num_parts_type = std::remove_const_t<decltype (message_type::num_parts)>;
@@ -71,6 +77,22 @@ namespace pstore::brokerface {
     }
   }
 
+  void send_message (ring_buffer & ring, bool const error_on_timeout, gsl::czstring const verb,
+                     gsl::czstring const path, std::chrono::milliseconds const timeout) {
+    auto const payload = make_payload (verb, path);
+    auto const deadline = std::chrono::steady_clock::now () + timeout;
+    while (!ring.try_push (payload)) {
+      // The ring buffer is full. Give the broker a chance to drain it.
+      if (std::chrono::steady_clock::now () >= deadline) {
+        if (error_on_timeout) {
+          raise (::pstore::error_code::pipe_write_timeout);
+        }
+        return;
+      }
+      std::this_thread::yield ();
+    }
+  }
+
   std::uint32_t next_message_id () {
     return message_id.load ();
   }
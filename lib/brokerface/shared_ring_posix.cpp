@@ -0,0 +1,157 @@
+//===- lib/brokerface/shared_ring_posix.cpp -------------------------------===//
+//*      _                        _         _              *
+//*  ___| |__   __ _ _ __ ___  __| |   _ __(_)_ __   __ _  *
+//* / __| '_ \ / _` | '__/ _ \/ _` |  | '__| | '_ \ / _` | *
+//* \__ \ | | | (_| | | |  __/ (_| |  | |  | | | | | (_| | *
+//* |___/_| |_|\__,_|_|  \___|\__,_|  |_|  |_|_| |_|\__, | *
+//*                                                 |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file shared_ring_posix.cpp
+/// \brief Implements the POSIX shared memory object which holds a broker ring buffer.
+
+#include "pstore/brokerface/shared_ring.hpp"
+
+#ifndef _WIN32
+
+#  include <cerrno>
+#  include <iomanip>
+#  include <sstream>
+
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+
+#  include "pstore/os/descriptor.hpp"
+#  include "pstore/support/error.hpp"
+#  include "pstore/support/fnv.hpp"
+#  include "pstore/support/quoted.hpp"
+
+namespace {
+
+  PSTORE_NO_RETURN void raise_shared_memory_error (int const errcode, char const * const what,
+                                                   std::string const & name) {
+    std::ostringstream str;
+    str << what << ' ' << pstore::quoted (name);
+    raise (pstore::errno_erc{errcode}, str.str ());
+  }
+
+  void * map (int const fd, std::size_t const size, std::string const & name) {
+    void * const ptr = ::mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      raise_shared_memory_error (errno, "Could not map shared memory", name);
+    }
+    return ptr;
+  }
+
+} // end anonymous namespace
+
+namespace pstore::brokerface {
+
+  // name
+  // ~~~~
+  std::string shared_ring::name (fifo_path const & fifo) {
+    // Some systems place a tight limit on the length of a shared memory object's name (31
+    // characters on macOS) so the name is derived from a hash of the FIFO path.
+    std::ostringstream str;
+    str << "/pstore-ring-" << std::hex << std::setw (16) << std::setfill ('0')
+        << fnv_64a_buf (gsl::make_span (fifo.get ()));
+    return str.str ();
+  }
+
+  // create
+  // ~~~~~~
+  shared_ring shared_ring::create (fifo_path const & fifo, std::size_t const capacity) {
+    std::string name = shared_ring::name (fifo);
+    ::shm_unlink (name.c_str ());
+
+    // The object is created without any permissions so that a client cannot open it before
+    // the ring buffer has been formatted.
+    pipe_descriptor const fd{::shm_open (name.c_str (), O_RDWR | O_CREAT | O_EXCL, 0)};
+    if (!fd.valid ()) {
+      raise_shared_memory_error (errno, "Could not create shared memory", name);
+    }
+    std::size_t const size = ring_buffer::region_size (capacity);
+    if (::ftruncate (fd.native_handle (), static_cast<off_t> (size)) != 0) {
+      int const err = errno;
+      ::shm_unlink (name.c_str ());
+      raise_shared_memory_error (err, "Could not size shared memory", name);
+    }
+    void * const ptr = map (fd.native_handle (), size, name);
+    ring_buffer ring = ring_buffer::create (ptr, capacity);
+
+    // Like the FIFO, the ring buffer may be used by any user.
+    constexpr mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+    if (::fchmod (fd.native_handle (), mode) != 0) {
+      int const err = errno;
+      ::munmap (ptr, size);
+      ::shm_unlink (name.c_str ());
+      raise_shared_memory_error (err, "Could not set permissions of shared memory", name);
+    }
+    return {std::move (name), ptr, size, ring, true};
+  }
+
+  // open
+  // ~~~~
+  std::optional<shared_ring> shared_ring::open (fifo_path const & fifo) {
+    std::string name = shared_ring::name (fifo);
+    pipe_descriptor const fd{::shm_open (name.c_str (), O_RDWR, 0)};
+    if (!fd.valid ()) {
+      int const err = errno;
+      // EACCES is expected if the broker is still formatting the ring buffer.
+      if (err == ENOENT || err == EACCES) {
+        return std::nullopt;
+      }
+      raise_shared_memory_error (err, "Could not open shared memory", name);
+    }
+    struct stat buf {};
+    if (::fstat (fd.native_handle (), &buf) != 0) {
+      raise_shared_memory_error (errno, "Could not stat shared memory", name);
+    }
+    auto const size = static_cast<std::size_t> (buf.st_size);
+    void * const ptr = map (fd.native_handle (), size, name);
+    ring_buffer const ring = ring_buffer::attach (ptr, size);
+    return shared_ring{std::move (name), ptr, size, ring, false};
+  }
+
+  // (ctor)
+  // ~~~~~~
+  shared_ring::shared_ring (std::string name, void * const ptr, std::size_t const size,
+                            ring_buffer const ring, bool const owner) noexcept
+          : name_{std::move (name)}
+          , ptr_{ptr}
+          , size_{size}
+          , ring_{ring}
+          , owner_{owner} {}
+
+  shared_ring::shared_ring (shared_ring && rhs) noexcept
+          : name_{std::move (rhs.name_)}
+          , ptr_{rhs.ptr_}
+          , size_{rhs.size_}
+          , ring_{rhs.ring_}
+          , owner_{rhs.owner_} {
+    rhs.ptr_ = nullptr;
+    rhs.owner_ = false;
+  }
+
+  // (dtor)
+  // ~~~~~~
+  shared_ring::~shared_ring () noexcept {
+    if (ptr_ != nullptr) {
+      ::munmap (ptr_, size_);
+    }
+    if (owner_) {
+      ::shm_unlink (name_.c_str ());
+    }
+  }
+
+} // end namespace pstore::brokerface
+
+#endif // _WIN32
@@ -19,6 +19,7 @@
 #include "pstore/core/start_vacuum.hpp"
 #include "pstore/core/time.hpp"
 #include "pstore/os/path.hpp"
+#include "pstore/support/metrics.hpp"
 
 #include "base32.hpp"
 
@@ -47,8 +48,8 @@ namespace pstore {
   // (ctor)
   // ~~~~~~
   database::database (std::string const & path, access_mode const am,
-                      bool const access_tick_enabled)
-          : storage_{database::open (path, am)}
+                      mapping_policy const & policy, bool const access_tick_enabled)
+          : storage_{database::open (path, am), policy}
           , size_{database::get_footer_pos (*this->file ())} {
 
     this->finish_init (access_tick_enabled);
@@ -115,13 +116,17 @@ namespace pstore {
 
   // older revision footer pos
   // ~~~~~~~~~~~~~~~~~~~~~~~~~
-  typed_address<trailer> database::older_revision_footer_pos (unsigned const revision) const {
-    if (revision == pstore::head_revision || revision > this->get_current_revision ()) {
+  typed_address<trailer>
+  database::older_revision_footer_pos (typed_address<trailer> const start,
+                                       unsigned const revision) const {
+    if (revision == pstore::head_revision) {
       raise (pstore::error_code::unknown_revision);
     }
 
-    // Walk backwards down the linked list of revisions to find it.
-    typed_address<trailer> footer_pos = size_.footer_pos ();
+    // Walk backwards down the linked list of revisions to find it. Where a trailer has a skip
+    // pointer we take it unless doing so would overshoot the target revision or would miss a
+    // better skip from the following generation.
+    typed_address<trailer> footer_pos = start;
     for (;;) {
       auto const tail = this->getro (footer_pos);
       unsigned int const tail_revision = tail->a.generation;
@@ -132,9 +137,20 @@ namespace pstore {
         break;
       }
 
-      // TODO: check that footer_pos and generation number are getting smaller; time must
-      // not be getting larger.
       footer_pos = tail->a.prev_generation;
+      if (tail->a.skip_generation != typed_address<trailer>::null ()) {
+        unsigned const skip = trailer::skip_target (tail_revision);
+        unsigned const skip_prev = trailer::skip_target (tail_revision - 1U);
+        if (skip == revision ||
+            (skip > revision && !(skip_prev + 2U < skip && skip_prev >= revision))) {
+          footer_pos = tail->a.skip_generation;
+          trailer::validate (*this, footer_pos);
+          if (this->getro (footer_pos)->a.generation != skip) {
+            raise (error_code::footer_corrupt, this->path ());
+          }
+          continue;
+        }
+      }
       trailer::validate (*this, footer_pos);
     }
 
@@ -330,7 +346,9 @@ namespace pstore {
     // a writable pointer).
     std::shared_ptr<std::uint8_t> result{new std::uint8_t[size], deleter};
 
+    metrics::increment (metrics::counter::spanning_reads);
     if (initialized) {
+      metrics::increment (metrics::counter::spanning_bytes, size);
       // Copy from the data store's regions to the newly allocated memory block.
       storage_.copy<storage::copy_from_store_traits> (
         addr, size, result.get (),
@@ -349,7 +367,9 @@ namespace pstore {
     std::shared_ptr<std::uint8_t> const result{new std::uint8_t[size],
                                                [] (std::uint8_t * const p) { delete[] p; }};
 
+    metrics::increment (metrics::counter::spanning_reads);
     if (initialized) {
+      metrics::increment (metrics::counter::spanning_bytes, size);
       // Copy from the data store's regions to the newly allocated memory block.
       storage_.copy<storage::copy_from_store_traits> (
         addr, size, result.get (),
@@ -360,6 +380,53 @@ namespace pstore {
     return std::static_pointer_cast<void const> (result);
   }
 
+  // getro view
+  // ~~~~~~~~~~
+  scatter_view database::getro_view (address const addr, std::size_t const size) const {
+    this->check_get_params (addr, size, false);
+    scatter_view result;
+    if (size == 0U) {
+      return result;
+    }
+    // Use the same test as getro() so that the PSTORE_ALWAYS_SPANNING setting also sends views
+    // down the path which handles data that spans more than one region.
+    if (!storage_.request_spans_regions (addr, size)) {
+      result.append ({storage_.address_to_raw_pointer (addr),
+                      static_cast<scatter_view::span_type::index_type> (size)});
+      return result;
+    }
+    storage_.for_each_region<std::uint8_t const *> (
+      addr, size, [&result] (std::uint8_t const * const ptr, std::uint64_t const n) {
+        result.append ({ptr, static_cast<scatter_view::span_type::index_type> (n)});
+      });
+    return result;
+  }
+
+  // prefetch
+  // ~~~~~~~~
+  void database::prefetch (address const addr, std::size_t const size,
+                           prefetch_hint const hint) const noexcept {
+    auto const logical_size = this->size ();
+    if (size == 0U || addr.absolute () >= logical_size) {
+      return;
+    }
+    auto const available = std::min (std::uint64_t{size}, logical_size - addr.absolute ());
+    storage_.for_each_region<std::uint8_t const *> (
+      addr, static_cast<std::size_t> (available),
+      [hint] (std::uint8_t const * const ptr, std::uint64_t const n) {
+        if (hint == prefetch_hint::page) {
+          will_need (ptr, static_cast<std::size_t> (n));
+          return;
+        }
+        constexpr auto cache_line_size = std::uintptr_t{64};
+        auto const last = reinterpret_cast<std::uintptr_t> (ptr + n);
+        for (auto line = reinterpret_cast<std::uintptr_t> (ptr) & ~(cache_line_size - 1U);
+             line < last; line += cache_line_size) {
+          PSTORE_PREFETCH (reinterpret_cast<void const *> (line));
+        }
+      });
+  }
+
   // get spanningu
   // ~~~~~~~~~~~~~
   auto database::get_spanningu (address const addr, std::size_t const size,
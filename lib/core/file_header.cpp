@@ -139,6 +139,9 @@ namespace pstore {
         // be separated by at least the size of the trailer and agree with the location
         // given by the current trailer's 'size' field.
         ok = false;
+      } else if (footer->a.skip_generation > prev_pos) {
+        // The skip pointer must not refer to a later trailer than the previous generation.
+        ok = false;
       } else if (pos.absolute () < footer->a.size) {
         ok = false;
       } else {
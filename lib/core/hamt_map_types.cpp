@@ -17,6 +17,10 @@
 #include "pstore/core/hamt_map_types.hpp"
 
 #include <new>
+#include <vector>
+
+#include "pstore/support/metrics.hpp"
+#include "pstore/support/parallel_for_each.hpp"
 
 namespace pstore::index::details {
 
@@ -31,20 +35,16 @@ namespace pstore::index::details {
 
   // operator new
   // ~~~~~~~~~~~~
-  void * linear_node::operator new (std::size_t const s, nchildren const size) {
+  void * linear_node::operator new (std::size_t const s, arena & storage,
+                                    nchildren const capacity) {
     (void) s;
-    std::size_t const actual_bytes = linear_node::size_bytes (size.n);
+    std::size_t const actual_bytes = linear_node::size_bytes (capacity.n);
     PSTORE_ASSERT (actual_bytes >= s);
-    return ::operator new (actual_bytes);
-  }
-
-  // operator delete
-  // ~~~~~~~~~~~~~~~
-  void linear_node::operator delete (void * const p, nchildren const /*size*/) {
-    ::operator delete (p);
-  }
-  void linear_node::operator delete (void * const p) {
-    ::operator delete (p);
+    PSTORE_STATIC_ASSERT (alignof (linear_node) == sizeof (std::uint64_t));
+    // The node's capacity is stored in the word immediately preceding it.
+    void * const ptr =
+      storage.allocate (sizeof (std::uint64_t) + actual_bytes, alignof (linear_node));
+    return new (ptr) std::uint64_t{capacity.n} + 1;
   }
 
   // (ctor)
@@ -70,13 +70,46 @@ namespace pstore::index::details {
     std::copy (rhs.begin (), rhs.end (), &leaves_[0]);
   }
 
+  // capacity
+  // ~~~~~~~~
+  std::size_t linear_node::capacity () const noexcept {
+    PSTORE_ASSERT (signature_ == node_signature_);
+    return static_cast<std::size_t> (*(reinterpret_cast<std::uint64_t const *> (this) - 1));
+  }
+
+  // try push back
+  // ~~~~~~~~~~~~~
+  bool linear_node::try_push_back (address const leaf) noexcept {
+    if (size_ >= this->capacity ()) {
+      return false;
+    }
+    // Note the use of '&leaves_[0]' to defeat an MSVC debug assertion about the bounds of
+    // the leaves_ array.
+    *(&leaves_[0] + size_) = leaf;
+    ++size_;
+    return true;
+  }
+
+  // try assign
+  // ~~~~~~~~~~
+  bool linear_node::try_assign (gsl::span<address const> const leaves) noexcept {
+    auto const size = static_cast<std::size_t> (leaves.size ());
+    if (size > this->capacity ()) {
+      return false;
+    }
+    std::copy (std::begin (leaves), std::end (leaves), &leaves_[0]);
+    size_ = size;
+    return true;
+  }
+
   // allocate
   // ~~~~~~~~
-  std::unique_ptr<linear_node> linear_node::allocate (std::size_t const num_children,
-                                                      linear_node const & from_node) {
+  linear_node * linear_node::allocate (arena & storage, std::size_t const num_children,
+                                       std::size_t const capacity,
+                                       linear_node const & from_node) {
+    PSTORE_ASSERT (capacity >= num_children);
     // Allocate the new node and fill in the basic fields.
-    auto new_node =
-      std::unique_ptr<linear_node> (new (nchildren{num_children}) linear_node (num_children));
+    auto * const new_node = new (storage, nchildren{capacity}) linear_node (num_children);
 
     std::size_t const num_to_copy = std::min (num_children, from_node.size ());
     auto const * const src_begin = from_node.leaves_;
@@ -87,27 +120,38 @@ namespace pstore::index::details {
     return new_node;
   }
 
-  std::unique_ptr<linear_node> linear_node::allocate (address const a, address const b) {
-    auto result = std::unique_ptr<linear_node> (new (nchildren{2U}) linear_node (2U));
+  linear_node * linear_node::allocate (arena & storage, address const a, address const b) {
+    auto * const result = new (storage, nchildren{2U}) linear_node (2U);
     (*result)[0] = a;
     (*result)[1] = b;
     return result;
   }
 
+  linear_node * linear_node::allocate (arena & storage, gsl::span<address const> const leaves) {
+    auto const size = static_cast<std::size_t> (leaves.size ());
+    auto * const result = new (storage, nchildren{size}) linear_node (size);
+    std::copy (std::begin (leaves), std::end (leaves), &result->leaves_[0]);
+    return result;
+  }
+
   // allocate from
   // ~~~~~~~~~~~~~
-  std::unique_ptr<linear_node> linear_node::allocate_from (linear_node const & orig_node,
-                                                           std::size_t const extra_children) {
-    return linear_node::allocate (orig_node.size () + extra_children, orig_node);
+  linear_node * linear_node::allocate_from (arena & storage, linear_node const & orig_node,
+                                            std::size_t const extra_children) {
+    std::size_t const size = orig_node.size () + extra_children;
+    // A node that is growing is likely to grow again so leave room for more children.
+    std::size_t const capacity =
+      extra_children > 0U ? std::max (size, orig_node.size () * 2U) : size;
+    return linear_node::allocate (storage, size, capacity, orig_node);
   }
 
-  std::unique_ptr<linear_node> linear_node::allocate_from (database const & db,
-                                                           index_pointer const node,
-                                                           std::size_t const extra_children) {
+  linear_node * linear_node::allocate_from (arena & storage, database const & db,
+                                            index_pointer const node,
+                                            std::size_t const extra_children) {
     std::pair<std::shared_ptr<linear_node const>, linear_node const *> const p =
       linear_node::get_node (db, node);
     PSTORE_ASSERT (p.second != nullptr);
-    return linear_node::allocate_from (*p.second, extra_children);
+    return linear_node::allocate_from (storage, *p.second, extra_children);
   }
 
   // get node
@@ -122,6 +166,7 @@ namespace pstore::index::details {
     }
 
     // Read an existing node. First work out its size.
+    metrics::increment (metrics::counter::hamt_node_loads);
     auto const addr = node.untag_address<linear_node> ();
     std::size_t const in_store_size = linear_node::size_bytes (db.getro (addr)->size ());
 
@@ -141,13 +186,13 @@ namespace pstore::index::details {
 
   // flush
   // ~~~~~
-  address linear_node::flush (transaction_base & transaction) const {
+  address linear_node::flush (transaction_base & transaction,
+                              gsl::not_null<address *> const pos) const {
     std::size_t const num_bytes = this->size_bytes ();
-
-    std::shared_ptr<void> ptr;
-    address result;
-    std::tie (ptr, result) = transaction.alloc_rw (num_bytes, alignof (linear_node));
-    new (ptr.get ()) linear_node (*this);
+    address const result = *pos;
+    PSTORE_ASSERT (result.absolute () % alignof (linear_node) == 0U);
+    new (transaction.getrw (result, num_bytes).get ()) linear_node (*this);
+    *pos += num_bytes;
     return result;
   }
 
@@ -190,6 +235,15 @@ namespace pstore::index::details {
     children_[index_b] = existing_leaf;
   }
 
+  // ctor (bitmap and children)
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  branch::branch (hash_type const bitmap, gsl::span<index_pointer const> const children)
+          : bitmap_{bitmap} {
+    PSTORE_ASSERT (bitmap != 0U);
+    PSTORE_ASSERT (bit_count::pop_count (bitmap) == static_cast<unsigned> (children.size ()));
+    std::copy (std::begin (children), std::end (children), std::begin (children_));
+  }
+
   // copy ctor
   // ~~~~~~~~~
   branch::branch (branch const & rhs)
@@ -237,6 +291,7 @@ namespace pstore::index::details {
     /// 1. Load the basic structure.
     /// 2. Calculate the actual size of the child pointer array.
     /// 3. Load the complete structure along with its child pointer array.
+    metrics::increment (metrics::counter::hamt_node_loads);
     auto base = std::static_pointer_cast<branch const> (
       db.getro (addr.to_address (), sizeof (branch) - sizeof (branch::children_)));
 
@@ -304,40 +359,114 @@ namespace pstore::index::details {
     parents->push (parent_type{index_pointer{this}, index});
   }
 
+  // assign
+  // ~~~~~~
+  void branch::assign (hash_type const bitmap, gsl::span<index_pointer const> const children) {
+    PSTORE_ASSERT (bitmap != 0U);
+    PSTORE_ASSERT (bit_count::pop_count (bitmap) == static_cast<unsigned> (children.size ()));
+    std::copy (std::begin (children), std::end (children), &children_[0]);
+    bitmap_ = bitmap;
+  }
+
   // store node
   // ~~~~~~~~~~
-  address branch::store_node (transaction_base & transaction) const {
+  address branch::store_node (transaction_base & transaction,
+                              gsl::not_null<address *> const pos) const {
     std::size_t const num_bytes = branch::size_bytes (this->size ());
-
-    auto [ptr, addr] = transaction.alloc_rw (num_bytes, alignof (branch));
-    new (ptr.get ()) branch (*this);
+    address const addr = *pos;
+    PSTORE_ASSERT (addr.absolute () % alignof (branch) == 0U);
+    new (transaction.getrw (addr, num_bytes).get ()) branch (*this);
+    *pos += num_bytes;
     return addr;
   }
 
+  namespace {
+
+    /// Writes a heap-resident child of a branch (along with its own heap-resident
+    /// descendants) to the store at *pos.
+    ///
+    /// \param transaction  The transaction to which the nodes will be written.
+    /// \param child  The heap-resident child node.
+    /// \param pos  The address at which the child will be written. Updated to point just
+    ///   beyond the data written.
+    /// \param shifts  The number of hash bits consumed by the parents of \p child.
+    /// \result The in-store (tagged) address of the child node.
+    address flush_child (transaction_base & transaction, index_pointer const child,
+                         gsl::not_null<address *> const pos, unsigned const shifts) {
+      PSTORE_ASSERT (child.is_heap ());
+      if (depth_is_branch (shifts)) {
+        PSTORE_ASSERT (child.is_branch ());
+        // This node is owned by a container in the outer HAMT structure. Don't delete it
+        // here. If this ever changes, then add a 'delete internal;' here.
+        return child.untag<branch *> ()->flush (transaction, pos, shifts);
+      }
+      PSTORE_ASSERT (child.is_linear ());
+      // Linear nodes are owned by an arena in the outer HAMT structure. Don't delete them
+      // here either.
+      return child.untag<linear_node *> ()->flush (transaction, pos) | branch_bit;
+    }
+
+  } // end anonymous namespace
+
+  // flush size
+  // ~~~~~~~~~~
+  std::uint64_t branch::flush_size (unsigned shifts) const {
+    shifts += hash_index_bits;
+    std::uint64_t result = branch::size_bytes (this->size ());
+    for (auto const & p : *this) {
+      if (p.is_heap ()) {
+        result += depth_is_branch (shifts) ? p.untag<branch const *> ()->flush_size (shifts)
+                                           : p.untag<linear_node const *> ()->size_bytes ();
+      }
+    }
+    return result;
+  }
+
   // flush
   // ~~~~~
-  address branch::flush (transaction_base & transaction, unsigned shifts) {
+  address branch::flush (transaction_base & transaction, gsl::not_null<address *> const pos,
+                         unsigned shifts) {
     shifts += hash_index_bits;
     for (auto & p : *this) {
       // If it is a heap node, flush its children first (depth-first search).
       if (p.is_heap ()) {
-        if (shifts < max_hash_bits) { // internal node
-          PSTORE_ASSERT (p.is_branch ());
-          auto * const internal = p.untag<branch *> ();
-          p = internal->flush (transaction, shifts);
-          // This node is owned by a container in the outer HAMT structure. Don't
-          // delete it here. If this ever changes, then add a 'delete internal;'
-          // here.
-        } else { // linear node
-          PSTORE_ASSERT (p.is_linear ());
-          auto * const linear = p.untag<linear_node *> ();
-          p = linear->flush (transaction) | branch_bit;
-          delete linear;
-        }
+        p = flush_child (transaction, p, pos, shifts);
+      }
+    }
+    // Flush itself.
+    return this->store_node (transaction, pos) | branch_bit;
+  }
+
+  // flush concurrently
+  // ~~~~~~~~~~~~~~~~~~
+  address branch::flush_concurrently (transaction_base & transaction,
+                                      gsl::not_null<address *> const pos, unsigned shifts) {
+    shifts += hash_index_bits;
+
+    // Assign each heap-resident child the same position that flush() would give it. Each
+    // of these sub-tries can then be written independently of the others.
+    struct subtrie {
+      index_pointer * child;
+      address first;
+    };
+    std::vector<subtrie> work;
+    work.reserve (this->size ());
+    for (auto & p : *this) {
+      if (p.is_heap ()) {
+        work.push_back ({&p, *pos});
+        *pos += depth_is_branch (shifts) ? p.untag<branch const *> ()->flush_size (shifts)
+                                         : p.untag<linear_node const *> ()->size_bytes ();
       }
     }
+
+    parallel_for_each (std::begin (work), std::end (work),
+                       [&transaction, shifts] (subtrie const & st) {
+                         address child_pos = st.first;
+                         *st.child = flush_child (transaction, *st.child, &child_pos, shifts);
+                       });
+
     // Flush itself.
-    return this->store_node (transaction) | branch_bit;
+    return this->store_node (transaction, pos) | branch_bit;
   }
 
 } // namespace pstore::index::details
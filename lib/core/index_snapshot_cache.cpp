@@ -0,0 +1,164 @@
+//===- lib/core/index_snapshot_cache.cpp ----------------------------------===//
+//*  _           _                                       _           _    *
+//* (_)_ __   __| | _____  __  ___ _ __   __ _ _ __  ___| |__   ___ | |_  *
+//* | | '_ \ / _` |/ _ \ \/ / / __| '_ \ / _` | '_ \/ __| '_ \ / _ \| __| *
+//* | | | | | (_| |  __/>  <  \__ \ | | | (_| | |_) \__ \ | | | (_) | |_  *
+//* |_|_| |_|\__,_|\___/_/\_\ |___/_| |_|\__,_| .__/|___/_| |_|\___/ \__| *
+//*                                           |_|                         *
+//*                 _           *
+//*   ___ __ _  ___| |__   ___  *
+//*  / __/ _` |/ __| '_ \ / _ \ *
+//* | (_| (_| | (__| | | |  __/ *
+//*  \___\__,_|\___|_| |_|\___| *
+//*                             *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file index_snapshot_cache.cpp
+#include "pstore/core/index_snapshot_cache.hpp"
+
+#include "pstore/support/assert.hpp"
+#include "pstore/support/metrics.hpp"
+
+namespace pstore::index {
+
+  // (ctor)
+  // ~~~~~~
+  snapshot_cache::snapshot_cache (std::size_t const capacity) {
+    PSTORE_ASSERT (capacity > 0U);
+    for (kind & k : kinds_) {
+      k.slots = std::vector<std::atomic<node *>> (capacity);
+    }
+  }
+
+  // search
+  // ~~~~~~
+  std::shared_ptr<index_base const> snapshot_cache::search (kind const & k,
+                                                            address const location) {
+    for (std::atomic<node *> const & slot : k.slots) {
+      node * const n = slot.load (std::memory_order_acquire);
+      // A cheap test before claiming the node. The node may be being reused for a different
+      // location so the test is repeated once the node has been claimed.
+      if (n == nullptr || n->location.load (std::memory_order_relaxed) != location) {
+        continue;
+      }
+      // Announce that the node is being read and then check that it is still in its slot.
+      // This pairs with the store to the slot and load of the reader count in insert(): if
+      // insert() evicts the node after this point, it sees the reader and leaves the node's
+      // index alone.
+      n->readers.fetch_add (1U, std::memory_order_seq_cst);
+      std::shared_ptr<index_base const> result;
+      if (slot.load (std::memory_order_seq_cst) == n &&
+          n->location.load (std::memory_order_relaxed) == location) {
+        // Avoid writing to the node's cache line if the flag is already set.
+        if (!n->referenced.load (std::memory_order_relaxed)) {
+          n->referenced.store (true, std::memory_order_relaxed);
+        }
+        result = n->index;
+      }
+      n->readers.fetch_sub (1U, std::memory_order_release);
+      if (result != nullptr) {
+        return result;
+      }
+    }
+    return nullptr;
+  }
+
+  // spare node
+  // ~~~~~~~~~~
+  auto snapshot_cache::spare_node (kind & k) -> node * {
+    node * spare = nullptr;
+    for (std::unique_ptr<node> const & n : k.pool) {
+      if (!n->in_slot && n->readers.load (std::memory_order_seq_cst) == 0U) {
+        n->index.reset ();
+        if (spare == nullptr) {
+          spare = n.get ();
+        }
+      }
+    }
+    if (spare == nullptr) {
+      spare = k.pool.emplace_back (std::make_unique<node> ()).get ();
+    }
+    return spare;
+  }
+
+  // find
+  // ~~~~
+  std::shared_ptr<index_base const> snapshot_cache::find (trailer::indices const which,
+                                                          address const location) const {
+    if (std::shared_ptr<index_base const> result =
+          search (kinds_[static_cast<unsigned> (which)], location)) {
+      metrics::increment (metrics::counter::index_cache_hits);
+      return result;
+    }
+    metrics::increment (metrics::counter::index_cache_misses);
+    return nullptr;
+  }
+
+  // insert
+  // ~~~~~~
+  std::shared_ptr<index_base const>
+  snapshot_cache::insert (trailer::indices const which, address const location,
+                          std::shared_ptr<index_base const> index) {
+    kind & k = kinds_[static_cast<unsigned> (which)];
+    std::scoped_lock<decltype (insert_mut_)> const lock{insert_mut_};
+    if (std::shared_ptr<index_base const> existing = search (k, location)) {
+      return existing;
+    }
+
+    // The node is in no slot so no reader can validate it until it is stored to one below.
+    node * const fresh = spare_node (k);
+    fresh->location.store (location, std::memory_order_relaxed);
+    fresh->index = std::move (index);
+    fresh->referenced.store (false, std::memory_order_relaxed);
+    fresh->in_slot = true;
+
+    // Use an empty slot if there is one. Otherwise sweep the slots from the hand, giving each
+    // node which has been found since the hand last passed it a second chance. The slots are
+    // only modified whilst the mutex is held so relaxed loads are sufficient here.
+    std::atomic<node *> * victim = nullptr;
+    for (std::atomic<node *> & slot : k.slots) {
+      if (slot.load (std::memory_order_relaxed) == nullptr) {
+        victim = &slot;
+        break;
+      }
+    }
+    while (victim == nullptr) {
+      std::atomic<node *> & slot = k.slots[k.hand];
+      k.hand = (k.hand + 1U) % k.slots.size ();
+      if (!slot.load (std::memory_order_relaxed)
+             ->referenced.exchange (false, std::memory_order_relaxed)) {
+        victim = &slot;
+      }
+    }
+
+    std::shared_ptr<index_base const> result = fresh->index;
+    if (node * const evicted = victim->exchange (fresh, std::memory_order_seq_cst)) {
+      evicted->in_slot = false;
+      // Release the evicted index now unless a reader may be copying it, in which case
+      // spare_node() releases it later.
+      if (evicted->readers.load (std::memory_order_seq_cst) == 0U) {
+        evicted->index.reset ();
+      }
+    }
+    return result;
+  }
+
+  // clear
+  // ~~~~~
+  void snapshot_cache::clear () noexcept {
+    for (kind & k : kinds_) {
+      for (std::atomic<node *> & slot : k.slots) {
+        slot.store (nullptr, std::memory_order_relaxed);
+      }
+      k.pool.clear ();
+      k.hand = 0;
+    }
+  }
+
+} // end namespace pstore::index
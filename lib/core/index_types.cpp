@@ -16,7 +16,12 @@
 
 #include "pstore/core/index_types.hpp"
 
+#include <functional>
+#include <numeric>
+#include <vector>
+
 #include "pstore/core/hamt_set.hpp"
+#include "pstore/support/parallel_for_each.hpp"
 
 namespace {
 
@@ -25,13 +30,26 @@ namespace {
     return static_cast<std::underlying_type_t<pstore::trailer::indices>> (idx);
   }
 
+  /// An index whose store space has been reserved but whose contents are yet to be
+  /// written.
+  struct pending_flush {
+    pstore::trailer::indices kind;
+    /// The number of bytes reserved for the index.
+    std::uint64_t size;
+    /// Writes the index to its reserved space.
+    std::function<pstore::typed_address<pstore::index::header_block> ()> write;
+  };
+
   template <pstore::trailer::indices Index>
-  void flush_index (pstore::transaction_base & transaction,
-                    pstore::trailer::index_records_array * const locations,
-                    unsigned const generation) {
+  void reserve_index (pstore::transaction_base & transaction,
+                      std::vector<pending_flush> * const pending, unsigned const generation) {
     pstore::database & db = transaction.db ();
     if (auto const index = pstore::index::get_index<Index> (db, false /*create*/)) {
-      (*locations)[index_integral (Index)] = index->flush (transaction, generation);
+      auto const reservation = index->reserve_flush (transaction);
+      pending->push_back (
+        {Index, reservation.size, [&transaction, index, reservation, generation] () {
+           return index->flush (transaction, reservation, generation);
+         }});
     }
   }
 
@@ -43,9 +61,14 @@ namespace pstore::index {
   // ~~~~~~~~~~~~~
   void flush_indices (transaction_base & transaction,
                       trailer::index_records_array * const locations, unsigned const generation) {
+    // Reserve the space for each index in turn. Allocating in a fixed order means that the
+    // store contents do not depend on the order in which the indices are subsequently
+    // written.
+    std::vector<pending_flush> pending;
+    pending.reserve (index_integral (trailer::indices::last));
 #define X(k)                                                                                       \
   case trailer::indices::k:                                                                        \
-    flush_index<trailer::indices::k> (transaction, locations, generation);                         \
+    reserve_index<trailer::indices::k> (transaction, &pending, generation);                        \
     break;
 
     for (auto ctr = std::underlying_type_t<trailer::indices>{0};
@@ -56,6 +79,20 @@ namespace pstore::index {
       }
     }
 #undef X
+
+    // Now write the indices. They are independent of one another so, if there's enough
+    // work to make it worthwhile, they can be written concurrently.
+    auto const write = [locations] (pending_flush const & p) {
+      (*locations)[index_integral (p.kind)] = p.write ();
+    };
+    auto const total = std::accumulate (
+      std::begin (pending), std::end (pending), std::uint64_t{0},
+      [] (std::uint64_t const acc, pending_flush const & p) { return acc + p.size; });
+    if (pending.size () > 1U && total >= details::parallel_flush_threshold) {
+      parallel_for_each (std::begin (pending), std::end (pending), write);
+    } else {
+      std::for_each (std::begin (pending), std::end (pending), write);
+    }
     PSTORE_ASSERT (locations->size () == index_integral (trailer::indices::last));
   }
 
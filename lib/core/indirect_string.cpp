@@ -78,6 +78,10 @@ namespace pstore {
       PSTORE_ASSERT (this->equal_contents (rhs));
       return true;
     }
+    if (has_hash_ && rhs.has_hash_ && hash_ != rhs.hash_) {
+      // Strings with different hashes cannot be equal: we needn't read either body.
+      return false;
+    }
     return equal_contents (rhs);
   }
 
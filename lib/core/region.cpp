@@ -24,8 +24,9 @@
 namespace pstore::region {
 
   std::unique_ptr<factory> get_factory (std::shared_ptr<file::file_handle> const & file,
-                                        std::uint64_t full_size, std::uint64_t min_size) {
-    return std::make_unique<file_based_factory> (file, full_size, min_size);
+                                        std::uint64_t full_size, std::uint64_t min_size,
+                                        mapping_policy const & policy) {
+    return std::make_unique<file_based_factory> (file, full_size, min_size, policy);
   }
 
   std::unique_ptr<factory> get_factory (std::shared_ptr<file::in_memory> const & file,
@@ -50,21 +51,24 @@ namespace pstore::region {
   // ~~~~~~
   file_based_factory::file_based_factory (std::shared_ptr<file::file_handle> file,
                                           std::uint64_t const full_size,
-                                          std::uint64_t const min_size)
+                                          std::uint64_t const min_size,
+                                          mapping_policy const & policy)
           : factory{full_size, min_size}
-          , file_{std::move (file)} {}
+          , file_{std::move (file)}
+          , policy_{policy} {}
 
   // init
   // ~~~~
   auto file_based_factory::init () -> std::vector<memory_mapper_ptr> {
-    return this->create<file::file_handle, memory_mapper> (file_);
+    return this->create<file::file_handle, memory_mapper> (file_, policy_);
   }
 
   // add
   // ~~~
   void file_based_factory::add (gsl::not_null<std::vector<memory_mapper_ptr> *> const regions,
                                 std::uint64_t const original_size, std::uint64_t const new_size) {
-    this->append<file::file_handle, memory_mapper> (file_, regions, original_size, new_size);
+    this->append<file::file_handle, memory_mapper> (file_, regions, original_size, new_size,
+                                                    policy_);
   }
 
   // file
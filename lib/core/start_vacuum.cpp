@@ -19,6 +19,7 @@
 // Local (public) includes
 #include "pstore/brokerface/fifo_path.hpp"
 #include "pstore/brokerface/send_message.hpp"
+#include "pstore/brokerface/shared_ring.hpp"
 #include "pstore/brokerface/writer.hpp"
 #include "pstore/core/database.hpp"
 
@@ -26,6 +27,14 @@ namespace pstore {
 
   void start_vacuum (database const & db) {
     brokerface::fifo_path const fifo (nullptr);
+#ifndef _WIN32
+    // Prefer the broker's shared-memory ring buffer if it has created one.
+    if (std::optional<brokerface::shared_ring> ring = brokerface::shared_ring::open (fifo)) {
+      brokerface::send_message (ring->ring (), false /*error on timeout*/, "GC",
+                                db.path ().c_str (), std::chrono::milliseconds{0});
+      return;
+    }
+#endif
     brokerface::writer wr (fifo);
     brokerface::send_message (wr, false /*error on timeout*/, "GC", db.path ().c_str ());
   }
@@ -17,6 +17,7 @@
 
 #include "pstore/core/storage.hpp"
 #include "pstore/core/file_header.hpp"
+#include "pstore/support/metrics.hpp"
 
 namespace {
 
@@ -66,6 +67,9 @@ namespace pstore {
       // Allocate new memory region(s) to accommodate the additional bytes requested.
       region_factory_->add (&regions_, old_physical_size, new_logical_size);
       this->update_master_pointers (old_num_regions);
+      metrics::increment (metrics::counter::regions_mapped, regions_.size () - old_num_regions);
+      metrics::increment (metrics::counter::bytes_mapped,
+                          regions_.back ()->end () - old_physical_size);
       return;
     }
     if (new_logical_size < old_logical_size) {
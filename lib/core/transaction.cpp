@@ -17,9 +17,19 @@
 /// \brief Data store transaction implementation
 #include "pstore/core/transaction.hpp"
 
+#include <algorithm>
 #include <utility>
 
 #include "pstore/core/index_types.hpp"
+#include "pstore/support/metrics.hpp"
+
+namespace {
+
+  /// The maximum number of bytes moved by each step of a copy_from() fallback. Bounds the size
+  /// of the temporary buffer needed when the destination spans more than one region.
+  constexpr auto copy_chunk_size = std::uint64_t{1024 * 1024};
+
+} // end anonymous namespace
 
 namespace pstore {
 
@@ -67,6 +77,7 @@ namespace pstore {
     auto const bytes_allocated = db.size () - old_size;
     PSTORE_ASSERT (bytes_allocated >= size);
     size_ += bytes_allocated;
+    metrics::record (metrics::histogram::allocation_bytes, bytes_allocated);
     return result;
   }
 
@@ -82,6 +93,52 @@ namespace pstore {
     return {ptr, addr};
   }
 
+  // copy from
+  // ~~~~~~~~~
+  address transaction_base::copy_from (file::file_base & file, std::uint64_t const offset,
+                                       std::uint64_t const size, unsigned const align) {
+    address const result = this->allocate (size, align);
+    std::uint64_t done = 0;
+    if (auto const * const src = file.as_file_handle ()) {
+      if (auto * const dest = db_.file ()->as_file_handle ()) {
+        done = file::copy_range (*src, offset, *dest, result.absolute (), size);
+      }
+    }
+    if (done < size) {
+      file.seek (offset + done);
+      while (done < size) {
+        auto const chunk = static_cast<std::size_t> (std::min (size - done, copy_chunk_size));
+        auto const ptr = std::static_pointer_cast<std::byte> (
+          db_.get (result + done, chunk, false /*initialized?*/));
+        if (file.read_span (gsl::make_span (ptr.get (), chunk)) != chunk) {
+          raise (error_code::did_not_read_number_of_bytes_requested);
+        }
+        done += chunk;
+      }
+    }
+    return result;
+  }
+
+  address transaction_base::copy_from (database const & source, address const addr,
+                                       std::uint64_t const size, unsigned const align) {
+    address const result = this->allocate (size, align);
+    std::uint64_t done = 0;
+    if (auto const * const src = source.file ()->as_file_handle ()) {
+      if (auto * const dest = db_.file ()->as_file_handle ()) {
+        done = file::copy_range (*src, addr.absolute (), *dest, result.absolute (), size);
+      }
+    }
+    while (done < size) {
+      auto const chunk = static_cast<std::size_t> (std::min (size - done, copy_chunk_size));
+      // A view of the source avoids the temporary copy that getro() would make if the data
+      // spans regions.
+      source.getro_view (addr + done, chunk)
+        .copy (db_.get (result + done, chunk, false /*initialized?*/).get ());
+      done += chunk;
+    }
+    return result;
+  }
+
   // commit
   // ~~~~~~
   transaction_base & transaction_base::commit () {
@@ -91,6 +148,7 @@ namespace pstore {
     }
 
     database & db = this->db ();
+    metrics::stopwatch phase;
 
     // We're going to write to the header, but this must be the very last
     // step of completing the transaction.
@@ -109,6 +167,7 @@ namespace pstore {
 
       auto locations = prev_footer->a.index_records;
       index::flush_indices (*this, &locations, generation);
+      phase.lap (metrics::histogram::commit_indices_ns);
 
       // Writing new data is done. Now we begin to build the new file footer.
       {
@@ -124,15 +183,25 @@ namespace pstore {
         t->a.size = size_ - sizeof (trailer);
         t->a.time = pstore::milliseconds_since_epoch ();
         t->a.prev_generation = head.footer_pos;
+        // Skip pointers are only useful if every earlier generation has one so we don't start
+        // adding them to a store whose history lacks them.
+        if (generation == 1U ||
+            prev_footer->a.skip_generation != typed_address<trailer>::null ()) {
+          t->a.skip_generation =
+            db.older_revision_footer_pos (head.footer_pos, trailer::skip_target (generation));
+        }
         t->crc = t->get_crc ();
       }
+      phase.lap (metrics::histogram::commit_trailer_ns);
     }
     // Complete the transaction by making it available to other clients. This modifies the
     // footer pointer in the file's header record.
     db.set_new_footer (new_footer_pos);
+    phase.lap (metrics::histogram::commit_publish_ns);
 
     // Mark both this transaction's contents and its trailer as read-only.
     db.protect (first_, (new_footer_pos + 1).to_address ());
+    phase.lap (metrics::histogram::commit_protect_ns);
 
     // That's the end of this transaction.
     first_ = address::null ();
@@ -18,9 +18,17 @@
 
 #include "pstore/exchange/export.hpp"
 
+#include <functional>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <vector>
+
 #include "pstore/core/generation_iterator.hpp"
+#include "pstore/exchange/export_binary.hpp"
 #include "pstore/exchange/export_compilation.hpp"
 #include "pstore/exchange/export_fragment.hpp"
+#include "pstore/support/parallel_for_each.hpp"
 
 namespace {
 
@@ -38,6 +46,25 @@ namespace {
     return footers;
   }
 
+  // emit debug line header data
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  void emit_debug_line_header_data (pstore::exchange::export_ns::ostream_base & os,
+                                    pstore::database const & db,
+                                    pstore::extent<std::uint8_t> const & ex) {
+    os << '"';
+    // Use a view of the data rather than getro() so that a block which spans memory-mapped
+    // regions isn't copied.
+    pstore::scatter_view const data = db.getro_view (ex);
+    if (data.is_contiguous ()) {
+      auto const * const ptr = data.empty () ? nullptr : data.begin ()->data ();
+      pstore::exchange::export_ns::emit_base64 (os, ptr, ptr + data.size ());
+    } else {
+      pstore::to_base64 (data.bytes_begin (), data.bytes_end (),
+                         pstore::exchange::export_ns::ostream_inserter{os});
+    }
+    os << '"';
+  }
+
   // emit debug line headers
   // ~~~~~~~~~~~~~~~~~~~~~~~
   bool emit_debug_line_headers (pstore::exchange::export_ns::ostream & os,
@@ -62,19 +89,15 @@ namespace {
       os << '\n' << object_indent;
       auto const & kvp = debug_line_headers->load_leaf (db, addr);
       pstore::exchange::export_ns::emit_digest (os, kvp.first);
-      os << R"(:")";
-      std::shared_ptr<std::uint8_t const> const data = db.getro (kvp.second);
-      auto const * const ptr = data.get ();
-      pstore::to_base64 (ptr, ptr + kvp.second.size,
-                         pstore::exchange::export_ns::ostream_inserter{os});
-      os << '"';
+      os << ':';
+      emit_debug_line_header_data (os, db, kvp.second);
     };
     pstore::diff (db, *debug_line_headers, generation - 1U,
                   pstore::exchange::export_ns::make_diff_out (&out_fn));
     if (!first) {
-      os << '\n' << ind << "},\n";
+      os << '\n' << ind << '}';
     }
-    return first;
+    return !first;
   }
 
   std::string prefix (bool prev_emitted, pstore::exchange::export_ns::indent const ind,
@@ -86,6 +109,267 @@ namespace {
 
 namespace pstore::exchange::export_ns {
 
+  namespace {
+
+    //*                        _ _      _                               _             *
+    //*  _ __   __ _ _ __ __ _| | | ___| |    _____  ___ __   ___  _ __| |_ ___ _ __  *
+    //* | '_ \ / _` | '__/ _` | | |/ _ \ |   / _ \ \/ / '_ \ / _ \| '__| __/ _ \ '__| *
+    //* | |_) | (_| | | | (_| | | |  __/ |  |  __/>  <| |_) | (_) | |  | ||  __/ |    *
+    //* | .__/ \__,_|_|  \__,_|_|_|\___|_|   \___/_/\_\ .__/ \___/|_|   \__\___|_|    *
+    //* |_|                                           |_|                             *
+    /// Produces the same output as the serial exporter but renders the bulk of it -- the
+    /// debug line headers, fragments, and compilations -- on a pool of worker threads.
+    ///
+    /// Each transaction is split into a series of pieces. The text of the transaction's
+    /// strings and of the JSON which surrounds its index entries is produced on the calling
+    /// thread because the string tables are built as this text is emitted. The index entries
+    /// themselves are divided into chunks each of which becomes a piece that is rendered by a
+    /// worker thread into its own buffer. The pieces are gathered in windows; once a window has
+    /// been rendered its pieces are written to the output, in order, by a separate thread while
+    /// the next window is prepared.
+    class parallel_exporter {
+    public:
+      parallel_exporter (database const & db, ostream & os, bool comments);
+      parallel_exporter (parallel_exporter const &) = delete;
+      parallel_exporter (parallel_exporter &&) = delete;
+
+      ~parallel_exporter () noexcept;
+
+      parallel_exporter & operator= (parallel_exporter const &) = delete;
+      parallel_exporter & operator= (parallel_exporter &&) = delete;
+
+      /// Adds the transaction whose trailer is at \p footer_pos to the output.
+      void add_transaction (typed_address<trailer> footer_pos, bool first);
+      /// Writes any remaining text to the output and waits for it to be written.
+      void finish ();
+
+    private:
+      /// The number of index entries rendered by a single worker task.
+      static constexpr std::size_t entries_per_piece = 128U;
+
+      /// A contiguous part of the output.
+      struct piece {
+        std::string text;
+        /// If non-null, a function which renders the text of the piece. Called on a worker
+        /// thread.
+        std::function<void (ostream_base &)> render;
+      };
+
+      /// Moves the text written to os_ so far to a new piece.
+      void end_text ();
+      /// Renders the pending pieces and hands them to the writer thread.
+      void flush_window ();
+
+      /// Returns the addresses of the entries added to \p index by revision \p generation.
+      template <typename Index>
+      std::vector<address> changes (Index const & index, unsigned generation) const;
+
+      /// Adds pieces which will render the index entries at \p addrs. Each entry is written
+      /// as its digest followed by the text produced by \p emit_value.
+      template <typename Index, typename EmitValue>
+      void add_entries (std::shared_ptr<Index const> const & index,
+                        std::vector<address> const & addrs, indent ind, EmitValue emit_value);
+
+      database const & db_;
+      ostream & out_;
+      bool const comments_;
+      string_mapping string_table_;
+      string_mapping path_table_;
+
+      /// The text being accumulated for the next piece.
+      std::unique_ptr<ostringstream> os_ = std::make_unique<ostringstream> ();
+      std::vector<piece> pieces_;
+      std::size_t pending_entries_ = 0;
+      std::size_t const window_entries_;
+      std::future<void> writer_;
+    };
+
+    // (ctor)
+    // ~~~~~~
+    parallel_exporter::parallel_exporter (database const & db, ostream & os, bool const comments)
+            : db_{db}
+            , out_{os}
+            , comments_{comments}
+            , string_table_{db, name_index_tag ()}
+            , path_table_{db, path_index_tag ()}
+            , window_entries_{entries_per_piece * 4U *
+                              std::max (std::thread::hardware_concurrency (), 1U)} {}
+
+    // (dtor)
+    // ~~~~~~
+    parallel_exporter::~parallel_exporter () noexcept {
+      // Make sure that the writer is no longer using the output stream.
+      if (writer_.valid ()) {
+        writer_.wait ();
+      }
+    }
+
+    // add transaction
+    // ~~~~~~~~~~~~~~~
+    void parallel_exporter::add_transaction (typed_address<trailer> const footer_pos,
+                                             bool const first) {
+      auto const ind = indent{}.next ().next ();
+      auto const object_indent = ind.next ();
+      unsigned const generation = db_.getro (footer_pos)->a.generation;
+      PSTORE_ASSERT (generation > 0U);
+
+      *os_ << (first ? "" : ",") << '\n' << ind << "{\n";
+      if (comments_) {
+        *os_ << object_indent << "// transaction #" << generation << '\n';
+      }
+
+      bool names_emitted = false;
+      if (auto const names = index::get_index_snapshot<trailer::indices::name> (db_, footer_pos)) {
+        names_emitted = emit_strings<trailer::indices::name> (
+          *os_, object_indent, db_, *names, generation, prefix (false, object_indent, "names"),
+          &string_table_, comments_);
+      }
+      bool paths_emitted = false;
+      if (auto const paths = index::get_index_snapshot<trailer::indices::path> (db_, footer_pos)) {
+        paths_emitted = emit_strings<trailer::indices::path> (
+          *os_, object_indent, db_, *paths, generation,
+          prefix (names_emitted, object_indent, "paths"), &path_table_, comments_);
+      }
+      if (paths_emitted || names_emitted) {
+        *os_ << ",\n";
+      }
+
+      if (auto const headers =
+            index::get_index_snapshot<trailer::indices::debug_line_header> (db_, footer_pos)) {
+        std::vector<address> const addrs = this->changes (*headers, generation);
+        if (!addrs.empty ()) {
+          *os_ << object_indent << R"("debugline":{)";
+          this->add_entries (headers, addrs, object_indent.next (),
+                             [this] (ostream_base & os1, indent,
+                                     extent<std::uint8_t> const & ex) {
+                               emit_debug_line_header_data (os1, db_, ex);
+                             });
+          *os_ << '\n' << object_indent << "},\n";
+        }
+      }
+
+      *os_ << object_indent << R"("fragments":{)";
+      if (auto const fragments =
+            index::get_index_snapshot<trailer::indices::fragment> (db_, footer_pos)) {
+        this->add_entries (fragments, this->changes (*fragments, generation),
+                           object_indent.next (),
+                           [this] (ostream_base & os1, indent const ind1,
+                                   extent<repo::fragment> const & ex) {
+                             emit_fragment (os1, ind1, db_, string_table_, db_.getro (ex),
+                                            comments_);
+                           });
+      }
+      *os_ << '\n' << object_indent << "},\n";
+
+      *os_ << object_indent << R"("compilations":{)";
+      if (auto const compilations =
+            index::get_index_snapshot<trailer::indices::compilation> (db_, footer_pos)) {
+        this->add_entries (compilations, this->changes (*compilations, generation),
+                           object_indent.next (),
+                           [this] (ostream_base & os1, indent const ind1,
+                                   extent<repo::compilation> const & ex) {
+                             emit_compilation (os1, ind1, db_, *db_.getro (ex), string_table_,
+                                               comments_);
+                           });
+      }
+      *os_ << '\n' << object_indent << "}\n";
+      *os_ << ind << '}';
+
+      if (pending_entries_ >= window_entries_) {
+        this->flush_window ();
+      }
+    }
+
+    // finish
+    // ~~~~~~
+    void parallel_exporter::finish () {
+      this->flush_window ();
+      if (writer_.valid ()) {
+        writer_.get ();
+      }
+    }
+
+    // changes
+    // ~~~~~~~
+    template <typename Index>
+    std::vector<address> parallel_exporter::changes (Index const & index,
+                                                     unsigned const generation) const {
+      std::vector<address> result;
+      diff (db_, index, generation - 1U, std::back_inserter (result));
+      return result;
+    }
+
+    // add entries
+    // ~~~~~~~~~~~
+    template <typename Index, typename EmitValue>
+    void parallel_exporter::add_entries (std::shared_ptr<Index const> const & index,
+                                         std::vector<address> const & addrs, indent const ind,
+                                         EmitValue emit_value) {
+      this->end_text ();
+      for (auto first = std::begin (addrs), last = std::end (addrs); first != last;) {
+        auto const n = std::min (static_cast<std::size_t> (std::distance (first, last)),
+                                 entries_per_piece);
+        bool const is_first = first == std::begin (addrs);
+        std::vector<address> chunk (first, first + static_cast<std::ptrdiff_t> (n));
+        pieces_.push_back (
+          {std::string{},
+           [this, index, chunk = std::move (chunk), ind, is_first,
+            emit_value] (ostream_base & os) {
+             char const * sep = is_first ? "\n" : ",\n";
+             for (address const addr : chunk) {
+               auto const & kvp = index->load_leaf (db_, addr);
+               os << sep << ind;
+               emit_digest (os, kvp.first);
+               os << ':';
+               emit_value (os, ind, kvp.second);
+               sep = ",\n";
+             }
+           }});
+        pending_entries_ += n;
+        first += static_cast<std::ptrdiff_t> (n);
+      }
+    }
+
+    // end text
+    // ~~~~~~~~
+    void parallel_exporter::end_text () {
+      pieces_.push_back ({os_->str (), nullptr});
+      os_ = std::make_unique<ostringstream> ();
+    }
+
+    // flush window
+    // ~~~~~~~~~~~~
+    void parallel_exporter::flush_window () {
+      this->end_text ();
+
+      std::vector<piece *> work;
+      for (piece & p : pieces_) {
+        if (p.render) {
+          work.push_back (&p);
+        }
+      }
+      parallel_for_each (std::begin (work), std::end (work), [] (piece * const p) {
+        ostringstream os;
+        p->render (os);
+        p->text = os.str ();
+        p->render = nullptr;
+      });
+
+      // Wait for the previous window to be written before starting on this one.
+      if (writer_.valid ()) {
+        writer_.get ();
+      }
+      writer_ = std::async (std::launch::async, [this, pieces = std::move (pieces_)] () {
+        for (piece const & p : pieces) {
+          out_ << p.text;
+        }
+      });
+      pieces_.clear ();
+      pending_entries_ = 0;
+    }
+
+  } // end anonymous namespace
+
   void emit_database (database & db, ostream & os, bool const comments) {
     string_mapping string_table{db, name_index_tag ()};
     string_mapping path_table{db, path_index_tag ()};
@@ -133,4 +417,36 @@ namespace pstore::exchange::export_ns {
     os << "\n}\n";
   }
 
+  void emit_database_parallel (database const & db, ostream & os, bool const comments) {
+    auto const ind = indent{}.next ();
+    os << "{\n";
+    os << ind << R"("version":1,)" << '\n';
+    os << ind << R"("id":")" << db.get_header ().id ().str () << "\",\n";
+    os << ind << R"("transactions":[)";
+
+    auto const f = footers (db);
+    PSTORE_ASSERT (std::distance (std::begin (f), std::end (f)) >= 1);
+    {
+      parallel_exporter exporter{db, os, comments};
+      for (auto it = std::next (std::begin (f)), end = std::end (f); it != end; ++it) {
+        exporter.add_transaction (*it, it == std::next (std::begin (f)));
+      }
+      exporter.finish ();
+    }
+    if (f.size () > 1U) {
+      os << '\n' << ind;
+    }
+    os << "]\n}\n";
+  }
+
+  void emit_database_binary (database const & db, ostream_base & os) {
+    auto const f = footers (db);
+    PSTORE_ASSERT (std::distance (std::begin (f), std::end (f)) >= 1);
+    binary_writer writer{db, os};
+    for (auto it = std::next (std::begin (f)), end = std::end (f); it != end; ++it) {
+      writer.add_transaction (*it);
+    }
+    writer.finish ();
+  }
+
 } // end namespace pstore::exchange::export_ns
@@ -0,0 +1,323 @@
+//===- lib/exchange/export_binary.cpp -------------------------------------===//
+//*                             _    *
+//*   _____  ___ __   ___  _ __| |_  *
+//*  / _ \ \/ / '_ \ / _ \| '__| __| *
+//* |  __/>  <| |_) | (_) | |  | |_  *
+//*  \___/_/\_\ .__/ \___/|_|   \__| *
+//*           |_|                    *
+//*  _     _                         *
+//* | |__ (_)_ __   __ _ _ __ _   _  *
+//* | '_ \| | '_ \ / _` | '__| | | | *
+//* | |_) | | | | | (_| | |  | |_| | *
+//* |_.__/|_|_| |_|\__,_|_|   \__, | *
+//*                           |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file export_binary.cpp
+/// \brief Implements the writer for the binary exchange format.
+
+#include "pstore/exchange/export_binary.hpp"
+
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include "pstore/core/diff.hpp"
+
+namespace pstore::exchange::export_ns {
+
+  // (ctor)
+  // ~~~~~~
+  binary_writer::binary_writer (database const & db, ostream_base & os)
+          : db_{db}
+          , os_{os}
+          , names_{db, name_index_tag ()}
+          , paths_{db, path_index_tag ()} {
+    binary::file_header header{};
+    header.signature1 = binary::signature1;
+    header.signature2 = binary::signature2;
+    header.version = binary::version;
+    header.id = db.get_header ().id ().array ();
+    os_.write (reinterpret_cast<char const *> (&header), sizeof (header));
+  }
+
+  // add transaction
+  // ~~~~~~~~~~~~~~~
+  void binary_writer::add_transaction (typed_address<trailer> const footer_pos) {
+    unsigned const generation = db_.getro (footer_pos)->a.generation;
+    PSTORE_ASSERT (generation > 0U);
+
+    this->write_record_header (binary::record_kind::transaction_begin, 0U);
+    this->write_strings<trailer::indices::name> (binary::record_kind::names, footer_pos,
+                                                 generation, &names_);
+    this->write_strings<trailer::indices::path> (binary::record_kind::paths, footer_pos,
+                                                 generation, &paths_);
+    this->write_debug_line_headers (footer_pos, generation);
+    this->write_fragments (footer_pos, generation);
+    this->write_compilations (footer_pos, generation);
+    this->write_record_header (binary::record_kind::transaction_end, 0U);
+  }
+
+  // finish
+  // ~~~~~~
+  void binary_writer::finish () {
+    this->write_record_header (binary::record_kind::end, 0U);
+  }
+
+  // write record header
+  // ~~~~~~~~~~~~~~~~~~~
+  void binary_writer::write_record_header (binary::record_kind const kind,
+                                           std::uint64_t const size) {
+    binary::record_header const header{kind, 0U, size};
+    os_.write (reinterpret_cast<char const *> (&header), sizeof (header));
+  }
+
+  // write padding
+  // ~~~~~~~~~~~~~
+  void binary_writer::write_padding (std::uint64_t const size) {
+    static constexpr std::array<char, binary::record_alignment> zeros{{}};
+    if (auto const padding = binary::padded_size (size) - size; padding > 0U) {
+      os_.write (zeros.data (), static_cast<std::streamsize> (padding));
+    }
+  }
+
+  // write record
+  // ~~~~~~~~~~~~
+  void binary_writer::write_record (binary::record_kind const kind) {
+    this->write_record_header (kind, payload_.size ());
+    if (!payload_.empty ()) {
+      os_.write (reinterpret_cast<char const *> (payload_.data ()),
+                 static_cast<std::streamsize> (payload_.size ()));
+    }
+    this->write_padding (payload_.size ());
+    payload_.clear ();
+  }
+
+  // write strings
+  // ~~~~~~~~~~~~~
+  template <trailer::indices Index>
+  void binary_writer::write_strings (binary::record_kind const kind,
+                                     typed_address<trailer> const footer_pos,
+                                     unsigned const generation, string_mapping * const table) {
+    auto const strings = index::get_index_snapshot<Index> (db_, footer_pos);
+    if (strings == nullptr) {
+      return;
+    }
+    std::vector<address> addrs;
+    diff (db_, *strings, generation - 1U, std::back_inserter (addrs));
+    if (addrs.empty ()) {
+      return;
+    }
+    this->append (std::uint64_t{addrs.size ()});
+    for (address const addr : addrs) {
+      indirect_string const str = strings->load_leaf (db_, addr);
+      shared_sstring_view owner;
+      raw_sstring_view const view = str.as_db_string_view (&owner);
+      this->append (std::uint64_t{view.size ()});
+      this->append_bytes (view.data (), view.size ());
+      this->append_padding ();
+      table->add (addr);
+    }
+    this->write_record (kind);
+  }
+
+  // write debug line headers
+  // ~~~~~~~~~~~~~~~~~~~~~~~~
+  void binary_writer::write_debug_line_headers (typed_address<trailer> const footer_pos,
+                                                unsigned const generation) {
+    auto const headers =
+      index::get_index_snapshot<trailer::indices::debug_line_header> (db_, footer_pos);
+    if (headers == nullptr) {
+      return;
+    }
+    auto const out_fn = [&] (address const addr) {
+      auto const & kvp = headers->load_leaf (db_, addr);
+      // Write the header data directly from the store rather than copying it to the payload
+      // buffer first.
+      scatter_view const data = db_.getro_view (kvp.second);
+      auto const size = sizeof (binary::digest) + data.size ();
+      this->write_record_header (binary::record_kind::debug_line_header, size);
+      binary::digest const digest{kvp.first};
+      os_.write (reinterpret_cast<char const *> (&digest), sizeof (digest));
+      for (auto const & s : data) {
+        os_.write (reinterpret_cast<char const *> (s.data ()),
+                   static_cast<std::streamsize> (s.size ()));
+      }
+      this->write_padding (size);
+    };
+    diff (db_, *headers, generation - 1U, make_diff_out (&out_fn));
+  }
+
+  // write fragments
+  // ~~~~~~~~~~~~~~~
+  void binary_writer::write_fragments (typed_address<trailer> const footer_pos,
+                                       unsigned const generation) {
+    auto const fragments = index::get_index_snapshot<trailer::indices::fragment> (db_, footer_pos);
+    if (fragments == nullptr) {
+      return;
+    }
+    auto const out_fn = [&] (address const addr) {
+      auto const & kvp = fragments->load_leaf (db_, addr);
+      std::shared_ptr<repo::fragment const> const fragment = db_.getro (kvp.second);
+      this->append (binary::digest{kvp.first});
+      this->append (std::uint64_t{fragment->size ()});
+      this->append_fragment (*fragment);
+      this->write_record (binary::record_kind::fragment);
+    };
+    diff (db_, *fragments, generation - 1U, make_diff_out (&out_fn));
+  }
+
+  // write compilations
+  // ~~~~~~~~~~~~~~~~~~
+  void binary_writer::write_compilations (typed_address<trailer> const footer_pos,
+                                          unsigned const generation) {
+    auto const compilations =
+      index::get_index_snapshot<trailer::indices::compilation> (db_, footer_pos);
+    if (compilations == nullptr) {
+      return;
+    }
+    auto const out_fn = [&] (address const addr) {
+      auto const & kvp = compilations->load_leaf (db_, addr);
+      std::shared_ptr<repo::compilation const> const compilation = db_.getro (kvp.second);
+      this->append (binary::digest{kvp.first});
+      this->append (std::uint64_t{names_.index (compilation->triple ())});
+      this->append (std::uint64_t{compilation->size ()});
+      for (repo::definition const & d : *compilation) {
+        binary::definition def{};
+        def.fragment = binary::digest{d.digest};
+        def.name = names_.index (d.name);
+        def.linkage = d.linkage ();
+        def.visibility = d.visibility ();
+        this->append (def);
+      }
+      this->write_record (binary::record_kind::compilation);
+    };
+    diff (db_, *compilations, generation - 1U, make_diff_out (&out_fn));
+  }
+
+  // append fragment
+  // ~~~~~~~~~~~~~~~
+  void binary_writer::append_fragment (repo::fragment const & fragment) {
+    for (repo::section_kind const kind : fragment) {
+#define X(a)                                                                                       \
+  case repo::section_kind::a:                                                                      \
+    this->append_section (kind, fragment.at<repo::section_kind::a> ());                            \
+    break;
+      switch (kind) {
+        PSTORE_MCREPO_SECTION_KINDS
+      case repo::section_kind::last:
+        // unreachable...
+        PSTORE_ASSERT (false);
+        break;
+      }
+#undef X
+    }
+  }
+
+  // append section
+  // ~~~~~~~~~~~~~~
+  void binary_writer::append_section (repo::section_kind const kind,
+                                      repo::generic_section const & section) {
+    repo::container<std::uint8_t> const data = section.payload ();
+    repo::container<repo::internal_fixup> const ifixups = section.ifixups ();
+    repo::container<repo::external_fixup> const xfixups = section.xfixups ();
+    this->append_section_header (kind, section.align (), data.size (), ifixups.size (),
+                                 xfixups.size ());
+    this->append_contents (data, ifixups, xfixups);
+  }
+
+  void binary_writer::append_section (repo::section_kind const kind,
+                                      repo::bss_section const & section) {
+    PSTORE_ASSERT (section.ifixups ().empty () && section.xfixups ().empty ());
+    this->append_section_header (kind, section.align (), section.size (), 0U, 0U);
+  }
+
+  void binary_writer::append_section (repo::section_kind const kind,
+                                      repo::debug_line_section const & section) {
+    repo::container<std::uint8_t> const data = section.payload ();
+    repo::container<repo::internal_fixup> const ifixups = section.ifixups ();
+    repo::container<repo::external_fixup> const xfixups = section.xfixups ();
+    this->append_section_header (kind, section.align (), data.size (), ifixups.size (),
+                                 xfixups.size ());
+    this->append (binary::digest{section.header_digest ()});
+    this->append_contents (data, ifixups, xfixups);
+  }
+
+  void binary_writer::append_section (repo::section_kind const kind,
+                                      repo::linked_definitions const & section) {
+    this->append_section_header (kind, 1U, section.size (), 0U, 0U);
+    for (repo::linked_definitions::value_type const & l : section) {
+      binary::linked_definition ld{};
+      ld.compilation = binary::digest{l.compilation};
+      ld.index = l.index;
+      this->append (ld);
+    }
+  }
+
+  // append section header
+  // ~~~~~~~~~~~~~~~~~~~~~
+  void binary_writer::append_section_header (repo::section_kind const kind, unsigned const align,
+                                             std::uint64_t const size,
+                                             std::size_t const num_ifixups,
+                                             std::size_t const num_xfixups) {
+    PSTORE_ASSERT (num_ifixups <= std::numeric_limits<std::uint32_t>::max () &&
+                   num_xfixups <= std::numeric_limits<std::uint32_t>::max ());
+    binary::section_header header{};
+    header.kind = kind;
+    header.align = align;
+    header.num_ifixups = static_cast<std::uint32_t> (num_ifixups);
+    header.num_xfixups = static_cast<std::uint32_t> (num_xfixups);
+    header.size = size;
+    this->append (header);
+  }
+
+  // append contents
+  // ~~~~~~~~~~~~~~~
+  void binary_writer::append_contents (repo::container<std::uint8_t> const & data,
+                                       repo::container<repo::internal_fixup> const & ifixups,
+                                       repo::container<repo::external_fixup> const & xfixups) {
+    this->append_bytes (data.data (), data.size ());
+    this->append_padding ();
+    for (repo::internal_fixup const & ifx : ifixups) {
+      this->append (ifx);
+    }
+    for (repo::external_fixup const & xfx : xfixups) {
+      binary::external_fixup x{};
+      x.name = names_.index (xfx.name);
+      x.type = xfx.type;
+      x.is_weak = xfx.is_weak;
+      x.offset = xfx.offset;
+      x.addend = xfx.addend;
+      this->append (x);
+    }
+  }
+
+  // append
+  // ~~~~~~
+  template <typename T>
+  void binary_writer::append (T const & t) {
+    static_assert (std::is_trivially_copyable_v<T>, "Only trivially copyable types may be written");
+    this->append_bytes (&t, sizeof (t));
+  }
+
+  // append bytes
+  // ~~~~~~~~~~~~
+  void binary_writer::append_bytes (void const * const ptr, std::size_t const size) {
+    auto const * const first = static_cast<std::byte const *> (ptr);
+    payload_.insert (std::end (payload_), first, first + size);
+  }
+
+  // append padding
+  // ~~~~~~~~~~~~~~
+  void binary_writer::append_padding () {
+    // The payload begins on a record_alignment boundary, so padding its size is sufficient.
+    payload_.resize (binary::padded_size (payload_.size ()));
+  }
+
+} // end namespace pstore::exchange::export_ns
@@ -15,8 +15,101 @@
 //===----------------------------------------------------------------------===//
 #include "pstore/exchange/export_emit.hpp"
 
+#include <algorithm>
+#include <array>
+
+#include "pstore/support/base64.hpp"
+#include "pstore/support/bit_count.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define PSTORE_EMIT_SIMD 1
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    define PSTORE_EMIT_AVX2_TARGET
+#  else
+#    define PSTORE_EMIT_AVX2_TARGET __attribute__ ((target ("avx2")))
+#  endif
+#else
+#  define PSTORE_EMIT_SIMD 0
+#endif
+
+namespace {
+
+  constexpr bool needs_escape (char const c) noexcept { return c == '"' || c == '\\'; }
+
+#if PSTORE_EMIT_SIMD
+  bool cpu_has_avx2 () noexcept {
+#  ifdef _MSC_VER
+    int info[4];
+    __cpuid (info, 0);
+    int const max_leaf = info[0];
+    __cpuid (info, 1);
+    // AVX2 also requires that the OS saves the YMM registers on a context switch.
+    if (max_leaf < 7 || (info[2] & (1 << 27)) == 0 || (_xgetbv (0) & 0x6U) != 0x6U) {
+      return false;
+    }
+    __cpuidex (info, 7, 0);
+    return (info[1] & (1 << 5)) != 0; // EBX bit 5: AVX2.
+#  else
+    return __builtin_cpu_supports ("avx2") != 0;
+#  endif
+  }
+
+  // SSE2 is part of the x86-64 base instruction set so needs no run-time check. Returns a
+  // pointer to the first character that needs to be escaped or to the start of the final
+  // block of fewer than 16 characters.
+  char const * find_escape_sse2 (char const * first, char const * const last) noexcept {
+    __m128i const quote = _mm_set1_epi8 ('"');
+    __m128i const backslash = _mm_set1_epi8 ('\\');
+    for (; last - first >= 16; first += 16) {
+      __m128i const x = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (first));
+      auto const mask = static_cast<unsigned> (_mm_movemask_epi8 (
+        _mm_or_si128 (_mm_cmpeq_epi8 (x, quote), _mm_cmpeq_epi8 (x, backslash))));
+      if (mask != 0U) {
+        return first + pstore::bit_count::ctz (mask);
+      }
+    }
+    return first;
+  }
+
+  PSTORE_EMIT_AVX2_TARGET
+  char const * find_escape_avx2 (char const * first, char const * const last) noexcept {
+    __m256i const quote = _mm256_set1_epi8 ('"');
+    __m256i const backslash = _mm256_set1_epi8 ('\\');
+    for (; last - first >= 32; first += 32) {
+      __m256i const x = _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (first));
+      auto const mask = static_cast<unsigned> (_mm256_movemask_epi8 (
+        _mm256_or_si256 (_mm256_cmpeq_epi8 (x, quote), _mm256_cmpeq_epi8 (x, backslash))));
+      if (mask != 0U) {
+        return first + pstore::bit_count::ctz (mask);
+      }
+    }
+    return first;
+  }
+#endif // PSTORE_EMIT_SIMD
+
+} // end anonymous namespace
+
 namespace pstore::exchange::export_ns {
 
+  namespace details {
+
+    // find escape
+    // ~~~~~~~~~~~
+    char const * find_escape (char const * first, char const * const last) noexcept {
+#if PSTORE_EMIT_SIMD
+      static bool const has_avx2 = cpu_has_avx2 ();
+      if (has_avx2) {
+        first = find_escape_avx2 (first, last);
+      }
+      first = find_escape_sse2 (first, last);
+#endif // PSTORE_EMIT_SIMD
+      return std::find_if (first, last, needs_escape);
+    }
+
+  } // end namespace details
+
   ostream_base & operator<< (ostream_base & os, indent const & i) {
     for (unsigned d = i.distance (); d > 0U; --d) {
       os << "  ";
@@ -34,11 +127,40 @@ namespace pstore::exchange::export_ns {
     os << '"';
   }
 
+  // emit string
+  // ~~~~~~~~~~~
+  void emit_string (ostream_base & os, char const * first, char const * const last) {
+    os << '"';
+    char const * pos;
+    while ((pos = details::find_escape (first, last)) != last) {
+      details::write_span (os, gsl::make_span (first, pos));
+      os << '\\' << *pos;
+      first = pos + 1;
+    }
+    details::write_span (os, gsl::make_span (first, last));
+    os << '"';
+  }
 
   void emit_string (ostream_base & os, raw_sstring_view const & view) {
     emit_string (os, std::begin (view), std::end (view));
   }
 
+  // emit base64
+  // ~~~~~~~~~~~
+  void emit_base64 (ostream_base & os, std::uint8_t const * first,
+                    std::uint8_t const * const last) {
+    // Encode the data in blocks whose size is a multiple of three so that padding is only
+    // produced at the very end.
+    constexpr auto block_size = std::size_t{3} * 1024U;
+    std::array<char, base64_encoded_size (block_size)> chars;
+    while (first != last) {
+      auto const size = std::min (static_cast<std::size_t> (last - first), block_size);
+      char * const end = base64_encode (first, size, chars.data ());
+      details::write_span (os, gsl::make_span (chars.data (), end));
+      first += size;
+    }
+  }
+
   ostream_base & show_string (ostream_base & os, database const & db,
                               typed_address<pstore::indirect_string> const addr,
                               bool const comments) {
@@ -0,0 +1,887 @@
+//===- lib/exchange/import_binary.cpp -------------------------------------===//
+//*  _                            _    *
+//* (_)_ __ ___  _ __   ___  _ __| |_  *
+//* | | '_ ` _ \| '_ \ / _ \| '__| __| *
+//* | | | | | | | |_) | (_) | |  | |_  *
+//* |_|_| |_| |_| .__/ \___/|_|   \__| *
+//*             |_|                    *
+//*  _     _                         *
+//* | |__ (_)_ __   __ _ _ __ _   _  *
+//* | '_ \| | '_ \ / _` | '__| | | | *
+//* | |_) | | | | | (_| | |  | |_| | *
+//* |_.__/|_|_| |_|\__,_|_|   \__, | *
+//*                           |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file import_binary.cpp
+/// \brief Implements the streaming reader for the binary exchange format.
+
+#include "pstore/exchange/import_binary.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <list>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/hamt_set.hpp"
+#include "pstore/core/indirect_string.hpp"
+#include "pstore/core/transaction.hpp"
+#include "pstore/exchange/import_patcher.hpp"
+#include "pstore/exchange/import_pipeline.hpp"
+#include "pstore/mcrepo/bss_section.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/debug_line_section.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/mcrepo/linked_definitions_section.hpp"
+#include "pstore/support/bit_count.hpp"
+#include "pstore/support/pointee_adaptor.hpp"
+
+namespace {
+
+#define X(a) +1
+  constexpr auto num_linkages = 0 PSTORE_REPO_LINKAGES;
+  constexpr auto num_visibilities = 0 PSTORE_REPO_VISIBILITIES;
+#undef X
+
+} // end anonymous namespace
+
+namespace pstore::exchange::import_ns {
+
+  // is binary input
+  // ~~~~~~~~~~~~~~~
+  bool is_binary_input (std::byte const * const first, std::byte const * const last) noexcept {
+    auto const & sig = binary::signature1;
+    return static_cast<std::size_t> (last - first) >= sig.size () &&
+           std::memcmp (first, sig.data (), sig.size ()) == 0;
+  }
+
+  //*                    _                 _                       _            *
+  //*  _ __   __ _ _   _| | ___   __ _  __| |   _ __ ___  __ _  __| | ___ _ __  *
+  //* | '_ \ / _` | | | | |/ _ \ / _` |/ _` |  | '__/ _ \/ _` |/ _` |/ _ \ '__| *
+  //* | |_) | (_| | |_| | | (_) | (_| | (_| |  | | |  __/ (_| | (_| |  __/ |    *
+  //* | .__/ \__,_|\__, |_|\___/ \__,_|\__,_|  |_|  \___|\__,_|\__,_|\___|_|    *
+  //* |_|          |___/                                                        *
+  /// Extracts values from the payload of a record. Values are copied out of the payload so
+  /// that it need not be aligned.
+  class binary_parser::payload_reader {
+  public:
+    payload_reader (std::byte const * const first, std::byte const * const last) noexcept
+            : origin_{first}
+            , first_{first}
+            , last_{last} {}
+
+    bool empty () const noexcept { return first_ == last_; }
+    /// Returns the total size of the payload.
+    std::size_t size () const noexcept { return static_cast<std::size_t> (last_ - origin_); }
+    std::size_t remaining () const noexcept { return static_cast<std::size_t> (last_ - first_); }
+
+    /// Copies a value of type T from the payload to \p t. Returns false if the payload is too
+    /// short.
+    template <typename T>
+    bool get (T * const t) noexcept {
+      static_assert (std::is_trivially_copyable_v<T>, "Only trivially copyable types may be read");
+      if (this->remaining () < sizeof (T)) {
+        return false;
+      }
+      std::memcpy (t, first_, sizeof (T));
+      first_ += sizeof (T);
+      return true;
+    }
+
+    /// Returns a pointer to the next \p size bytes of the payload and advances past them and
+    /// any padding which follows them. The padding after the final item of a record lies
+    /// beyond the payload's recorded size. Returns nullptr if the payload is too short.
+    std::byte const * take (std::uint64_t const size) noexcept {
+      if (size > this->remaining ()) {
+        return nullptr;
+      }
+      auto const offset = static_cast<std::uint64_t> (first_ - origin_);
+      auto const end = static_cast<std::uint64_t> (last_ - origin_);
+      std::byte const * const result = first_;
+      first_ = origin_ + std::min (binary::padded_size (offset + size), end);
+      return result;
+    }
+
+  private:
+    std::byte const * const origin_;
+    std::byte const * first_;
+    std::byte const * const last_;
+  };
+
+  //*                             _  *
+  //*  _ __ ___  ___ ___  _ __ __| | *
+  //* | '__/ _ \/ __/ _ \| '__/ _` | *
+  //* | | |  __/ (_| (_) | | | (_| | *
+  //* |_|  \___|\___\___/|_|  \__,_| *
+  //*                                *
+  /// A record which has been decoded and validated but not yet added to the store. A record
+  /// owns all of its data so that it may outlive the input from which it was decoded.
+  struct binary_parser::record {
+    struct begin_transaction {};
+    struct end_transaction {};
+    struct end {
+      uuid id;
+    };
+    struct strings {
+      bool is_path = false;
+      /// A list so that the strings do not move once they've been added to an index.
+      std::list<std::string> values;
+    };
+    struct debug_line_header {
+      index::digest digest;
+      std::vector<std::uint8_t> data;
+    };
+    struct fragment {
+      index::digest digest;
+      /// The fragment's sections in order of their kind. The names of the external fixups are
+      /// not filled in until the record is stored.
+      std::vector<repo::section_content> sections;
+      /// The name index of each of the sections' external fixups, in order.
+      std::vector<std::uint64_t> xfixup_names;
+      /// The digest of the header referenced by the debug line section, if there is one.
+      index::digest debug_line_header;
+      std::vector<repo::linked_definitions::value_type> linked_definitions;
+    };
+    struct compilation {
+      index::digest digest;
+      std::uint64_t triple = 0;
+      std::vector<binary::definition> definitions;
+    };
+
+    /// The offset in the input of the start of the record.
+    std::uint64_t pos = 0;
+    /// An estimate of the number of bytes of memory occupied by the record.
+    std::size_t size = 0;
+    std::variant<begin_transaction, end_transaction, end, strings, debug_line_header, fragment,
+                 compilation>
+      value;
+  };
+
+  //*      _                  *
+  //*  ___| |_ ___  _ __ ___  *
+  //* / __| __/ _ \| '__/ _ \ *
+  //* \__ \ || (_) | | |  __/ *
+  //* |___/\__\___/|_|  \___| *
+  //*                         *
+  /// The second stage of the binary import: adds decoded records to the store.
+  class binary_parser::store {
+  public:
+    explicit store (gsl::not_null<database *> const db) noexcept
+            : db_{db} {}
+    store (store const &) = delete;
+    store (store &&) = delete;
+
+    // An incomplete transaction is rolled back by its destructor.
+    ~store () noexcept = default;
+
+    store & operator= (store const &) = delete;
+    store & operator= (store &&) = delete;
+
+    /// Adds the contents of \p r to the store.
+    std::error_code apply (record && r) {
+      return std::visit ([this] (auto & value) { return this->add (value); }, r.value);
+    }
+
+  private:
+    std::error_code add (record::begin_transaction const &);
+    std::error_code add (record::end_transaction const &);
+    std::error_code add (record::end const & r);
+    std::error_code add (record::strings & r);
+    std::error_code add (record::debug_line_header const & r);
+    std::error_code add (record::fragment & r);
+    std::error_code add (record::compilation const & r);
+
+    gsl::not_null<database *> const db_;
+    std::optional<transaction<transaction_lock>> transaction_;
+    std::list<std::unique_ptr<patcher>> patches_;
+
+    /// The strings added by the current transaction. These must remain alive until the
+    /// transaction is committed.
+    std::list<std::string> strings_;
+    std::list<raw_sstring_view> views_;
+    /// Maps from a name index to the address of the corresponding string in the store.
+    std::vector<typed_address<indirect_string>> names_;
+  };
+
+  // add begin transaction
+  // ~~~~~~~~~~~~~~~~~~~~~
+  std::error_code binary_parser::store::add (record::begin_transaction const &) {
+    PSTORE_ASSERT (!transaction_);
+    transaction_.emplace (begin (*db_));
+    return {};
+  }
+
+  // add end transaction
+  // ~~~~~~~~~~~~~~~~~~~
+  std::error_code binary_parser::store::add (record::end_transaction const &) {
+    PSTORE_ASSERT (transaction_);
+    for (auto const & patch : patches_) {
+      if (std::error_code const erc = (*patch) (&*transaction_)) {
+        return erc;
+      }
+    }
+    patches_.clear ();
+    transaction_->commit ();
+    transaction_.reset ();
+    views_.clear ();
+    strings_.clear ();
+    return {};
+  }
+
+  // add end
+  // ~~~~~~~
+  std::error_code binary_parser::store::add (record::end const & r) {
+    PSTORE_ASSERT (!transaction_);
+    db_->set_id (r.id);
+    return {};
+  }
+
+  // add strings
+  // ~~~~~~~~~~~
+  std::error_code binary_parser::store::add (record::strings & r) {
+    PSTORE_ASSERT (transaction_);
+    if (r.values.empty ()) {
+      return {};
+    }
+    auto const index = r.is_path ? index::get_index<trailer::indices::path> (*db_)
+                                 : index::get_index<trailer::indices::name> (*db_);
+    // Take ownership of the strings before they are referenced by the index.
+    auto const first = std::begin (r.values);
+    auto const last = std::end (strings_);
+    strings_.splice (last, r.values);
+
+    indirect_string_adder adder;
+    for (auto it = first; it != last; ++it) {
+      views_.emplace_back (make_sstring_view (*it));
+      auto const res = adder.add (*transaction_, index, &views_.back ());
+      if (!res.second) {
+        return error::duplicate_name;
+      }
+      if (!r.is_path) {
+        names_.push_back (typed_address<indirect_string>::make (res.first.get_address ()));
+      }
+    }
+    adder.flush (*transaction_);
+    return {};
+  }
+
+  // add debug line header
+  // ~~~~~~~~~~~~~~~~~~~~~
+  std::error_code binary_parser::store::add (record::debug_line_header const & r) {
+    PSTORE_ASSERT (transaction_);
+    auto const size = r.data.size ();
+    auto [out, where] = transaction_->alloc_rw<std::uint8_t> (size);
+    std::copy (std::begin (r.data), std::end (r.data), out.get ());
+    index::get_index<trailer::indices::debug_line_header> (*db_)->insert (
+      *transaction_, std::make_pair (r.digest, extent<std::uint8_t>{where, size}));
+    return {};
+  }
+
+  // add fragment
+  // ~~~~~~~~~~~~
+  std::error_code binary_parser::store::add (record::fragment & r) {
+    PSTORE_ASSERT (transaction_);
+    std::vector<std::unique_ptr<repo::section_creation_dispatcher>> dispatchers;
+    dispatchers.reserve (r.sections.size ());
+
+    auto name = std::begin (r.xfixup_names);
+    for (repo::section_content & content : r.sections) {
+      for (repo::external_fixup & xfx : content.xfixups) {
+        PSTORE_ASSERT (name != std::end (r.xfixup_names) && *name < names_.size ());
+        xfx.name = names_[static_cast<std::size_t> (*name++)];
+      }
+
+      switch (content.kind) {
+      case repo::section_kind::bss:
+        dispatchers.emplace_back (new repo::bss_section_creation_dispatcher (&content));
+        break;
+      case repo::section_kind::linked_definitions:
+        dispatchers.emplace_back (new repo::linked_definitions_creation_dispatcher (
+          r.linked_definitions.data (),
+          r.linked_definitions.data () + r.linked_definitions.size ()));
+        // The addresses of the definitions are filled in once the transaction's
+        // compilations are known.
+        break;
+      case repo::section_kind::debug_line: {
+        auto const headers = index::get_index<trailer::indices::debug_line_header> (*db_);
+        auto const pos = headers->find (*db_, r.debug_line_header);
+        if (pos == headers->end (*db_)) {
+          return error::debug_line_header_digest_not_found;
+        }
+        dispatchers.emplace_back (new repo::debug_line_section_creation_dispatcher (
+          r.debug_line_header, pos->second, &content));
+      } break;
+      default:
+        dispatchers.emplace_back (
+          new repo::generic_section_creation_dispatcher (content.kind, &content));
+        break;
+      }
+    }
+
+    auto const fext =
+      repo::fragment::alloc (*transaction_, make_pointee_adaptor (dispatchers.begin ()),
+                             make_pointee_adaptor (dispatchers.end ()));
+    index::get_index<trailer::indices::fragment> (*db_)->insert (
+      *transaction_, std::make_pair (r.digest, fext));
+    if (!r.linked_definitions.empty ()) {
+      patches_.emplace_back (new address_patch (db_, fext));
+    }
+    return {};
+  }
+
+  // add compilation
+  // ~~~~~~~~~~~~~~~
+  std::error_code binary_parser::store::add (record::compilation const & r) {
+    PSTORE_ASSERT (transaction_);
+    auto const fragments = index::get_index<trailer::indices::fragment> (*db_);
+    std::vector<repo::definition> definitions;
+    definitions.reserve (r.definitions.size ());
+    for (binary::definition const & d : r.definitions) {
+      auto const pos = fragments->find (*db_, d.fragment.get ());
+      if (pos == fragments->end (*db_)) {
+        return error::no_such_fragment;
+      }
+      PSTORE_ASSERT (d.name < names_.size ());
+      definitions.emplace_back (d.fragment.get (), pos->second,
+                                names_[static_cast<std::size_t> (d.name)], d.linkage,
+                                d.visibility);
+    }
+
+    PSTORE_ASSERT (r.triple < names_.size ());
+    extent<repo::compilation> const compilation_extent = repo::compilation::alloc (
+      *transaction_, names_[static_cast<std::size_t> (r.triple)], std::begin (definitions),
+      std::end (definitions));
+    index::get_index<trailer::indices::compilation> (*db_)->insert (
+      *transaction_, std::make_pair (r.digest, compilation_extent));
+    return {};
+  }
+
+  //*  _                _                                   _  *
+  //* | |__   __ _  ___| | ____ _ _ __ ___  _   _ _ __   __| | *
+  //* | '_ \ / _` |/ __| |/ / _` | '__/ _ \| | | | '_ \ / _` | *
+  //* | |_) | (_| | (__|   < (_| | | | (_) | |_| | | | | (_| | *
+  //* |_.__/ \__,_|\___|_|\_\__, |_|  \___/ \__,_|_| |_|\__,_| *
+  //*                       |___/                              *
+  /// Runs the store on a separate thread, taking decoded records from a queue.
+  class binary_parser::background {
+  public:
+    /// The error raised by the storage thread and the position of the record responsible.
+    using result = std::pair<std::error_code, std::uint64_t>;
+
+    background (gsl::not_null<store *> const s, std::size_t const max_queued)
+            : queue_{max_queued}
+            , result_{std::async (std::launch::async, &background::run, this, s)} {}
+    background (background const &) = delete;
+    background (background &&) = delete;
+
+    /// Stops the storage thread, discarding any records that have not yet been stored.
+    ~background () noexcept {
+      if (result_.valid ()) {
+        queue_.cancel ();
+        result_.wait ();
+      }
+    }
+
+    background & operator= (background const &) = delete;
+    background & operator= (background &&) = delete;
+
+    /// Queues \p r to be stored. Returns false if the storage thread has stopped because of
+    /// an error.
+    bool push (record && r) {
+      auto const size = r.size;
+      return queue_.push (std::move (r), size);
+    }
+    /// Waits for the queued records to be stored.
+    result finish () {
+      queue_.close ();
+      return result_.get ();
+    }
+
+  private:
+    result run (gsl::not_null<store *> s);
+
+    bounded_queue<record> queue_;
+    std::future<result> result_;
+  };
+
+  // run
+  // ~~~
+  auto binary_parser::background::run (gsl::not_null<store *> const s) -> result {
+    PSTORE_TRY {
+      while (std::optional<record> r = queue_.pop ()) {
+        std::uint64_t const pos = r->pos;
+        std::error_code erc;
+        PSTORE_TRY { erc = s->apply (std::move (*r)); }
+        // clang-format off
+        PSTORE_CATCH (std::system_error const & ex, { // clang-format on
+          erc = ex.code ();
+        })
+        if (erc) {
+          // Unblock the producer.
+          queue_.cancel ();
+          return {erc, pos};
+        }
+      }
+    }
+    // clang-format off
+    PSTORE_CATCH (..., { // clang-format on
+      queue_.cancel ();
+      throw;
+    })
+    return {};
+  }
+
+  //*  _     _                                                           *
+  //* | |__ (_)_ __   __ _ _ __ _   _    _ __   __ _ _ __ ___  ___ _ __  *
+  //* | '_ \| | '_ \ / _` | '__| | | |  | '_ \ / _` | '__/ __|/ _ \ '__| *
+  //* | |_) | | | | | (_| | |  | |_| |  | |_) | (_| | |  \__ \  __/ |    *
+  //* |_.__/|_|_| |_|\__,_|_|   \__, |  | .__/ \__,_|_|  |___/\___|_|    *
+  //*                           |___/   |_|                              *
+  // (ctor)
+  // ~~~~~~
+  binary_parser::binary_parser (gsl::not_null<database *> const db, store_mode const mode,
+                                std::size_t const max_queued)
+          : store_{std::make_unique<store> (db)} {
+    if (mode == store_mode::background) {
+      background_ = std::make_unique<background> (store_.get (), max_queued);
+    }
+  }
+
+  // (dtor)
+  // ~~~~~~
+  // The storage thread is stopped before the store is destroyed.
+  binary_parser::~binary_parser () noexcept = default;
+
+  // input
+  // ~~~~~
+  binary_parser & binary_parser::input (std::byte const * first, std::byte const * const last) {
+    if (error_) {
+      return *this;
+    }
+    PSTORE_TRY {
+      // If an item was left incomplete by an earlier call, add bytes to the buffer until it
+      // is complete.
+      while (!buffer_.empty () && !error_) {
+        auto const size = this->item_size (buffer_.data (), buffer_.size ());
+        if (buffer_.size () < size) {
+          if (first == last) {
+            return *this;
+          }
+          auto const n =
+            std::min (size - buffer_.size (), static_cast<std::uint64_t> (last - first));
+          buffer_.insert (std::end (buffer_), first, first + n);
+          first += n;
+          continue;
+        }
+        if (std::error_code const erc = this->item (buffer_.data (), buffer_.data () + size)) {
+          this->fail (erc);
+        }
+        buffer_.clear ();
+      }
+
+      // Consume complete items directly from the input.
+      while (!error_ && first != last) {
+        auto const available = static_cast<std::size_t> (last - first);
+        auto const size = this->item_size (first, available);
+        if (size > available) {
+          buffer_.assign (first, last);
+          break;
+        }
+        if (std::error_code const erc = this->item (first, first + size)) {
+          this->fail (erc);
+        }
+        first += size;
+      }
+    }
+    // clang-format off
+    PSTORE_CATCH (std::system_error const & ex, { // clang-format on
+      this->fail (ex.code ());
+    })
+    return *this;
+  }
+
+  // eof
+  // ~~~
+  binary_parser & binary_parser::eof () {
+    if (error_) {
+      return *this;
+    }
+    if (!seen_end_ || !buffer_.empty ()) {
+      this->fail (error::unexpected_end_of_input);
+    } else {
+      this->wait_for_store ();
+    }
+    return *this;
+  }
+
+  // fail
+  // ~~~~
+  void binary_parser::fail (std::error_code const erc) {
+    PSTORE_ASSERT (erc);
+    error_ = erc;
+    this->wait_for_store ();
+  }
+
+  // wait for store
+  // ~~~~~~~~~~~~~~
+  void binary_parser::wait_for_store () {
+    if (!background_) {
+      return;
+    }
+    auto const [erc, pos] = background_->finish ();
+    background_.reset ();
+    if (erc) {
+      error_ = erc;
+      pos_ = pos;
+    }
+  }
+
+  // item size
+  // ~~~~~~~~~
+  std::uint64_t binary_parser::item_size (std::byte const * const first,
+                                          std::size_t const available) const noexcept {
+    if (!seen_header_) {
+      return sizeof (binary::file_header);
+    }
+    if (available < sizeof (binary::record_header)) {
+      return sizeof (binary::record_header);
+    }
+    binary::record_header header;
+    std::memcpy (&header, first, sizeof (header));
+    // Guard against a size so large that the addition would overflow.
+    auto const max_payload = std::numeric_limits<std::uint64_t>::max () -
+                             sizeof (binary::record_header) - binary::record_alignment;
+    return sizeof (binary::record_header) +
+           binary::padded_size (std::min (header.size, max_payload));
+  }
+
+  // item
+  // ~~~~
+  std::error_code binary_parser::item (std::byte const * const first,
+                                       std::byte const * const last) {
+    std::error_code erc;
+    if (!seen_header_) {
+      erc = this->file_header (first);
+      seen_header_ = true;
+    } else if (seen_end_) {
+      // Nothing may follow the end record.
+      erc = error::unexpected_record;
+    } else {
+      binary::record_header header;
+      std::memcpy (&header, first, sizeof (header));
+      auto const * const payload_first = first + sizeof (header);
+      payload_reader payload{payload_first, payload_first + header.size};
+      erc = this->decode (header.kind, payload);
+    }
+    if (!erc) {
+      pos_ += static_cast<std::uint64_t> (last - first);
+    }
+    return erc;
+  }
+
+  // file header
+  // ~~~~~~~~~~~
+  std::error_code binary_parser::file_header (std::byte const * const first) {
+    binary::file_header header;
+    std::memcpy (&header, first, sizeof (header));
+    if (header.signature1 != binary::signature1 || header.signature2 != binary::signature2) {
+      return error::bad_signature;
+    }
+    if (header.version != binary::version) {
+      return error::unsupported_version;
+    }
+    id_ = uuid{header.id};
+    return {};
+  }
+
+  // decode
+  // ~~~~~~
+  std::error_code binary_parser::decode (binary::record_kind const kind,
+                                         payload_reader & payload) {
+    using binary::record_kind;
+    // With the exception of those which begin a transaction or end the file, records may only
+    // appear within a transaction.
+    if (kind != record_kind::transaction_begin && kind != record_kind::end && !in_transaction_) {
+      return error::unexpected_record;
+    }
+    record r;
+    r.pos = pos_;
+    r.size = payload.size ();
+    std::error_code erc;
+    switch (kind) {
+    case record_kind::transaction_begin:
+      if (in_transaction_) {
+        return error::unexpected_record;
+      }
+      in_transaction_ = true;
+      r.value = record::begin_transaction{};
+      break;
+    case record_kind::names: erc = this->strings (payload, false, &r); break;
+    case record_kind::paths: erc = this->strings (payload, true, &r); break;
+    case record_kind::debug_line_header: erc = this->debug_line_header (payload, &r); break;
+    case record_kind::fragment: erc = this->fragment (payload, &r); break;
+    case record_kind::compilation: erc = this->compilation (payload, &r); break;
+    case record_kind::transaction_end:
+      in_transaction_ = false;
+      r.value = record::end_transaction{};
+      break;
+    case record_kind::end:
+      if (in_transaction_) {
+        return error::unexpected_record;
+      }
+      seen_end_ = true;
+      r.value = record::end{id_};
+      break;
+    default: return error::bad_record;
+    }
+    if (erc) {
+      return erc;
+    }
+    if (!payload.empty ()) {
+      return error::bad_record;
+    }
+    return this->emit (std::move (r));
+  }
+
+  // emit
+  // ~~~~
+  std::error_code binary_parser::emit (record && r) {
+    if (!background_) {
+      return store_->apply (std::move (r));
+    }
+    if (!background_->push (std::move (r))) {
+      // The storage thread stopped because of an error. fail() will retrieve it.
+      return std::make_error_code (std::errc::operation_canceled);
+    }
+    return {};
+  }
+
+  // strings
+  // ~~~~~~~
+  std::error_code binary_parser::strings (payload_reader & payload, bool const is_path,
+                                          record * const r) {
+    std::uint64_t count = 0;
+    if (!payload.get (&count)) {
+      return error::bad_record;
+    }
+    record::strings value;
+    value.is_path = is_path;
+    for (auto ctr = count; ctr > 0U; --ctr) {
+      std::uint64_t length = 0;
+      std::byte const * str = nullptr;
+      if (!payload.get (&length) || (str = payload.take (length)) == nullptr) {
+        return error::bad_record;
+      }
+      value.values.emplace_back (reinterpret_cast<char const *> (str),
+                                 static_cast<std::size_t> (length));
+    }
+    if (!is_path) {
+      num_names_ += count;
+    }
+    r->value = std::move (value);
+    return {};
+  }
+
+  // debug line header
+  // ~~~~~~~~~~~~~~~~~
+  std::error_code binary_parser::debug_line_header (payload_reader & payload, record * const r) {
+    binary::digest digest;
+    if (!payload.get (&digest)) {
+      return error::bad_record;
+    }
+    auto const size = payload.remaining ();
+    auto const * const data = reinterpret_cast<std::uint8_t const *> (payload.take (size));
+    PSTORE_ASSERT (data != nullptr);
+    r->value = record::debug_line_header{digest.get (), {data, data + size}};
+    return {};
+  }
+
+  // fragment
+  // ~~~~~~~~
+  std::error_code binary_parser::fragment (payload_reader & payload, record * const r) {
+    binary::digest digest;
+    std::uint64_t num_sections = 0;
+    if (!payload.get (&digest) || !payload.get (&num_sections) ||
+        num_sections > repo::num_section_kinds) {
+      return error::bad_record;
+    }
+
+    record::fragment value;
+    value.digest = digest.get ();
+    value.sections.reserve (static_cast<std::size_t> (num_sections));
+    std::bitset<repo::num_section_kinds> present;
+
+    for (; num_sections > 0U; --num_sections) {
+      binary::section_header header;
+      if (!payload.get (&header)) {
+        return error::bad_record;
+      }
+      using utype = std::underlying_type_t<repo::section_kind>;
+      auto const index = static_cast<utype> (header.kind);
+      // Sections must appear in order of their kind and each kind at most once.
+      if (index >= repo::num_section_kinds ||
+          (present.any () && index <= static_cast<utype> (value.sections.back ().kind))) {
+        return error::bad_record;
+      }
+      if (header.align == 0U || bit_count::pop_count (header.align) != 1U) {
+        return error::alignment_must_be_power_of_2;
+      }
+      if (header.align > std::numeric_limits<std::uint8_t>::max ()) {
+        return error::alignment_is_too_great;
+      }
+      present.set (index);
+      repo::section_content & content = value.sections.emplace_back (
+        header.kind, static_cast<std::uint8_t> (header.align));
+
+      switch (header.kind) {
+      case repo::section_kind::bss:
+        if (header.num_ifixups != 0U || header.num_xfixups != 0U) {
+          return error::bad_record;
+        }
+        if (header.size > std::numeric_limits<repo::bss_section::size_type>::max ()) {
+          return error::number_too_large;
+        }
+        content.data.resize (static_cast<std::size_t> (header.size));
+        r->size += static_cast<std::size_t> (header.size);
+        break;
+
+      case repo::section_kind::linked_definitions:
+        if (header.size == 0U || header.num_ifixups != 0U || header.num_xfixups != 0U ||
+            header.size > payload.remaining () / sizeof (binary::linked_definition)) {
+          return error::bad_record;
+        }
+        value.linked_definitions.reserve (static_cast<std::size_t> (header.size));
+        for (auto ctr = header.size; ctr > 0U; --ctr) {
+          binary::linked_definition ld;
+          payload.get (&ld);
+          value.linked_definitions.emplace_back (ld.compilation.get (), ld.index,
+                                                 typed_address<repo::definition>::null ());
+        }
+        break;
+
+      case repo::section_kind::debug_line: {
+        binary::digest header_digest;
+        if (!payload.get (&header_digest)) {
+          return error::bad_record;
+        }
+        value.debug_line_header = header_digest.get ();
+        if (std::error_code const erc =
+              this->section_contents (payload, header, &content, &value.xfixup_names)) {
+          return erc;
+        }
+      } break;
+
+      default:
+        if (std::error_code const erc =
+              this->section_contents (payload, header, &content, &value.xfixup_names)) {
+          return erc;
+        }
+        break;
+      }
+    }
+
+    // Check that the target of each internal fixup is present in the fragment.
+    for (repo::section_content const & c : value.sections) {
+      if (std::any_of (std::begin (c.ifixups), std::end (c.ifixups),
+                       [&present] (repo::internal_fixup const & ifx) {
+                         auto const target = static_cast<std::size_t> (ifx.section);
+                         return target >= present.size () || !present.test (target);
+                       })) {
+        return error::internal_fixup_target_not_found;
+      }
+    }
+    r->value = std::move (value);
+    return {};
+  }
+
+  // section contents
+  // ~~~~~~~~~~~~~~~~
+  std::error_code
+  binary_parser::section_contents (payload_reader & payload, binary::section_header const & header,
+                                   repo::section_content * const content,
+                                   std::vector<std::uint64_t> * const xfixup_names) const {
+    std::byte const * const data = payload.take (header.size);
+    if (data == nullptr ||
+        header.num_ifixups > payload.remaining () / sizeof (repo::internal_fixup) ||
+        header.num_xfixups > payload.remaining () / sizeof (binary::external_fixup)) {
+      return error::bad_record;
+    }
+    auto const * const bytes = reinterpret_cast<std::uint8_t const *> (data);
+    content->data.assign (bytes, bytes + header.size);
+
+    content->ifixups.reserve (header.num_ifixups);
+    for (auto ctr = header.num_ifixups; ctr > 0U; --ctr) {
+      repo::internal_fixup ifx{repo::section_kind::text, 0, 0, 0};
+      if (!payload.get (&ifx)) {
+        return error::bad_record;
+      }
+      content->ifixups.push_back (ifx);
+    }
+    content->xfixups.reserve (header.num_xfixups);
+    for (auto ctr = header.num_xfixups; ctr > 0U; --ctr) {
+      binary::external_fixup xfx;
+      if (!payload.get (&xfx)) {
+        return error::bad_record;
+      }
+      if (xfx.name >= num_names_) {
+        return error::no_such_name;
+      }
+      // The name's address is filled in when the fragment is stored.
+      content->xfixups.emplace_back (typed_address<indirect_string>::null (), xfx.type,
+                                     xfx.is_weak ? repo::binding::weak : repo::binding::strong,
+                                     xfx.offset, xfx.addend);
+      xfixup_names->push_back (xfx.name);
+    }
+    return {};
+  }
+
+  // compilation
+  // ~~~~~~~~~~~
+  std::error_code binary_parser::compilation (payload_reader & payload, record * const r) {
+    binary::digest digest;
+    std::uint64_t triple = 0;
+    std::uint64_t num_definitions = 0;
+    if (!payload.get (&digest) || !payload.get (&triple) || !payload.get (&num_definitions) ||
+        num_definitions > payload.remaining () / sizeof (binary::definition)) {
+      return error::bad_record;
+    }
+    if (triple >= num_names_) {
+      return error::no_such_name;
+    }
+
+    record::compilation value;
+    value.digest = digest.get ();
+    value.triple = triple;
+    value.definitions.reserve (static_cast<std::size_t> (num_definitions));
+    for (; num_definitions > 0U; --num_definitions) {
+      binary::definition d;
+      payload.get (&d);
+      if (static_cast<unsigned> (d.linkage) >= num_linkages) {
+        return error::bad_linkage;
+      }
+      if (static_cast<unsigned> (d.visibility) >= num_visibilities) {
+        return error::bad_visibility;
+      }
+      if (d.name >= num_names_) {
+        return error::no_such_name;
+      }
+      value.definitions.push_back (d);
+    }
+    r->value = std::move (value);
+    return {};
+  }
+
+} // end namespace pstore::exchange::import_ns
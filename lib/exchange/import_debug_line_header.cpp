@@ -41,10 +41,12 @@ namespace pstore::exchange::import_ns {
   // ~~~~~~~~~~~~
   std::error_code debug_line_index::string_value (peejay::u8string_view s) {
     // Decode the received string to get the raw binary.
-    std::vector<std::uint8_t> data;
-    if (!from_base64 (std::begin (s), std::end (s), std::back_inserter (data))) {
+    std::vector<std::uint8_t> data (base64_decoded_size (s.size ()));
+    std::optional<std::uint8_t *> const end = base64_decode (s.data (), s.size (), data.data ());
+    if (!end) {
       return error::bad_base64_data;
     }
+    data.resize (static_cast<std::size_t> (*end - data.data ()));
 
     // Create space for this data in the store.
     std::shared_ptr<std::uint8_t> out;
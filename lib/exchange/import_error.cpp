@@ -106,6 +106,12 @@ namespace pstore::exchange::import_ns {
       break;
 
     case error::number_too_large: result = "number too large"; break;
+
+    case error::bad_signature: result = "input is not a binary exchange file"; break;
+    case error::unsupported_version: result = "unsupported binary exchange version"; break;
+    case error::bad_record: result = "malformed binary exchange record"; break;
+    case error::unexpected_record: result = "unexpected binary exchange record"; break;
+    case error::unexpected_end_of_input: result = "unexpected end of input"; break;
     }
     return result;
   }
@@ -48,43 +48,6 @@ namespace {
 
 namespace pstore::exchange::import_ns {
 
-  //*          _    _                            _      _     *
-  //*  __ _ __| |__| |_ _ ___ ______  _ __  __ _| |_ __| |_   *
-  //* / _` / _` / _` | '_/ -_|_-<_-< | '_ \/ _` |  _/ _| ' \  *
-  //* \__,_\__,_\__,_|_| \___/__/__/ | .__/\__,_|\__\__|_||_| *
-  //*                                |_|                      *
-  //-MARK: address patch
-  // ctor
-  // ~~~~
-  address_patch::address_patch (gsl::not_null<database *> const db,
-                                extent<repo::fragment> const & ex) noexcept
-          : db_{db}
-          , fragment_extent_{ex} {}
-
-  // operator()
-  // ~~~~~~~~~~
-  std::error_code address_patch::operator() (transaction_base * const transaction) {
-    auto const compilations = index::get_index<trailer::indices::compilation> (*db_);
-
-    auto const fragment = repo::fragment::load (*transaction, fragment_extent_);
-    for (repo::linked_definitions::value_type & l :
-         fragment->template at<repo::section_kind::linked_definitions> ()) {
-      auto const pos = compilations->find (*db_, l.compilation);
-      if (pos == compilations->end (*db_)) {
-        return error::no_such_compilation;
-      }
-      auto const compilation = repo::compilation::load (transaction->db (), pos->second);
-      static_assert (std::is_unsigned<decltype (l.index)>::value,
-                     "index is not unsigned so we'll have to check for negative");
-      if (l.index >= compilation->size ()) {
-        return error::index_out_of_range;
-      }
-
-      l.pointer = repo::compilation::index_address (pos->second.addr, l.index);
-    }
-    return {};
-  }
-
   //*   __                             _                _   _              *
   //*  / _|_ _ __ _ __ _ _ __  ___ _ _| |_   ___ ___ __| |_(_)___ _ _  ___ *
   //* |  _| '_/ _` / _` | '  \/ -_) ' \  _| (_-</ -_) _|  _| / _ \ ' \(_-< *
@@ -0,0 +1,93 @@
+//===- lib/exchange/import_pipeline.cpp -----------------------------------===//
+//*  _                            _    *
+//* (_)_ __ ___  _ __   ___  _ __| |_  *
+//* | | '_ ` _ \| '_ \ / _ \| '__| __| *
+//* | | | | | | | |_) | (_) | |  | |_  *
+//* |_|_| |_| |_| .__/ \___/|_|   \__| *
+//*             |_|                    *
+//*        _            _ _             *
+//*  _ __ (_)_ __   ___| (_)_ __   ___  *
+//* | '_ \| | '_ \ / _ \ | | '_ \ / _ \ *
+//* | |_) | | |_) |  __/ | | | | |  __/ *
+//* | .__/|_| .__/ \___|_|_|_| |_|\___| *
+//* |_|     |_|                         *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file import_pipeline.cpp
+/// \brief Implements the components used to connect the stages of a multi-threaded import.
+
+#include "pstore/exchange/import_pipeline.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+#include "pstore/support/error.hpp"
+
+namespace pstore::exchange::import_ns {
+
+  //*                     _          _                    _  *
+  //*  _ __ ___  __ _  __| |    __ _| |__   ___  __ _  __| | *
+  //* | '__/ _ \/ _` |/ _` |   / _` | '_ \ / _ \/ _` |/ _` | *
+  //* | | |  __/ (_| | (_| |  | (_| | | | |  __/ (_| | (_| | *
+  //* |_|  \___|\__,_|\__,_|   \__,_|_| |_|\___|\__,_|\__,_| *
+  //*                                                        *
+  // (ctor)
+  // ~~~~~~
+  read_ahead::read_ahead (gsl::not_null<std::FILE *> const file, std::size_t const chunk_size,
+                          std::size_t const max_chunks)
+          : queue_{chunk_size * std::max (max_chunks, std::size_t{1})}
+          , thread_{&read_ahead::reader, this, file, chunk_size} {}
+
+  // (dtor)
+  // ~~~~~~
+  read_ahead::~read_ahead () noexcept {
+    // Wake the reader if it is waiting for room in the queue.
+    queue_.cancel ();
+    thread_.join ();
+  }
+
+  // next
+  // ~~~~
+  gsl::span<std::byte const> read_ahead::next () {
+    if (std::optional<std::vector<std::byte>> chunk = queue_.pop ()) {
+      current_ = std::move (*chunk);
+      return {current_.data (), static_cast<std::ptrdiff_t> (current_.size ())};
+    }
+    // The reader has closed the queue: we've reached the end of the input or an error.
+    if (error_) {
+      raise_error_code (error_);
+    }
+    current_.clear ();
+    return {};
+  }
+
+  // reader
+  // ~~~~~~
+  void read_ahead::reader (gsl::not_null<std::FILE *> const file, std::size_t const chunk_size) {
+    for (;;) {
+      std::vector<std::byte> chunk (chunk_size);
+      errno = 0;
+      std::size_t const nread = std::fread (chunk.data (), 1U, chunk.size (), file);
+      if (nread < chunk.size () && std::ferror (file)) {
+        error_ = errno != 0 ? std::error_code{errno, std::generic_category ()}
+                            : std::make_error_code (std::errc::io_error);
+        break;
+      }
+      if (nread == 0U) {
+        break;
+      }
+      chunk.resize (nread);
+      if (!queue_.push (std::move (chunk), nread)) {
+        return; // The consumer has cancelled.
+      }
+    }
+    queue_.close ();
+  }
+
+} // end namespace pstore::exchange::import_ns
@@ -63,45 +63,63 @@ namespace pstore::http {
     return str.str ();
   }
 
-  // Here we bridge from the std::error_code world to HTTP status codes.
-  void report_error (std::error_code const error, request_info const & request,
-                     socket_descriptor & socket) {
-    static constexpr auto sender = net::network_sender;
-
-    auto const report = [&] (http_status_code const code, gsl::czstring const message) {
-      send_error_page (sender, std::ref (socket), request.uri ().c_str (), code, message,
-                       error.message ().c_str ());
-    };
-
-    log (logger::priority::error, "http error: ", error.message ());
-    auto const & cat = error.category ();
-    if (cat == get_error_category ()) {
-      switch (static_cast<error_code> (error.value ())) {
-      case error_code::bad_request: return report (http_status_code::bad_request, "Bad request");
-
-      case error_code::bad_websocket_version:
-        send_bad_websocket_version (sender, std::ref (socket));
-        return;
-
-      case error_code::not_implemented:
-        return report (http_status_code::not_implemented, "Not implemented");
-
-      case error_code::string_too_long:
-      case error_code::refill_out_of_range: break;
+  namespace {
+
+    // Here we bridge from the std::error_code world to HTTP status codes.
+    template <typename Sender, typename IO>
+    void report_error_impl (Sender const sender, IO const io, std::error_code const error,
+                            request_info const & request) {
+      auto const report = [&] (http_status_code const code, gsl::czstring const message) {
+        send_error_page (sender, io, request.uri ().c_str (), code, message,
+                         error.message ().c_str ());
+      };
+
+      log (logger::priority::error, "http error: ", error.message ());
+      auto const & cat = error.category ();
+      if (cat == get_error_category ()) {
+        switch (static_cast<error_code> (error.value ())) {
+        case error_code::bad_request: return report (http_status_code::bad_request, "Bad request");
+
+        case error_code::bad_websocket_version:
+          send_bad_websocket_version (sender, IO{io});
+          return;
+
+        case error_code::not_implemented:
+          return report (http_status_code::not_implemented, "Not implemented");
+
+        case error_code::string_too_long:
+        case error_code::refill_out_of_range: break;
+        }
+      } else if (cat == romfs::category) {
+        switch (static_cast<romfs::error_code> (error.value ())) {
+        case romfs::error_code::enoent:
+        case romfs::error_code::enotdir: return report (http_status_code::not_found, "Not found");
+
+        case romfs::error_code::einval: break;
+        }
       }
-    } else if (cat == romfs::category) {
-      switch (static_cast<romfs::error_code> (error.value ())) {
-      case romfs::error_code::enoent:
-      case romfs::error_code::enotdir: return report (http_status_code::not_found, "Not found");
 
-      case romfs::error_code::einval: break;
-      }
+      // Some error that we don't know how to report properly.
+      std::ostringstream message;
+      message << "Server internal error: " << error.message ();
+      report (http_status_code::internal_server_error, message.str ().c_str ());
     }
 
-    // Some error that we don't know how to report properly.
-    std::ostringstream message;
-    message << "Server internal error: " << error.message ();
-    report (http_status_code::internal_server_error, message.str ().c_str ());
+  } // end anonymous namespace
+
+  void report_error (std::error_code const error, request_info const & request,
+                     socket_descriptor & socket) {
+    report_error_impl (net::network_sender, std::ref (socket), error, request);
+  }
+
+  void report_error (std::error_code const error, request_info const & request,
+                     std::vector<std::uint8_t> & output) {
+    auto const append = [] (std::vector<std::uint8_t> & out,
+                            gsl::span<std::uint8_t const> const & s) {
+      out.insert (std::end (out), std::begin (s), std::end (s));
+      return error_or<std::vector<std::uint8_t> &>{out};
+    };
+    report_error_impl (append, std::ref (output), error, request);
   }
 
 } // end namespace pstore::http
@@ -0,0 +1,868 @@
+//===- lib/http/event_server.cpp ------------------------------------------===//
+//*                       _                                    *
+//*   _____   _____ _ __ | |_    ___  ___ _ ____   _____ _ __  *
+//*  / _ \ \ / / _ \ '_ \| __|  / __|/ _ \ '__\ \ / / _ \ '__| *
+//* |  __/\ V /  __/ | | | |_   \__ \  __/ |   \ V /  __/ |    *
+//*  \___| \_/ \___|_| |_|\__|  |___/\___|_|    \_/ \___|_|    *
+//*                                                            *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file event_server.cpp
+/// \brief Implements the event-driven HTTP server.
+
+#include "pstore/http/event_server.hpp"
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+
+// Standard library includes
+#  include <algorithm>
+#  include <array>
+#  include <atomic>
+#  include <chrono>
+#  include <condition_variable>
+#  include <deque>
+#  include <functional>
+#  include <memory>
+#  include <mutex>
+#  include <thread>
+#  include <unordered_map>
+#  include <unordered_set>
+#  include <vector>
+
+// OS-specific includes
+#  include <fcntl.h>
+#  include <netdb.h>
+#  include <sys/epoll.h>
+#  include <sys/socket.h>
+
+// Local includes
+#  include "pstore/http/error_reporting.hpp"
+#  include "pstore/http/headers.hpp"
+#  include "pstore/http/net_txrx.hpp"
+#  include "pstore/http/request.hpp"
+#  include "pstore/http/serve_dynamic_content.hpp"
+#  include "pstore/http/serve_static_content.hpp"
+#  include "pstore/http/server_status.hpp"
+#  include "pstore/os/thread.hpp"
+
+namespace {
+
+  using namespace pstore::http;
+  namespace gsl = pstore::gsl;
+  using pstore::error_or;
+  using pstore::error_or_n;
+  using priority = pstore::logger::priority;
+  using socket_descriptor = pstore::socket_descriptor;
+  using epoll_descriptor = pstore::details::descriptor<pstore::details::posix_descriptor_traits>;
+
+  /// The largest request line and headers that a client may send.
+  constexpr std::size_t max_request_size = std::size_t{16} * 1024U;
+  /// The largest WebSocket frame that a client may send.
+  constexpr std::uint64_t max_frame_size = std::uint64_t{16} * 1024U * 1024U;
+  /// The number of events collected by each call to epoll_wait().
+  constexpr int max_events = 64;
+  /// The number of bytes of responses which may be waiting to be sent to a client before the
+  /// server stops reading that client's requests.
+  constexpr std::size_t max_pending_output = std::size_t{1024} * 1024U;
+
+  // worker count
+  // ~~~~~~~~~~~~
+  /// Returns the number of threads in the worker pool. A handful of threads is enough to keep
+  /// a slow client from delaying the others without the cost of a thread per connection.
+  unsigned worker_count () {
+    constexpr auto min_workers = 2U;
+    constexpr auto max_workers = 4U;
+    return std::max (std::min (std::thread::hardware_concurrency (), max_workers), min_workers);
+  }
+
+  // get client name
+  // ~~~~~~~~~~~~~~~
+  /// Returns the numeric host address of a client. A name lookup could block the event loop
+  /// so is not attempted.
+  std::string get_client_name (sockaddr_in const & client_addr) {
+    std::array<char, NI_MAXHOST> host_name{{'\0'}};
+    if (::getnameinfo (reinterpret_cast<sockaddr const *> (&client_addr), sizeof (client_addr),
+                       host_name.data (), host_name.size (), nullptr, socklen_t{0},
+                       NI_NUMERICHOST) != 0) {
+      return "(unknown)";
+    }
+    host_name.back () = '\0'; // guarantee nul termination.
+    return host_name.data ();
+  }
+
+  /// The responses which are waiting to be sent to a client.
+  using output_queue = std::vector<std::uint8_t>;
+
+  // queue sender
+  // ~~~~~~~~~~~~
+  /// A sender which appends data to a session's output queue. Responses are therefore never
+  /// written directly to a socket: a worker could otherwise be blocked by a client which is
+  /// slow to read them. The queue is sent by event_loop::flush() as the socket allows.
+  error_or<output_queue &> queue_sender (output_queue & out,
+                                         gsl::span<std::uint8_t const> const & s) {
+    out.insert (std::end (out), std::begin (s), std::end (s));
+    return error_or<output_queue &>{out};
+  }
+
+  // make memory reader
+  // ~~~~~~~~~~~~~~~~~~
+  /// Returns a buffered_reader<> which yields the bytes of \p input. The input is a complete
+  /// request or frame which has already been received so the reader never blocks. The reader
+  /// shares the session's output queue as its "IO" value with queue_sender(). The queue is
+  /// held by reference_wrapper<> because the reader assigns each updated IO value to the
+  /// previous one: with a plain reference that would move the queue onto itself and lose any
+  /// responses that it holds.
+  auto make_memory_reader (gsl::span<std::uint8_t const> & input) {
+    using io_type = std::reference_wrapper<output_queue>;
+    auto refill = [&input] (io_type io, gsl::span<std::uint8_t> const & buffer) {
+      auto const size = std::min (input.size (), buffer.size ());
+      std::copy_n (input.begin (), size, buffer.begin ());
+      input = input.subspan (size);
+      return pstore::error_or_n<io_type, gsl::span<std::uint8_t>::iterator>{
+        std::in_place, io, buffer.begin () + size};
+    };
+    return make_buffered_reader<io_type> (refill);
+  }
+
+  //*                     _                                  _  *
+  //* __      _____  _ __| | _____ _ __    _ __   ___   ___ | | *
+  //* \ \ /\ / / _ \| '__| |/ / _ \ '__|  | '_ \ / _ \ / _ \| | *
+  //*  \ V  V / (_) | |  |   <  __/ |     | |_) | (_) | (_) | | *
+  //*   \_/\_/ \___/|_|  |_|\_\___|_|     | .__/ \___/ \___/|_| *
+  //*                                     |_|                   *
+  /// A fixed number of threads which run tasks posted to a shared queue.
+  class worker_pool {
+  public:
+    explicit worker_pool (unsigned num_threads);
+    worker_pool (worker_pool const &) = delete;
+    worker_pool (worker_pool &&) noexcept = delete;
+
+    ~worker_pool () noexcept { this->stop (); }
+
+    worker_pool & operator= (worker_pool const &) = delete;
+    worker_pool & operator= (worker_pool &&) noexcept = delete;
+
+    /// Adds a task to the queue. It will be run by the first available worker.
+    void post (std::function<void ()> && task);
+    /// Waits for the workers to finish their current tasks then discards any tasks which
+    /// remain in the queue.
+    void stop () noexcept;
+
+  private:
+    void worker ();
+
+    std::mutex mut_;
+    std::condition_variable cv_;
+    std::deque<std::function<void ()>> tasks_;
+    bool done_ = false;
+    std::vector<std::thread> threads_;
+  };
+
+  // (ctor)
+  // ~~~~~~
+  worker_pool::worker_pool (unsigned const num_threads) {
+    threads_.reserve (num_threads);
+    for (auto ctr = 0U; ctr < num_threads; ++ctr) {
+      threads_.emplace_back (&worker_pool::worker, this);
+    }
+  }
+
+  // post
+  // ~~~~
+  void worker_pool::post (std::function<void ()> && task) {
+    std::lock_guard<decltype (mut_)> const lock{mut_};
+    tasks_.push_back (std::move (task));
+    cv_.notify_one ();
+  }
+
+  // stop
+  // ~~~~
+  void worker_pool::stop () noexcept {
+    {
+      std::lock_guard<decltype (mut_)> const lock{mut_};
+      done_ = true;
+      cv_.notify_all ();
+    }
+    for (std::thread & t : threads_) {
+      t.join ();
+    }
+    threads_.clear ();
+    tasks_.clear ();
+  }
+
+  // worker
+  // ~~~~~~
+  void worker_pool::worker () {
+    constexpr auto ident = "http";
+    pstore::threads::set_name (ident);
+    pstore::create_log_stream (ident);
+
+    for (;;) {
+      std::function<void ()> task;
+      {
+        std::unique_lock<decltype (mut_)> lock{mut_};
+        cv_.wait (lock, [this] () { return done_ || !tasks_.empty (); });
+        if (done_) {
+          return;
+        }
+        task = std::move (tasks_.front ());
+        tasks_.pop_front ();
+      }
+      PSTORE_TRY { task (); }
+      // clang-format off
+      PSTORE_CATCH (std::exception const & ex, { //clang-format on
+        log (priority::error, "Error: ", ex.what ());
+      })
+      // clang-format off
+      PSTORE_CATCH (..., { // clang-format on
+        log (priority::error, "Unknown exception");
+      })
+    }
+  }
+
+  //*                    _              *
+  //*  ___  ___  ___ ___(_) ___  _ __   *
+  //* / __|/ _ \/ __/ __| |/ _ \| '_ \  *
+  //* \__ \  __/\__ \__ \ | (_) | | | | *
+  //* |___/\___||___/___/_|\___/|_| |_| *
+  //*                                   *
+  /// The state of a single client connection. A session begins by exchanging HTTP and may be
+  /// upgraded to the WebSocket protocol.
+  struct session {
+    explicit session (socket_descriptor && s) noexcept
+            : socket{std::move (s)} {}
+
+    /// Serializes the workers which read from and write to this session.
+    std::mutex mut;
+    socket_descriptor socket;
+    /// Bytes received from the client which do not yet form a complete request or frame.
+    std::vector<std::uint8_t> input;
+    /// Responses which have been generated but not yet accepted by the socket.
+    output_queue output;
+    /// Set once no more input will be processed. The session is closed as soon as its output
+    /// queue is empty.
+    bool draining = false;
+    /// True once the session has been upgraded to the WebSocket protocol.
+    bool is_websocket = false;
+    /// The number of bytes of the body of the previous HTTP request which are yet to be
+    /// skipped.
+    std::uint64_t discard = 0;
+    /// The WebSocket message being assembled from a sequence of frames.
+    ws_command command;
+    /// The channel subscription of a WebSocket session.
+    std::unique_ptr<pstore::brokerface::subscriber<pstore::descriptor_condition_variable>>
+      subscription;
+    /// The descriptor of the condition variable associated with the subscribed channel or -1.
+    int channel_fd = -1;
+    /// Set once the session has been closed. No further work is done for it.
+    bool closed = false;
+    /// The time at which data was last received from or sent to the client.
+    std::chrono::steady_clock::time_point last_active = std::chrono::steady_clock::now ();
+  };
+
+  //*                       _      _                    *
+  //*   _____   _____ _ __ | |_   | | ___   ___  _ __   *
+  //*  / _ \ \ / / _ \ '_ \| __|  | |/ _ \ / _ \| '_ \  *
+  //* |  __/\ V /  __/ | | | |_   | | (_) | (_) | |_) | *
+  //*  \___| \_/ \___|_| |_|\__|  |_|\___/ \___/| .__/  *
+  //*                                           |_|     *
+  class event_loop {
+  public:
+    event_loop (epoll_descriptor && ep, pstore::romfs::romfs & file_system,
+                channel_container const & channels, event_server_options const & options);
+
+    /// Starts serving a client which has connected.
+    void add_session (socket_descriptor && client);
+    std::error_code run (socket_descriptor const & listener,
+                         gsl::not_null<server_status *> status);
+
+  private:
+    /// Adds \p fd to the set of descriptors watched by the event loop.
+    std::error_code watch (int fd, std::uint32_t events);
+
+    /// Accepts all of the pending connections on \p listener.
+    void accept_connections (socket_descriptor const & listener);
+    /// Called by a worker when there is activity on a session's socket. \p events is the set
+    /// of epoll events which were reported.
+    void service (std::shared_ptr<session> const & s, std::uint32_t events);
+    /// Reads and processes the input which is available on the session's socket.
+    void read_input (session & s);
+    /// Called by a worker when the channel to which a session has subscribed has messages.
+    void push_messages (std::shared_ptr<session> const & s);
+    /// Adds the messages waiting for a subscribed session to its output queue.
+    void queue_messages (session & s);
+    /// Called by a worker to close the persistent HTTP sessions which have been idle for too
+    /// long.
+    void expire ();
+
+    /// Serves the complete requests and frames in the session's input buffer. Returns false
+    /// if the session should be closed.
+    bool process_input (session & s);
+    bool serve_request (session & s, gsl::span<std::uint8_t const> unit);
+    bool serve_frame (session & s, gsl::span<std::uint8_t const> unit);
+    void subscribe (session & s, std::string const & uri);
+
+    /// Sends as much of the session's output as the socket will accept without blocking and
+    /// then either closes the session or calls rearm().
+    void flush (session & s);
+    /// Asks the event loop for notification of the next event of interest for session \p s:
+    /// input if the session is accepting requests, and the socket becoming writable if there
+    /// is output waiting to be sent.
+    void rearm (session & s);
+    /// Stops all work for session \p s. The caller must hold the session's mutex.
+    void close_session (session & s);
+    void shutdown ();
+
+    epoll_descriptor epoll_;
+    pstore::romfs::romfs & file_system_;
+    channel_container const & channels_;
+    event_server_options const options_;
+    /// True whilst a call to expire() is waiting to be run by a worker.
+    std::atomic<bool> expire_posted_{false};
+
+    /// Maps from the descriptor of a channel's condition variable to the condition variable.
+    std::unordered_map<int, pstore::descriptor_condition_variable *> channel_cvs_;
+
+    /// Guards sessions_ and subscribers_. A worker may acquire this mutex whilst holding a
+    /// session's mutex but not the reverse.
+    std::mutex mut_;
+    /// Maps from a client socket descriptor to its session.
+    std::unordered_map<int, std::shared_ptr<session>> sessions_;
+    /// Maps from the descriptor of a channel's condition variable to the client socket
+    /// descriptors of the sessions subscribed to that channel.
+    std::unordered_map<int, std::unordered_set<int>> subscribers_;
+
+    /// Declared last so that the workers are stopped before the other members are destroyed.
+    worker_pool workers_;
+  };
+
+  // (ctor)
+  // ~~~~~~
+  event_loop::event_loop (epoll_descriptor && ep, pstore::romfs::romfs & file_system,
+                          channel_container const & channels,
+                          event_server_options const & options)
+          : epoll_{std::move (ep)}
+          , file_system_{file_system}
+          , channels_{channels}
+          , options_{options}
+          , workers_{worker_count ()} {}
+
+  // watch
+  // ~~~~~
+  std::error_code event_loop::watch (int const fd, std::uint32_t const events) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (::epoll_ctl (epoll_.native_handle (), EPOLL_CTL_ADD, fd, &ev) != 0) {
+      return get_last_error ();
+    }
+    return {};
+  }
+
+  // run
+  // ~~~
+  std::error_code event_loop::run (socket_descriptor const & listener,
+                                   gsl::not_null<server_status *> const status) {
+    if (listener.valid ()) {
+      if (std::error_code const erc = this->watch (listener.native_handle (), EPOLLIN)) {
+        return erc;
+      }
+    }
+    // The channel condition variables are level-triggered: they remain readable until reset.
+    for (auto const & kvp : channels_) {
+      pstore::descriptor_condition_variable * const cv = std::get<1> (kvp.second);
+      int const fd = cv->wait_descriptor ().native_handle ();
+      if (std::error_code const erc = this->watch (fd, EPOLLIN)) {
+        return erc;
+      }
+      channel_cvs_[fd] = cv;
+    }
+
+    std::error_code result;
+    std::array<epoll_event, max_events> events;
+    auto last_idle_check = std::chrono::steady_clock::now ();
+    for (auto expected_state = server_status::http_state::initializing;
+         status->listening (expected_state);
+         expected_state = server_status::http_state::listening) {
+
+      if (auto const now = std::chrono::steady_clock::now ();
+          now - last_idle_check >= options_.idle_check_interval) {
+        last_idle_check = now;
+        // A single task checks all of the sessions. Don't post another if the previous check
+        // has not yet been run.
+        if (!expire_posted_.exchange (true)) {
+          workers_.post ([this] () { this->expire (); });
+        }
+      }
+
+      int const count =
+        ::epoll_wait (epoll_.native_handle (), events.data (), max_events,
+                      static_cast<int> (options_.idle_check_interval.count ()));
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        result = get_last_error ();
+        log (priority::error, "epoll_wait: ", result.message ());
+        break;
+      }
+
+      for (auto ctr = 0; ctr < count; ++ctr) {
+        epoll_event const & event = events[static_cast<std::size_t> (ctr)];
+        int const fd = event.data.fd;
+        if (fd == listener.native_handle ()) {
+          this->accept_connections (listener);
+          continue;
+        }
+
+        std::lock_guard<decltype (mut_)> const lock{mut_};
+        if (auto const cv_pos = channel_cvs_.find (fd); cv_pos != channel_cvs_.end ()) {
+          // There are messages to push to the channel's subscribers.
+          cv_pos->second->reset ();
+          for (int const subscriber : subscribers_[fd]) {
+            if (auto const pos = sessions_.find (subscriber); pos != sessions_.end ()) {
+              workers_.post ([this, s = pos->second] () { this->push_messages (s); });
+            }
+          }
+        } else if (auto const pos = sessions_.find (fd); pos != sessions_.end ()) {
+          workers_.post (
+            [this, s = pos->second, ev = event.events] () { this->service (s, ev); });
+        }
+      }
+    }
+
+    this->shutdown ();
+    return result;
+  }
+
+  // accept connections
+  // ~~~~~~~~~~~~~~~~~~
+  void event_loop::accept_connections (socket_descriptor const & listener) {
+    for (;;) {
+      sockaddr_in client_addr{}; // client address.
+      auto clientlen = static_cast<socklen_t> (sizeof (client_addr));
+      socket_descriptor childfd{::accept4 (listener.native_handle (),
+                                           reinterpret_cast<struct sockaddr *> (&client_addr),
+                                           &clientlen, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+      if (!childfd.valid ()) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          log (priority::error, "accept: ", get_last_error ().message ());
+        }
+        return;
+      }
+      log (priority::info, "Connection from ", get_client_name (client_addr));
+      this->add_session (std::move (childfd));
+    }
+  }
+
+  // add session
+  // ~~~~~~~~~~~
+  void event_loop::add_session (socket_descriptor && client) {
+    int const fd = client.native_handle ();
+    {
+      std::lock_guard<decltype (mut_)> const lock{mut_};
+      sessions_[fd] = std::make_shared<session> (std::move (client));
+    }
+    if (std::error_code const erc = this->watch (fd, EPOLLIN | EPOLLRDHUP | EPOLLONESHOT)) {
+      log (priority::error, "epoll_ctl: ", erc.message ());
+      std::lock_guard<decltype (mut_)> const lock{mut_};
+      sessions_.erase (fd);
+    }
+  }
+
+  // service
+  // ~~~~~~~
+  void event_loop::service (std::shared_ptr<session> const & s, std::uint32_t const events) {
+    std::lock_guard<decltype (s->mut)> const lock{s->mut};
+    if (s->closed) {
+      return;
+    }
+    if (!s->draining && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0U) {
+      this->read_input (*s);
+    }
+    // Writing to a WebSocket client may have been held up by a full output queue.
+    if (!s->draining && s->subscription && s->output.size () < max_pending_output) {
+      this->queue_messages (*s);
+    }
+    this->flush (*s);
+  }
+
+  // read input
+  // ~~~~~~~~~~
+  void event_loop::read_input (session & s) {
+    std::array<std::uint8_t, 4096> buffer;
+    // Stop reading if the client isn't collecting its responses.
+    while (s.output.size () < max_pending_output) {
+      ssize_t const nread = ::recv (s.socket.native_handle (), buffer.data (), buffer.size (), 0);
+      if (nread > 0) {
+        s.input.insert (std::end (s.input), buffer.data (), buffer.data () + nread);
+        s.last_active = std::chrono::steady_clock::now ();
+        if (!this->process_input (s)) {
+          s.draining = true;
+          return;
+        }
+        continue;
+      }
+      if (nread < 0 && errno == EINTR) {
+        continue;
+      }
+      if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+      }
+      // The client has closed the connection or there was an error. Any responses which
+      // are still queued are sent before the session is closed.
+      if (nread < 0) {
+        log (priority::error, "recv: ", get_last_error ().message ());
+      }
+      s.draining = true;
+      return;
+    }
+  }
+
+  // process input
+  // ~~~~~~~~~~~~~
+  bool event_loop::process_input (session & s) {
+    for (;;) {
+      auto const input = gsl::span<std::uint8_t const> (s.input);
+      std::size_t unit_size = 0;
+      if (s.is_websocket) {
+        pstore::maybe<std::uint64_t> const size = frame_size (input);
+        if (size && *size > max_frame_size) {
+          log (priority::error, "WebSocket frame too large: ", *size);
+          send_close_frame (queue_sender, std::ref (s.output), close_status_code::message_too_big);
+          return false;
+        }
+        if (!size || *size > static_cast<std::uint64_t> (input.size ())) {
+          return true; // Wait for the rest of the frame.
+        }
+        unit_size = static_cast<std::size_t> (*size);
+        if (!this->serve_frame (s, input.first (static_cast<std::ptrdiff_t> (unit_size)))) {
+          return false;
+        }
+      } else if (s.discard > 0U) {
+        // Skip the body of the previous request. We don't use it.
+        unit_size = static_cast<std::size_t> (
+          std::min (s.discard, static_cast<std::uint64_t> (input.size ())));
+        if (unit_size == 0U) {
+          return true; // Wait for the rest of the body.
+        }
+        s.discard -= unit_size;
+      } else {
+        pstore::maybe<std::size_t> const size = request_size (input);
+        if (!size) {
+          if (s.input.size () > max_request_size) {
+            log (priority::error, "HTTP request too large");
+            return false;
+          }
+          return true; // Wait for the rest of the request.
+        }
+        unit_size = *size;
+        if (!this->serve_request (s, input.first (static_cast<std::ptrdiff_t> (unit_size)))) {
+          return false;
+        }
+      }
+      s.input.erase (std::begin (s.input),
+                     std::begin (s.input) + static_cast<std::ptrdiff_t> (unit_size));
+    }
+  }
+
+  // serve request
+  // ~~~~~~~~~~~~~
+  /// Responds to a complete HTTP request. Returns true if the connection is persistent or
+  /// was upgraded to the WebSocket protocol and should remain open.
+  bool event_loop::serve_request (session & s, gsl::span<std::uint8_t const> unit) {
+    auto reader = make_memory_reader (unit);
+
+    auto const eri = read_request (reader, std::ref (s.output));
+    if (!eri) {
+      log (priority::error, "Failed reading HTTP request: ", eri.get_error ().message ());
+      return false;
+    }
+    request_info const & request = pstore::get<1> (eri);
+    log (priority::info,
+         "Request: ", request.method () + ' ' + request.version () + ' ' + request.uri ());
+
+    // We only currently support the GET method.
+    if (request.method () != "GET") {
+      report_error (make_error_code (error_code::not_implemented), request, s.output);
+      return false;
+    }
+
+    // Respond appropriately based on the request and headers.
+    bool upgraded = false;
+    bool keep_alive = false;
+    auto const serve_reply = [&] (output_queue & io2,
+                                  header_info const & header_contents) -> std::error_code {
+      if (header_contents.bad_content_length) {
+        // We can't tell where this request's body ends and the next request begins.
+        return make_error_code (error_code::bad_request);
+      }
+      if (header_contents.connection_upgrade && header_contents.upgrade_to_websocket) {
+        auto const eo = accept_upgrade (queue_sender, std::ref (io2), header_contents);
+        if (eo) {
+          log (priority::info, "Started WebSockets session");
+          upgraded = true;
+          this->subscribe (s, request.uri ());
+        }
+        return eo.get_error ();
+      }
+
+      keep_alive = header_contents.keep_alive (request.version ());
+      s.discard = header_contents.content_length.value_or (0U);
+      if (!details::starts_with (request.uri (), dynamic_path)) {
+        return serve_static_content (queue_sender, std::ref (io2), request.uri (), file_system_,
+                                     keep_alive)
+          .get_error ();
+      }
+
+      return serve_dynamic_content (queue_sender, std::ref (io2), request.uri (), keep_alive)
+        .get_error ();
+    };
+
+    // Scan the HTTP headers.
+    std::error_code const err = read_headers (
+      reader, std::ref (s.output),
+      [] (header_info io, std::string const & key, std::string const & value) {
+        return io.handler (key, value);
+      },
+      header_info ()) >>= serve_reply;
+
+    if (err) {
+      // Report the error to the user as an HTTP error. Error responses always close the
+      // connection.
+      report_error (err, request, s.output);
+      return false;
+    }
+    s.is_websocket = upgraded;
+    return upgraded || keep_alive;
+  }
+
+  // serve frame
+  // ~~~~~~~~~~~
+  /// Responds to a complete WebSocket frame. Returns false if the session should be closed.
+  bool event_loop::serve_frame (session & s, gsl::span<std::uint8_t const> unit) {
+    auto reader = make_memory_reader (unit);
+    bool const done =
+      std::get<1> (socket_read (reader, queue_sender, std::ref (s.output), &s.command));
+    if (done) {
+      log (priority::info, "Ended WebSockets session");
+    }
+    return !done;
+  }
+
+  // subscribe
+  // ~~~~~~~~~
+  void event_loop::subscribe (session & s, std::string const & uri) {
+    channel_container_entry const * const entry = find_channel (channels_, uri);
+    if (entry == nullptr) {
+      return;
+    }
+    s.subscription = std::get<0> (*entry)->new_subscriber ();
+    s.channel_fd = std::get<1> (*entry)->wait_descriptor ().native_handle ();
+
+    std::lock_guard<decltype (mut_)> const lock{mut_};
+    subscribers_[s.channel_fd].insert (s.socket.native_handle ());
+  }
+
+  // push messages
+  // ~~~~~~~~~~~~~
+  void event_loop::push_messages (std::shared_ptr<session> const & s) {
+    std::lock_guard<decltype (s->mut)> const lock{s->mut};
+    if (s->closed || s->draining || !s->subscription) {
+      return;
+    }
+    this->queue_messages (*s);
+    this->flush (*s);
+  }
+
+  // queue messages
+  // ~~~~~~~~~~~~~~
+  void event_loop::queue_messages (session & s) {
+    // Messages which don't fit are left with the subscription until the client has read
+    // those that are already queued.
+    while (s.output.size () < max_pending_output) {
+      pstore::brokerface::shared_message const message = s.subscription->pop ();
+      if (!message) {
+        break;
+      }
+      log (priority::info, "sending:", *message);
+      send_message (queue_sender, std::ref (s.output), opcode::text,
+                    as_bytes (gsl::make_span (*message)));
+    }
+  }
+
+  // expire
+  // ~~~~~~
+  void event_loop::expire () {
+    expire_posted_ = false;
+    std::vector<std::shared_ptr<session>> sessions;
+    {
+      std::lock_guard<decltype (mut_)> const lock{mut_};
+      sessions.reserve (sessions_.size ());
+      for (auto const & kvp : sessions_) {
+        sessions.push_back (kvp.second);
+      }
+    }
+    auto const now = std::chrono::steady_clock::now ();
+    for (std::shared_ptr<session> const & s : sessions) {
+      // A session whose mutex is held is being served so is not idle.
+      std::unique_lock<decltype (s->mut)> const lock{s->mut, std::try_to_lock};
+      if (lock.owns_lock () && !s->closed && !s->is_websocket &&
+          now - s->last_active >= options_.keep_alive_timeout) {
+        log (priority::info, "Closing idle connection");
+        this->close_session (*s);
+      }
+    }
+  }
+
+  // flush
+  // ~~~~~
+  void event_loop::flush (session & s) {
+    auto pos = std::size_t{0};
+    auto const size = s.output.size ();
+    while (pos < size) {
+      ssize_t const nsent =
+        ::send (s.socket.native_handle (), s.output.data () + pos, size - pos, MSG_NOSIGNAL);
+      if (nsent >= 0) {
+        pos += static_cast<std::size_t> (nsent);
+        continue;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      log (priority::error, "send: ", get_last_error ().message ());
+      this->close_session (s);
+      return;
+    }
+    if (pos > 0U) {
+      s.output.erase (std::begin (s.output),
+                      std::begin (s.output) + static_cast<std::ptrdiff_t> (pos));
+      s.last_active = std::chrono::steady_clock::now ();
+    }
+    if (s.draining && s.output.empty ()) {
+      this->close_session (s);
+      return;
+    }
+    this->rearm (s);
+  }
+
+  // rearm
+  // ~~~~~
+  void event_loop::rearm (session & s) {
+    epoll_event ev{};
+    ev.events = EPOLLONESHOT;
+    if (!s.draining && s.output.size () < max_pending_output) {
+      ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (!s.output.empty ()) {
+      ev.events |= EPOLLOUT;
+    }
+    ev.data.fd = s.socket.native_handle ();
+    if (::epoll_ctl (epoll_.native_handle (), EPOLL_CTL_MOD, ev.data.fd, &ev) != 0) {
+      log (priority::error, "epoll_ctl: ", get_last_error ().message ());
+      this->close_session (s);
+    }
+  }
+
+  // close session
+  // ~~~~~~~~~~~~~
+  void event_loop::close_session (session & s) {
+    s.closed = true;
+    s.subscription.reset ();
+    int const fd = s.socket.native_handle ();
+    ::epoll_ctl (epoll_.native_handle (), EPOLL_CTL_DEL, fd, nullptr);
+
+    // The socket is closed when the last reference to the session is dropped. Until then, its
+    // descriptor cannot be reused by a new connection.
+    std::lock_guard<decltype (mut_)> const lock{mut_};
+    if (s.channel_fd != -1) {
+      subscribers_[s.channel_fd].erase (fd);
+    }
+    sessions_.erase (fd);
+  }
+
+  // shutdown
+  // ~~~~~~~~
+  void event_loop::shutdown () {
+    workers_.stop ();
+
+    std::unordered_map<int, std::shared_ptr<session>> sessions;
+    {
+      std::lock_guard<decltype (mut_)> const lock{mut_};
+      sessions.swap (sessions_);
+      subscribers_.clear ();
+    }
+    for (auto const & kvp : sessions) {
+      session & s = *kvp.second;
+      if (s.is_websocket && s.output.empty ()) {
+        // Make a single attempt to send the close frame: we won't wait for a slow client.
+        send_close_frame (queue_sender, std::ref (s.output), close_status_code::going_away);
+        ::send (s.socket.native_handle (), s.output.data (), s.output.size (), MSG_NOSIGNAL);
+      }
+      // Subscriptions must be released before the channels are destroyed.
+      s.subscription.reset ();
+    }
+  }
+
+} // end anonymous namespace
+
+namespace pstore::http {
+
+  // (ctor)
+  // ~~~~~~
+  event_server::event_server (romfs::romfs & file_system, channel_container const & channels,
+                              event_server_options const & options)
+          : file_system_{file_system}
+          , channels_{channels}
+          , options_{options} {}
+
+  // add client
+  // ~~~~~~~~~~
+  std::error_code event_server::add_client (socket_descriptor && client) {
+    int const flags = ::fcntl (client.native_handle (), F_GETFL);
+    if (flags < 0 || ::fcntl (client.native_handle (), F_SETFL, flags | O_NONBLOCK) < 0) {
+      return get_last_error ();
+    }
+    clients_.push_back (std::move (client));
+    return {};
+  }
+
+  // run
+  // ~~~
+  std::error_code event_server::run (socket_descriptor const & listener,
+                                     gsl::not_null<server_status *> const status) {
+    // The event loop must never block waiting for a connection.
+    if (listener.valid ()) {
+      int const flags = ::fcntl (listener.native_handle (), F_GETFL);
+      if (flags < 0 || ::fcntl (listener.native_handle (), F_SETFL, flags | O_NONBLOCK) < 0) {
+        return get_last_error ();
+      }
+    }
+
+    epoll_descriptor ep{::epoll_create1 (EPOLL_CLOEXEC)};
+    if (!ep.valid ()) {
+      return get_last_error ();
+    }
+    event_loop loop{std::move (ep), file_system_, channels_, options_};
+    for (socket_descriptor & client : clients_) {
+      loop.add_session (std::move (client));
+    }
+    clients_.clear ();
+    return loop.run (listener, status);
+  }
+
+} // end namespace pstore::http
+
+#endif // PSTORE_HAVE_SYS_EPOLL_H
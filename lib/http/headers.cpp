@@ -86,9 +86,12 @@ namespace {
     return hi;
   }
 
-  // The "connection" header is a comma-separated string. We're looking for the "upgrade" request.
+  // The "connection" header is a comma-separated string. We're looking for the "upgrade",
+  // "keep-alive", and "close" options.
   header_info connection (header_info hi, std::string const & value) {
     static std::string const upgrade = "upgrade";
+    static std::string const keep_alive = "keep-alive";
+    static std::string const close = "close";
 
     std::vector<std::string> strings;
     split (value, std::back_inserter (strings), ',');
@@ -102,12 +105,48 @@ namespace {
 
       if (case_insensitive_equal (upgrade, begin, end)) {
         hi.connection_upgrade = true;
+      } else if (case_insensitive_equal (keep_alive, begin, end)) {
+        hi.connection_keep_alive = true;
+      } else if (case_insensitive_equal (close, begin, end)) {
+        hi.connection_close = true;
       }
     }
 
     return hi;
   }
 
+  header_info content_length_header (header_info hi, std::string const & value) {
+    // Ignore trailing whitespace.
+    auto last = value.length ();
+    while (last > 0 && pstore::isspace (value[last - 1U])) {
+      --last;
+    }
+    auto pos = std::string::size_type{0};
+    auto num = std::uint64_t{0};
+    for (; pos < last && std::isdigit (static_cast<unsigned char> (value[pos])); ++pos) {
+      auto const digit = static_cast<unsigned> (value[pos] - '0');
+      if (num > (std::numeric_limits<std::uint64_t>::max () - digit) / 10U) {
+        break; // overflow.
+      }
+      num = num * 10U + digit;
+    }
+    if (pos == 0 || pos != last) {
+      // Empty, not a number, or too large.
+      hi.bad_content_length = true;
+    } else if (hi.content_length && *hi.content_length != num) {
+      // A repeated header must agree with the first.
+      hi.bad_content_length = true;
+    } else {
+      hi.content_length = pstore::just (num);
+    }
+    return hi;
+  }
+
+  header_info transfer_encoding_header (header_info hi, std::string const &) {
+    hi.transfer_encoding = true;
+    return hi;
+  }
+
   header_info sec_websocket_key (header_info hi, std::string const & value) {
     hi.websocket_key = value;
     return hi;
@@ -136,8 +175,20 @@ namespace {
 
 bool pstore::http::header_info::operator== (header_info const & rhs) const {
   return upgrade_to_websocket == rhs.upgrade_to_websocket &&
-         connection_upgrade == rhs.connection_upgrade && websocket_key == rhs.websocket_key &&
-         websocket_version == rhs.websocket_version;
+         connection_upgrade == rhs.connection_upgrade &&
+         connection_keep_alive == rhs.connection_keep_alive &&
+         connection_close == rhs.connection_close && websocket_key == rhs.websocket_key &&
+         websocket_version == rhs.websocket_version && content_length == rhs.content_length &&
+         bad_content_length == rhs.bad_content_length && transfer_encoding == rhs.transfer_encoding;
+}
+
+bool pstore::http::header_info::keep_alive (std::string const & version) const {
+  // We don't decode transfer encodings so cannot find the end of such a request's body.
+  if (connection_close || transfer_encoding) {
+    return false;
+  }
+  // HTTP/1.1 connections are persistent by default.
+  return version == "HTTP/1.1" || connection_keep_alive;
 }
 
 header_info pstore::http::header_info::handler (std::string const & key,
@@ -146,6 +197,8 @@ header_info pstore::http::header_info::handler (std::string const & key,
     std::string, std::function<header_info (header_info, std::string const & value)>> const
     handlers = {
       {"connection", connection},
+      {"content-length", content_length_header},
+      {"transfer-encoding", transfer_encoding_header},
       {"upgrade", upgrade},
       {"sec-websocket-key", sec_websocket_key},
       {"sec-websocket-version", sec_websocket_version},
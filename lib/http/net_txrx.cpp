@@ -15,9 +15,13 @@
 //===----------------------------------------------------------------------===//
 #include "pstore/http/net_txrx.hpp"
 
+#include <cerrno>
+#include <system_error>
+
 #ifdef _WIN32
 #  include <winsock2.h>
 #else
+#  include <poll.h>
 #  include <sys/socket.h>
 #endif // _WIN32
 
@@ -44,6 +48,47 @@ namespace {
   using data_type = std::uint8_t const *;
 #endif // _!WIN32
 
+  /// The longest time for which a send to a socket whose buffer is full will wait for the
+  /// client to catch up before giving up.
+  constexpr auto send_timeout_ms = 10000;
+
+  // would block
+  // ~~~~~~~~~~~
+  /// Returns true if the most recent socket call failed because a non-blocking socket was
+  /// not ready.
+  bool would_block () noexcept {
+#ifdef _WIN32
+    return WSAGetLastError () == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif // !_WIN32
+  }
+
+  // wait for writable
+  // ~~~~~~~~~~~~~~~~~
+  /// Waits until \p socket is able to accept more data. Returns an error if the wait fails or
+  /// times out.
+  std::error_code wait_for_writable (pstore::socket_descriptor const & socket) {
+#ifdef _WIN32
+    WSAPOLLFD fd{};
+    fd.fd = socket.native_handle ();
+    fd.events = POLLOUT;
+    int const res = ::WSAPoll (&fd, 1, send_timeout_ms);
+#else
+    pollfd fd{};
+    fd.fd = socket.native_handle ();
+    fd.events = POLLOUT;
+    int const res = ::poll (&fd, 1, send_timeout_ms);
+#endif // !_WIN32
+    if (res < 0) {
+      return pstore::http::get_last_error ();
+    }
+    if (res == 0) {
+      return std::make_error_code (std::errc::timed_out);
+    }
+    return {};
+  }
+
 } // end anonymous namespace
 
 
@@ -71,6 +116,8 @@ namespace pstore::http::net {
     return result_type{std::in_place, socket, s.begin () + nread};
   }
 
+  // network sender
+  // ~~~~~~~~~~~~~~
   error_or<socket_descriptor &> network_sender (socket_descriptor & socket,
                                                 gsl::span<std::uint8_t const> const & s) {
     using result_type = error_or<socket_descriptor &>;
@@ -80,9 +127,23 @@ namespace pstore::http::net {
     PSTORE_ASSERT (sizeof (size_type) < sizeof (size) ||
                    static_cast<size_type> (size) < std::numeric_limits<size_type>::max ());
 
-    if (::send (socket.native_handle (), reinterpret_cast<data_type> (s.data ()),
-                static_cast<size_type> (size), 0 /*flags*/) < 0) {
-      return result_type{get_last_error ()};
+    // A send may be partial or, if the socket is non-blocking, may fail because the socket's
+    // buffer is full. Keep going until all of the data has been sent.
+    auto const * data = s.data ();
+    while (size > 0) {
+      auto const nsent = ::send (socket.native_handle (), reinterpret_cast<data_type> (data),
+                                 static_cast<size_type> (size), 0 /*flags*/);
+      if (nsent < 0) {
+        if (!would_block ()) {
+          return result_type{get_last_error ()};
+        }
+        if (std::error_code const erc = wait_for_writable (socket)) {
+          return result_type{erc};
+        }
+        continue;
+      }
+      data += nsent;
+      size -= nsent;
     }
     return result_type{socket};
   }
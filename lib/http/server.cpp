@@ -37,6 +37,7 @@
 
 // Local includes
 #include "pstore/http/error_reporting.hpp"
+#include "pstore/http/event_server.hpp"
 #include "pstore/http/headers.hpp"
 #include "pstore/http/net_txrx.hpp"
 #include "pstore/http/request.hpp"
@@ -84,6 +85,7 @@ namespace {
     return eo{std::move (fd)};
   }
 
+#ifndef PSTORE_HAVE_SYS_EPOLL_H
   // get client name
   // ~~~~~~~~~~~~~~~
   pstore::error_or<std::string> get_client_name (sockaddr_in const & client_addr) {
@@ -113,45 +115,6 @@ namespace {
     using priority = pstore::logger::priority;
     PSTORE_ASSERT (header_contents.connection_upgrade && header_contents.upgrade_to_websocket);
 
-    log (priority::info, "WebSocket upgrade requested");
-    // Validate the request headers
-    if (!header_contents.websocket_key || !header_contents.websocket_version) {
-      log (priority::error, "Missing WebSockets upgrade key or version header.");
-      return return_type{pstore::http::error_code::bad_request};
-    }
-
-
-    if (*header_contents.websocket_version != pstore::http::ws_version) {
-      log (priority::error, "Bad Websocket version number requested");
-      return return_type{pstore::http::error_code::bad_websocket_version};
-    }
-
-
-    // Send back the server handshake response.
-    auto const accept_ws_connection = [&header_contents, &io] () {
-      log (priority::info, "Accepting WebSockets upgrade");
-
-      std::string const date = pstore::http::http_date (std::chrono::system_clock::now ());
-      std::string const accept = pstore::http::source_key (*header_contents.websocket_key);
-
-      std::array<pstore::http::czstring_pair, 5> headers{{
-        {"Upgrade", "WebSocket"},
-        {"Connection", "Upgrade"},
-        {"Sec-WebSocket-Accept", accept.c_str ()},
-        {"Date", date.c_str ()},
-        {"Last-Modified", date.c_str ()},
-      }};
-
-      auto const status_line = build_status_line (
-        pstore::http::http_status_code::switching_protocols, "Switching Protocols");
-
-      auto sender = pstore::http::net::network_sender;
-      return pstore::http::send (sender, io, status_line) >>= [&] (IO io2) {
-        return pstore::http::send (
-          sender, io2, pstore::http::build_headers (std::begin (headers), std::end (headers)));
-      };
-    };
-
     auto server_loop_thread = [&channels] (Reader && reader2, socket_descriptor io2,
                                            std::string const uri) {
       PSTORE_TRY {
@@ -185,7 +148,8 @@ namespace {
     };
 
     PSTORE_ASSERT (io.get ().valid ());
-    return accept_ws_connection () >>= create_ws_server;
+    return pstore::http::accept_upgrade (pstore::http::net::network_sender, io,
+                                         header_contents) >>= create_ws_server;
   }
 
 #ifndef NDEBUG
@@ -238,10 +202,108 @@ namespace {
     return return_type{std::move (childfd)};
   }
 
+#endif // !PSTORE_HAVE_SYS_EPOLL_H
+
 } // end anonymous namespace
 
 namespace pstore::http {
 
+#ifndef PSTORE_HAVE_SYS_EPOLL_H
+  namespace {
+
+    // serve connections
+    // ~~~~~~~~~~~~~~~~~
+    /// Serves one connection at a time, spawning a thread to manage each WebSocket session. Used
+    /// where the event-driven server is not available.
+    void serve_connections (socket_descriptor const & parentfd, romfs::romfs & file_system,
+                            gsl::not_null<server_status *> const status,
+                            channel_container const & channels) {
+      using priority = logger::priority;
+
+      std::vector<std::unique_ptr<std::thread>> websockets_workers;
+
+      for (auto expected_state = server_status::http_state::initializing;
+           status->listening (expected_state);
+           expected_state = server_status::http_state::listening) {
+
+        // Wait for a connection request.
+        error_or<socket_descriptor> echildfd = wait_for_connection (parentfd);
+        if (!echildfd) {
+          log (priority::error, "wait_for_connection: ", echildfd.get_error ().message ());
+          continue;
+        }
+        socket_descriptor & childfd = *echildfd;
+
+        // Get the HTTP request line.
+        auto reader = make_buffered_reader<socket_descriptor &> (net::refiller);
+
+        PSTORE_ASSERT (childfd.valid ());
+        error_or_n<socket_descriptor &, request_info> eri =
+          read_request (reader, std::ref (childfd));
+        if (!eri) {
+          log (priority::error, "Failed reading HTTP request: ", eri.get_error ().message ());
+          continue;
+        }
+        childfd = std::move (get<0> (eri));
+        request_info const & request = get<1> (eri);
+        log (priority::info,
+             "Request: ", request.method () + ' ' + request.version () + ' ' + request.uri ());
+
+        // We only currently support the GET method.
+        if (request.method () != "GET") {
+          report_error (make_error_code (pstore::http::error_code::not_implemented), request,
+                        childfd);
+          continue;
+        }
+
+        // Respond appropriately based on the request and headers.
+        auto const serve_reply = [&] (socket_descriptor & io2,
+                                      header_info const & header_contents) -> std::error_code {
+          if (header_contents.connection_upgrade && header_contents.upgrade_to_websocket) {
+
+            error_or<std::unique_ptr<std::thread>> p =
+              upgrade_to_ws (reader, std::ref (childfd), request, header_contents, channels);
+            if (p) {
+              websockets_workers.emplace_back (std::move (*p));
+            }
+            return p.get_error ();
+          }
+
+          if (!details::starts_with (request.uri (), dynamic_path)) {
+            return serve_static_content (net::network_sender, std::ref (io2), request.uri (),
+                                         file_system)
+              .get_error ();
+          }
+
+          return serve_dynamic_content (net::network_sender, std::ref (io2), request.uri ())
+            .get_error ();
+        };
+
+        // Scan the HTTP headers.
+        PSTORE_ASSERT (childfd.valid ());
+        std::error_code const err = read_headers (
+          reader, std::ref (childfd),
+          [] (header_info io, std::string const & key, std::string const & value) {
+            return io.handler (key, value);
+          },
+          header_info ()) >>= serve_reply;
+
+        if (err) {
+          // Report the error to the user as an HTTP error.
+          report_error (err, request, childfd);
+        }
+
+        PSTORE_ASSERT (input_is_empty (reader, childfd));
+      }
+
+      for (std::unique_ptr<std::thread> const & worker : websockets_workers) {
+        worker->join ();
+      }
+    }
+
+  } // end anonymous namespace
+#endif // !PSTORE_HAVE_SYS_EPOLL_H
+
   int server (romfs::romfs & file_system, gsl::not_null<server_status *> const status,
               channel_container const & channels,
               std::function<void (in_port_t)> notify_listening) {
@@ -258,86 +320,16 @@ namespace pstore::http {
 
     log (priority::info, "starting server-loop on port ", status->port ());
 
-    std::vector<std::unique_ptr<std::thread>> websockets_workers;
     notify_listening (status->port ());
 
-    for (auto expected_state = server_status::http_state::initializing;
-         status->listening (expected_state);
-         expected_state = server_status::http_state::listening) {
-
-      // Wait for a connection request.
-      error_or<socket_descriptor> echildfd = wait_for_connection (parentfd);
-      if (!echildfd) {
-        log (priority::error, "wait_for_connection: ", echildfd.get_error ().message ());
-        continue;
-      }
-      socket_descriptor & childfd = *echildfd;
-
-      // Get the HTTP request line.
-      auto reader = make_buffered_reader<socket_descriptor &> (net::refiller);
-
-      PSTORE_ASSERT (childfd.valid ());
-      error_or_n<socket_descriptor &, request_info> eri = read_request (reader, std::ref (childfd));
-      if (!eri) {
-        log (priority::error, "Failed reading HTTP request: ", eri.get_error ().message ());
-        continue;
-      }
-      childfd = std::move (get<0> (eri));
-      request_info const & request = get<1> (eri);
-      log (priority::info,
-           "Request: ", request.method () + ' ' + request.version () + ' ' + request.uri ());
-
-      // We only currently support the GET method.
-      if (request.method () != "GET") {
-        report_error (make_error_code (pstore::http::error_code::not_implemented), request,
-                      childfd);
-        continue;
-      }
-
-      // Respond appropriately based on the request and headers.
-      auto const serve_reply = [&] (socket_descriptor & io2,
-                                    header_info const & header_contents) -> std::error_code {
-        if (header_contents.connection_upgrade && header_contents.upgrade_to_websocket) {
-
-          error_or<std::unique_ptr<std::thread>> p =
-            upgrade_to_ws (reader, std::ref (childfd), request, header_contents, channels);
-          if (p) {
-            websockets_workers.emplace_back (std::move (*p));
-          }
-          return p.get_error ();
-        }
-
-        if (!details::starts_with (request.uri (), dynamic_path)) {
-          return serve_static_content (net::network_sender, std::ref (io2), request.uri (),
-                                       file_system)
-            .get_error ();
-        }
-
-        return serve_dynamic_content (net::network_sender, std::ref (io2), request.uri ())
-          .get_error ();
-      };
-
-      // Scan the HTTP headers.
-      PSTORE_ASSERT (childfd.valid ());
-      std::error_code const err = read_headers (
-        reader, std::ref (childfd),
-        [] (header_info io, std::string const & key, std::string const & value) {
-          return io.handler (key, value);
-        },
-        header_info ()) >>= serve_reply;
-
-      if (err) {
-        // Report the error to the user as an HTTP error.
-        report_error (err, request, childfd);
-      }
-
-      PSTORE_ASSERT (input_is_empty (reader, childfd));
-    }
-
-    for (std::unique_ptr<std::thread> const & worker : websockets_workers) {
-      worker->join ();
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+    if (std::error_code const erc =
+          event_server{file_system, channels}.run (parentfd, status)) {
+      log (priority::error, "event server: ", erc.message ());
     }
-
+#else
+    serve_connections (parentfd, file_system, status, channels);
+#endif
     return 0;
   }
 
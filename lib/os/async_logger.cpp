@@ -0,0 +1,462 @@
+//===- lib/os/async_logger.cpp --------------------------------------------===//
+//*                                _                              *
+//*   __ _ ___ _   _ _ __   ___   | | ___   __ _  __ _  ___ _ __  *
+//*  / _` / __| | | | '_ \ / __|  | |/ _ \ / _` |/ _` |/ _ \ '__| *
+//* | (_| \__ \ |_| | | | | (__   | | (_) | (_| | (_| |  __/ |    *
+//*  \__,_|___/\__, |_| |_|\___|  |_|\___/ \__, |\__, |\___|_|    *
+//*            |___/                       |___/ |___/            *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file async_logger.cpp
+/// \brief Implements asynchronous logging: each thread queues its messages in its own
+/// single-producer, single-consumer ring buffer which a background thread drains.
+
+#include "pstore/os/logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#  include <pthread.h>
+#endif
+
+#include "pstore/os/thread.hpp"
+#include "pstore/support/portab.hpp"
+#include "pstore/support/round2.hpp"
+
+namespace {
+
+  using pstore::logger;
+  using priority = logger::priority;
+  using time_point = std::chrono::system_clock::time_point;
+
+  constexpr std::size_t cache_line_size = 64;
+
+  // log ring
+  // ~~~~~~~~
+  /// A bounded queue of messages written by a single thread and read by the background thread.
+  class log_ring {
+  public:
+    struct record {
+      logger * target = nullptr;
+      priority p = priority::debug;
+      std::string message;
+      /// The time at which the message was logged.
+      time_point when;
+    };
+
+    explicit log_ring (std::size_t capacity);
+    log_ring (log_ring const &) = delete;
+    log_ring (log_ring &&) noexcept = delete;
+    ~log_ring () noexcept = default;
+    log_ring & operator= (log_ring const &) = delete;
+    log_ring & operator= (log_ring &&) noexcept = delete;
+
+    std::size_t capacity () const noexcept { return mask_ + 1U; }
+
+    /// Called by the producer. Returns false if the ring is full.
+    bool try_push (logger * target, priority p, std::string const & message, time_point when);
+    /// Called by the producer. Returns the number of records waiting to be written.
+    std::size_t size () const noexcept;
+
+    /// Called by the consumer. Writes every available record to its target.
+    /// \returns  The number of records written.
+    std::size_t drain ();
+    /// Called by the consumer.
+    bool empty () const noexcept;
+
+    /// The number of messages discarded by the producer because the ring was full.
+    std::atomic<std::uint64_t> dropped{0U};
+
+  private:
+    std::vector<record> records_;
+    std::size_t const mask_;
+    /// The total number of records pushed. Written only by the producer.
+    alignas (cache_line_size) std::atomic<std::size_t> head_{0U};
+    /// The total number of records written. Written only by the consumer.
+    alignas (cache_line_size) std::atomic<std::size_t> tail_{0U};
+  };
+
+  // (ctor)
+  // ~~~~~~
+  log_ring::log_ring (std::size_t const capacity)
+          : records_ (static_cast<std::size_t> (pstore::round_to_power_of_2 (
+              static_cast<std::uint64_t> (std::max (capacity, std::size_t{2})))))
+          , mask_{records_.size () - 1U} {}
+
+  // try push
+  // ~~~~~~~~
+  bool log_ring::try_push (logger * const target, priority const p, std::string const & message,
+                           time_point const when) {
+    std::size_t const head = head_.load (std::memory_order_relaxed);
+    if (head - tail_.load (std::memory_order_acquire) > mask_) {
+      return false;
+    }
+    record & r = records_[head & mask_];
+    r.target = target;
+    r.p = p;
+    r.message = message;
+    r.when = when;
+    head_.store (head + 1U, std::memory_order_release);
+    return true;
+  }
+
+  // size
+  // ~~~~
+  std::size_t log_ring::size () const noexcept {
+    return head_.load (std::memory_order_relaxed) - tail_.load (std::memory_order_acquire);
+  }
+
+  // drain
+  // ~~~~~
+  std::size_t log_ring::drain () {
+    std::size_t const first = tail_.load (std::memory_order_relaxed);
+    std::size_t const head = head_.load (std::memory_order_acquire);
+    if (first == head) {
+      return 0U;
+    }
+    if (std::uint64_t const lost = dropped.exchange (0U, std::memory_order_relaxed)) {
+      records_[first & mask_].target->log (priority::warning, "log messages dropped: ", lost);
+    }
+    for (std::size_t tail = first; tail != head; ++tail) {
+      // The message is not moved from the record so that the producer can reuse its storage.
+      record const & r = records_[tail & mask_];
+      r.target->log (r.p, r.message, r.when);
+      // Releasing each record as it is written lets a blocked producer make progress.
+      tail_.store (tail + 1U, std::memory_order_release);
+    }
+    return head - first;
+  }
+
+  // empty
+  // ~~~~~
+  bool log_ring::empty () const noexcept {
+    return head_.load (std::memory_order_acquire) == tail_.load (std::memory_order_relaxed);
+  }
+
+  // async writer
+  // ~~~~~~~~~~~~
+  /// Owns the background thread and the rings of the threads which have logged a message whilst
+  /// it was running.
+  class async_writer {
+  public:
+    static async_writer & get ();
+
+    void start (std::size_t ring_capacity, pstore::log_overflow overflow);
+    void stop ();
+    void flush ();
+    bool running () const noexcept { return running_.load (std::memory_order_acquire); }
+
+    /// Queues a message for \p target which was logged at time \p when.
+    /// \returns  False if the background thread is not running, in which case the caller must
+    ///   write the message itself.
+    bool push (logger * target, priority p, std::string const & message, time_point when);
+
+  private:
+    /// The longest that the background thread sleeps before checking the rings for messages.
+    static constexpr auto poll_interval = std::chrono::milliseconds{50};
+
+    async_writer ();
+
+#ifndef _WIN32
+    /// Called in the child process after fork(). The background thread does not exist in the
+    /// child so this abandons it and returns to synchronous logging.
+    void reset_in_child () noexcept;
+#endif
+
+    void thread_entry ();
+    /// Returns the calling thread's ring, creating and registering it if necessary.
+    log_ring & thread_ring ();
+    /// Wakes the background thread if it is waiting for messages.
+    void wake ();
+
+    std::atomic<bool> running_{false};
+    /// Incremented each time that the background thread is started so that threads can tell
+    /// whether their ring was registered with an earlier instance.
+    std::atomic<unsigned> generation_{0U};
+    std::size_t ring_capacity_ = 1024;
+    pstore::log_overflow overflow_ = pstore::log_overflow::drop;
+
+    std::mutex mut_;
+    /// Signalled to wake the background thread.
+    std::condition_variable cv_;
+    /// Signalled by the background thread each time that it finishes a pass over the rings.
+    std::condition_variable written_cv_;
+    std::vector<std::shared_ptr<log_ring>> rings_;
+    std::atomic<bool> sleeping_{false};
+    /// True from the moment that stop() is called until it has written the final messages.
+    /// Signalled on written_cv_ when it becomes false.
+    bool stop_ = false;
+    /// The number of calls to flush() and the number of those which the background thread has
+    /// satisfied.
+    std::uint64_t flush_requested_ = 0U;
+    std::uint64_t flushed_ = 0U;
+    std::thread thread_;
+  };
+
+  // get
+  // ~~~
+  async_writer & async_writer::get () {
+    static async_writer writer;
+    return writer;
+  }
+
+  // (ctor)
+  // ~~~~~~
+  async_writer::async_writer () {
+#ifndef _WIN32
+    // Holding the mutex across fork() ensures that the child's copy of the writer's state is
+    // consistent.
+    ::pthread_atfork ([] () { async_writer::get ().mut_.lock (); },
+                      [] () { async_writer::get ().mut_.unlock (); },
+                      [] () { async_writer::get ().reset_in_child (); });
+#endif
+  }
+
+#ifndef _WIN32
+  // reset in child
+  // ~~~~~~~~~~~~~~
+  void async_writer::reset_in_child () noexcept {
+    running_.store (false, std::memory_order_relaxed);
+    // Ensure that threads don't use the rings which belonged to the parent. Their messages
+    // will be written by the parent.
+    generation_.fetch_add (1U, std::memory_order_relaxed);
+    rings_.clear ();
+    stop_ = false;
+    sleeping_.store (false, std::memory_order_relaxed);
+    flushed_ = flush_requested_;
+    // The std::thread refers to a thread which does not exist in this process: it can be
+    // neither joined nor destroyed whilst joinable so is overwritten. The condition variables
+    // may record waiters which were left behind in the parent.
+    new (&thread_) std::thread{};
+    new (&cv_) std::condition_variable{};
+    new (&written_cv_) std::condition_variable{};
+    mut_.unlock ();
+  }
+#endif
+
+  // start
+  // ~~~~~
+  void async_writer::start (std::size_t const ring_capacity,
+                            pstore::log_overflow const overflow) {
+    std::scoped_lock<decltype (mut_)> const lock{mut_};
+    if (thread_.joinable () || stop_) {
+      return;
+    }
+    ring_capacity_ = ring_capacity;
+    overflow_ = overflow;
+    stop_ = false;
+    generation_.fetch_add (1U, std::memory_order_relaxed);
+    thread_ = std::thread{[this] () { this->thread_entry (); }};
+    // The store releases the settings above to the threads which push messages.
+    running_.store (true, std::memory_order_release);
+  }
+
+  // stop
+  // ~~~~
+  void async_writer::stop () {
+    std::thread thread;
+    {
+      std::scoped_lock<decltype (mut_)> const lock{mut_};
+      if (!thread_.joinable ()) {
+        return;
+      }
+      running_.store (false, std::memory_order_release);
+      stop_ = true;
+      // thread_ is only accessed with the mutex held so it can't be joined in place.
+      thread = std::move (thread_);
+    }
+    cv_.notify_one ();
+    thread.join ();
+
+    std::scoped_lock<decltype (mut_)> const lock{mut_};
+    // Write anything queued by a thread which was part way through logging a message whilst
+    // the background thread was making its final pass.
+    for (std::shared_ptr<log_ring> const & ring : rings_) {
+      ring->drain ();
+    }
+    rings_.clear ();
+    stop_ = false;
+    // Release any flush() which is waiting for the stop to complete.
+    written_cv_.notify_all ();
+  }
+
+  // flush
+  // ~~~~~
+  void async_writer::flush () {
+    std::unique_lock<decltype (mut_)> lock{mut_};
+    if (stop_) {
+      // The messages might be written by stop()'s final pass rather than by the background
+      // thread. Returning before that pass would allow an async_logger to be destroyed whilst
+      // records which refer to it are still queued.
+      written_cv_.wait (lock, [this] () { return !stop_; });
+      return;
+    }
+    if (!thread_.joinable ()) {
+      return;
+    }
+    std::uint64_t const ticket = ++flush_requested_;
+    cv_.notify_one ();
+    written_cv_.wait (lock, [this, ticket] () { return flushed_ >= ticket; });
+  }
+
+  // push
+  // ~~~~
+  bool async_writer::push (logger * const target, priority const p, std::string const & message,
+                           time_point const when) {
+    if (!this->running ()) {
+      return false;
+    }
+    log_ring & ring = this->thread_ring ();
+    while (!ring.try_push (target, p, message, when)) {
+      this->wake ();
+      if (overflow_ == pstore::log_overflow::drop) {
+        ring.dropped.fetch_add (1U, std::memory_order_relaxed);
+        return true;
+      }
+      if (!this->running ()) {
+        return false;
+      }
+      std::this_thread::yield ();
+    }
+    // Don't wait for the poll interval to expire if the ring is filling up.
+    if (ring.size () > ring.capacity () / 2U) {
+      this->wake ();
+    }
+    return true;
+  }
+
+  // thread ring
+  // ~~~~~~~~~~~
+  log_ring & async_writer::thread_ring () {
+    struct per_thread {
+      std::shared_ptr<log_ring> ring;
+      unsigned generation = 0U;
+    };
+    thread_local per_thread state;
+
+    unsigned const generation = generation_.load (std::memory_order_relaxed);
+    if (!state.ring || state.generation != generation) {
+      state.ring = std::make_shared<log_ring> (ring_capacity_);
+      state.generation = generation;
+      std::scoped_lock<decltype (mut_)> const lock{mut_};
+      rings_.push_back (state.ring);
+    }
+    return *state.ring;
+  }
+
+  // wake
+  // ~~~~
+  void async_writer::wake () {
+    if (sleeping_.load (std::memory_order_relaxed)) {
+      cv_.notify_one ();
+    }
+  }
+
+  // thread entry
+  // ~~~~~~~~~~~~
+  void async_writer::thread_entry () {
+    pstore::threads::set_name ("log");
+
+    std::vector<std::shared_ptr<log_ring>> rings;
+    std::unique_lock<decltype (mut_)> lock{mut_};
+    for (;;) {
+      bool const stopping = stop_;
+      std::uint64_t const ticket = flush_requested_;
+      rings = rings_;
+      lock.unlock ();
+
+      std::size_t written = 0U;
+      for (std::shared_ptr<log_ring> const & ring : rings) {
+        written += ring->drain ();
+      }
+      rings.clear ();
+
+      lock.lock ();
+      // Forget the rings of threads which have exited once their messages have been written.
+      rings_.erase (std::remove_if (std::begin (rings_), std::end (rings_),
+                                    [] (std::shared_ptr<log_ring> const & ring) {
+                                      return ring.use_count () == 1 && ring->empty ();
+                                    }),
+                    std::end (rings_));
+      flushed_ = ticket;
+      written_cv_.notify_all ();
+      if (stopping) {
+        break;
+      }
+      if (written == 0U && !stop_ && flush_requested_ == ticket) {
+        sleeping_.store (true, std::memory_order_relaxed);
+        cv_.wait_for (lock, poll_interval);
+        sleeping_.store (false, std::memory_order_relaxed);
+      }
+    }
+  }
+
+} // end anonymous namespace
+
+namespace pstore {
+
+  //*                                _                              *
+  //*   __ _ ___ _   _ _ __   ___   | | ___   __ _  __ _  ___ _ __  *
+  //*  / _` / __| | | | '_ \ / __|  | |/ _ \ / _` |/ _` |/ _ \ '__| *
+  //* | (_| \__ \ |_| | | | | (__   | | (_) | (_| | (_| |  __/ |    *
+  //*  \__,_|___/\__, |_| |_|\___|  |_|\___/ \__, |\__, |\___|_|    *
+  //*            |___/                       |___/ |___/            *
+  // (ctor)
+  // ~~~~~~
+  async_logger::async_logger (std::unique_ptr<logger> && target)
+          : target_{std::move (target)} {}
+
+  // (dtor)
+  // ~~~~~~
+  async_logger::~async_logger () noexcept {
+    // The queued records refer to the target logger which is about to be destroyed.
+    no_ex_escape ([] () { async_writer::get ().flush (); });
+  }
+
+  // log
+  // ~~~
+  void async_logger::log (priority const p, std::string const & message) {
+    // The time is taken now so that the message's timestamp is not delayed by the queue.
+    this->log (p, message, std::chrono::system_clock::now ());
+  }
+  void async_logger::log (priority const p, std::string const & message,
+                          time_point const when) {
+    if (!async_writer::get ().push (target_.get (), p, message, when)) {
+      target_->log (p, message, when);
+    }
+  }
+
+  // start async logging
+  // ~~~~~~~~~~~~~~~~~~~
+  void start_async_logging (std::size_t const ring_capacity, log_overflow const overflow) {
+    async_writer::get ().start (ring_capacity, overflow);
+  }
+
+  // stop async logging
+  // ~~~~~~~~~~~~~~~~~~
+  void stop_async_logging () { async_writer::get ().stop (); }
+
+  // async logging enabled
+  // ~~~~~~~~~~~~~~~~~~~~~
+  bool async_logging_enabled () noexcept { return async_writer::get ().running (); }
+
+  // flush log
+  // ~~~~~~~~~
+  void flush_log () { async_writer::get ().flush (); }
+
+} // end namespace pstore
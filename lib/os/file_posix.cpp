@@ -21,6 +21,7 @@
 #  include "pstore/os/file.hpp"
 
 // standard includes
+#  include <algorithm>
 #  include <array>
 #  include <cerrno>
 #  include <cstdio>
@@ -508,5 +509,55 @@ namespace pstore::file {
     }
   }
 
+  std::uint64_t copy_range (file_handle const & src, std::uint64_t src_offset,
+                            file_handle & dest, std::uint64_t dest_offset,
+                            std::uint64_t const size) {
+    std::uint64_t copied = 0;
+#  ifdef PSTORE_HAVE_COPY_FILE_RANGE
+    if (!src.is_open () || !dest.is_open ()) {
+      return copied;
+    }
+    while (copied < size) {
+      if (src_offset > uoff_max || dest_offset > uoff_max) {
+        raise (std::errc::invalid_argument, "copy_range");
+      }
+      auto in_off = static_cast<off_t> (src_offset);
+      auto out_off = static_cast<off_t> (dest_offset);
+      // Limit each request so that the result is always representable by ssize_t.
+      auto const chunk = static_cast<std::size_t> (
+        std::min (size - copied, std::uint64_t{std::numeric_limits<ssize_t>::max () / 2}));
+      ssize_t const r = ::copy_file_range (src.raw_handle (), &in_off, dest.raw_handle (),
+                                           &out_off, chunk, 0U);
+      if (r == -1) {
+        int const err = errno;
+        if (err == EINTR) {
+          continue;
+        }
+        // The call is not supported by the kernel, cannot copy between these file systems, or
+        // is not supported by the file system. The caller must use a fallback.
+        if (err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP ||
+            err == EBADF) {
+          break;
+        }
+        raise_file_error (err, "copy_file_range failed", dest.path ());
+      }
+      if (r == 0) {
+        break; // End of the source file.
+      }
+      auto const n = static_cast<std::uint64_t> (r);
+      copied += n;
+      src_offset += n;
+      dest_offset += n;
+    }
+#  else
+    (void) src;
+    (void) src_offset;
+    (void) dest;
+    (void) dest_offset;
+    (void) size;
+#  endif // PSTORE_HAVE_COPY_FILE_RANGE
+    return copied;
+  }
+
 } // namespace pstore::file
 #endif //_WIN32
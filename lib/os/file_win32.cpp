@@ -487,6 +487,14 @@ namespace pstore {
       }
     }
 
+    std::uint64_t copy_range (file_handle const & /*src*/, std::uint64_t /*src_offset*/,
+                              file_handle & /*dest*/, std::uint64_t /*dest_offset*/,
+                              std::uint64_t /*size*/) {
+      // Windows has no equivalent of copy_file_range() for arbitrary byte ranges (block
+      // cloning requires ReFS and cluster alignment) so the caller's fallback is always used.
+      return 0;
+    }
+
   } // end namespace file
 } // end namespace pstore
 #endif // #ifdef _WIN32
@@ -49,6 +49,10 @@ namespace pstore {
   //*        |___/|___/          *
   // log
   // ~~~
+  void logger::log (priority const p, std::string const & message,
+                    std::chrono::system_clock::time_point const /*when*/) {
+    this->log (p, message);
+  }
   void logger::log (priority const p, gsl::czstring const message, int const d) {
     this->log (p, to_string (message, d));
   }
@@ -286,7 +290,7 @@ namespace pstore {
 
   namespace details {
 
-    thread_local logger_collection * log_destinations = nullptr;
+    thread_local std::unique_ptr<logger_collection> log_destinations;
 
   } // end namespace details
 
@@ -331,9 +335,13 @@ namespace pstore {
       loggers->emplace_back (new stderr_logger);
     }
 
-    using details::log_destinations;
-    delete log_destinations;
-    log_destinations = loggers.release ();
+    if (async_logging_enabled ()) {
+      for (std::unique_ptr<logger> & l : *loggers) {
+        l = std::make_unique<async_logger> (std::move (l));
+      }
+    }
+
+    details::log_destinations = std::move (loggers);
   }
 
 
@@ -347,8 +355,13 @@ namespace pstore {
   // log
   // ~~~
   void basic_logger::log (priority const p, std::string const & message) {
+    this->log (p, message, std::chrono::system_clock::now ());
+  }
+  void basic_logger::log (priority const p, std::string const & message,
+                          std::chrono::system_clock::time_point const when) {
     std::array<char, time_buffer_size> time_buffer;
-    std::size_t const r = time_string (std::time (nullptr), ::gsl::make_span (time_buffer));
+    std::size_t const r = time_string (std::chrono::system_clock::to_time_t (when),
+                                       ::gsl::make_span (time_buffer));
     (void) r;
     PSTORE_ASSERT (r == sizeof (time_buffer) - 1);
     gsl::czstring const time_str = time_buffer.data ();
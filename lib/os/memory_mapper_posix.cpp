@@ -103,6 +103,19 @@ namespace pstore {
 
 
 
+  // will need
+  // ~~~~~~~~~
+  void will_need (void const * const addr, std::size_t const len) noexcept {
+    if (len == 0U) {
+      return;
+    }
+    // posix_madvise() requires an address which is a multiple of the page size.
+    static auto const page_size = std::uintptr_t{system_page_size{}.get ()};
+    auto const first = reinterpret_cast<std::uintptr_t> (addr);
+    auto const start = first & ~(page_size - 1U);
+    ::posix_madvise (reinterpret_cast<void *> (start), first + len - start, POSIX_MADV_WILLNEED);
+  }
+
   // read only
   // ~~~~~~~~~
   void memory_mapper_base::read_only_impl (void * const addr, std::size_t const len) {
@@ -120,9 +133,10 @@ namespace pstore {
   // (ctor)
   // ~~~~~~
   memory_mapper::memory_mapper (file::file_handle & file, bool const write_enabled,
-                                std::uint64_t const offset, std::uint64_t const length)
-          : memory_mapper_base (mmap (file, write_enabled, offset, length), write_enabled, offset,
-                                length) {}
+                                std::uint64_t const offset, std::uint64_t const length,
+                                mapping_policy const & policy)
+          : memory_mapper_base (mmap (file, write_enabled, offset, length, policy), write_enabled,
+                                offset, length) {}
 
   // (dtor)
   // ~~~~~~
@@ -132,11 +146,18 @@ namespace pstore {
   // ~~~~
   std::shared_ptr<void> memory_mapper::mmap (file::file_handle & file, bool const write_enabled,
                                              std::uint64_t const offset,
-                                             std::uint64_t const length) {
+                                             std::uint64_t const length,
+                                             mapping_policy const & policy) {
+    int flags = MAP_SHARED;
+#  ifdef MAP_POPULATE
+    if (policy.populate) {
+      flags |= MAP_POPULATE;
+    }
+#  endif
     void * const ptr = ::mmap (nullptr, // base address
                                length,
                                PROT_READ | (write_enabled ? PROT_WRITE : 0), // protection flags
-                               MAP_SHARED, file.raw_handle (), checked_offset (offset));
+                               flags, file.raw_handle (), checked_offset (offset));
     void const * const map_failed = MAP_FAILED; // NOLINT
     if (ptr == map_failed) {
       int const last_error = errno;
@@ -145,6 +166,22 @@ namespace pstore {
       raise (errno_erc{last_error}, message.str ());
     }
 
+    // The remaining requests are hints: failure is not an error.
+#  ifdef MADV_HUGEPAGE
+    if (policy.huge_pages) {
+      ::madvise (ptr, length, MADV_HUGEPAGE);
+    }
+#  endif
+    switch (policy.access) {
+    case mapping_policy::access_pattern::random:
+      ::posix_madvise (ptr, length, POSIX_MADV_RANDOM);
+      break;
+    case mapping_policy::access_pattern::sequential:
+      ::posix_madvise (ptr, length, POSIX_MADV_SEQUENTIAL);
+      break;
+    case mapping_policy::access_pattern::normal: break;
+    }
+
     return std::shared_ptr<void> (ptr, [length] (void * const p) {
       if (::munmap (p, length) == -1) {
         raise (errno_erc{errno}, "munmap");
@@ -118,6 +118,15 @@ namespace pstore {
   //*  | | | | | |  __/ | | | | | (_) | |  | |_| |  | | | | | | (_| | |_) | |_) |  __/ |     *
   //*  |_| |_| |_|\___|_| |_| |_|\___/|_|   \__, |  |_| |_| |_|\__,_| .__/| .__/ \___|_|     *
   //*                                       |___/                   |_|   |_|                *
+  // will need
+  // ~~~~~~~~~
+  void will_need (void const * const addr, std::size_t const len) noexcept {
+    // PrefetchVirtualMemory() is not available on all of the versions of Windows that we
+    // support. This is only a hint so we do nothing.
+    (void) addr;
+    (void) len;
+  }
+
   // read only impl
   // ~~~~~~~~~~~~~~
   void memory_mapper_base::read_only_impl (void * addr, std::size_t len) {
@@ -131,9 +140,9 @@ namespace pstore {
   // (ctor)
   // ~~~~~~
   memory_mapper::memory_mapper (file::file_handle & file, bool write_enabled, std::uint64_t offset,
-                                std::uint64_t length)
-          : memory_mapper_base (mmap (file, write_enabled, offset, length), write_enabled, offset,
-                                length) {}
+                                std::uint64_t length, mapping_policy const & policy)
+          : memory_mapper_base (mmap (file, write_enabled, offset, length, policy), write_enabled,
+                                offset, length) {}
 
   // (dtor)
   // ~~~~~~
@@ -142,7 +151,10 @@ namespace pstore {
   // mmap [static]
   // ~~~~~~~~~~~~~
   std::shared_ptr<void> memory_mapper::mmap (file::file_handle & file, bool write_enabled,
-                                             std::uint64_t offset, std::uint64_t length) {
+                                             std::uint64_t offset, std::uint64_t length,
+                                             mapping_policy const & policy) {
+    // The mapping policy's hints have no direct equivalent for views of a file mapping.
+    (void) policy;
     file_mapping mapping (file, write_enabled, offset + length);
     void * mapped_ptr =
       ::MapViewOfFile (mapping.handle (), write_enabled ? FILE_MAP_WRITE : FILE_MAP_READ,
@@ -0,0 +1,325 @@
+//===- lib/support/base64.cpp ---------------------------------------------===//
+//*  _                     __   _  _    *
+//* | |__   __ _ ___  ___ / /_ | || |   *
+//* | '_ \ / _` / __|/ _ \ '_ \| || |_  *
+//* | |_) | (_| \__ \  __/ (_) |__   _| *
+//* |_.__/ \__,_|___/\___|\___/   |_|   *
+//*                                     *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/support/base64.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define PSTORE_BASE64_SIMD 1
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    define PSTORE_BASE64_SSSE3_TARGET
+#    define PSTORE_BASE64_AVX2_TARGET
+#  else
+#    define PSTORE_BASE64_SSSE3_TARGET __attribute__ ((target ("ssse3")))
+#    define PSTORE_BASE64_AVX2_TARGET __attribute__ ((target ("avx2")))
+#  endif
+#else
+#  define PSTORE_BASE64_SIMD 0
+#endif
+
+// The vector implementations follow Wojciech Muła and Daniel Lemire, "Faster Base64 Encoding
+// and Decoding Using AVX2 Instructions", ACM Transactions on the Web 12(3), 2018. Each kernel
+// converts as many whole blocks as it can and returns the number of input elements that it
+// consumed; the remainder is handled by the scalar to_base64() and from_base64() functions.
+// Because the kernels only consume complete groups of four characters, the scalar code always
+// resumes at the start of a group.
+
+namespace {
+
+#if PSTORE_BASE64_SIMD
+  /// The instruction set extensions available to the Base64 kernels. Later members imply the
+  /// presence of earlier ones.
+  enum class isa { scalar, ssse3, avx2 };
+
+  isa detect_isa () noexcept {
+#  ifdef _MSC_VER
+    int info[4];
+    __cpuid (info, 0);
+    int const max_leaf = info[0];
+    __cpuid (info, 1);
+    bool const has_ssse3 = (info[2] & (1 << 9)) != 0;   // ECX bit 9: SSSE3.
+    bool const has_osxsave = (info[2] & (1 << 27)) != 0; // ECX bit 27: OSXSAVE.
+    // AVX2 also requires that the OS saves the YMM registers on a context switch.
+    if (max_leaf >= 7 && has_osxsave && (_xgetbv (0) & 0x6U) == 0x6U) {
+      __cpuidex (info, 7, 0);
+      if ((info[1] & (1 << 5)) != 0) { // EBX bit 5: AVX2.
+        return isa::avx2;
+      }
+    }
+    return has_ssse3 ? isa::ssse3 : isa::scalar;
+#  else
+    if (__builtin_cpu_supports ("avx2") != 0) {
+      return isa::avx2;
+    }
+    return __builtin_cpu_supports ("ssse3") != 0 ? isa::ssse3 : isa::scalar;
+#  endif
+  }
+
+  isa cpu_isa () noexcept {
+    static isa const result = detect_isa ();
+    return result;
+  }
+
+  //*                           _       *
+  //*   ___ _ __   ___ ___   __| | ___  *
+  //*  / _ \ '_ \ / __/ _ \ / _` |/ _ \ *
+  //* |  __/ | | | (_| (_) | (_| |  __/ *
+  //*  \___|_| |_|\___\___/ \__,_|\___| *
+  //*                                   *
+  // Spreads the 12 bytes at the start of each 128-bit lane across 16 bytes so that each byte
+  // holds one six-bit value.
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i unpack (__m128i in) noexcept {
+    in = _mm_shuffle_epi8 (in, _mm_setr_epi8 (1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m128i const t0 = _mm_and_si128 (in, _mm_set1_epi32 (0x0FC0FC00));
+    __m128i const t1 = _mm_mulhi_epu16 (t0, _mm_set1_epi32 (0x04000040));
+    __m128i const t2 = _mm_and_si128 (in, _mm_set1_epi32 (0x003F03F0));
+    __m128i const t3 = _mm_mullo_epi16 (t2, _mm_set1_epi32 (0x01000010));
+    return _mm_or_si128 (t1, t3);
+  }
+
+  // The values added to six-bit values to produce the corresponding Base64 characters. The
+  // table is indexed as described by to_ascii().
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i encode_offsets () noexcept {
+    return _mm_setr_epi8 ('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  }
+
+  // Converts six-bit values to Base64 characters. Each value is mapped to an index into the
+  // table of offsets: 0-25 to 13, 26-51 to 0, 52-61 to 1-10, 62 to 11, and 63 to 12.
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i to_ascii (__m128i const values) noexcept {
+    __m128i index = _mm_subs_epu8 (values, _mm_set1_epi8 (51));
+    __m128i const less = _mm_cmpgt_epi8 (_mm_set1_epi8 (26), values);
+    index = _mm_or_si128 (index, _mm_and_si128 (less, _mm_set1_epi8 (13)));
+    return _mm_add_epi8 (_mm_shuffle_epi8 (encode_offsets (), index), values);
+  }
+
+  // Converts 12 bytes to 16 characters per iteration. Each load reads 16 bytes.
+  PSTORE_BASE64_SSSE3_TARGET
+  std::size_t encode_ssse3 (std::uint8_t const * in, std::size_t size, char * out) noexcept {
+    auto const * const first = in;
+    for (; size >= 16U; in += 12, size -= 12U, out += 16) {
+      __m128i const x = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (in));
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (out), to_ascii (unpack (x)));
+    }
+    return static_cast<std::size_t> (in - first);
+  }
+
+  PSTORE_BASE64_AVX2_TARGET
+  inline __m256i unpack (__m256i in) noexcept {
+    in = _mm256_shuffle_epi8 (in, _mm256_broadcastsi128_si256 (_mm_setr_epi8 (
+                                    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)));
+    __m256i const t0 = _mm256_and_si256 (in, _mm256_set1_epi32 (0x0FC0FC00));
+    __m256i const t1 = _mm256_mulhi_epu16 (t0, _mm256_set1_epi32 (0x04000040));
+    __m256i const t2 = _mm256_and_si256 (in, _mm256_set1_epi32 (0x003F03F0));
+    __m256i const t3 = _mm256_mullo_epi16 (t2, _mm256_set1_epi32 (0x01000010));
+    return _mm256_or_si256 (t1, t3);
+  }
+
+  PSTORE_BASE64_AVX2_TARGET
+  inline __m256i to_ascii (__m256i const values) noexcept {
+    __m256i index = _mm256_subs_epu8 (values, _mm256_set1_epi8 (51));
+    __m256i const less = _mm256_cmpgt_epi8 (_mm256_set1_epi8 (26), values);
+    index = _mm256_or_si256 (index, _mm256_and_si256 (less, _mm256_set1_epi8 (13)));
+    __m256i const offsets = _mm256_broadcastsi128_si256 (encode_offsets ());
+    return _mm256_add_epi8 (_mm256_shuffle_epi8 (offsets, index), values);
+  }
+
+  // Converts 24 bytes to 32 characters per iteration. Each 128-bit lane is loaded
+  // separately so that it receives 12 bytes of input; the upper load reads 16 bytes starting
+  // 12 bytes into the block.
+  PSTORE_BASE64_AVX2_TARGET
+  std::size_t encode_avx2 (std::uint8_t const * in, std::size_t size, char * out) noexcept {
+    auto const * const first = in;
+    for (; size >= 28U; in += 24, size -= 24U, out += 32) {
+      __m128i const lo = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (in));
+      __m128i const hi = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (in + 12));
+      __m256i const x = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (out), to_ascii (unpack (x)));
+    }
+    return static_cast<std::size_t> (in - first);
+  }
+
+  //*      _                    _       *
+  //*   __| | ___  ___ ___   __| | ___  *
+  //*  / _` |/ _ \/ __/ _ \ / _` |/ _ \ *
+  //* | (_| |  __/ (_| (_) | (_| |  __/ *
+  //*  \__,_|\___|\___\___/ \__,_|\___| *
+  //*                                   *
+  // Lookup tables used to validate and translate Base64 characters. A character is valid if
+  // the entries selected by its low and high nibbles have no bits in common. Note that the
+  // '=' padding character is rejected: it is left for the scalar code.
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i lut_lo () noexcept {
+    return _mm_setr_epi8 (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+                          0x1B, 0x1B, 0x1B, 0x1A);
+  }
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i lut_hi () noexcept {
+    return _mm_setr_epi8 (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                          0x10, 0x10, 0x10, 0x10);
+  }
+  // The values added to each character to produce its six-bit value, indexed by the
+  // character's high nibble (less one for '/').
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i lut_roll () noexcept {
+    return _mm_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  }
+
+  // Converts 16 Base64 characters to their six-bit values. Returns false if any of the
+  // characters is not a member of the Base64 alphabet.
+  PSTORE_BASE64_SSSE3_TARGET
+  inline bool from_ascii (__m128i * const x) noexcept {
+    __m128i const mask_2f = _mm_set1_epi8 (0x2F);
+    __m128i const hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (*x, 4), mask_2f);
+    __m128i const lo_nibbles = _mm_and_si128 (*x, mask_2f);
+    __m128i const lo = _mm_shuffle_epi8 (lut_lo (), lo_nibbles);
+    __m128i const hi = _mm_shuffle_epi8 (lut_hi (), hi_nibbles);
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_and_si128 (lo, hi), _mm_setzero_si128 ())) !=
+        0xFFFF) {
+      return false;
+    }
+    __m128i const eq_2f = _mm_cmpeq_epi8 (*x, mask_2f);
+    __m128i const roll = _mm_shuffle_epi8 (lut_roll (), _mm_add_epi8 (eq_2f, hi_nibbles));
+    *x = _mm_add_epi8 (*x, roll);
+    return true;
+  }
+
+  // Packs each group of four six-bit values into three bytes. The result occupies the first
+  // 12 bytes of each 128-bit lane.
+  PSTORE_BASE64_SSSE3_TARGET
+  inline __m128i pack (__m128i const values) noexcept {
+    __m128i const merge_ab_bc = _mm_maddubs_epi16 (values, _mm_set1_epi32 (0x01400140));
+    __m128i const merged = _mm_madd_epi16 (merge_ab_bc, _mm_set1_epi32 (0x00011000));
+    return _mm_shuffle_epi8 (
+      merged, _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  }
+
+  // Converts 16 characters to 12 bytes per iteration. Stops at the first block containing a
+  // character that is not part of the Base64 alphabet.
+  PSTORE_BASE64_SSSE3_TARGET
+  std::size_t decode_ssse3 (char const * in, std::size_t size, std::uint8_t * out) noexcept {
+    auto const * const first = in;
+    for (; size >= 16U; in += 16, size -= 16U, out += 12) {
+      __m128i x = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (in));
+      if (!from_ascii (&x)) {
+        break;
+      }
+      // Only 12 of the 16 bytes are valid: go via a temporary so that we never write beyond
+      // the space required by the caller.
+      std::array<std::uint8_t, 16> bytes;
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (bytes.data ()), pack (x));
+      std::memcpy (out, bytes.data (), 12U);
+    }
+    return static_cast<std::size_t> (in - first);
+  }
+
+  PSTORE_BASE64_AVX2_TARGET
+  inline bool from_ascii (__m256i * const x) noexcept {
+    __m256i const mask_2f = _mm256_set1_epi8 (0x2F);
+    __m256i const hi_nibbles = _mm256_and_si256 (_mm256_srli_epi32 (*x, 4), mask_2f);
+    __m256i const lo_nibbles = _mm256_and_si256 (*x, mask_2f);
+    __m256i const lo = _mm256_shuffle_epi8 (_mm256_broadcastsi128_si256 (lut_lo ()), lo_nibbles);
+    __m256i const hi = _mm256_shuffle_epi8 (_mm256_broadcastsi128_si256 (lut_hi ()), hi_nibbles);
+    if (_mm256_testz_si256 (lo, hi) == 0) {
+      return false;
+    }
+    __m256i const eq_2f = _mm256_cmpeq_epi8 (*x, mask_2f);
+    __m256i const roll = _mm256_shuffle_epi8 (_mm256_broadcastsi128_si256 (lut_roll ()),
+                                              _mm256_add_epi8 (eq_2f, hi_nibbles));
+    *x = _mm256_add_epi8 (*x, roll);
+    return true;
+  }
+
+  // Packs each group of four six-bit values into three bytes. The result occupies the first
+  // 24 bytes of the vector.
+  PSTORE_BASE64_AVX2_TARGET
+  inline __m256i pack (__m256i const values) noexcept {
+    __m256i const merge_ab_bc = _mm256_maddubs_epi16 (values, _mm256_set1_epi32 (0x01400140));
+    __m256i const merged = _mm256_madd_epi16 (merge_ab_bc, _mm256_set1_epi32 (0x00011000));
+    __m256i const lanes = _mm256_shuffle_epi8 (
+      merged, _mm256_broadcastsi128_si256 (
+                _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+    return _mm256_permutevar8x32_epi32 (lanes, _mm256_setr_epi32 (0, 1, 2, 4, 5, 6, 3, 7));
+  }
+
+  // Converts 32 characters to 24 bytes per iteration.
+  PSTORE_BASE64_AVX2_TARGET
+  std::size_t decode_avx2 (char const * in, std::size_t size, std::uint8_t * out) noexcept {
+    auto const * const first = in;
+    for (; size >= 32U; in += 32, size -= 32U, out += 24) {
+      __m256i x = _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (in));
+      if (!from_ascii (&x)) {
+        break;
+      }
+      std::array<std::uint8_t, 32> bytes;
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (bytes.data ()), pack (x));
+      std::memcpy (out, bytes.data (), 24U);
+    }
+    return static_cast<std::size_t> (in - first);
+  }
+#endif // PSTORE_BASE64_SIMD
+
+} // end anonymous namespace
+
+namespace pstore {
+
+  // base64 encode
+  // ~~~~~~~~~~~~~
+  char * base64_encode (std::uint8_t const * first, std::size_t size, char * out) noexcept {
+#if PSTORE_BASE64_SIMD
+    auto const consume = [&] (std::size_t const n) {
+      first += n;
+      size -= n;
+      out += n / 3U * 4U;
+    };
+    isa const kind = cpu_isa ();
+    if (kind >= isa::avx2) {
+      consume (encode_avx2 (first, size, out));
+    }
+    if (kind >= isa::ssse3) {
+      consume (encode_ssse3 (first, size, out));
+    }
+#endif // PSTORE_BASE64_SIMD
+    return to_base64 (first, first + size, out);
+  }
+
+  // base64 decode
+  // ~~~~~~~~~~~~~
+  std::optional<std::uint8_t *> base64_decode (char const * first, std::size_t size,
+                                               std::uint8_t * out) noexcept {
+#if PSTORE_BASE64_SIMD
+    auto const consume = [&] (std::size_t const n) {
+      first += n;
+      size -= n;
+      out += n / 4U * 3U;
+    };
+    isa const kind = cpu_isa ();
+    if (kind >= isa::avx2) {
+      consume (decode_avx2 (first, size, out));
+    }
+    if (kind >= isa::ssse3) {
+      consume (decode_ssse3 (first, size, out));
+    }
+#endif // PSTORE_BASE64_SIMD
+    return from_base64 (first, first + size, out);
+  }
+
+} // end namespace pstore
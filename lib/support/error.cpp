@@ -72,6 +72,8 @@ std::string pstore::error_category::message (int const error) const {
   case error_code::unable_to_open_named_pipe: result = "unable to open named pipe"; break;
   case error_code::pipe_write_timeout: result = "pipe write timeout"; break;
   case error_code::write_failed: result = "write failed"; break;
+  case error_code::ring_buffer_corrupt: result = "ring buffer corrupt"; break;
+  case error_code::ring_record_too_large: result = "ring buffer record too large"; break;
   }
   return result;
 }
@@ -0,0 +1,216 @@
+//===- lib/support/metrics.cpp --------------------------------------------===//
+//*                 _        _           *
+//*  _ __ ___   ___| |_ _ __(_) ___ ___  *
+//* | '_ ` _ \ / _ \ __| '__| |/ __/ __| *
+//* | | | | | |  __/ |_| |  | | (__\__ \ *
+//* |_| |_| |_|\___|\__|_|  |_|\___|___/ *
+//*                                      *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file metrics.cpp
+/// \brief Implements the registry of per-thread measurements and their aggregation.
+
+#include "pstore/support/metrics.hpp"
+
+#include <mutex>
+#include <sstream>
+
+#include "pstore/support/assert.hpp"
+
+namespace {
+
+  using pstore::metrics::snapshot;
+  using pstore::metrics::details::thread_block;
+
+  /// Adds the measurements recorded in \p block to those in \p s.
+  void accumulate (snapshot * const s, thread_block const & block) noexcept {
+    for (auto c = 0U; c < pstore::metrics::num_counters; ++c) {
+      s->counters[c] += block.counters[c].load (std::memory_order_relaxed);
+    }
+    for (auto h = 0U; h < pstore::metrics::num_histograms; ++h) {
+      auto & sh = s->histograms[h];
+      auto const & th = block.histograms[h];
+      sh.count += th.count.load (std::memory_order_relaxed);
+      sh.sum += th.sum.load (std::memory_order_relaxed);
+      for (auto b = 0U; b < pstore::metrics::num_buckets; ++b) {
+        sh.buckets[b] += th.buckets[b].load (std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // registry
+  // ~~~~~~~~
+  /// Records the blocks of the running threads and the totals of those which have exited.
+  class registry {
+  public:
+    static registry & get ();
+
+    void attach (thread_block * block);
+    /// Removes \p block from the list of running threads' blocks and adds its measurements to
+    /// the exited threads' totals.
+    void detach (thread_block * block);
+
+    snapshot collect () const;
+
+  private:
+    registry () = default;
+
+    mutable std::mutex mut_;
+    thread_block * first_ = nullptr;
+    snapshot exited_;
+  };
+
+  // get
+  // ~~~
+  registry & registry::get () {
+    static registry r;
+    return r;
+  }
+
+  // attach
+  // ~~~~~~
+  void registry::attach (thread_block * const block) {
+    std::scoped_lock<decltype (mut_)> const lock{mut_};
+    PSTORE_ASSERT (block->prev == nullptr && block->next == nullptr);
+    block->next = first_;
+    if (first_ != nullptr) {
+      first_->prev = block;
+    }
+    first_ = block;
+  }
+
+  // detach
+  // ~~~~~~
+  void registry::detach (thread_block * const block) {
+    std::scoped_lock<decltype (mut_)> const lock{mut_};
+    accumulate (&exited_, *block);
+    if (block->prev != nullptr) {
+      block->prev->next = block->next;
+    } else {
+      PSTORE_ASSERT (first_ == block);
+      first_ = block->next;
+    }
+    if (block->next != nullptr) {
+      block->next->prev = block->prev;
+    }
+    block->prev = block->next = nullptr;
+  }
+
+  // collect
+  // ~~~~~~~
+  snapshot registry::collect () const {
+    std::scoped_lock<decltype (mut_)> const lock{mut_};
+    snapshot result = exited_;
+    for (thread_block const * block = first_; block != nullptr; block = block->next) {
+      accumulate (&result, *block);
+    }
+    return result;
+  }
+
+  // thread registration
+  // ~~~~~~~~~~~~~~~~~~~
+  /// Owns a thread's block and keeps it in the registry for the lifetime of the thread.
+  class thread_registration {
+  public:
+    thread_registration () { registry::get ().attach (&block_); }
+    thread_registration (thread_registration const &) = delete;
+    thread_registration (thread_registration &&) noexcept = delete;
+    ~thread_registration () noexcept { registry::get ().detach (&block_); }
+
+    thread_registration & operator= (thread_registration const &) = delete;
+    thread_registration & operator= (thread_registration &&) noexcept = delete;
+
+    thread_block & block () noexcept { return block_; }
+
+  private:
+    thread_block block_;
+  };
+
+} // end anonymous namespace
+
+namespace pstore::metrics {
+
+  // name
+  // ~~~~
+  gsl::czstring name (counter const c) noexcept {
+    switch (c) {
+    case counter::regions_mapped: return "regions_mapped";
+    case counter::bytes_mapped: return "bytes_mapped";
+    case counter::spanning_reads: return "spanning_reads";
+    case counter::spanning_bytes: return "spanning_bytes";
+    case counter::hamt_node_loads: return "hamt_node_loads";
+    case counter::index_cache_hits: return "index_cache_hits";
+    case counter::index_cache_misses: return "index_cache_misses";
+    case counter::broker_commands: return "broker_commands";
+    case counter::last: break;
+    }
+    PSTORE_ASSERT (false);
+    return "unknown";
+  }
+
+  gsl::czstring name (histogram const h) noexcept {
+    switch (h) {
+    case histogram::allocation_bytes: return "allocation_bytes";
+    case histogram::commit_indices_ns: return "commit_indices_ns";
+    case histogram::commit_trailer_ns: return "commit_trailer_ns";
+    case histogram::commit_publish_ns: return "commit_publish_ns";
+    case histogram::commit_protect_ns: return "commit_protect_ns";
+    case histogram::last: break;
+    }
+    PSTORE_ASSERT (false);
+    return "unknown";
+  }
+
+  namespace details {
+
+    // this thread
+    // ~~~~~~~~~~~
+    thread_block & this_thread () noexcept {
+      thread_local thread_registration registration;
+      return registration.block ();
+    }
+
+  } // end namespace details
+
+  // collect
+  // ~~~~~~~
+  snapshot collect () { return registry::get ().collect (); }
+
+  // to json
+  // ~~~~~~~
+  std::string to_json (snapshot const & s) {
+    std::ostringstream os;
+    os << R"({ "counters": {)";
+    auto const * separator = " ";
+    for (auto c = 0U; c < num_counters; ++c) {
+      os << separator << '"' << name (static_cast<counter> (c)) << "\": " << s.counters[c];
+      separator = ", ";
+    }
+    os << R"( }, "histograms": {)";
+    separator = " ";
+    for (auto h = 0U; h < num_histograms; ++h) {
+      histogram_snapshot const & hs = s.histograms[h];
+      os << separator << '"' << name (static_cast<histogram> (h)) << R"(": { "count": )"
+         << hs.count << R"(, "sum": )" << hs.sum << R"(, "buckets": {)";
+      auto const * bucket_separator = " ";
+      for (auto b = 0U; b < num_buckets; ++b) {
+        if (hs.buckets[b] != 0U) {
+          std::uint64_t const lower = b == 0U ? 0U : std::uint64_t{1} << (b - 1U);
+          os << bucket_separator << '"' << lower << "\": " << hs.buckets[b];
+          bucket_separator = ", ";
+        }
+      }
+      os << " } }";
+      separator = ", ";
+    }
+    os << " } }";
+    return os.str ();
+  }
+
+} // end namespace pstore::metrics
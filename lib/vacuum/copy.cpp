@@ -17,16 +17,26 @@
 
 #include "pstore/vacuum/copy.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <optional>
 #include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "pstore/core/file_header.hpp"
 #include "pstore/core/hamt_map.hpp"
 #include "pstore/core/index_types.hpp"
 #include "pstore/os/logging.hpp"
 #include "pstore/os/thread.hpp"
+#include "pstore/support/error.hpp"
 #include "pstore/support/portab.hpp"
+#include "pstore/vacuum/incremental.hpp"
 #include "pstore/vacuum/status.hpp"
 #include "pstore/vacuum/user_options.hpp"
 #include "pstore/vacuum/watch.hpp"
@@ -45,16 +55,26 @@ namespace {
 
   // Tell the "watch" thread to start monitoring the store for changes.
   void start_watching (std::shared_ptr<pstore::database> const & source,
-                       vacuum::status * const st) {
+                       vacuum::status * const st,
+                       unsigned const revision = pstore::head_revision) {
     auto & wst = vacuum::wst;
     std::scoped_lock<decltype (wst.start_watch_mutex)> const lock{wst.start_watch_mutex};
-    source->sync ();
+    source->sync (revision);
     wst.start_watch = true;
     st->modified = false;
     wst.start_watch_cv.notify_one ();
   }
 
 
+  // Syncs the source to its head revision and returns that revision.
+  unsigned sync_to_head (pstore::database & source) {
+    auto & wst = vacuum::wst;
+    std::scoped_lock<decltype (wst.start_watch_mutex)> const lock{wst.start_watch_mutex};
+    source.sync ();
+    return source.get_current_revision ();
+  }
+
+
   void precopy_delay (vacuum::status * const st) {
     auto & wst = vacuum::wst;
     using priority = pstore::logger::priority;
@@ -73,11 +93,177 @@ namespace {
     }
   }
 
+
+  // Makes a byte-for-byte copy of the file at from_path. Where possible, the kernel copies
+  // the data without it passing through this process.
+  void copy_file (std::string const & from_path, std::string const & to_path) {
+    using pstore::file::file_handle;
+    file_handle from{from_path};
+    from.open (file_handle::create_mode::open_existing, file_handle::writable_mode::read_only);
+    file_handle to{to_path};
+    to.open (file_handle::create_mode::open_always, file_handle::writable_mode::read_write);
+    to.truncate (0U);
+
+    std::uint64_t const size = from.size ();
+    std::uint64_t done = pstore::file::copy_range (from, 0U, to, 0U, size);
+    if (done < size) {
+      std::vector<std::byte> buffer (
+        static_cast<std::size_t> (std::min (size - done, std::uint64_t{1024 * 1024})));
+      from.seek (done);
+      to.seek (done);
+      while (done < size) {
+        auto const chunk = static_cast<std::size_t> (std::min (size - done,
+                                                               std::uint64_t{buffer.size ()}));
+        auto const span = pstore::gsl::make_span (buffer.data (), chunk);
+        if (from.read_span (span) != chunk) {
+          pstore::raise (pstore::error_code::did_not_read_number_of_bytes_requested);
+        }
+        to.write_span (span);
+        done += chunk;
+      }
+    }
+  }
+
 } // end anonymous namespace
 
 namespace vacuum {
 
-  void copy (std::shared_ptr<pstore::database> source, status * const st,
+  // replace source
+  // ~~~~~~~~~~~~~~
+  bool replace_source (std::shared_ptr<pstore::database> & source,
+                       std::unique_lock<pstore::file::range_lock> & lock,
+                       std::string const & destination_path, unsigned const revision,
+                       status * const st) {
+    using priority = pstore::logger::priority;
+    std::string const source_path = source->path ();
+    {
+      // The watch thread uses the source and the lock only whilst it holds start_watch_mutex.
+      std::scoped_lock<decltype (wst.start_watch_mutex)> const mlock{wst.start_watch_mutex};
+      // Whilst the exclusive lock is held no other process has the store open and any which
+      // tries to open it must wait: the source cannot gain a revision before it is replaced.
+      if (!lock.try_lock ()) {
+        log (priority::notice, "Store is open in another process: not replaced.");
+        return false;
+      }
+      source->sync ();
+      if (source->get_current_revision () != revision) {
+        lock.unlock ();
+        log (priority::notice, "Store was modified after vacuuming: not replaced.");
+        return false;
+      }
+      if (std::rename (destination_path.c_str (), source_path.c_str ()) != 0) {
+        int const err = errno;
+        lock.unlock ();
+        pstore::raise (pstore::errno_erc{err}, "rename");
+      }
+      lock.unlock ();
+    }
+
+    log (priority::notice, "Vacuuming complete");
+    stop (st);
+    while (st->watch_running) {
+      std::this_thread::sleep_for (std::chrono::microseconds (10));
+    }
+
+    // TODO: wait for the watch thread to close its connection to the source store.
+
+    // assert that there's a single reference to the source pointer.
+    source.reset ();
+    return true;
+  }
+
+  // copy incremental
+  // ~~~~~~~~~~~~~~~~
+  bool copy_incremental (std::shared_ptr<pstore::database> const & source,
+                         std::string const & destination_path, status * const st,
+                         checkpoint * const cp) {
+    using priority = pstore::logger::priority;
+    std::string const cp_path = checkpoint_path (destination_path);
+
+    std::optional<checkpoint> previous;
+    if (pstore::file::exists (destination_path)) {
+      previous = read_checkpoint (cp_path, source->get_header ().id ());
+    }
+    source->sync ();
+    if (previous && previous->target_revision <= source->get_current_revision ()) {
+      *cp = *previous;
+    } else {
+      // There's no usable record of earlier progress: start again with an empty store.
+      log (priority::notice, "Starting a new incremental vacuum");
+      pstore::file::unlink (destination_path, true /*allow_noent*/);
+      *cp = checkpoint{source->get_header ().id ()};
+    }
+
+    // A partially complete copy must be finished using the revision with which it began.
+    start_watching (source, st,
+                    cp->stage == phase::complete ? pstore::head_revision : cp->target_revision);
+
+    auto destination = std::make_unique<pstore::database> (
+      destination_path, pstore::database::access_mode::writable);
+    destination->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+
+    auto const copy_to_target = [&] () {
+      log (priority::notice, "Copying to revision ", cp->target_revision);
+      write_checkpoint (cp_path, *cp);
+      return copy_generations (
+        *source, *destination, cp,
+        [&cp_path] (checkpoint const & c) { write_checkpoint (cp_path, c); },
+        [st] () -> bool { return st->modified || st->done; });
+    };
+
+    if (cp->stage == phase::complete) {
+      start_generation (cp, *source, *destination);
+    }
+    bool complete = copy_to_target ();
+    // The watch thread does not report revisions that were added before the copy resumed (or
+    // in the same second as it began) so go on to copy anything newer than the target.
+    while (complete && !st->modified && sync_to_head (*source) != cp->target_revision) {
+      start_generation (cp, *source, *destination);
+      complete = copy_to_target ();
+    }
+    destination->close ();
+
+    if (!complete || st->modified) {
+      log (priority::notice, "Store was modified during vacuuming: progress saved.");
+      return false;
+    }
+    return true;
+  }
+
+  // replace source incremental
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~
+  bool replace_source_incremental (std::shared_ptr<pstore::database> & source,
+                                   std::unique_lock<pstore::file::range_lock> & lock,
+                                   std::string const & destination_path, checkpoint const & cp,
+                                   status * const st) {
+    // After the swap, the vacuumed store is the source. A copy of it is kept as the destination
+    // of the next incremental vacuum, along with a checkpoint which records that every one of
+    // its revisions has been copied.
+    checkpoint next;
+    {
+      pstore::database const copied{destination_path, pstore::database::access_mode::read_only};
+      next = checkpoint{copied.get_header ().id ()};
+      next.base_revision = copied.get_current_revision ();
+      next.target_revision = next.base_revision;
+      next.destination_revision = next.base_revision;
+    }
+    std::string const next_path = destination_path + ".next";
+    copy_file (destination_path, next_path);
+
+    if (!replace_source (source, lock, destination_path, cp.target_revision, st)) {
+      pstore::file::unlink (next_path, true /*allow_noent*/);
+      return false;
+    }
+    if (pstore::file::file_handle{next_path}.rename (destination_path)) {
+      write_checkpoint (checkpoint_path (destination_path), next);
+    } else {
+      pstore::file::unlink (next_path, true /*allow_noent*/);
+    }
+    return true;
+  }
+
+  void copy (std::shared_ptr<pstore::database> source,
+             std::unique_lock<pstore::file::range_lock> & lock, status * const st,
              user_options const & opt) {
     pstore::threads::set_name ("copy");
     pstore::create_log_stream ("vacuumd");
@@ -97,14 +283,26 @@ namespace vacuum {
 
         log (priority::notice, "Collecting...");
 
+        std::string const destination_path = source->path () + ".gc";
+        if (opt.incremental) {
+          checkpoint cp;
+          if (copy_incremental (source, destination_path, st, &cp) &&
+              !replace_source_incremental (source, lock, destination_path, cp, st)) {
+            // Give whatever prevented the swap a chance to finish before trying again.
+            std::this_thread::sleep_for (watch_interval);
+          }
+          continue;
+        }
+
         // Tell the "watch" thread to start monitoring the store for changes.
         start_watching (source, st);
+        unsigned const revision = source->get_current_revision ();
 
         bool copy_aborted = false;
         // TODO: a new constructor to make a uniquely named file in the same directory as
         // 'from'
         auto destination = std::make_unique<pstore::database> (
-          source->path () + ".gc", pstore::database::access_mode::writable);
+          destination_path, pstore::database::access_mode::writable);
 
         // We don't want our pristine new store to be vacuumed; it doesn't need it.
         destination->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
@@ -127,13 +325,10 @@ namespace vacuum {
             std::string const & key = kvp.first;
             pstore::extent<char> const & extent = kvp.second;
 
-            pstore::address const addr = transaction.allocate (extent.size, 1 /*align*/);
-            // Copy from the source file to the data store.
-            std::memcpy (transaction.getrw (addr, extent.size).get (),
-                         source->getro (extent).get (), extent.size);
-
+            // Copy from the source file to the data store. Where possible the kernel moves the
+            // data between the two files without it passing through this process.
             destination_names->insert_or_assign (
-              transaction, key, make_extent (pstore::typed_address<char> (addr), extent.size));
+              transaction, key, transaction.copy_from (*source, extent, 1U /*align*/));
 
             // Has the watch thread asked us to abort the copy?
             if (st->modified) {
@@ -153,21 +348,11 @@ namespace vacuum {
         }
 
         if (!copy_aborted) {
-          log (priority::notice, "Vacuuming complete");
-          stop (st);
-          while (st->watch_running) {
-            std::this_thread::sleep_for (std::chrono::microseconds (10));
-          }
-
-          // TODO: wait for the watch thread to close its connection to the source store.
-
-          pstore::file::file_handle destination_file{destination->path ()};
-          std::string const source_path = source->path ();
           destination.reset (); // Close the target data store
-          // assert that there's a single reference to the source pointer.
-          source.reset ();
-
-          destination_file.rename (source_path);
+          if (!replace_source (source, lock, destination_path, revision, st)) {
+            // The copy is out of date: start again.
+            pstore::file::unlink (destination_path, true /*allow_noent*/);
+          }
         }
       }
     }
@@ -0,0 +1,500 @@
+//===- lib/vacuum/incremental.cpp -----------------------------------------===//
+//*  _                                          _        _  *
+//* (_)_ __   ___ _ __ ___ _ __ ___   ___ _ __ | |_ __ _| | *
+//* | | '_ \ / __| '__/ _ \ '_ ` _ \ / _ \ '_ \| __/ _` | | *
+//* | | | | | (__| | |  __/ | | | | |  __/ | | | || (_| | | *
+//* |_|_| |_|\___|_|  \___|_| |_| |_|\___|_| |_|\__\__,_|_| *
+//*                                                         *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file incremental.cpp
+
+#include "pstore/vacuum/incremental.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include "pstore/core/crc32.hpp"
+#include "pstore/core/database.hpp"
+#include "pstore/core/diff.hpp"
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/hamt_set.hpp"
+#include "pstore/core/index_types.hpp"
+#include "pstore/core/indirect_string.hpp"
+#include "pstore/core/transaction.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/os/file.hpp"
+#include "pstore/support/error.hpp"
+
+namespace {
+
+  using pstore::address;
+  using pstore::extent;
+  using pstore::typed_address;
+  using pstore::index::digest;
+  namespace repo = pstore::repo;
+
+  /// Returns the first address written by the revision which follows \p revision. Index
+  /// entries at or above this address were added after \p revision.
+  address first_address_after (pstore::database const & db, unsigned const revision) {
+    return (db.older_revision_footer_pos (revision) + 1).to_address ();
+  }
+
+  /// Copies individual index entries from the source store to the destination, rewriting the
+  /// store addresses that they contain so that they refer to the copies.
+  class relocator {
+  public:
+    relocator (pstore::database const & source, pstore::database & destination,
+               vacuum::checkpoint const & cp);
+
+    /// Returns the addresses of the leaves that were added to the index associated with
+    /// \p stage between the base and target revisions.
+    std::vector<address> new_entries (vacuum::phase stage) const;
+
+    /// Copies the index entry whose leaf is at \p addr in the source store.
+    void copy (pstore::transaction_base & transaction, vacuum::phase stage, address addr);
+
+    /// Writes the bodies of any strings added by copy(). Must be called before the
+    /// transaction is committed.
+    void flush (pstore::transaction_base & transaction);
+
+  private:
+    template <pstore::trailer::indices Index>
+    void copy_string (pstore::transaction_base & transaction, address addr);
+    void copy_debug_line_header (pstore::transaction_base & transaction, address addr);
+    void copy_write (pstore::transaction_base & transaction, address addr);
+
+    /// Ensures that the fragment with the given digest is present in the destination.
+    /// \returns The extent of the destination's copy of the fragment.
+    extent<repo::fragment> fragment (pstore::transaction_base & transaction, digest const & d);
+    /// Ensures that the compilation with the given digest is present in the destination.
+    /// \returns The extent of the destination's copy of the compilation.
+    extent<repo::compilation> compilation (pstore::transaction_base & transaction,
+                                           digest const & d);
+
+    void patch (pstore::transaction_base & transaction, repo::generic_section * s);
+    void patch (pstore::transaction_base & transaction, repo::debug_line_section * s);
+    void patch (pstore::transaction_base &, repo::bss_section *) {}
+    void patch (pstore::transaction_base & transaction, repo::linked_definitions * s);
+
+    /// Maps the address of a name in the source store to the address of its copy.
+    typed_address<pstore::indirect_string> name (typed_address<pstore::indirect_string> src);
+
+    /// Looks for the entry with key \p d in the source and destination copies of an index.
+    /// \returns A pair containing the source's value and, if the destination does not
+    ///   already hold an up-to-date copy, true.
+    template <pstore::trailer::indices Index>
+    auto lookup (digest const & d) const
+      -> std::pair<typename pstore::index::enum_to_index<Index>::type::mapped_type, bool>;
+
+    pstore::database const & source_;
+    pstore::database & destination_;
+    unsigned const base_revision_;
+    /// Source addresses at or above this value were written after the base revision.
+    address const source_threshold_;
+    /// Destination addresses at or above this value were written by this generation.
+    address const destination_threshold_;
+
+    std::unordered_map<address, typed_address<pstore::indirect_string>> names_;
+    pstore::indirect_string_adder adder_;
+    // The strings added to adder_ must remain valid until flush() is called.
+    std::deque<pstore::shared_sstring_view> owners_;
+    std::deque<pstore::raw_sstring_view> views_;
+  };
+
+  // ctor
+  // ~~~~
+  relocator::relocator (pstore::database const & source, pstore::database & destination,
+                        vacuum::checkpoint const & cp)
+          : source_{source}
+          , destination_{destination}
+          , base_revision_{cp.base_revision}
+          , source_threshold_{first_address_after (source, cp.base_revision)}
+          , destination_threshold_{first_address_after (destination, cp.destination_revision)} {}
+
+  // new entries
+  // ~~~~~~~~~~~
+  std::vector<address> relocator::new_entries (vacuum::phase const stage) const {
+    using pstore::trailer;
+    std::vector<address> result;
+    auto const collect = [&] (auto const & index) {
+      if (index != nullptr) {
+        pstore::diff (source_, *index, base_revision_, std::back_inserter (result));
+      }
+    };
+    switch (stage) {
+    case vacuum::phase::names:
+      collect (pstore::index::get_index<trailer::indices::name> (source_, false));
+      break;
+    case vacuum::phase::paths:
+      collect (pstore::index::get_index<trailer::indices::path> (source_, false));
+      break;
+    case vacuum::phase::debug_line_headers:
+      collect (pstore::index::get_index<trailer::indices::debug_line_header> (source_, false));
+      break;
+    case vacuum::phase::write:
+      collect (pstore::index::get_index<trailer::indices::write> (source_, false));
+      break;
+    case vacuum::phase::fragments:
+      collect (pstore::index::get_index<trailer::indices::fragment> (source_, false));
+      break;
+    case vacuum::phase::compilations:
+      collect (pstore::index::get_index<trailer::indices::compilation> (source_, false));
+      break;
+    case vacuum::phase::complete: break;
+    }
+    return result;
+  }
+
+  // copy
+  // ~~~~
+  void relocator::copy (pstore::transaction_base & transaction, vacuum::phase const stage,
+                        address const addr) {
+    using pstore::trailer;
+    switch (stage) {
+    case vacuum::phase::names:
+      this->copy_string<trailer::indices::name> (transaction, addr);
+      break;
+    case vacuum::phase::paths:
+      this->copy_string<trailer::indices::path> (transaction, addr);
+      break;
+    case vacuum::phase::debug_line_headers: this->copy_debug_line_header (transaction, addr); break;
+    case vacuum::phase::write: this->copy_write (transaction, addr); break;
+    case vacuum::phase::fragments: {
+      auto const fragments = pstore::index::get_index<trailer::indices::fragment> (source_, false);
+      this->fragment (transaction, fragments->load_leaf (source_, addr).first);
+    } break;
+    case vacuum::phase::compilations: {
+      auto const compilations =
+        pstore::index::get_index<trailer::indices::compilation> (source_, false);
+      this->compilation (transaction, compilations->load_leaf (source_, addr).first);
+    } break;
+    case vacuum::phase::complete: PSTORE_ASSERT (false && "Nothing to copy"); break;
+    }
+  }
+
+  // flush
+  // ~~~~~
+  void relocator::flush (pstore::transaction_base & transaction) {
+    adder_.flush (transaction);
+    views_.clear ();
+    owners_.clear ();
+  }
+
+  // copy string
+  // ~~~~~~~~~~~
+  template <pstore::trailer::indices Index>
+  void relocator::copy_string (pstore::transaction_base & transaction, address const addr) {
+    pstore::indirect_string const str =
+      pstore::index::get_index<Index> (source_, false)->load_leaf (source_, addr);
+    owners_.emplace_back ();
+    views_.push_back (str.as_db_string_view (&owners_.back ()));
+    auto const pos =
+      adder_.add (transaction, pstore::index::get_index<Index> (destination_), &views_.back ())
+        .first;
+    if (Index == pstore::trailer::indices::name) {
+      names_[addr] = typed_address<pstore::indirect_string> (pos.get_address ());
+    }
+  }
+
+  // copy debug line header
+  // ~~~~~~~~~~~~~~~~~~~~~~
+  void relocator::copy_debug_line_header (pstore::transaction_base & transaction,
+                                          address const addr) {
+    using pstore::trailer;
+    auto const kvp = pstore::index::get_index<trailer::indices::debug_line_header> (source_, false)
+                       ->load_leaf (source_, addr);
+    pstore::index::get_index<trailer::indices::debug_line_header> (destination_)
+      ->insert_or_assign (transaction, kvp.first, transaction.copy_from (source_, kvp.second, 1U));
+  }
+
+  // copy write
+  // ~~~~~~~~~~
+  void relocator::copy_write (pstore::transaction_base & transaction, address const addr) {
+    using pstore::trailer;
+    auto const kvp =
+      pstore::index::get_index<trailer::indices::write> (source_, false)->load_leaf (source_, addr);
+    pstore::index::get_index<trailer::indices::write> (destination_)
+      ->insert_or_assign (transaction, kvp.first, transaction.copy_from (source_, kvp.second, 1U));
+  }
+
+  // lookup
+  // ~~~~~~
+  template <pstore::trailer::indices Index>
+  auto relocator::lookup (digest const & d) const
+    -> std::pair<typename pstore::index::enum_to_index<Index>::type::mapped_type, bool> {
+    auto const src = pstore::index::get_index<Index> (source_, false);
+    auto const dest = pstore::index::get_index<Index> (destination_, false);
+    auto const src_pos = src->find (source_, d);
+    if (src_pos == src->cend (source_)) {
+      pstore::raise (pstore::error_code::index_corrupt);
+    }
+    if (dest != nullptr) {
+      auto const dest_pos = dest->find (destination_, d);
+      if (dest_pos != dest->cend (destination_)) {
+        // If the destination's entry was written during this generation or the source's
+        // entry predates it, then the destination is up to date.
+        if (dest_pos.get_address () >= destination_threshold_ ||
+            src_pos.get_address () < source_threshold_) {
+          return {dest_pos->second, false};
+        }
+      }
+    }
+    if (src_pos.get_address () < source_threshold_) {
+      // An old entry that was never copied: the source store is inconsistent.
+      pstore::raise (pstore::error_code::index_corrupt);
+    }
+    return {src_pos->second, true};
+  }
+
+  // fragment
+  // ~~~~~~~~
+  extent<repo::fragment> relocator::fragment (pstore::transaction_base & transaction,
+                                              digest const & d) {
+    using pstore::trailer;
+    auto const [src_extent, copy_needed] = this->lookup<trailer::indices::fragment> (d);
+    if (!copy_needed) {
+      return src_extent;
+    }
+
+    extent<repo::fragment> const fext =
+      transaction.copy_from (source_, src_extent, alignof (repo::fragment));
+    // Record the copy before patching it: the fragment's linked definitions may lead back to
+    // a compilation which refers to this fragment.
+    pstore::index::get_index<trailer::indices::fragment> (destination_)
+      ->insert_or_assign (transaction, d, fext);
+
+    std::shared_ptr<repo::fragment> const f = repo::fragment::load (transaction, fext);
+    for (repo::section_kind const kind : *f) {
+#define X(a)                                                                                       \
+  case repo::section_kind::a: this->patch (transaction, &f->at<repo::section_kind::a> ()); break;
+      switch (kind) {
+        PSTORE_MCREPO_SECTION_KINDS
+      case repo::section_kind::last: PSTORE_ASSERT (false && "Illegal section kind"); break;
+      }
+#undef X
+    }
+    return fext;
+  }
+
+  // compilation
+  // ~~~~~~~~~~~
+  extent<repo::compilation> relocator::compilation (pstore::transaction_base & transaction,
+                                                    digest const & d) {
+    using pstore::trailer;
+    auto const [src_extent, copy_needed] = this->lookup<trailer::indices::compilation> (d);
+    if (!copy_needed) {
+      return src_extent;
+    }
+
+    std::shared_ptr<repo::compilation const> const src =
+      repo::compilation::load (source_, src_extent);
+    std::vector<repo::definition> definitions;
+    definitions.reserve (src->size ());
+    for (repo::definition const & def : *src) {
+      definitions.emplace_back (def.digest, this->fragment (transaction, def.digest),
+                                this->name (def.name), def.linkage (), def.visibility ());
+    }
+
+    auto const compilations = pstore::index::get_index<trailer::indices::compilation> (
+      destination_);
+    // Copying a fragment may have led to this compilation being copied through the fragment's
+    // linked definitions. If so, use that copy.
+    auto const pos = compilations->find (destination_, d);
+    if (pos != compilations->cend (destination_) &&
+        pos.get_address () >= destination_threshold_) {
+      return pos->second;
+    }
+    extent<repo::compilation> const cext =
+      repo::compilation::alloc (transaction, this->name (src->triple ()),
+                                std::begin (definitions), std::end (definitions));
+    compilations->insert_or_assign (transaction, d, cext);
+    return cext;
+  }
+
+  // patch
+  // ~~~~~
+  void relocator::patch (pstore::transaction_base &, repo::generic_section * const s) {
+    for (repo::external_fixup & xfx : s->xfixups_span ()) {
+      xfx.name = this->name (xfx.name);
+    }
+  }
+  void relocator::patch (pstore::transaction_base & transaction,
+                         repo::debug_line_section * const s) {
+    using pstore::trailer;
+    auto const headers =
+      pstore::index::get_index<trailer::indices::debug_line_header> (destination_, false);
+    if (headers == nullptr) {
+      pstore::raise (pstore::error_code::index_corrupt);
+    }
+    auto const pos = headers->find (destination_, s->header_digest ());
+    if (pos == headers->cend (destination_)) {
+      pstore::raise (pstore::error_code::index_corrupt);
+    }
+    s->set_header_extent (pos->second);
+    this->patch (transaction, &s->generic ());
+  }
+  void relocator::patch (pstore::transaction_base & transaction,
+                         repo::linked_definitions * const s) {
+    for (repo::linked_definitions::value_type & l : *s) {
+      extent<repo::compilation> const c = this->compilation (transaction, l.compilation);
+      l.pointer = repo::compilation::index_address (c.addr, l.index);
+    }
+  }
+
+  // name
+  // ~~~~
+  typed_address<pstore::indirect_string>
+  relocator::name (typed_address<pstore::indirect_string> const src) {
+    auto const pos = names_.find (src.to_address ());
+    if (pos != names_.end ()) {
+      return pos->second;
+    }
+    // The string was copied by an earlier generation: find it by value.
+    pstore::shared_sstring_view owner;
+    pstore::raw_sstring_view const view = pstore::get_sstring_view (source_, src, &owner);
+    auto const names =
+      pstore::index::get_index<pstore::trailer::indices::name> (destination_, false);
+    if (names == nullptr) {
+      pstore::raise (pstore::error_code::index_corrupt);
+    }
+    auto const it = names->find (destination_, pstore::indirect_string{destination_, &view});
+    if (it == names->cend (destination_)) {
+      pstore::raise (pstore::error_code::index_corrupt);
+    }
+    auto const result = typed_address<pstore::indirect_string> (it.get_address ());
+    names_.emplace (src.to_address (), result);
+    return result;
+  }
+
+  constexpr vacuum::phase next (vacuum::phase const stage) noexcept {
+    PSTORE_ASSERT (stage != vacuum::phase::complete);
+    return static_cast<vacuum::phase> (static_cast<std::underlying_type_t<vacuum::phase>> (stage) +
+                                       1U);
+  }
+
+} // end anonymous namespace
+
+namespace vacuum {
+
+  // get crc
+  // ~~~~~~~
+  std::uint32_t checkpoint::get_crc () const noexcept {
+    return pstore::crc32 (pstore::gsl::make_span (reinterpret_cast<std::uint8_t const *> (this),
+                                                  offsetof (checkpoint, crc)));
+  }
+
+  // is valid
+  // ~~~~~~~~
+  bool checkpoint::is_valid () const noexcept {
+    return signature == file_signature && stage <= phase::complete && crc == this->get_crc ();
+  }
+
+  // checkpoint path
+  // ~~~~~~~~~~~~~~~
+  std::string checkpoint_path (std::string const & destination_path) {
+    return destination_path + ".checkpoint";
+  }
+
+  // read checkpoint
+  // ~~~~~~~~~~~~~~~
+  std::optional<checkpoint> read_checkpoint (std::string const & path,
+                                             pstore::uuid const & source_id) {
+    using pstore::file::file_handle;
+    file_handle file{path};
+    file.open (file_handle::create_mode::open_existing, file_handle::writable_mode::read_only);
+    if (!file.is_open () || file.size () != sizeof (checkpoint)) {
+      return std::nullopt;
+    }
+    checkpoint cp;
+    file.read (&cp);
+    if (!cp.is_valid () || cp.source_id != source_id.array ()) {
+      return std::nullopt;
+    }
+    return cp;
+  }
+
+  // write checkpoint
+  // ~~~~~~~~~~~~~~~~
+  void write_checkpoint (std::string const & path, checkpoint const & cp) {
+    using pstore::file::file_handle;
+    checkpoint c = cp;
+    c.crc = c.get_crc ();
+    file_handle file{path};
+    file.open (file_handle::create_mode::open_always, file_handle::writable_mode::read_write);
+    file.seek (0);
+    file.write (c);
+    file.truncate (sizeof (c));
+  }
+
+  // start generation
+  // ~~~~~~~~~~~~~~~~
+  void start_generation (checkpoint * const cp, pstore::database const & source,
+                         pstore::database const & destination) {
+    PSTORE_ASSERT (cp->stage == phase::complete);
+    cp->base_revision = cp->target_revision;
+    cp->target_revision = source.get_current_revision ();
+    cp->destination_revision = destination.get_current_revision ();
+    cp->stage = cp->base_revision == cp->target_revision ? phase::complete : phase::names;
+    cp->done = 0;
+  }
+
+  // copy generations
+  // ~~~~~~~~~~~~~~~~
+  bool copy_generations (pstore::database const & source, pstore::database & destination,
+                         checkpoint * const cp,
+                         std::function<void (checkpoint const &)> const & save,
+                         std::function<bool ()> const & interrupted,
+                         std::size_t const batch_size) {
+    PSTORE_ASSERT (source.get_current_revision () == cp->target_revision);
+    PSTORE_ASSERT (batch_size > 0U);
+    relocator r{source, destination, *cp};
+    while (cp->stage != phase::complete) {
+      std::vector<address> const entries = r.new_entries (cp->stage);
+      // Skip the entries that were copied before an earlier pass was interrupted.
+      auto const skip = std::min (cp->done, static_cast<std::uint64_t> (entries.size ()));
+      auto first = std::begin (entries) + static_cast<std::ptrdiff_t> (skip);
+      auto const last = std::end (entries);
+      while (first != last) {
+        auto const batch_end =
+          first + std::min (static_cast<std::ptrdiff_t> (batch_size), std::distance (first, last));
+        bool stop = false;
+        auto transaction = pstore::begin (destination);
+        auto pos = first;
+        while (pos != batch_end && !stop) {
+          r.copy (transaction, cp->stage, *pos);
+          ++pos;
+          stop = interrupted ();
+        }
+        r.flush (transaction);
+        transaction.commit ();
+
+        cp->done += static_cast<std::uint64_t> (std::distance (first, pos));
+        save (*cp);
+        if (stop) {
+          return false;
+        }
+        first = pos;
+      }
+      cp->stage = next (cp->stage);
+      cp->done = 0;
+      save (*cp);
+      if (cp->stage != phase::complete && interrupted ()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+} // end namespace vacuum
@@ -19,28 +19,45 @@
 #include <string>
 
 #include "pstore/brokerface/fifo_path.hpp"
+#include "pstore/brokerface/ring_buffer.hpp"
 #include "pstore/brokerface/send_message.hpp"
 #include "pstore/brokerface/writer.hpp"
 #include "pstore/support/parallel_for_each.hpp"
 
 #include "iota_generator.hpp"
 
+namespace {
+
+  std::string flood_path (unsigned long const count) {
+    std::string path;
+    path.reserve (count);
+    for (auto ctr = 0UL; ctr <= count; ++ctr) {
+      path += ctr % 10 + '0';
+    }
+    return path;
+  }
+
+} // end anonymous namespace
+
 void flood_server (pstore::gsl::czstring pipe_path, std::chrono::milliseconds retry_timeout,
-                   unsigned long num) {
+                   unsigned long num, pstore::brokerface::ring_buffer * const ring) {
+  constexpr bool error_on_timeout = true;
+  if (ring != nullptr) {
+    pstore::parallel_for_each (
+      iota_generator (), iota_generator (num), [ring, retry_timeout] (unsigned long count) {
+        pstore::brokerface::send_message (*ring, error_on_timeout, "ECHO",
+                                          flood_path (count).c_str (), retry_timeout);
+      });
+    return;
+  }
+
   pstore::parallel_for_each (
     iota_generator (), iota_generator (num), [pipe_path, retry_timeout] (unsigned long count) {
       pstore::brokerface::fifo_path fifo (pipe_path, retry_timeout,
                                           pstore::brokerface::fifo_path::infinite_retries);
       pstore::brokerface::writer wr (fifo, retry_timeout,
                                      pstore::brokerface::writer::infinite_retries);
-
-      std::string path;
-      path.reserve (count);
-      for (auto ctr = 0UL; ctr <= count; ++ctr) {
-        path += ctr % 10 + '0';
-      }
-
-      constexpr bool error_on_timeout = true;
-      pstore::brokerface::send_message (wr, error_on_timeout, "ECHO", path.c_str ());
+      pstore::brokerface::send_message (wr, error_on_timeout, "ECHO",
+                                        flood_path (count).c_str ());
     });
 }
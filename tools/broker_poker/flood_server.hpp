@@ -20,7 +20,13 @@
 #include <chrono>
 #include "pstore/support/gsl.hpp"
 
+namespace pstore::brokerface {
+  class ring_buffer;
+} // end namespace pstore::brokerface
+
+/// Sends \p num ECHO messages to the broker concurrently. The messages are written to the
+/// broker's shared-memory ring buffer if \p ring is not null or to its FIFO otherwise.
 void flood_server (pstore::gsl::czstring pipe_path, std::chrono::milliseconds retry_timeout,
-                   unsigned long num);
+                   unsigned long num, pstore::brokerface::ring_buffer * ring);
 
 #endif // PSTORE_BROKER_POKER_FLOOD_SERVER_HPP
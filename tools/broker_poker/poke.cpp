@@ -23,6 +23,7 @@
 #include <cwchar>
 #include <string>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <vector>
 
@@ -37,6 +38,7 @@
 
 #include "pstore/brokerface/fifo_path.hpp"
 #include "pstore/brokerface/send_message.hpp"
+#include "pstore/brokerface/shared_ring.hpp"
 #include "pstore/brokerface/writer.hpp"
 #include "pstore/command_line/tchar.hpp"
 #include "pstore/config/config.hpp"
@@ -69,22 +71,51 @@ int main (int argc, char * argv[]) {
     pstore::gsl::czstring pipe_path =
       opt.pipe_path.has_value () ? opt.pipe_path.value ().c_str () : nullptr;
 
+    pstore::brokerface::fifo_path fifo (pipe_path, opt.retry_timeout,
+                                        pstore::brokerface::fifo_path::infinite_retries);
+
+    pstore::brokerface::ring_buffer * ring = nullptr;
+#ifdef _WIN32
+    if (opt.ring) {
+      pstore::command_line::error_stream
+        << PSTORE_NATIVE_TEXT ("The broker ring buffer is not supported on this platform.")
+        << std::endl;
+      return EXIT_FAILURE;
+    }
+#else
+    std::optional<pstore::brokerface::shared_ring> shared =
+      opt.ring ? pstore::brokerface::shared_ring::open (fifo) : std::nullopt;
+    if (opt.ring) {
+      if (!shared) {
+        pstore::command_line::error_stream
+          << PSTORE_NATIVE_TEXT ("The broker has not created a ring buffer.") << std::endl;
+        return EXIT_FAILURE;
+      }
+      ring = &shared->ring ();
+    }
+#endif
+
     if (opt.flood > 0) {
-      flood_server (pipe_path, opt.retry_timeout, opt.flood);
+      flood_server (pipe_path, opt.retry_timeout, opt.flood, ring);
     }
 
-    pstore::brokerface::fifo_path fifo (pipe_path, opt.retry_timeout,
-                                        pstore::brokerface::fifo_path::infinite_retries);
-    pstore::brokerface::writer wr (fifo, opt.retry_timeout,
-                                   pstore::brokerface::writer::infinite_retries);
+    auto send = [&] (pstore::gsl::czstring const verb, pstore::gsl::czstring const path) {
+      if (ring != nullptr) {
+        pstore::brokerface::send_message (*ring, error_on_timeout, verb, path, opt.retry_timeout);
+        return;
+      }
+      pstore::brokerface::writer wr (fifo, opt.retry_timeout,
+                                     pstore::brokerface::writer::infinite_retries);
+      pstore::brokerface::send_message (wr, error_on_timeout, verb, path);
+    };
 
     if (opt.verb.length () > 0) {
       char const * path_str = (opt.path.length () > 0) ? opt.path.c_str () : nullptr;
-      pstore::brokerface::send_message (wr, error_on_timeout, opt.verb.c_str (), path_str);
+      send (opt.verb.c_str (), path_str);
     }
 
     if (opt.kill) {
-      pstore::brokerface::send_message (wr, error_on_timeout, "SUICIDE", nullptr);
+      send ("SUICIDE", nullptr);
     }
   }
   // clang-format off
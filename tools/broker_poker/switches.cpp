@@ -52,6 +52,9 @@ std::pair<switches, int> get_switches (int argc, tchar * argv[]) {
     name ("kill"), desc ("Ask the broker to quit after commands have been processed."));
   args.add<alias> (name ("k"), desc ("Alias for --kill"), aliasopt (kill));
 
+  auto & ring = args.add<bool_opt> (
+    name ("ring"), desc ("Send messages through the broker's shared-memory ring buffer."));
+
   auto & verb = args.add<string_opt> (positional, optional, usage ("[verb]"));
   auto & path = args.add<string_opt> (positional, optional, usage ("[path]"));
 
@@ -63,6 +66,7 @@ std::pair<switches, int> get_switches (int argc, tchar * argv[]) {
   result.retry_timeout = std::chrono::milliseconds (retry_timeout.get ());
   result.flood = flood.get ();
   result.kill = kill.get ();
+  result.ring = ring.get ();
   result.pipe_path = path_option (pipe_path.get ());
   return {result, EXIT_SUCCESS};
 }
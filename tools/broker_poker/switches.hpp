@@ -34,6 +34,8 @@ struct switches {
 
   unsigned flood = 0;
   bool kill = false;
+  /// Send messages through the broker's shared-memory ring buffer rather than its FIFO.
+  bool ring = false;
 };
 
 std::pair<switches, int> get_switches (int argc, pstore::command_line::tchar * argv[]);
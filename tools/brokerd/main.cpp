@@ -36,6 +36,8 @@ int main (int argc, char * argv[]) {
     return broker::exit_code;
   }
 
+  // The broker's threads log from their hot paths, so hand the writes to a background thread.
+  start_async_logging ();
   try {
     broker::exit_code = run_broker (opt);
   } catch (std::exception const & ex) {
@@ -45,6 +47,7 @@ int main (int argc, char * argv[]) {
     log (priority::error, "unknown error");
     broker::exit_code = EXIT_FAILURE;
   }
+  stop_async_logging ();
 
   return broker::exit_code;
 }
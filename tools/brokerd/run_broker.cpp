@@ -38,6 +38,7 @@
 #include "pstore/broker/uptime.hpp"
 #include "pstore/brokerface/fifo_path.hpp"
 #include "pstore/brokerface/message_type.hpp"
+#include "pstore/brokerface/shared_ring.hpp"
 #include "pstore/config/config.hpp"
 #include "pstore/http/server.hpp"
 #include "pstore/http/server_status.hpp"
@@ -94,6 +95,7 @@ namespace {
 
         http::channel_container channels{
           {"commits", http::channel_container_entry{&broker::commits_channel, &broker::commits_cv}},
+          {"metrics", http::channel_container_entry{&broker::metrics_channel, &broker::metrics_cv}},
           {"uptime", http::channel_container_entry{&broker::uptime_channel, &broker::uptime_cv}},
         };
 
@@ -115,10 +117,12 @@ namespace {
 
     std::vector<std::future<void>> futures;
 
-    futures.push_back (create_thread ([&fifo, commands] () {
-      thread_init ("command");
-      commands->thread_entry (fifo);
-    }));
+    for (auto ctr = 0U; ctr < commands->num_command_threads (); ++ctr) {
+      futures.push_back (create_thread ([ctr, &fifo, commands] () {
+        thread_init ("command"s + std::to_string (ctr));
+        commands->thread_entry (fifo);
+      }));
+    }
 
     futures.push_back (create_thread ([scav] () {
       thread_init ("scavenger");
@@ -149,6 +153,20 @@ namespace {
     return {p};
   }
 
+#ifndef _WIN32
+  // ring capacity
+  // ~~~~~~~~~~~~~
+  /// Converts the user's choice of ring buffer size (in KiB) to a permitted capacity.
+  std::size_t ring_capacity (unsigned const kib) {
+    using brokerface::ring_buffer;
+    auto capacity = ring_buffer::min_capacity;
+    while (capacity < std::size_t{kib} * 1024U && capacity < ring_buffer::max_capacity) {
+      capacity <<= 1U;
+    }
+    return capacity;
+  }
+#endif // _WIN32
+
   // get http server status
   // ~~~~~~~~~~~~~~~~~~~~~~
   /// Create an HTTP server_status object which reflects the user's choice of port.
@@ -187,6 +205,14 @@ int run_broker (switches const & opt) {
 
   brokerface::fifo_path fifo{opt.pipe_path.has_value () ? opt.pipe_path->c_str () : nullptr};
 
+#ifndef _WIN32
+  std::optional<brokerface::shared_ring> ring;
+  if (opt.ring_size > 0U && !opt.playback_path.has_value ()) {
+    log (priority::notice, "creating ring buffer");
+    ring.emplace (brokerface::shared_ring::create (fifo, ring_capacity (opt.ring_size)));
+  }
+#endif // _WIN32
+
   std::vector<std::future<void>> futures;
   std::thread quit;
 
@@ -195,10 +221,9 @@ int run_broker (switches const & opt) {
 
   log (priority::notice, "starting threads");
   {
-    auto commands = std::make_shared<broker::command_processor> (opt.num_read_threads, &http_status,
-                                                                 &uptime_done, opt.scavenge_time);
+    auto commands =
+      std::make_shared<broker::command_processor> (opt.scavenge_time, opt.num_command_threads);
     auto scav = std::make_shared<broker::scavenger> (commands);
-    commands->attach_scavenger (scav);
 
     quit = create_quit_thread (make_weak (commands), make_weak (scav), opt.num_read_threads,
                                &http_status, &uptime_done);
@@ -222,6 +247,14 @@ int run_broker (switches const & opt) {
           read_loop (fifo, record_file, commands);
         }));
       }
+#ifndef _WIN32
+      if (ring) {
+        futures.push_back (create_thread ([&ring, &record_file, commands] () {
+          thread_init ("ring");
+          ring_read_loop (ring->ring (), record_file, commands);
+        }));
+      }
+#endif // _WIN32
     }
   }
 
@@ -15,6 +15,7 @@
 //===----------------------------------------------------------------------===//
 #include "switches.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -52,6 +53,8 @@ std::pair<switches, int> get_switches (int const argc, tchar * argv[]) {
 
   auto & num_read_threads =
     args.add<unsigned_opt> ("read-threads"sv, desc{"The number of pipe reading threads"}, init{2U});
+  auto & num_command_threads = args.add<unsigned_opt> (
+    "command-threads"sv, desc{"The number of command processing threads"}, init{1U});
 
   auto & http_port = args.add<opt<std::uint16_t>> (
     "http-port"sv, desc{"The port on which to listen for HTTP connections"}, init{in_port_t{8080}},
@@ -69,6 +72,12 @@ std::pair<switches, int> get_switches (int const argc, tchar * argv[]) {
                                  "queue before being removed by the scavenger"},
                             init{4U * 60U * 60U});
 
+  auto & ring_size = args.add<unsigned_opt> (
+    "ring-size"sv,
+    desc{"The size in KiB of a shared-memory ring buffer through which clients may send "
+         "commands (0 disables the ring buffer)"},
+    init{0U}, meta{"size"});
+
   args.parse_args (argc, argv, "pstore broker agent");
 
   switches result;
@@ -76,9 +85,11 @@ std::pair<switches, int> get_switches (int const argc, tchar * argv[]) {
   result.record_path = path_option (record_path);
   result.pipe_path = path_option (pipe_path);
   result.num_read_threads = num_read_threads.get ();
+  result.num_command_threads = std::max (num_command_threads.get (), 1U);
   result.announce_http_port = announce_http_port.get ();
   result.http_port = disable_http ? std::optional<in_port_t> (std::nullopt)
                                   : std::optional<in_port_t> (http_port.get ());
   result.scavenge_time = std::chrono::seconds{scavenge_time.get ()};
+  result.ring_size = ring_size.get ();
   return {std::move (result), EXIT_SUCCESS};
 }
@@ -32,9 +32,13 @@ struct switches {
   std::optional<std::string> record_path;
   std::optional<std::string> pipe_path;
   unsigned num_read_threads = 2U;
+  /// The number of threads which execute commands.
+  unsigned num_command_threads = 1U;
   bool announce_http_port = false;
   std::optional<in_port_t> http_port;
   std::chrono::seconds scavenge_time;
+  /// The capacity (in KiB) of the shared-memory ring buffer. Zero disables the ring buffer.
+  unsigned ring_size = 0U;
 };
 
 std::pair<switches, int> get_switches (int argc, pstore::command_line::tchar * argv[]);
@@ -15,6 +15,12 @@
 //===----------------------------------------------------------------------===//
 
 #include <iostream>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#  include <fcntl.h>
+#  include <io.h>
+#endif
 
 #include "pstore/exchange/export.hpp"
 #include "pstore/core/database.hpp"
@@ -23,6 +29,22 @@
 using namespace pstore::command_line;
 using namespace std::string_view_literals;
 
+namespace {
+
+  void set_output_stream_to_binary (pstore::gsl::not_null<FILE *> const file) {
+#ifdef _MSC_VER
+    // Suppress the translation of line-feed characters into CR-LF combinations which would
+    // otherwise corrupt the binary output.
+    if (_setmode (_fileno (file), O_BINARY) == -1) {
+      throw std::runtime_error ("Cannot set stream to binary mode");
+    }
+#else
+    (void) file; // Avoid an unused argument warning.
+#endif
+  }
+
+} // end anonymous namespace
+
 #ifdef _WIN32
 int _tmain (int argc, TCHAR const * argv[]) {
 #else
@@ -38,12 +60,27 @@ int main (int argc, char * argv[]) {
       "no-comments"sv,
       desc{"Disable embedded comments. (Required for output to be ECMA-404 compliant.)"},
       init (false));
+    auto & parallel = args.add<bool_opt> (
+      "parallel"sv, desc{"Render the output using a pool of worker threads."}, init (false));
+    args.add<alias> ("j"sv, desc{"Alias for --parallel"}, aliasopt{parallel});
+    auto & binary = args.add<bool_opt> (
+      "binary"sv, desc{"Write the compact binary exchange format rather than JSON."},
+      init (false));
 
     args.parse_args (argc, argv, "pstore export utility\n");
 
     pstore::exchange::export_ns::ostream os{stdout};
-    pstore::database db{db_path.get (), pstore::database::access_mode::read_only};
-    pstore::exchange::export_ns::emit_database (db, os, !no_comments);
+    // The export visits the store from start to finish.
+    pstore::database db{db_path.get (), pstore::database::access_mode::read_only,
+                        pstore::mapping_policy{pstore::mapping_policy::access_pattern::sequential}};
+    if (binary) {
+      set_output_stream_to_binary (stdout);
+      pstore::exchange::export_ns::emit_database_binary (db, os);
+    } else if (parallel) {
+      pstore::exchange::export_ns::emit_database_parallel (db, os, !no_comments);
+    } else {
+      pstore::exchange::export_ns::emit_database (db, os, !no_comments);
+    }
     os.flush ();
   }
   // clang-format off
@@ -13,31 +13,155 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 //===----------------------------------------------------------------------===//
+#include <algorithm>
 #include <bitset>
+#include <stdexcept>
 
 #include "pstore/command_line/command_line.hpp"
 #include "pstore/command_line/revision_opt.hpp"
 #include "pstore/command_line/str_to_revision.hpp"
 #include "pstore/core/database.hpp"
+#include "pstore/exchange/import_binary.hpp"
+#include "pstore/exchange/import_pipeline.hpp"
 #include "pstore/exchange/import_root.hpp"
+#include "pstore/os/memory_mapper.hpp"
 
 using namespace pstore::command_line;
 using namespace std::string_literals;
+using namespace std::string_view_literals;
 
 namespace {
 
+  /// The number of bytes requested by each read of the input.
+  constexpr std::size_t chunk_size = 65535;
+  /// The number of chunks which may be read ahead of the parser when memory use is not
+  /// limited.
+  constexpr std::size_t read_ahead_chunks = 16;
+
   bool is_file_input (string_opt const & json_source) {
     return json_source.get_num_occurrences () > 0;
   }
 
   FILE * open_input (string_opt const & json_source) {
-    return is_file_input (json_source) ? std::fopen (json_source.get ().c_str (), "r") : stdin;
+    return is_file_input (json_source) ? std::fopen (json_source.get ().c_str (), "rb") : stdin;
   }
 
   std::string input_name (string_opt const & json_source) {
     return is_file_input (json_source) ? json_source.get () : "stdin"s;
   }
 
+  //*  _                   _          _                    *
+  //* (_)_ __  _ __  _   _| |_    ___| |_ __ _  __ _  ___  *
+  //* | | '_ \| '_ \| | | | __|  / __| __/ _` |/ _` |/ _ \ *
+  //* | | | | | |_) | |_| | |_   \__ \ || (_| | (_| |  __/ *
+  //* |_|_| |_| .__/ \__,_|\__|  |___/\__\__,_|\__, |\___| *
+  //*         |_|                              |___/       *
+  /// The source of the input to be parsed.
+  class input_stage {
+  public:
+    input_stage () noexcept = default;
+    input_stage (input_stage const &) = delete;
+    input_stage (input_stage &&) = delete;
+    virtual ~input_stage () noexcept = default;
+    input_stage & operator= (input_stage const &) = delete;
+    input_stage & operator= (input_stage &&) = delete;
+
+    /// Returns the next chunk of input. The chunk remains valid until the next call. An empty
+    /// chunk marks the end of the input.
+    virtual pstore::gsl::span<std::byte const> next () = 0;
+  };
+
+  /// Reads the input on the thread which parses it.
+  class stream_input final : public input_stage {
+  public:
+    explicit stream_input (FILE * const file)
+            : file_{file}
+            , buffer_ (chunk_size) {}
+
+    pstore::gsl::span<std::byte const> next () override {
+      if (std::feof (file_)) {
+        return {};
+      }
+      std::size_t const nread = std::fread (buffer_.data (), 1U, buffer_.size (), file_);
+      if (nread < buffer_.size () && std::ferror (file_)) {
+        throw std::runtime_error ("there was an error reading input");
+      }
+      return {buffer_.data (), static_cast<std::ptrdiff_t> (nread)};
+    }
+
+  private:
+    FILE * const file_;
+    std::vector<std::byte> buffer_;
+  };
+
+  /// Reads the input on a separate thread so that reading overlaps with parsing.
+  class read_ahead_input final : public input_stage {
+  public:
+    read_ahead_input (FILE * const file, std::size_t const max_chunks)
+            : reader_{file, chunk_size, max_chunks} {}
+
+    pstore::gsl::span<std::byte const> next () override { return reader_.next (); }
+
+  private:
+    pstore::exchange::import_ns::read_ahead reader_;
+  };
+
+  /// Memory-maps an input file so that it is parsed in place. The operating system reads
+  /// the file ahead of the parser.
+  class mapped_input final : public input_stage {
+  public:
+    explicit mapped_input (std::string const & path)
+            : file_{path} {
+      using pstore::file::file_handle;
+      file_.open (file_handle::create_mode::open_existing, file_handle::writable_mode::read_only,
+                  file_handle::present_mode::must_exist);
+      if (std::uint64_t const size = file_.size (); size > 0U) {
+        mapper_ = std::make_unique<pstore::memory_mapper> (
+          file_, false /*write enabled*/, 0U, size,
+          pstore::mapping_policy{pstore::mapping_policy::access_pattern::sequential});
+      }
+    }
+
+    pstore::gsl::span<std::byte const> next () override {
+      // The whole file is returned as a single chunk.
+      if (mapper_ == nullptr || done_) {
+        return {};
+      }
+      done_ = true;
+      return {std::static_pointer_cast<std::byte const> (mapper_->data ()).get (),
+              static_cast<std::ptrdiff_t> (mapper_->size ())};
+    }
+
+  private:
+    pstore::file::file_handle file_;
+    std::unique_ptr<pstore::memory_mapper> mapper_;
+    bool done_ = false;
+  };
+
+  /// Presents the input to \p parser beginning with \p chunk and continuing with the results
+  /// of calling input.next(). \p report is called to describe an error raised by the parser.
+  /// Returns true if the input was parsed successfully.
+  template <typename Parser, typename ReportFunction>
+  bool parse (pstore::gsl::span<std::byte const> chunk, input_stage & input, Parser & parser,
+              ReportFunction report) {
+    for (;;) {
+      if (chunk.empty ()) {
+        parser.eof ();
+        if (parser.has_error ()) {
+          report (parser);
+          return false;
+        }
+        return true;
+      }
+      parser.input (chunk.data (), chunk.data () + chunk.size ());
+      if (parser.has_error ()) {
+        report (parser);
+        return false;
+      }
+      chunk = input.next ();
+    }
+  }
+
 } // end anonymous namespace
 
 #ifdef _WIN32
@@ -54,6 +178,18 @@ int main (int argc, char * argv[]) {
     auto & json_source = args.add<string_opt> (
       positional, usage ("[input]"), desc ("The export file to be read (stdin if not specified)."));
 
+    auto & pipeline = args.add<bool_opt> (
+      "pipeline"sv,
+      desc ("Read, parse, and store the input on separate threads. The input file is "
+            "memory-mapped unless --max-memory is specified."),
+      init (false));
+    args.add<alias> ("j"sv, desc ("Alias for --pipeline"), aliasopt{pipeline});
+    auto & max_memory_mib = args.add<unsigned_opt> (
+      "max-memory"sv,
+      desc ("Limit the memory used to hold data passing between the stages of the pipeline "
+            "(in MiB). 0 means no limit."),
+      init (0U), meta ("MiB"));
+
     args.parse_args (argc, argv, "pstore import utility\n");
 
     if (pstore::file::exists (db_path.get ())) {
@@ -79,41 +215,49 @@ int main (int argc, char * argv[]) {
       return EXIT_FAILURE;
     }
 
-    auto parser = pstore::exchange::import_ns::create_parser (db);
-
-    std::vector<std::uint8_t> buffer;
-    buffer.resize (65535);
+    // When memory use is limited, half of the budget goes to buffering the input and half to
+    // records waiting to be stored.
+    std::size_t const max_memory = std::size_t{max_memory_mib.get ()} << 20U;
+    std::unique_ptr<input_stage> input;
+    if (!pipeline) {
+      input = std::make_unique<stream_input> (infile.get ());
+    } else if (is_file_input (json_source) && max_memory == 0U) {
+      input = std::make_unique<mapped_input> (json_source.get ());
+    } else {
+      input = std::make_unique<read_ahead_input> (
+        infile.get (), max_memory == 0U ? read_ahead_chunks
+                                        : std::max (max_memory / 2U / chunk_size, std::size_t{1}));
+    }
 
-    for (;;) {
-      auto * const ptr = reinterpret_cast<std::byte *> (buffer.data ());
-      std::size_t const nread =
-        std::fread (ptr, sizeof (std::uint8_t), buffer.size (), infile.get ());
-      if (nread < buffer.size ()) {
-        if (std::ferror (infile.get ())) {
-          error_stream << PSTORE_NATIVE_TEXT ("error: there was an error reading input")
-                       << std::endl;
-          exit_code = EXIT_FAILURE;
-          break;
-        }
+    pstore::gsl::span<std::byte const> const first = input->next ();
+    // The input's signature tells us whether it uses the binary or JSON exchange format.
+    if (pstore::exchange::import_ns::is_binary_input (first.data (),
+                                                      first.data () + first.size ())) {
+      using pstore::exchange::import_ns::binary_parser;
+      binary_parser parser{&db,
+                           pipeline ? binary_parser::store_mode::background
+                                    : binary_parser::store_mode::immediate,
+                           max_memory / 2U};
+      auto const report = [&json_source] (pstore::exchange::import_ns::binary_parser const & p) {
+        error_stream << pstore::utf::to_native_string (input_name (json_source))
+                     << PSTORE_NATIVE_TEXT (":") << p.pos () << PSTORE_NATIVE_TEXT (": error: ")
+                     << pstore::utf::to_native_string (p.last_error ().message ()) << std::endl;
+      };
+      if (!parse (first, *input, parser, report)) {
+        exit_code = EXIT_FAILURE;
       }
-
-      parser.input (ptr, ptr + nread);
-      if (parser.has_error ()) {
-        auto const coord = parser.pos ();
+    } else {
+      auto parser = pstore::exchange::import_ns::create_parser (db);
+      auto const report = [&json_source] (decltype (parser) const & p) {
+        auto const coord = p.pos ();
         error_stream << pstore::utf::to_native_string (input_name (json_source))
                      << PSTORE_NATIVE_TEXT (":") << static_cast<unsigned> (peejay::line{coord})
                      << PSTORE_NATIVE_TEXT (":") << static_cast<unsigned> (peejay::column{coord})
                      << PSTORE_NATIVE_TEXT (": error: ")
-                     << pstore::utf::to_native_string (parser.last_error ().message ())
-                     << std::endl;
+                     << pstore::utf::to_native_string (p.last_error ().message ()) << std::endl;
+      };
+      if (!parse (first, *input, parser, report)) {
         exit_code = EXIT_FAILURE;
-        break;
-      }
-
-      // Stop if we've reached the end of the file.
-      if (std::feof (infile.get ())) {
-        parser.eof ();
-        break;
       }
     }
   }
@@ -26,6 +26,7 @@
 #include <memory>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "pstore/command_line/command_line.hpp"
 #include "pstore/command_line/tchar.hpp"
@@ -129,6 +130,9 @@ int main (int argc, char * argv[]) {
       // Start a transaction...
       auto transaction = pstore::begin (database);
 
+      std::vector<std::pair<pstore::index::digest, pstore::extent<pstore::repo::fragment>>>
+        members;
+      members.reserve (keys.size ());
       for (auto & k : keys) {
         // Allocate space in the transaction for the value block
         auto addr = pstore::typed_address<std::uint8_t>::null ();
@@ -138,13 +142,14 @@ int main (int argc, char * argv[]) {
         // Copy the value to the store.
         std::copy (std::begin (value), std::end (value), ptr.get ());
 
-        // Add the key/value pair to the index.
-        index->insert_or_assign (
-          transaction, k,
-          make_extent (pstore::typed_address<pstore::repo::fragment> (addr.to_address ()),
-                       value.size ()));
+        members.emplace_back (
+          k, make_extent (pstore::typed_address<pstore::repo::fragment> (addr.to_address ()),
+                          value.size ()));
       }
 
+      // Add the key/value pairs to the index in a single batch.
+      index->insert_or_assign_range (transaction, std::begin (members), std::end (members));
+
       transaction.commit ();
     }
 
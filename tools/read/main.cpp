@@ -133,7 +133,9 @@ int main (int argc, char * argv[]) {
       return exit_code;
     }
 
-    pstore::database db{opt.db_path, pstore::database::access_mode::read_only};
+    // A single index lookup touches a small number of scattered pages.
+    pstore::database db{opt.db_path, pstore::database::access_mode::read_only,
+                        pstore::mapping_policy{pstore::mapping_policy::access_pattern::random}};
     db.sync (opt.revision);
 
     bool const ok =
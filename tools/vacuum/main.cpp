@@ -114,7 +114,9 @@ int main (int argc, char * argv[]) {
     // to the real file name that we're replacing. If the target file isn't writable, we
     // shouldn't try to replace it with the newer version.
     auto src_db = std::make_shared<pstore::database> (
-      src_path, pstore::database::access_mode::writable, false /*access tick enabled*/);
+      src_path, pstore::database::access_mode::writable,
+      pstore::mapping_policy{pstore::mapping_policy::access_pattern::sequential},
+      false /*access tick enabled*/);
 
     vacuum::status st;
     std::thread quit_th = create_quit_thread (st, src_db);
@@ -131,7 +133,7 @@ int main (int argc, char * argv[]) {
       file_lock->unlock ();
     }
 
-    std::thread copy_th (vacuum::copy, src_db, &st, std::ref (user_opt));
+    std::thread copy_th (vacuum::copy, src_db, std::ref (*file_lock), &st, std::ref (user_opt));
     std::thread watch_th (vacuum::watch, src_db, std::ref (*file_lock), &st);
 
     src_db.reset (); // main thread releases its reference to the source database.
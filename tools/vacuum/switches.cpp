@@ -23,10 +23,15 @@ std::pair<vacuum::user_options, int> get_switches (int argc, tchar * argv[]) {
   argument_parser args;
   auto & path = args.add<string_opt> (positional, usage ("repository"),
                                       desc ("Path of the pstore repository to be vacuumed."));
+  auto & incremental = args.add<bool_opt> (
+    name ("incremental"),
+    desc ("Copy only the data added since the previous vacuum and resume an interrupted one."));
+  args.add<alias> (name ("i"), desc ("Alias for --incremental"), aliasopt (incremental));
 
   args.parse_args (argc, argv, "pstore vacuum utility\n");
 
   vacuum::user_options opt;
   opt.src_path = path.get ();
+  opt.incremental = incremental.get ();
   return {opt, EXIT_SUCCESS};
 }
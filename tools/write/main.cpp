@@ -53,24 +53,10 @@ namespace {
     } else {
       auto const size = file.size ();
 
-      // Allocate space in the transaction for 'size' bytes.
-      auto addr = pstore::typed_address<char>::null ();
-      std::shared_ptr<char> ptr;
-      std::tie (ptr, addr) = transaction.alloc_rw<char> (size);
-
-      // Copy from the source file to the data store. The destination for the read_span() is
-      // the memory that we just allocated in the data store.
-      auto span = pstore::gsl::make_span (ptr.get (), static_cast<std::ptrdiff_t> (size));
-      std::size_t const bytes_read = file.read_span (span);
-
-      auto const expected_size = span.size_bytes ();
-      PSTORE_ASSERT (expected_size >= 0);
-      if (bytes_read !=
-          static_cast<std::make_unsigned_t<std::remove_const_t<decltype (expected_size)>>> (
-            expected_size)) {
-        error_stream << PSTORE_NATIVE_TEXT ("Did not read the number of bytes requested");
-        std::exit (EXIT_FAILURE);
-      }
+      // Copy from the source file to the data store. Where possible the kernel moves the data
+      // directly between the two files so it never passes through this process.
+      auto const addr = pstore::typed_address<char>::make (
+        transaction.copy_from (file, 0U, size, alignof (char)));
 
       // Add it to the names index.
       names.insert_or_assign (transaction, key, make_extent (addr, size));
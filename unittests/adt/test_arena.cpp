@@ -0,0 +1,81 @@
+//===- unittests/adt/test_arena.cpp ---------------------------------------===//
+//*                              *
+//*   __ _ _ __ ___ _ __   __ _  *
+//*  / _` | '__/ _ \ '_ \ / _` | *
+//* | (_| | | |  __/ | | | (_| | *
+//*  \__,_|_|  \___|_| |_|\__,_| *
+//*                              *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "pstore/adt/arena.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include <gmock/gmock.h>
+
+namespace {
+
+  bool is_aligned (void const * const p, std::size_t const align) {
+    return reinterpret_cast<std::uintptr_t> (p) % align == 0U;
+  }
+
+} // end anonymous namespace
+
+TEST (Arena, InitiallyEmpty) {
+  pstore::arena a;
+  EXPECT_EQ (a.capacity (), 0U);
+}
+
+TEST (Arena, AllocationsAreAlignedAndDistinct) {
+  pstore::arena a{64};
+  auto * const p1 = static_cast<std::byte *> (a.allocate (3, 1));
+  auto * const p2 = static_cast<std::byte *> (a.allocate (8, 8));
+  auto * const p3 = static_cast<std::byte *> (a.allocate (16, 16));
+  EXPECT_TRUE (is_aligned (p2, 8U));
+  EXPECT_TRUE (is_aligned (p3, 16U));
+  // Writing to each allocation must not disturb the others.
+  std::memset (p1, 1, 3);
+  std::memset (p2, 2, 8);
+  std::memset (p3, 3, 16);
+  EXPECT_EQ (p1[2], std::byte{1});
+  EXPECT_EQ (p2[0], std::byte{2});
+  EXPECT_EQ (p2[7], std::byte{2});
+  EXPECT_EQ (p3[0], std::byte{3});
+}
+
+TEST (Arena, ChunksGrowGeometrically) {
+  pstore::arena a{64};
+  a.allocate (64, 1);
+  EXPECT_EQ (a.capacity (), 64U);
+  a.allocate (1, 1);
+  EXPECT_EQ (a.capacity (), 64U + 128U);
+  a.allocate (128, 1);
+  EXPECT_EQ (a.capacity (), 64U + 128U + 256U);
+}
+
+TEST (Arena, LargeRequest) {
+  pstore::arena a{64};
+  void * const p = a.allocate (1000, 8);
+  EXPECT_TRUE (is_aligned (p, 8U));
+  EXPECT_GE (a.capacity (), 1000U);
+}
+
+TEST (Arena, ClearRetainsLastChunk) {
+  pstore::arena a{64};
+  a.allocate (64, 1);
+  auto * const p2 = a.allocate (100, 1);
+  EXPECT_EQ (a.capacity (), 64U + 128U);
+  a.clear ();
+  EXPECT_EQ (a.capacity (), 128U);
+  // The retained chunk is reused from its start.
+  EXPECT_EQ (a.allocate (100, 1), p2);
+  EXPECT_EQ (a.capacity (), 128U);
+}
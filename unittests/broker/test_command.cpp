@@ -25,7 +25,6 @@
 
 // pstore includes
 #include "pstore/brokerface/fifo_path.hpp"
-#include "pstore/http/server_status.hpp"
 
 using namespace std::chrono_literals;
 
@@ -33,10 +32,8 @@ namespace {
 
   class mock_cp final : public pstore::broker::command_processor {
   public:
-    explicit mock_cp (unsigned const num_read_threads,
-                      std::optional<pstore::http::server_status> * const http_status,
-                      std::atomic<bool> * const uptime_done)
-            : command_processor (num_read_threads, http_status, uptime_done, 4h) {}
+    mock_cp ()
+            : command_processor (4h) {}
 
     MOCK_METHOD2 (suicide, void (pstore::brokerface::fifo_path const &,
                                  pstore::broker::broker_command const &));
@@ -61,10 +58,7 @@ namespace {
   class Command : public ::testing::Test {
   public:
     Command ()
-            : http_status_{std::in_place, in_port_t{8080}}
-            , uptime_done_{false}
-            , cp_{1U, &http_status_, &uptime_done_}
-            , fifo_{nullptr} {}
+            : fifo_{nullptr} {}
 
     mock_cp & cp () { return cp_; }
     pstore::brokerface::fifo_path & fifo () { return fifo_; }
@@ -74,9 +68,6 @@ namespace {
     static constexpr std::uint16_t num_parts = 1;
 
   private:
-    std::optional<pstore::http::server_status> http_status_;
-    std::atomic<bool> uptime_done_;
-
     mock_cp cp_;
     pstore::brokerface::fifo_path fifo_;
   };
@@ -0,0 +1,169 @@
+//===- unittests/broker/test_message_queue.cpp ----------------------------===//
+//*                                                                          *
+//*  _ __ ___   ___  ___ ___  __ _  __ _  ___    __ _ _   _  ___ _   _  ___  *
+//* | '_ ` _ \ / _ \/ __/ __|/ _` |/ _` |/ _ \  / _` | | | |/ _ \ | | |/ _ \ *
+//* | | | | | |  __/\__ \__ \ (_| | (_| |  __/ | (_| | |_| |  __/ |_| |  __/ *
+//* |_| |_| |_|\___||___/___/\__,_|\__, |\___|  \__, |\__,_|\___|\__,_|\___| *
+//*                                |___/           |_|                       *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file test_message_queue.cpp
+
+#include "pstore/broker/message_queue.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "pstore/broker/message_pool.hpp"
+
+using pstore::broker::message_queue;
+
+TEST (MessageQueue, CapacityIsRoundedUp) {
+  message_queue<int> q{5U};
+  EXPECT_EQ (q.capacity (), 8U);
+}
+
+TEST (MessageQueue, PushPop) {
+  message_queue<int> q;
+  q.push (1);
+  q.push (2);
+  q.push (3);
+  EXPECT_EQ (q.pop (), 1);
+  EXPECT_EQ (q.pop (), 2);
+  EXPECT_EQ (q.pop (), 3);
+  int out = 0;
+  EXPECT_FALSE (q.try_pop (&out));
+}
+
+TEST (MessageQueue, Full) {
+  message_queue<std::unique_ptr<int>> q{2U};
+  EXPECT_TRUE (q.try_push (std::make_unique<int> (1)));
+  EXPECT_TRUE (q.try_push (std::make_unique<int> (2)));
+
+  // A failed push must leave its argument untouched.
+  auto v = std::make_unique<int> (3);
+  EXPECT_FALSE (q.try_push (std::move (v)));
+  ASSERT_NE (v, nullptr);
+  EXPECT_EQ (*v, 3);
+
+  EXPECT_EQ (*q.pop (), 1);
+  EXPECT_TRUE (q.try_push (std::move (v)));
+  EXPECT_EQ (*q.pop (), 2);
+  EXPECT_EQ (*q.pop (), 3);
+}
+
+TEST (MessageQueue, Clear) {
+  message_queue<int> q{4U};
+  for (auto ctr = 0; ctr < 4; ++ctr) {
+    q.push (std::move (ctr));
+  }
+  q.clear ();
+  int out = 0;
+  EXPECT_FALSE (q.try_pop (&out));
+  // The queue can be refilled.
+  for (auto ctr = 0; ctr < 4; ++ctr) {
+    EXPECT_TRUE (q.try_push (std::move (ctr)));
+  }
+}
+
+TEST (MessageQueue, PopBlocksUntilPush) {
+  message_queue<int> q{4U, 0U /*spin count*/};
+  int received = 0;
+  std::thread consumer{[&q, &received] () { received = q.pop (); }};
+  q.push (42);
+  consumer.join ();
+  EXPECT_EQ (received, 42);
+}
+
+TEST (MessageQueue, PushBlocksWhilstFull) {
+  message_queue<int> q{2U, 0U /*spin count*/};
+  q.push (1);
+  q.push (2);
+  std::thread producer{[&q] () { q.push (3); }};
+  EXPECT_EQ (q.pop (), 1);
+  producer.join ();
+  EXPECT_EQ (q.pop (), 2);
+  EXPECT_EQ (q.pop (), 3);
+}
+
+TEST (MessageQueue, ManyProducersManyConsumers) {
+  // A small queue ensures that both producers and consumers frequently have to wait.
+  message_queue<unsigned> q{16U};
+  constexpr auto num_producers = 4U;
+  constexpr auto num_consumers = 4U;
+  constexpr auto values_per_producer = 5000U;
+  constexpr auto total = num_producers * values_per_producer;
+
+  std::vector<std::thread> threads;
+  for (auto p = 0U; p < num_producers; ++p) {
+    threads.emplace_back ([&q, p] () {
+      for (auto ctr = 0U; ctr < values_per_producer; ++ctr) {
+        q.push (p * values_per_producer + ctr);
+      }
+    });
+  }
+  std::vector<std::vector<unsigned>> received (num_consumers);
+  for (auto c = 0U; c < num_consumers; ++c) {
+    threads.emplace_back ([&q, &received, c] () {
+      for (auto ctr = 0U; ctr < total / num_consumers; ++ctr) {
+        received[c].push_back (q.pop ());
+      }
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join ();
+  }
+
+  // Every value must have been received exactly once.
+  std::vector<unsigned> all;
+  for (std::vector<unsigned> const & r : received) {
+    // Each consumer sees the values from a single producer in the order that they were pushed.
+    std::vector<unsigned> last (num_producers, 0U);
+    for (unsigned const v : r) {
+      unsigned const p = v / values_per_producer;
+      EXPECT_GT (v + 1U, last[p]);
+      last[p] = v + 1U;
+    }
+    all.insert (std::end (all), std::begin (r), std::end (r));
+  }
+  std::sort (std::begin (all), std::end (all));
+  ASSERT_EQ (all.size (), total);
+  for (auto ctr = 0U; ctr < total; ++ctr) {
+    EXPECT_EQ (all[ctr], ctr);
+  }
+}
+
+TEST (MessagePool, Recycles) {
+  pstore::broker::message_pool pool{2U};
+  auto a = pool.get_from_pool ();
+  ASSERT_NE (a, nullptr);
+  auto const * const address = a.get ();
+  pool.return_to_pool (std::move (a));
+  EXPECT_EQ (pool.get_from_pool ().get (), address);
+}
+
+TEST (MessagePool, DiscardsWhenFull) {
+  pstore::broker::message_pool pool{2U};
+  auto a = pool.get_from_pool ();
+  auto b = pool.get_from_pool ();
+  auto c = pool.get_from_pool ();
+  auto const * const a_address = a.get ();
+  auto const * const b_address = b.get ();
+  pool.return_to_pool (std::move (a));
+  pool.return_to_pool (std::move (b));
+  pool.return_to_pool (std::move (c));
+  EXPECT_EQ (c, nullptr);
+  // The pool holds the first two buffers that were returned to it.
+  EXPECT_EQ (pool.get_from_pool ().get (), a_address);
+  EXPECT_EQ (pool.get_from_pool ().get (), b_address);
+}
@@ -65,3 +65,16 @@ TEST (MessageParse, TwoPartCommandOutOfOrder) {
   EXPECT_EQ (c2->path, "to be or not to be");
   EXPECT_TRUE (cmds.empty ());
 }
+
+TEST (MessageParse, CompleteCommand) {
+  using namespace pstore::broker;
+  std::unique_ptr<broker_command> command = parse ("HELO to be or not to be"s);
+  ASSERT_NE (command.get (), nullptr);
+  EXPECT_EQ (command->verb, "HELO");
+  EXPECT_EQ (command->path, "to be or not to be");
+
+  command = parse ("NOP"s);
+  ASSERT_NE (command.get (), nullptr);
+  EXPECT_EQ (command->verb, "NOP");
+  EXPECT_EQ (command->path, "");
+}
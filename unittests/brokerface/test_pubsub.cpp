@@ -17,6 +17,7 @@
 
 #include <condition_variable>
 #include <thread>
+#include <vector>
 
 #include <gmock/gmock.h>
 
@@ -85,7 +86,7 @@ TEST (PubSub, PubSub) {
 
   std::thread thread{[&] () {
     listening_counter.increment ();
-    while (std::optional<std::string> const message = sub->listen ()) {
+    while (pstore::brokerface::shared_message const message = sub->listen ()) {
       received_counter.increment ();
       received.call (*message);
     }
@@ -126,3 +127,69 @@ TEST (PubSub, PublishWithNooneListening) {
   pstore::brokerface::channel<decltype (cv)> chan{&cv};
   chan.publish ([&fn] (int a) { return fn.call (a); }, 7);
 }
+
+TEST (PubSub, MessageIsSharedBySubscribers) {
+  std::condition_variable cv;
+  pstore::brokerface::channel<decltype (cv)> chan{&cv};
+  auto sub1 = chan.new_subscriber ();
+  auto sub2 = chan.new_subscriber ();
+
+  chan.publish ("message");
+  pstore::brokerface::shared_message const m1 = sub1->pop ();
+  pstore::brokerface::shared_message const m2 = sub2->pop ();
+  ASSERT_NE (m1, nullptr);
+  EXPECT_EQ (*m1, "message");
+  // Both subscribers see the same buffer rather than a copy.
+  EXPECT_EQ (m1, m2);
+  EXPECT_EQ (sub1->pop (), nullptr);
+  EXPECT_EQ (sub2->pop (), nullptr);
+}
+
+TEST (PubSub, BatchedListen) {
+  std::condition_variable cv;
+  pstore::brokerface::channel<decltype (cv)> chan{&cv};
+  auto sub = chan.new_subscriber ();
+
+  chan.publish ("message 1");
+  chan.publish ("message 2");
+  chan.publish ("message 3");
+
+  std::vector<pstore::brokerface::shared_message> messages;
+  EXPECT_TRUE (sub->listen (&messages));
+  ASSERT_EQ (messages.size (), 3U);
+  EXPECT_EQ (*messages[0], "message 1");
+  EXPECT_EQ (*messages[1], "message 2");
+  EXPECT_EQ (*messages[2], "message 3");
+
+  sub->cancel ();
+  messages.clear ();
+  EXPECT_FALSE (sub->listen (&messages));
+  EXPECT_TRUE (messages.empty ());
+}
+
+TEST (PubSub, ManyPublishers) {
+  std::condition_variable cv;
+  pstore::brokerface::channel<decltype (cv)> chan{&cv};
+  auto sub = chan.new_subscriber ();
+
+  constexpr auto num_publishers = 4U;
+  constexpr auto messages_per_publisher = 1000U;
+  std::vector<std::thread> publishers;
+  for (auto p = 0U; p < num_publishers; ++p) {
+    publishers.emplace_back ([&chan] () {
+      for (auto ctr = 0U; ctr < messages_per_publisher; ++ctr) {
+        chan.publish (std::to_string (ctr));
+      }
+    });
+  }
+
+  std::vector<pstore::brokerface::shared_message> messages;
+  while (messages.size () < num_publishers * messages_per_publisher) {
+    ASSERT_TRUE (sub->listen (&messages));
+  }
+  for (std::thread & t : publishers) {
+    t.join ();
+  }
+  EXPECT_EQ (messages.size (), num_publishers * messages_per_publisher);
+  EXPECT_EQ (sub->pop (), nullptr);
+}
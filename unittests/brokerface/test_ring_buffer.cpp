@@ -0,0 +1,235 @@
+//===- unittests/brokerface/test_ring_buffer.cpp --------------------------===//
+//*       _                _            __  __            *
+//*  _ __(_)_ __   __ _   | |__  _   _ / _|/ _| ___ _ __  *
+//* | '__| | '_ \ / _` |  | '_ \| | | | |_| |_ / _ \ '__| *
+//* | |  | | | | | (_| |  | |_) | |_| |  _|  _|  __/ |    *
+//* |_|  |_|_| |_|\__, |  |_.__/ \__,_|_| |_|  \___|_|    *
+//*               |___/                                   *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file test_ring_buffer.cpp
+
+#include "pstore/brokerface/ring_buffer.hpp"
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "pstore/brokerface/shared_ring.hpp"
+
+// Local includes
+#include "check_for_error.hpp"
+
+using pstore::brokerface::ring_buffer;
+
+namespace {
+
+  class RingBuffer : public testing::Test {
+  protected:
+    ring_buffer make_ring (std::size_t const capacity = ring_buffer::min_capacity) {
+      std::size_t size = ring_buffer::region_size (capacity);
+      memory_.resize (size + alignment);
+      void * ptr = memory_.data ();
+      std::size_t space = memory_.size ();
+      std::align (alignment, size, ptr, space);
+      region_ = static_cast<std::uint8_t *> (ptr);
+      data_ = region_ + size - capacity;
+      return ring_buffer::create (ptr, capacity);
+    }
+
+    /// Overwrites the 32-bit word at \p offset from the start of the memory given to the
+    /// buffer. This simulates a producer which scribbles on the shared memory.
+    void poke_region (std::size_t const offset, std::uint32_t const value) {
+      std::memcpy (region_ + offset, &value, sizeof (value));
+    }
+    /// Overwrites the state word of the record at \p offset in the buffer's record storage.
+    void poke_state (std::size_t const offset, std::uint32_t const value) {
+      std::memcpy (data_ + offset, &value, sizeof (value));
+    }
+
+    // The bits of a record's state word.
+    static constexpr std::uint32_t published_flag = UINT32_C (1) << 31U;
+    static constexpr std::uint32_t padding_flag = UINT32_C (1) << 30U;
+
+  private:
+    static constexpr std::size_t alignment = 64;
+    std::vector<std::uint8_t> memory_;
+    std::uint8_t * region_ = nullptr;
+    std::uint8_t * data_ = nullptr;
+  };
+
+} // end anonymous namespace
+
+TEST_F (RingBuffer, InitiallyEmpty) {
+  ring_buffer ring = this->make_ring ();
+  EXPECT_EQ (ring.capacity (), ring_buffer::min_capacity);
+  EXPECT_TRUE (ring.empty ());
+  std::string out;
+  EXPECT_FALSE (ring.try_pop (&out));
+}
+
+TEST_F (RingBuffer, PushPop) {
+  ring_buffer ring = this->make_ring ();
+  EXPECT_TRUE (ring.try_push ("hello"));
+  EXPECT_TRUE (ring.try_push (""));
+  EXPECT_TRUE (ring.try_push ("world"));
+  EXPECT_FALSE (ring.empty ());
+
+  std::string out;
+  EXPECT_TRUE (ring.try_pop (&out));
+  EXPECT_EQ (out, "hello");
+  EXPECT_TRUE (ring.try_pop (&out));
+  EXPECT_EQ (out, "");
+  EXPECT_TRUE (ring.try_pop (&out));
+  EXPECT_EQ (out, "world");
+  EXPECT_FALSE (ring.try_pop (&out));
+  EXPECT_TRUE (ring.empty ());
+}
+
+TEST_F (RingBuffer, WrapAround) {
+  ring_buffer ring = this->make_ring ();
+  // Records of this size do not divide the buffer evenly so some will need padding to
+  // remain contiguous.
+  for (auto ctr = 0U; ctr < 32U; ++ctr) {
+    std::string const payload (1000U + ctr, static_cast<char> ('a' + ctr % 26U));
+    ASSERT_TRUE (ring.try_push (payload));
+    std::string out;
+    ASSERT_TRUE (ring.try_pop (&out));
+    EXPECT_EQ (out, payload);
+  }
+}
+
+TEST_F (RingBuffer, Full) {
+  ring_buffer ring = this->make_ring ();
+  std::string const payload (ring.max_record_size (), 'x');
+  EXPECT_TRUE (ring.try_push (payload));
+  EXPECT_TRUE (ring.try_push (payload));
+  EXPECT_FALSE (ring.try_push ("y"));
+
+  std::string out;
+  EXPECT_TRUE (ring.try_pop (&out));
+  EXPECT_EQ (out, payload);
+  EXPECT_TRUE (ring.try_push ("y"));
+}
+
+TEST_F (RingBuffer, RecordTooLarge) {
+  ring_buffer ring = this->make_ring ();
+  std::string const payload (ring.max_record_size () + 1U, 'x');
+  check_for_error ([&] () { ring.try_push (payload); },
+                   pstore::error_code::ring_record_too_large);
+}
+
+TEST_F (RingBuffer, AttachToUnformattedMemory) {
+  std::vector<std::uint8_t> memory (ring_buffer::region_size (ring_buffer::min_capacity));
+  check_for_error ([&] () { ring_buffer::attach (memory.data (), memory.size ()); },
+                   pstore::error_code::ring_buffer_corrupt);
+}
+
+TEST_F (RingBuffer, CorruptRecordLength) {
+  ring_buffer ring = this->make_ring ();
+  EXPECT_TRUE (ring.try_push ("hello"));
+  // A length far larger than the buffer must not be used to read the payload.
+  this->poke_state (0U, published_flag | UINT32_C (0x3FFFFFFF));
+  std::string out;
+  check_for_error ([&] () { ring.try_pop (&out); }, pstore::error_code::ring_buffer_corrupt);
+}
+
+TEST_F (RingBuffer, CorruptRecordStraddlesEnd) {
+  ring_buffer ring = this->make_ring ();
+  // Consume two records (each of which occupies its 8 byte header plus its payload) to move
+  // to the last 16 bytes of the buffer. A record may not extend beyond the end.
+  std::string out;
+  for (auto const length : {std::size_t{2040}, std::size_t{2024}}) {
+    ASSERT_TRUE (ring.try_push (std::string (length, 'x')));
+    ASSERT_TRUE (ring.try_pop (&out));
+  }
+  this->poke_state (ring.capacity () - 16U, published_flag | 64U);
+  check_for_error ([&] () { ring.try_pop (&out); }, pstore::error_code::ring_buffer_corrupt);
+}
+
+TEST_F (RingBuffer, CorruptPaddingLength) {
+  ring_buffer ring = this->make_ring ();
+  // Padding must run exactly to the end of the buffer.
+  this->poke_state (0U, published_flag | padding_flag | 16U);
+  std::string out;
+  check_for_error ([&] () { ring.try_pop (&out); }, pstore::error_code::ring_buffer_corrupt);
+}
+
+TEST_F (RingBuffer, CapacityIsNotReread) {
+  ring_buffer ring = this->make_ring ();
+  // The capacity field in the control block follows the 64-bit magic number. Changing it
+  // after the buffer was created must have no effect.
+  this->poke_region (8U, UINT32_C (0xFFFFFFFF));
+  EXPECT_EQ (ring.capacity (), ring_buffer::min_capacity);
+  EXPECT_TRUE (ring.try_push ("hello"));
+  std::string out;
+  EXPECT_TRUE (ring.try_pop (&out));
+  EXPECT_EQ (out, "hello");
+}
+
+TEST_F (RingBuffer, ManyProducers) {
+  ring_buffer ring = this->make_ring ();
+  constexpr auto num_producers = 4U;
+  constexpr auto records_per_producer = 2000U;
+
+  std::vector<std::thread> producers;
+  for (auto p = 0U; p < num_producers; ++p) {
+    producers.emplace_back ([&ring, p] () {
+      for (auto ctr = 0U; ctr < records_per_producer; ++ctr) {
+        std::string const payload = std::to_string (p) + ':' + std::to_string (ctr);
+        while (!ring.try_push (payload)) {
+          std::this_thread::yield ();
+        }
+      }
+    });
+  }
+
+  // Each producer's records must arrive in the order in which they were pushed.
+  std::vector<unsigned> expected (num_producers, 0U);
+  std::string out;
+  for (auto received = 0U; received < num_producers * records_per_producer;) {
+    if (!ring.try_pop (&out)) {
+      ring.wait (std::chrono::milliseconds{10});
+      continue;
+    }
+    auto const colon = out.find (':');
+    ASSERT_NE (colon, std::string::npos);
+    auto const p = static_cast<unsigned> (std::stoul (out.substr (0, colon)));
+    ASSERT_LT (p, num_producers);
+    EXPECT_EQ (std::stoul (out.substr (colon + 1U)), expected[p]);
+    ++expected[p];
+    ++received;
+  }
+  for (std::thread & t : producers) {
+    t.join ();
+  }
+  EXPECT_TRUE (ring.empty ());
+}
+
+#ifndef _WIN32
+TEST (SharedRing, ClientToServer) {
+  using pstore::brokerface::shared_ring;
+  pstore::brokerface::fifo_path const fifo{"/tmp/pstore-test-shared-ring.fifo"};
+  EXPECT_FALSE (shared_ring::open (fifo).has_value ());
+
+  shared_ring server = shared_ring::create (fifo, ring_buffer::min_capacity);
+  std::optional<shared_ring> client = shared_ring::open (fifo);
+  ASSERT_TRUE (client.has_value ());
+  EXPECT_EQ (client->ring ().capacity (), ring_buffer::min_capacity);
+
+  std::string const payload (2000U, 'p');
+  EXPECT_TRUE (client->ring ().try_push (payload));
+  std::string out;
+  EXPECT_TRUE (server.ring ().try_pop (&out));
+  EXPECT_EQ (out, payload);
+}
+#endif // _WIN32
@@ -0,0 +1,336 @@
+//===- unittests/core/test_async_logger.cpp -------------------------------===//
+//*                                _                              *
+//*   __ _ ___ _   _ _ __   ___   | | ___   __ _  __ _  ___ _ __  *
+//*  / _` / __| | | | '_ \ / __|  | |/ _ \ / _` |/ _` |/ _ \ '__| *
+//* | (_| \__ \ |_| | | | | (__   | | (_) | (_| | (_| |  __/ |    *
+//*  \__,_|___/\__, |_| |_|\___|  |_|\___/ \__, |\__, |\___|_|    *
+//*            |___/                       |___/ |___/            *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file test_async_logger.cpp
+
+#include "pstore/os/logging.hpp"
+
+// standard library
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// OS-specific includes
+#ifndef _WIN32
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+// 3rd party
+#include <gmock/gmock.h>
+
+using testing::ElementsAre;
+using priority = pstore::logger::priority;
+
+namespace {
+
+  // capture logger
+  // ~~~~~~~~~~~~~~
+  /// Records the messages that it is asked to write and the times at which they were logged.
+  /// If the gate is closed, the first call to log() blocks until it is opened.
+  class capture_logger final : public pstore::logger {
+  public:
+    using time_point = std::chrono::system_clock::time_point;
+
+    using logger::log;
+    void log (priority p, std::string const & message) override;
+    void log (priority p, std::string const & message, time_point when) override;
+
+    std::vector<std::string> messages () const;
+    std::vector<time_point> times () const;
+
+    void close_gate ();
+    /// Blocks until a call to log() is waiting for the gate to open.
+    void wait_for_arrival ();
+    void open_gate ();
+
+  private:
+    mutable std::mutex mut_;
+    std::condition_variable cv_;
+    std::vector<std::string> messages_;
+    std::vector<time_point> times_;
+    bool closed_ = false;
+    bool arrived_ = false;
+  };
+
+  void capture_logger::log (priority const p, std::string const & message) {
+    this->log (p, message, std::chrono::system_clock::now ());
+  }
+
+  void capture_logger::log (priority const, std::string const & message, time_point const when) {
+    std::unique_lock<std::mutex> lock{mut_};
+    if (closed_) {
+      arrived_ = true;
+      cv_.notify_all ();
+      cv_.wait (lock, [this] () { return !closed_; });
+    }
+    messages_.push_back (message);
+    times_.push_back (when);
+  }
+
+  std::vector<std::string> capture_logger::messages () const {
+    std::scoped_lock<std::mutex> const lock{mut_};
+    return messages_;
+  }
+
+  std::vector<capture_logger::time_point> capture_logger::times () const {
+    std::scoped_lock<std::mutex> const lock{mut_};
+    return times_;
+  }
+
+  void capture_logger::close_gate () {
+    std::scoped_lock<std::mutex> const lock{mut_};
+    closed_ = true;
+    arrived_ = false;
+  }
+
+  void capture_logger::wait_for_arrival () {
+    std::unique_lock<std::mutex> lock{mut_};
+    cv_.wait (lock, [this] () { return arrived_; });
+  }
+
+  void capture_logger::open_gate () {
+    {
+      std::scoped_lock<std::mutex> const lock{mut_};
+      closed_ = false;
+    }
+    cv_.notify_all ();
+  }
+
+
+  // forwarding logger
+  // ~~~~~~~~~~~~~~~~~
+  /// Passes messages to a logger that it does not own.
+  class forwarding_logger final : public pstore::logger {
+  public:
+    explicit forwarding_logger (pstore::logger & target) noexcept
+            : target_{target} {}
+
+    using logger::log;
+    void log (priority const p, std::string const & message) override {
+      target_.log (p, message);
+    }
+
+  private:
+    pstore::logger & target_;
+  };
+
+
+  class AsyncLogger : public testing::Test {
+  protected:
+    AsyncLogger ()
+            : capture_{new capture_logger}
+            , logger_{std::unique_ptr<pstore::logger>{capture_}} {}
+    ~AsyncLogger () override { pstore::stop_async_logging (); }
+
+    capture_logger * capture_; // owned by logger_.
+    pstore::async_logger logger_;
+  };
+
+} // end anonymous namespace
+
+TEST_F (AsyncLogger, SynchronousWhenStopped) {
+  EXPECT_FALSE (pstore::async_logging_enabled ());
+  logger_.log (priority::info, "hello");
+  EXPECT_THAT (capture_->messages (), ElementsAre ("hello"));
+}
+
+TEST_F (AsyncLogger, FlushWritesInOrder) {
+  pstore::start_async_logging ();
+  EXPECT_TRUE (pstore::async_logging_enabled ());
+  std::vector<std::string> expected;
+  for (auto ctr = 0U; ctr < 100U; ++ctr) {
+    expected.push_back (std::to_string (ctr));
+    logger_.log (priority::info, expected.back ());
+  }
+  pstore::flush_log ();
+  EXPECT_EQ (capture_->messages (), expected);
+}
+
+TEST_F (AsyncLogger, StopWritesQueuedMessages) {
+  pstore::start_async_logging ();
+  logger_.log (priority::info, "one");
+  logger_.log (priority::info, "two ", 2);
+  pstore::stop_async_logging ();
+  EXPECT_FALSE (pstore::async_logging_enabled ());
+  EXPECT_THAT (capture_->messages (), ElementsAre ("one", "two 2"));
+
+  logger_.log (priority::info, "three");
+  EXPECT_THAT (capture_->messages (), ElementsAre ("one", "two 2", "three"));
+}
+
+TEST_F (AsyncLogger, DestroyWhilstStopping) {
+  capture_logger other_capture;
+  auto other = std::make_unique<pstore::async_logger> (
+    std::make_unique<forwarding_logger> (other_capture));
+
+  pstore::start_async_logging ();
+  capture_->close_gate ();
+  // The background thread waits at the gate whilst writing the first message so the second
+  // remains in the ring.
+  logger_.log (priority::info, "one");
+  capture_->wait_for_arrival ();
+  other->log (priority::info, "two");
+
+  std::thread stopper{[] () { pstore::stop_async_logging (); }};
+  std::vector<std::string> written;
+  std::thread destroyer{[&other, &other_capture, &written] () {
+    while (pstore::async_logging_enabled ()) {
+      std::this_thread::yield ();
+    }
+    // The stop is in progress. Destroying the logger must wait for its queued message to be
+    // written.
+    other.reset ();
+    written = other_capture.messages ();
+  }};
+  std::this_thread::sleep_for (std::chrono::milliseconds{20});
+  capture_->open_gate ();
+  stopper.join ();
+  destroyer.join ();
+
+  EXPECT_THAT (capture_->messages (), ElementsAre ("one"));
+  EXPECT_THAT (written, ElementsAre ("two"));
+}
+
+TEST_F (AsyncLogger, RecordsTimeOfLogging) {
+  pstore::start_async_logging ();
+  capture_->close_gate ();
+  logger_.log (priority::info, "one");
+  capture_->wait_for_arrival ();
+
+  // The second message is queued whilst the background thread is held at the gate. Its time
+  // must be that at which it was logged rather than when it was written.
+  auto const before = std::chrono::system_clock::now ();
+  logger_.log (priority::info, "two");
+  auto const after = std::chrono::system_clock::now ();
+  std::this_thread::sleep_for (std::chrono::milliseconds{50});
+  capture_->open_gate ();
+  pstore::flush_log ();
+
+  EXPECT_THAT (capture_->messages (), ElementsAre ("one", "two"));
+  std::vector<capture_logger::time_point> const times = capture_->times ();
+  ASSERT_EQ (times.size (), 2U);
+  EXPECT_GE (times[1], before);
+  EXPECT_LE (times[1], after);
+}
+
+TEST_F (AsyncLogger, DropsWhenFull) {
+  pstore::start_async_logging (2U, pstore::log_overflow::drop);
+  capture_->close_gate ();
+  // The background thread takes the first message then waits at the gate.
+  logger_.log (priority::info, "0");
+  capture_->wait_for_arrival ();
+  // The first message occupies its slot until it has been written, so the ring has space for
+  // only one more; the remainder are discarded.
+  for (auto const * const message : {"1", "2", "3", "4"}) {
+    logger_.log (priority::info, message);
+  }
+  capture_->open_gate ();
+  pstore::flush_log ();
+  EXPECT_THAT (capture_->messages (), ElementsAre ("0", "log messages dropped: 3", "1"));
+}
+
+TEST_F (AsyncLogger, BlocksWhenFull) {
+  pstore::start_async_logging (2U, pstore::log_overflow::block);
+  capture_->close_gate ();
+  logger_.log (priority::info, "0");
+  capture_->wait_for_arrival ();
+
+  std::atomic<bool> done{false};
+  std::thread producer{[this, &done] () {
+    for (auto const * const message : {"1", "2", "3", "4"}) {
+      logger_.log (priority::info, message);
+    }
+    done = true;
+  }};
+  std::this_thread::sleep_for (std::chrono::milliseconds{20});
+  EXPECT_FALSE (done);
+
+  capture_->open_gate ();
+  producer.join ();
+  pstore::flush_log ();
+  EXPECT_THAT (capture_->messages (), ElementsAre ("0", "1", "2", "3", "4"));
+}
+
+TEST_F (AsyncLogger, ManyThreads) {
+  pstore::start_async_logging (16U, pstore::log_overflow::block);
+  constexpr auto num_threads = 4U;
+  constexpr auto messages_per_thread = 500U;
+
+  std::vector<std::thread> threads;
+  for (auto t = 0U; t < num_threads; ++t) {
+    threads.emplace_back ([this, t] () {
+      for (auto ctr = 0U; ctr < messages_per_thread; ++ctr) {
+        logger_.log (priority::info, std::to_string (t) + ':' + std::to_string (ctr));
+      }
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join ();
+  }
+  pstore::flush_log ();
+
+  // Each thread's messages must be written in the order in which they were logged.
+  std::vector<std::string> const messages = capture_->messages ();
+  ASSERT_EQ (messages.size (), num_threads * messages_per_thread);
+  std::vector<unsigned> expected (num_threads, 0U);
+  for (std::string const & message : messages) {
+    auto const colon = message.find (':');
+    ASSERT_NE (colon, std::string::npos);
+    auto const t = static_cast<unsigned> (std::stoul (message.substr (0, colon)));
+    ASSERT_LT (t, num_threads);
+    EXPECT_EQ (std::stoul (message.substr (colon + 1U)), expected[t]);
+    ++expected[t];
+  }
+}
+
+#ifndef _WIN32
+TEST_F (AsyncLogger, Fork) {
+  pstore::start_async_logging ();
+  logger_.log (priority::info, "parent");
+  // Ensure that the background thread isn't holding the capture logger's mutex.
+  pstore::flush_log ();
+
+  pid_t const pid = ::fork ();
+  ASSERT_NE (pid, -1);
+  if (pid == 0) {
+    // The background thread does not exist in the child so its messages must be written
+    // immediately. Exiting must not try to join the thread.
+    bool ok = !pstore::async_logging_enabled ();
+    logger_.log (priority::info, "child");
+    std::vector<std::string> const messages = capture_->messages ();
+    ok = ok && !messages.empty () && messages.back () == "child";
+    pstore::flush_log ();
+    std::exit (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  int status = 0;
+  ASSERT_EQ (::waitpid (pid, &status, 0), pid);
+  EXPECT_TRUE (WIFEXITED (status));
+  EXPECT_EQ (WEXITSTATUS (status), EXIT_SUCCESS);
+
+  // The parent continues to log asynchronously.
+  EXPECT_TRUE (pstore::async_logging_enabled ());
+  logger_.log (priority::info, "after");
+  pstore::flush_log ();
+  EXPECT_THAT (capture_->messages (), ElementsAre ("parent", "after"));
+}
+#endif // _WIN32
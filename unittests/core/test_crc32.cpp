@@ -17,6 +17,8 @@
 
 // Standard library includes
 #include <cstring>
+#include <numeric>
+#include <vector>
 
 // 3rd party includes
 #include <gtest/gtest.h>
@@ -38,3 +40,49 @@ TEST (Crc32, Sequence) {
   auto span = pstore::gsl::make_span (str, length);
   EXPECT_EQ (pstore::crc32 (span), 0x0fcdae64U);
 }
+
+namespace {
+
+  // A bit-at-a-time reference implementation.
+  std::uint32_t reference_crc32 (std::uint8_t const * p, std::size_t length) {
+    auto crc = std::uint32_t{0};
+    for (; length > 0; --length) {
+      crc ^= *(p++);
+      for (auto bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ ((crc & 1U) != 0U ? 0xEDB88320U : 0U);
+      }
+    }
+    return crc ^ ~0U;
+  }
+
+  std::vector<std::uint8_t> make_buffer (std::size_t size) {
+    std::vector<std::uint8_t> buffer (size);
+    std::iota (std::begin (buffer), std::end (buffer), std::uint8_t{0x5A});
+    return buffer;
+  }
+
+} // end anonymous namespace
+
+// Covers lengths and alignments which exercise each of the byte, slice-by-8, and carry-less
+// multiply paths.
+TEST (Crc32, MatchesReference) {
+  auto const buffer = make_buffer (1024U + 16U);
+  for (auto offset = std::size_t{0}; offset < 16U; ++offset) {
+    for (auto length = std::size_t{0}; length <= 1024U; length += (length < 200U ? 1U : 61U)) {
+      auto const * const p = buffer.data () + offset;
+      EXPECT_EQ (reference_crc32 (p, length), pstore::crc32 (pstore::gsl::make_span (p, length)))
+        << "offset=" << offset << " length=" << length;
+    }
+  }
+}
+
+TEST (Crc32, AccumulatorMatchesSingleBuffer) {
+  auto const buffer = make_buffer (777U);
+  auto const expected = pstore::crc32 (pstore::gsl::make_span (buffer));
+  for (auto split = std::size_t{0}; split <= buffer.size (); split += 37U) {
+    pstore::crc32_accumulator acc;
+    acc.append (buffer.data (), split);
+    acc.append (pstore::gsl::make_span (buffer.data () + split, buffer.size () - split));
+    EXPECT_EQ (expected, acc.get ()) << "split=" << split;
+  }
+}
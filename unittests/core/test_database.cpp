@@ -29,6 +29,7 @@
 #include <gmock/gmock.h>
 
 // pstore library includes
+#include "pstore/core/transaction.hpp"
 #include "pstore/support/portab.hpp"
 
 // Local includes
@@ -208,6 +209,41 @@ TEST_F (Database, Allocate16BytesAligned1024) {
   EXPECT_EQ (addr.absolute () + align, addr2.absolute ());
 }
 
+TEST (SkipTarget, IsEarlierGeneration) {
+  EXPECT_EQ (0U, pstore::trailer::skip_target (0U));
+  EXPECT_EQ (0U, pstore::trailer::skip_target (1U));
+  for (auto generation = 2U; generation < 1024U; ++generation) {
+    EXPECT_LT (pstore::trailer::skip_target (generation), generation - 1U)
+      << "generation " << generation;
+  }
+}
+
+TEST_F (Database, OlderRevisionFooterPosUsesSkipPointers) {
+  pstore::database db{store_.file ()};
+  db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+
+  constexpr auto num_revisions = 200U;
+  // footers[n] is the address of the trailer for generation n.
+  std::vector<pstore::typed_address<pstore::trailer>> footers{db.footer_pos ()};
+  for (auto ctr = 1U; ctr <= num_revisions; ++ctr) {
+    auto transaction = pstore::begin (db);
+    *(transaction.alloc_rw<int> ().first) = 37;
+    transaction.commit ();
+    footers.push_back (db.footer_pos ());
+  }
+
+  for (auto generation = 1U; generation <= num_revisions; ++generation) {
+    auto const footer = db.getro (footers[generation]);
+    EXPECT_EQ (footers[generation - 1U], footer->a.prev_generation);
+    EXPECT_EQ (footers[pstore::trailer::skip_target (generation)], footer->a.skip_generation)
+      << "generation " << generation;
+  }
+  for (auto revision = 0U; revision <= num_revisions; ++revision) {
+    EXPECT_EQ (footers[revision], db.older_revision_footer_pos (revision))
+      << "revision " << revision;
+  }
+}
+
 namespace {
 
   class OpenCorruptStore : public ::testing::Test {
@@ -18,9 +18,12 @@
 // Standard library includes
 #include <random>
 #include <list>
+#include <map>
+#include <optional>
+#include <set>
 
 // 3rd party includes
-#include <gtest/gtest.h>
+#include <gmock/gmock.h>
 
 // pstore includes
 #include "pstore/core/index_types.hpp"
@@ -246,6 +249,258 @@ TEST_F (DefaultIndexFixture, UpsertInternalStore) {
   EXPECT_FALSE (itp3.second);
 }
 
+namespace {
+
+  // Returns a collection of key/value pairs with distinct pseudo-random keys.
+  std::vector<std::pair<std::string, std::string>> make_pairs (std::size_t const count,
+                                                               unsigned const seed) {
+    std::mt19937 generator{seed};
+    std::uniform_int_distribution<unsigned> distribution;
+    std::set<std::string> keys;
+    while (keys.size () < count) {
+      keys.insert ("key" + std::to_string (distribution (generator)));
+    }
+    std::vector<std::pair<std::string, std::string>> result;
+    result.reserve (count);
+    for (auto const & key : keys) {
+      result.emplace_back (key, "value of " + key);
+    }
+    std::shuffle (std::begin (result), std::end (result), generator);
+    return result;
+  }
+
+} // end anonymous namespace
+
+// test insert_range: an empty range does nothing.
+TEST_F (DefaultIndexFixture, InsertRangeEmpty) {
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  std::vector<std::pair<std::string, std::string>> const empty;
+  EXPECT_EQ (0U, index_->insert_range (t1, std::begin (empty), std::end (empty)));
+  EXPECT_TRUE (index_->empty ());
+  EXPECT_TRUE (index_->root ().is_empty ());
+}
+
+// test insert_range: a single element produces a leaf root.
+TEST_F (DefaultIndexFixture, InsertRangeSingle) {
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  std::array<std::pair<std::string, std::string>, 1> const pairs{{{"a"s, "b"s}}};
+  EXPECT_EQ (1U, index_->insert_range (t1, std::begin (pairs), std::end (pairs)));
+  EXPECT_EQ (1U, index_->size ());
+  EXPECT_TRUE (index_->root ().is_leaf ());
+  auto const it = index_->find (db_, "a"s);
+  ASSERT_NE (it, index_->cend (db_));
+  EXPECT_EQ ("b", it->second);
+}
+
+// test insert_range: the result is the same as inserting each key in turn.
+TEST_F (DefaultIndexFixture, InsertRangeMatchesInsert) {
+  auto const pairs = make_pairs (2000U, 1U);
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  EXPECT_EQ (pairs.size (), index_->insert_range (t1, std::begin (pairs), std::end (pairs)));
+  EXPECT_EQ (pairs.size (), index_->size ());
+
+  default_index expected{db_};
+  for (auto const & kvp : pairs) {
+    expected.insert (t1, kvp);
+  }
+
+  using map = std::map<std::string, std::string>;
+  map const actual_contents (index_->begin (db_), index_->end (db_));
+  map const expected_contents (expected.begin (db_), expected.end (db_));
+  EXPECT_EQ (expected_contents, actual_contents);
+
+  // The same should be true once both indices have been written to the store.
+  index_->flush (t1, db_.get_current_revision ());
+  expected.flush (t1, db_.get_current_revision ());
+  for (auto const & kvp : pairs) {
+    auto const it = index_->find (db_, kvp.first);
+    ASSERT_NE (it, index_->cend (db_)) << "key " << kvp.first << " was not found";
+    EXPECT_EQ (kvp.second, it->second);
+  }
+  EXPECT_EQ (map (expected.begin (db_), expected.end (db_)),
+             map (index_->begin (db_), index_->end (db_)));
+}
+
+// test insert_range: merge a batch into an index which is in the store.
+TEST_F (DefaultIndexFixture, InsertRangeIntoStore) {
+  auto const initial = make_pairs (500U, 2U);
+  auto const more = make_pairs (500U, 3U);
+
+  auto root = pstore::typed_address<pstore::index::header_block>::null ();
+  {
+    transaction_type t1 = begin (db_, lock_guard{mutex_});
+    default_index index{db_};
+    EXPECT_EQ (initial.size (), index.insert_range (t1, std::begin (initial), std::end (initial)));
+    root = index.flush (t1, db_.get_current_revision () + 1U);
+    t1.commit ();
+  }
+
+  // A batch containing both existing keys with new values and new keys.
+  std::vector<std::pair<std::string, std::string>> batch;
+  std::transform (std::begin (initial), std::end (initial), std::back_inserter (batch),
+                  [] (std::pair<std::string, std::string> const & kvp) {
+                    return std::make_pair (kvp.first, "new "s + kvp.second);
+                  });
+  std::copy (std::begin (more), std::end (more), std::back_inserter (batch));
+
+  transaction_type t2 = begin (db_, lock_guard{mutex_});
+  default_index index{db_, root};
+  std::set<std::string> existing;
+  for (auto const & kvp : initial) {
+    existing.insert (kvp.first);
+  }
+  auto const expected_new = static_cast<std::size_t> (
+    std::count_if (std::begin (more), std::end (more),
+                   [&existing] (std::pair<std::string, std::string> const & kvp) {
+                     return existing.count (kvp.first) == 0U;
+                   }));
+  EXPECT_EQ (expected_new, index.insert_range (t2, std::begin (batch), std::end (batch)));
+  EXPECT_EQ (initial.size () + expected_new, index.size ());
+
+  // insert_range() must not have modified the existing values.
+  for (auto const & kvp : initial) {
+    auto const it = index.find (db_, kvp.first);
+    ASSERT_NE (it, index.cend (db_));
+    EXPECT_EQ (kvp.second, it->second);
+  }
+  for (auto const & kvp : more) {
+    EXPECT_TRUE (index.contains (db_, kvp.first)) << "key " << kvp.first << " was not found";
+  }
+}
+
+// test insert_or_assign_range: existing keys are updated and the last duplicate wins.
+TEST_F (DefaultIndexFixture, InsertOrAssignRange) {
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  index_->insert (t1, std::make_pair ("a"s, "a1"s));
+  index_->insert (t1, std::make_pair ("b"s, "b1"s));
+  index_->flush (t1, db_.get_current_revision ());
+
+  std::array<std::pair<std::string, std::string>, 4> const batch{
+    {{"b"s, "b2"s}, {"c"s, "c1"s}, {"c"s, "c2"s}, {"b"s, "b3"s}}};
+  EXPECT_EQ (1U, index_->insert_or_assign_range (t1, std::begin (batch), std::end (batch)));
+  EXPECT_EQ (3U, index_->size ());
+  EXPECT_EQ ("a1", index_->find (db_, "a"s)->second);
+  EXPECT_EQ ("b3", index_->find (db_, "b"s)->second);
+  EXPECT_EQ ("c2", index_->find (db_, "c"s)->second);
+
+  // insert_range: the first of a set of duplicates wins.
+  std::array<std::pair<std::string, std::string>, 3> const batch2{
+    {{"d"s, "d1"s}, {"a"s, "a2"s}, {"d"s, "d2"s}}};
+  EXPECT_EQ (1U, index_->insert_range (t1, std::begin (batch2), std::end (batch2)));
+  EXPECT_EQ (4U, index_->size ());
+  EXPECT_EQ ("a1", index_->find (db_, "a"s)->second);
+  EXPECT_EQ ("d1", index_->find (db_, "d"s)->second);
+}
+
+// test reserve_flush: flush writes exactly the reserved space and nothing more.
+TEST_F (DefaultIndexFixture, FlushUsesReservation) {
+  auto const pairs = make_pairs (500U, 4U);
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  index_->insert_range (t1, std::begin (pairs), std::end (pairs));
+  ASSERT_TRUE (index_->root ().is_branch ());
+
+  pstore::index::flush_reservation const reservation = index_->reserve_flush (t1);
+  EXPECT_EQ (index_->root ().untag<branch const *> ()->flush_size (0U) +
+               sizeof (pstore::index::header_block),
+             reservation.size);
+
+  auto const size_before = t1.size ();
+  auto const header = index_->flush (t1, reservation, db_.get_current_revision ());
+  EXPECT_EQ (size_before, t1.size ());
+  // The header block is the last record written.
+  EXPECT_EQ (reservation.first + reservation.size - sizeof (pstore::index::header_block),
+             header.to_address ());
+  EXPECT_TRUE (index_->root ().is_address ());
+}
+
+// test flush: an index which is large enough to be written concurrently round-trips.
+TEST_F (DefaultIndexFixture, ConcurrentFlush) {
+  auto const pairs = make_pairs (40000U, 5U);
+  auto header = pstore::typed_address<pstore::index::header_block>::null ();
+  {
+    transaction_type t1 = begin (db_, lock_guard{mutex_});
+    index_->insert_range (t1, std::begin (pairs), std::end (pairs));
+    ASSERT_GE (index_->root ().untag<branch const *> ()->flush_size (0U),
+               pstore::index::details::parallel_flush_threshold);
+    header = index_->flush (t1, db_.get_current_revision () + 1U);
+    t1.commit ();
+  }
+
+  default_index index{db_, header};
+  EXPECT_EQ (pairs.size (), index.size ());
+  for (auto const & kvp : pairs) {
+    auto const it = index.find (db_, kvp.first);
+    ASSERT_NE (it, index.cend (db_)) << "key " << kvp.first << " was not found";
+    EXPECT_EQ (kvp.second, it->second);
+  }
+}
+
+// test find_many: the results match those of find() for both present and absent keys.
+TEST_F (DefaultIndexFixture, FindMany) {
+  auto const pairs = make_pairs (500U, 4U);
+  auto header = pstore::typed_address<pstore::index::header_block>::null ();
+  {
+    transaction_type t1 = begin (db_, lock_guard{mutex_});
+    index_->insert_range (t1, std::begin (pairs), std::end (pairs));
+    header = index_->flush (t1, db_.get_current_revision () + 1U);
+    t1.commit ();
+  }
+  default_index const index{db_, header};
+
+  std::vector<std::string> keys;
+  for (auto ctr = std::size_t{0}; ctr < pairs.size (); ctr += 3U) {
+    keys.push_back (pairs[ctr].first);
+    keys.push_back ("absent"s + std::to_string (ctr));
+  }
+
+  for (auto const hint :
+       {pstore::database::prefetch_hint::cache, pstore::database::prefetch_hint::page}) {
+    std::vector<default_index::const_iterator> actual;
+    index.find_many (db_, std::begin (keys), std::end (keys), std::back_inserter (actual), hint);
+    ASSERT_EQ (keys.size (), actual.size ());
+    for (auto ctr = std::size_t{0}; ctr < keys.size (); ++ctr) {
+      EXPECT_EQ (index.find (db_, keys[ctr]), actual[ctr]) << "key " << keys[ctr];
+    }
+  }
+}
+
+// test find_many with spans: the values match those found by find() for both present and
+// absent keys.
+TEST_F (DefaultIndexFixture, FindManyValues) {
+  auto const pairs = make_pairs (500U, 4U);
+  auto header = pstore::typed_address<pstore::index::header_block>::null ();
+  {
+    transaction_type t1 = begin (db_, lock_guard{mutex_});
+    index_->insert_range (t1, std::begin (pairs), std::end (pairs));
+    header = index_->flush (t1, db_.get_current_revision () + 1U);
+    t1.commit ();
+  }
+  default_index const index{db_, header};
+
+  std::vector<std::string> keys;
+  for (auto ctr = std::size_t{0}; ctr < pairs.size (); ctr += 3U) {
+    keys.push_back ("absent"s + std::to_string (ctr));
+    keys.push_back (pairs[ctr].first);
+  }
+  // A key may appear more than once.
+  keys.push_back (pairs.front ().first);
+
+  std::vector<std::optional<std::string>> values (keys.size (), "stale"s);
+  auto const found =
+    index.find_many (db_, pstore::gsl::make_span (keys), pstore::gsl::make_span (values));
+  auto expected_found = std::size_t{0};
+  for (auto ctr = std::size_t{0}; ctr < keys.size (); ++ctr) {
+    auto const pos = index.find (db_, keys[ctr]);
+    if (pos == index.cend (db_)) {
+      EXPECT_FALSE (values[ctr].has_value ()) << "key " << keys[ctr];
+    } else {
+      ++expected_found;
+      EXPECT_EQ (std::optional<std::string>{pos->second}, values[ctr]) << "key " << keys[ctr];
+    }
+  }
+  EXPECT_EQ (expected_found, found);
+}
+
 // *******************************************
 // *                                         *
 // *             hash_function               *
@@ -1265,6 +1520,40 @@ TEST_F (TwoValuesWithHashCollision, LeafLevelLinearCaseIterator) {
   }
 }
 
+TEST_F (TwoValuesWithHashCollision, LeafLevelLinearFindMany) {
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  this->insert_or_assign (*index_, t1, "g");
+  this->insert_or_assign (*index_, t1, "h");
+  this->insert_or_assign (*index_, t1, "i");
+  index_->flush (t1, db_.get_current_revision ());
+
+  std::array<std::string, 3> const keys{{"i", "g", "h"}};
+  std::vector<test_trie::const_iterator> actual;
+  index_->find_many (db_, std::begin (keys), std::end (keys), std::back_inserter (actual));
+  ASSERT_EQ (keys.size (), actual.size ());
+  for (auto ctr = std::size_t{0}; ctr < keys.size (); ++ctr) {
+    ASSERT_NE (index_->cend (db_), actual[ctr]);
+    EXPECT_EQ (keys[ctr], actual[ctr]->first);
+  }
+}
+
+TEST_F (TwoValuesWithHashCollision, LeafLevelLinearFindManyValues) {
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  this->insert_or_assign (*index_, t1, "g");
+  this->insert_or_assign (*index_, t1, "h");
+  this->insert_or_assign (*index_, t1, "i");
+  index_->flush (t1, db_.get_current_revision ());
+
+  std::vector<std::string> const keys{"i", "a", "g", "h"};
+  std::vector<std::optional<std::string>> values (keys.size ());
+  EXPECT_EQ (3U, index_->find_many (db_, pstore::gsl::make_span (keys),
+                                    pstore::gsl::make_span (values)));
+  EXPECT_EQ (std::optional<std::string>{"value i"}, values[0]);
+  EXPECT_FALSE (values[1].has_value ());
+  EXPECT_EQ (std::optional<std::string>{"value g"}, values[2]);
+  EXPECT_EQ (std::optional<std::string>{"value h"}, values[3]);
+}
+
 TEST_F (TwoValuesWithHashCollision, LeafLevelLinearUpsertIterator) {
   transaction_type t1 = begin (db_, lock_guard{mutex_});
   this->insert_or_assign (*index_, t1, "g");
@@ -1324,6 +1613,42 @@ TEST_F (TwoValuesWithHashCollision, LeafLevelLinearInsertIterator) {
   std::string const & v = (*itp.first).second;
   EXPECT_EQ ("value g", v);
 }
+
+TEST_F (TwoValuesWithHashCollision, InsertRangeWithCollisions) {
+  transaction_type t1 = begin (db_, lock_guard{mutex_});
+  std::array<std::pair<std::string, std::string>, 5> const batch{{{"a"s, "value a"s},
+                                                                  {"b"s, "value b"s},
+                                                                  {"e"s, "value e"s},
+                                                                  {"f"s, "value f"s},
+                                                                  {"g"s, "value g"s}}};
+  EXPECT_EQ (5U, index_->insert_range (t1, std::begin (batch), std::end (batch)));
+  EXPECT_EQ (5U, index_->size ());
+  this->check_is_heap_branch (index_->root ());
+  index_->flush (t1, db_.get_current_revision ());
+
+  // "h" and "i" collide with "g" in all hash bits so must end up in a linear node with it.
+  std::array<std::pair<std::string, std::string>, 4> const batch2{{{"h"s, "value h"s},
+                                                                   {"i"s, "value i"s},
+                                                                   {"g"s, "new value g"s},
+                                                                   {"c"s, "value c"s}}};
+  EXPECT_EQ (3U, index_->insert_or_assign_range (t1, std::begin (batch2), std::end (batch2)));
+  EXPECT_EQ (8U, index_->size ());
+  for (auto const * key : {"a", "b", "c", "e", "f", "h", "i"}) {
+    auto const it = index_->find (db_, std::string{key});
+    ASSERT_NE (it, index_->cend (db_)) << "key " << key << " was not found";
+    EXPECT_EQ ("value "s + key, it->second);
+  }
+  EXPECT_EQ ("new value g", index_->find (db_, "g"s)->second);
+
+  // Check the result once it has been written to the store.
+  index_->flush (t1, db_.get_current_revision ());
+  std::vector<std::string> keys;
+  for (auto const & kvp : index_->make_range (db_)) {
+    keys.push_back (kvp.first);
+  }
+  std::sort (std::begin (keys), std::end (keys));
+  EXPECT_THAT (keys, ::testing::ElementsAre ("a", "b", "c", "e", "f", "g", "h", "i"));
+}
 // *******************************************
 // *                                         *
 // *         FourNodesOnTwoLevels            *
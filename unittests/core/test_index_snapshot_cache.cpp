@@ -0,0 +1,227 @@
+//===- unittests/core/test_index_snapshot_cache.cpp -----------------------===//
+//*  _           _                                       _           _    *
+//* (_)_ __   __| | _____  __  ___ _ __   __ _ _ __  ___| |__   ___ | |_  *
+//* | | '_ \ / _` |/ _ \ \/ / / __| '_ \ / _` | '_ \/ __| '_ \ / _ \| __| *
+//* | | | | | (_| |  __/>  <  \__ \ | | | (_| | |_) \__ \ | | | (_) | |_  *
+//* |_|_| |_|\__,_|\___/_/\_\ |___/_| |_|\__,_| .__/|___/_| |_|\___/ \__| *
+//*                                           |_|                         *
+//*                 _           *
+//*   ___ __ _  ___| |__   ___  *
+//*  / __/ _` |/ __| '_ \ / _ \ *
+//* | (_| (_| | (__| | | |  __/ *
+//*  \___\__,_|\___|_| |_|\___| *
+//*                             *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/core/index_snapshot_cache.hpp"
+
+// Standard library includes
+#include <string>
+#include <thread>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/index_types.hpp"
+#include "pstore/core/transaction.hpp"
+
+// local includes
+#include "empty_store.hpp"
+
+namespace {
+
+  class IndexSnapshot : public testing::Test {
+  public:
+    IndexSnapshot ()
+            : db_{store_.file ()} {
+      db_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    }
+
+  protected:
+    using lock_guard = std::unique_lock<mock_mutex>;
+    using transaction_type = pstore::transaction<lock_guard>;
+    static constexpr auto write_index = pstore::trailer::indices::write;
+
+    /// Commits a transaction which adds \p key to the write index.
+    void add (std::string const & key);
+
+    mock_mutex mutex_;
+    in_memory_store store_;
+    pstore::database db_;
+  };
+
+  // add
+  // ~~~
+  void IndexSnapshot::add (std::string const & key) {
+    transaction_type t = begin (db_, lock_guard{mutex_});
+    auto const index = pstore::index::get_index<write_index> (db_);
+    index->insert_or_assign (t, key, pstore::extent<char>{});
+    t.commit ();
+  }
+
+} // end anonymous namespace
+
+TEST_F (IndexSnapshot, NoIndex) {
+  EXPECT_EQ (pstore::index::get_index_snapshot<write_index> (db_), nullptr);
+}
+
+TEST_F (IndexSnapshot, SameLocationSameInstance) {
+  this->add ("a");
+  auto const s1 = pstore::index::get_index_snapshot<write_index> (db_);
+  auto const s2 = pstore::index::get_index_snapshot<write_index> (db_);
+  ASSERT_NE (s1, nullptr);
+  EXPECT_EQ (s1, s2);
+}
+
+TEST_F (IndexSnapshot, OlderRevision) {
+  this->add ("a");
+  this->add ("b");
+
+  auto const r1 =
+    pstore::index::get_index_snapshot<write_index> (db_, db_.older_revision_footer_pos (1));
+  auto const r2 = pstore::index::get_index_snapshot<write_index> (db_);
+  ASSERT_NE (r1, nullptr);
+  ASSERT_NE (r2, nullptr);
+  EXPECT_NE (r1, r2);
+
+  EXPECT_TRUE (r1->contains (db_, std::string{"a"}));
+  EXPECT_FALSE (r1->contains (db_, std::string{"b"}));
+  EXPECT_TRUE (r2->contains (db_, std::string{"a"}));
+  EXPECT_TRUE (r2->contains (db_, std::string{"b"}));
+
+  // A snapshot remains valid when the database moves to a different revision.
+  db_.sync (1);
+  EXPECT_EQ (r1, pstore::index::get_index_snapshot<write_index> (db_));
+}
+
+TEST_F (IndexSnapshot, ConcurrentReaders) {
+  this->add ("a");
+  this->add ("b");
+  auto const r1_pos = db_.older_revision_footer_pos (1);
+  auto const r2_pos = db_.footer_pos ();
+
+  constexpr auto num_threads = 4U;
+  constexpr auto iterations = 100U;
+  std::vector<std::shared_ptr<pstore::index::write_index const>> r1 (num_threads);
+  std::vector<std::shared_ptr<pstore::index::write_index const>> r2 (num_threads);
+  std::vector<unsigned> failures (num_threads, 0U);
+  std::vector<std::thread> threads;
+  threads.reserve (num_threads);
+  for (auto t = 0U; t < num_threads; ++t) {
+    threads.emplace_back ([&, t] () {
+      for (auto ctr = 0U; ctr < iterations; ++ctr) {
+        r1[t] = pstore::index::get_index_snapshot<write_index> (db_, r1_pos);
+        r2[t] = pstore::index::get_index_snapshot<write_index> (db_, r2_pos);
+        if (!r1[t]->contains (db_, std::string{"a"}) || r1[t]->contains (db_, std::string{"b"}) ||
+            !r2[t]->contains (db_, std::string{"b"})) {
+          ++failures[t];
+        }
+      }
+    });
+  }
+  for (auto & thread : threads) {
+    thread.join ();
+  }
+
+  for (auto t = 0U; t < num_threads; ++t) {
+    EXPECT_EQ (failures[t], 0U);
+    // Every thread must have been given the same instance for each revision.
+    EXPECT_EQ (r1[t], r1[0]);
+    EXPECT_EQ (r2[t], r2[0]);
+  }
+}
+
+TEST (SnapshotCache, InsertDuplicateReturnsOriginal) {
+  using pstore::index::index_base;
+  using pstore::trailer;
+  struct dummy final : index_base {};
+
+  pstore::index::snapshot_cache cache;
+  auto const location = pstore::address{64};
+  EXPECT_EQ (cache.find (trailer::indices::write, location), nullptr);
+
+  std::shared_ptr<index_base const> const first = std::make_shared<dummy> ();
+  EXPECT_EQ (cache.insert (trailer::indices::write, location, first), first);
+  EXPECT_EQ (cache.insert (trailer::indices::write, location, std::make_shared<dummy> ()),
+             first);
+  EXPECT_EQ (cache.find (trailer::indices::write, location), first);
+  // Each index kind has its own entries.
+  EXPECT_EQ (cache.find (trailer::indices::name, location), nullptr);
+
+  cache.clear ();
+  EXPECT_EQ (cache.find (trailer::indices::write, location), nullptr);
+}
+
+TEST (SnapshotCache, EvictsLeastRecentlyUsed) {
+  using pstore::index::index_base;
+  using pstore::trailer;
+  struct dummy final : index_base {};
+  constexpr auto which = trailer::indices::write;
+  auto const a = pstore::address{64};
+  auto const b = pstore::address{128};
+  auto const c = pstore::address{192};
+
+  pstore::index::snapshot_cache cache{2U};
+  std::shared_ptr<index_base const> const ia = cache.insert (which, a, std::make_shared<dummy> ());
+  std::weak_ptr<index_base const> ib = cache.insert (which, b, std::make_shared<dummy> ());
+  EXPECT_FALSE (ib.expired ());
+
+  // Using 'a' gives it a second chance so 'b', which has not been used since it was added, is
+  // the entry that is evicted.
+  EXPECT_EQ (cache.find (which, a), ia);
+  std::shared_ptr<index_base const> const ic = cache.insert (which, c, std::make_shared<dummy> ());
+  EXPECT_EQ (cache.find (which, a), ia);
+  EXPECT_EQ (cache.find (which, b), nullptr);
+  EXPECT_EQ (cache.find (which, c), ic);
+  // Nothing else refers to the evicted instance so it has been destroyed.
+  EXPECT_TRUE (ib.expired ());
+
+  // The other index kinds have their own entries.
+  EXPECT_NE (cache.insert (trailer::indices::name, b, std::make_shared<dummy> ()), nullptr);
+  EXPECT_EQ (cache.find (which, a), ia);
+  EXPECT_EQ (cache.find (which, c), ic);
+}
+
+TEST (SnapshotCache, ConcurrentFindAndEvict) {
+  using pstore::index::index_base;
+  using pstore::trailer;
+  struct dummy final : index_base {
+    explicit dummy (pstore::address const l) noexcept
+            : location{l} {}
+    pstore::address const location;
+  };
+  constexpr auto which = trailer::indices::write;
+  constexpr auto num_threads = 4U;
+  constexpr auto num_locations = 6U;
+  constexpr auto iterations = 2000U;
+
+  // There are more locations than slots so entries are evicted whilst other threads are
+  // reading them. Every instance returned must be the one for the requested location.
+  pstore::index::snapshot_cache cache{2U};
+  std::vector<std::thread> threads;
+  for (auto t = 0U; t < num_threads; ++t) {
+    threads.emplace_back ([&cache, t] () {
+      for (auto ctr = 0U; ctr < iterations; ++ctr) {
+        auto const location = pstore::address{64U * (1U + (ctr + t) % num_locations)};
+        std::shared_ptr<index_base const> index = cache.find (which, location);
+        if (index == nullptr) {
+          index = cache.insert (which, location, std::make_shared<dummy> (location));
+        }
+        ASSERT_NE (index, nullptr);
+        EXPECT_EQ (static_cast<dummy const &> (*index).location, location);
+      }
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join ();
+  }
+}
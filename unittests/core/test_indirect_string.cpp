@@ -32,6 +32,10 @@ using namespace std::string_view_literals;
 
 namespace {
 
+  /// The number of bytes occupied by an in-store indirect_string: the address of the body
+  /// followed by its hash.
+  constexpr auto indirect_size = sizeof (pstore::address) + sizeof (std::uint64_t);
+
   class IndirectString : public testing::Test {
   public:
     IndirectString ()
@@ -73,7 +77,7 @@ TEST_F (IndirectString, StoreRefToHeapRoundTrip) {
     pstore::indirect_string indirect{db_, &sstring};
     auto writer = pstore::serialize::archive::make_writer (transaction);
     pstore::address const indirect_addr = pstore::serialize::write (writer, indirect);
-    EXPECT_EQ (transaction.size (), sizeof (pstore::address));
+    EXPECT_EQ (transaction.size (), indirect_size);
 
     transaction.commit ();
     return indirect_addr;
@@ -100,7 +104,7 @@ TEST_F (IndirectString, StoreRoundTrip) {
     pstore::indirect_string indirect{db_, &sstring};
     auto writer = pstore::serialize::archive::make_writer (transaction);
     auto const indirect_addr = pstore::serialize::write (writer, indirect);
-    EXPECT_EQ (transaction.size (), sizeof (pstore::address));
+    EXPECT_EQ (transaction.size (), indirect_size);
 
     // Now the body of the string (and patch the pointer).
     pstore::indirect_string::write_body_and_patch_address (
@@ -150,6 +154,32 @@ namespace {
 
 } // end anonymous namespace
 
+TEST_F (IndirectString, HashIsRecorded) {
+  using namespace pstore;
+  constexpr auto str = "string";
+  raw_sstring_view const sstring = make_sstring_view (str);
+
+  mock_mutex mutex;
+  auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+  address const indirect_addr = write_indirected_string (transaction, str).first;
+
+  auto reader = serialize::archive::make_reader (db_, indirect_addr);
+  auto const ind = serialize::read<indirect_string> (reader);
+  EXPECT_EQ (ind.hash (), fnv_64a_hash () (sstring));
+  EXPECT_EQ (indirect_string (db_, ind.in_store_address ()).hash (), ind.hash ())
+    << "A hash computed from the body must match the recorded value";
+
+  // Replace the string body pointer with a bogus address. Comparison with a string whose
+  // hash differs must not need to read the body.
+  *db_.getrw (typed_address<address> (indirect_addr)) = address{0x02};
+  auto reader2 = serialize::archive::make_reader (db_, indirect_addr);
+  auto const bad = serialize::read<indirect_string> (reader2);
+  raw_sstring_view const other = make_sstring_view ("other");
+  EXPECT_FALSE (bad == indirect_string (db_, &other));
+
+  transaction.commit ();
+}
+
 TEST_F (IndirectString, BadDatabaseAddress) {
   using namespace pstore;
 
@@ -229,7 +259,7 @@ TEST_F (IndirectStringAdder, NewString) {
         EXPECT_EQ (res2.first->as_string_view (&res2_owner), sstring1);
         EXPECT_FALSE (res2.second);
       }
-      EXPECT_EQ (transaction.size (), sizeof (pstore::address));
+      EXPECT_EQ (transaction.size (), indirect_size);
       adder.flush (transaction);
     }
     transaction.commit ();
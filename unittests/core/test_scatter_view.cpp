@@ -0,0 +1,98 @@
+//===- unittests/core/test_scatter_view.cpp -------------------------------===//
+//*                _   _                    _                *
+//*  ___  ___ __ _| |_| |_ ___ _ __  __   _(_) _____      __ *
+//* / __|/ __/ _` | __| __/ _ \ '__| \ \ / / |/ _ \ \ /\ / / *
+//* \__ \ (_| (_| | |_| ||  __/ |     \ V /| |  __/\ V  V /  *
+//* |___/\___\__,_|\__|\__\___|_|      \_/ |_|\___| \_/\_/   *
+//*                                                          *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/core/scatter_view.hpp"
+
+// Standard library includes
+#include <numeric>
+#include <vector>
+
+// 3rd party includes
+#include <gmock/gmock.h>
+
+// pstore includes
+#include "pstore/core/database.hpp"
+
+namespace {
+
+  class ScatterView : public testing::Test {
+  public:
+    ScatterView ()
+            : file_{std::make_shared<pstore::file::in_memory> (
+                pstore::aligned_valloc (file_size, page_size), file_size)} {
+      pstore::database::build_new_store (*file_);
+    }
+
+  protected:
+    static constexpr auto page_size = std::size_t{4096};
+    static constexpr auto region_size = pstore::storage::min_region_size;
+    static constexpr auto file_size = region_size * 2U;
+
+    std::shared_ptr<pstore::file::in_memory> file_;
+  };
+
+} // end anonymous namespace
+
+TEST_F (ScatterView, Empty) {
+  pstore::scatter_view const view;
+  EXPECT_TRUE (view.empty ());
+  EXPECT_TRUE (view.is_contiguous ());
+  EXPECT_EQ (0U, view.pieces ());
+  EXPECT_EQ (view.bytes_begin (), view.bytes_end ());
+}
+
+TEST_F (ScatterView, SingleRegion) {
+  pstore::database db{file_};
+  db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+  auto const addr = db.allocate (16U, 1U /*align*/);
+
+  pstore::scatter_view const view = db.getro_view (addr, 16U);
+  EXPECT_EQ (16U, view.size ());
+  EXPECT_TRUE (view.is_contiguous ());
+  ASSERT_EQ (1U, view.pieces ());
+  EXPECT_EQ (db.storage ().address_to_raw_pointer (addr), view.begin ()->data ());
+}
+
+TEST_F (ScatterView, SpansRegions) {
+  pstore::database db{file_};
+  db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+
+  // Allocate enough storage that a second region is needed then place a block of data so that
+  // it straddles the boundary between them.
+  constexpr auto size = std::size_t{32};
+  db.allocate (region_size - db.size () - size / 2U, 1U /*align*/);
+  auto const addr = db.allocate (size, 1U /*align*/);
+  ASSERT_EQ (2U, db.storage ().regions ().size ());
+
+  std::vector<std::uint8_t> expected (size);
+  std::iota (std::begin (expected), std::end (expected), std::uint8_t{0});
+  {
+    std::shared_ptr<void> const rw = db.getrw (addr, size);
+    std::copy (std::begin (expected), std::end (expected), static_cast<std::uint8_t *> (rw.get ()));
+  }
+
+  pstore::scatter_view const view = db.getro_view (addr, size);
+  EXPECT_EQ (size, view.size ());
+  EXPECT_FALSE (view.is_contiguous ());
+  ASSERT_EQ (2U, view.pieces ());
+  EXPECT_EQ (size / 2U, static_cast<std::size_t> (view.begin ()->size ()));
+
+  std::vector<std::uint8_t> actual (size);
+  view.copy (actual.data ());
+  EXPECT_THAT (actual, testing::ContainerEq (expected));
+
+  EXPECT_THAT (std::vector<std::uint8_t> (view.bytes_begin (), view.bytes_end ()),
+               testing::ContainerEq (expected));
+}
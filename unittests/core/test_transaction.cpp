@@ -16,13 +16,17 @@
 #include "pstore/core/transaction.hpp"
 
 // Standard library includes
+#include <algorithm>
+#include <array>
 #include <mutex>
 #include <numeric>
+#include <vector>
 
 // 3rd party includes
 #include <gmock/gmock.h>
 
 // Local includes
+#include "check_for_error.hpp"
 #include "empty_store.hpp"
 
 namespace {
@@ -485,3 +489,101 @@ TEST_F (Transaction, GetRwUInt64) {
   }
   EXPECT_EQ (expected, *db_.getro (extent));
 }
+
+TEST_F (Transaction, CopyFromFile) {
+  // An in-memory file has no file descriptor so the data must be streamed into the store.
+  std::array<std::uint8_t, 16> src{};
+  std::iota (std::begin (src), std::end (src), std::uint8_t{1});
+  auto const buffer = std::make_shared<std::array<std::uint8_t, 16>> (src);
+  pstore::file::in_memory file{buffer, buffer->size (), buffer->size (), false};
+
+  pstore::extent<std::uint8_t> extent;
+  {
+    mock_mutex mutex;
+    auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+    extent = make_extent (
+      pstore::typed_address<std::uint8_t>::make (transaction.copy_from (file, 4U, 10U, 1U)),
+      10U);
+    transaction.commit ();
+  }
+  std::shared_ptr<std::uint8_t const> const actual = db_.getro (extent);
+  EXPECT_THAT (std::vector<std::uint8_t> (actual.get (), actual.get () + extent.size),
+               testing::ElementsAreArray (src.data () + 4, 10));
+}
+
+TEST_F (Transaction, CopyFromFileTooShort) {
+  auto const buffer = std::make_shared<std::array<std::uint8_t, 4>> ();
+  pstore::file::in_memory file{buffer, buffer->size (), buffer->size (), false};
+
+  mock_mutex mutex;
+  auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+  check_for_error ([&] () { transaction.copy_from (file, 0U, 8U, 1U); },
+                   pstore::error_code::did_not_read_number_of_bytes_requested);
+  transaction.rollback ();
+}
+
+TEST_F (Transaction, CopyFromDatabase) {
+  in_memory_store source_store;
+  pstore::database source{source_store.file ()};
+  source.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+
+  std::uint64_t const expected = 1ULL << 40;
+  pstore::extent<std::uint64_t> source_extent;
+  {
+    mock_mutex mutex;
+    auto transaction = begin (source, std::unique_lock<mock_mutex>{mutex});
+    auto [ptr, addr] = transaction.alloc_rw<std::uint64_t> ();
+    *ptr = expected;
+    source_extent = make_extent (addr, sizeof (std::uint64_t));
+    transaction.commit ();
+  }
+
+  pstore::extent<std::uint64_t> extent;
+  {
+    mock_mutex mutex;
+    auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+    extent = transaction.copy_from (source, source_extent);
+    transaction.commit ();
+  }
+  EXPECT_EQ (extent.size, source_extent.size);
+  EXPECT_EQ (expected, *db_.getro (extent));
+}
+
+TEST (TransactionFile, CopyFromFileToFileBackedStore) {
+  // Both the source and the store are physical files so the kernel may perform the copy.
+  using pstore::file::file_handle;
+  std::string const tmp = file_handle::get_temporary_directory ();
+
+  std::vector<std::uint8_t> src (std::size_t{3} * 4096U + 17U);
+  std::iota (std::begin (src), std::end (src), std::uint8_t{0});
+  file_handle file;
+  file.open (file_handle::unique{}, tmp);
+  file.write_span (
+    pstore::gsl::make_span (reinterpret_cast<std::byte const *> (src.data ()), src.size ()));
+
+  file_handle store_file;
+  store_file.open (file_handle::unique{}, tmp);
+  std::string const store_path = store_file.path ();
+  store_file.close ();
+  pstore::file::unlink (store_path);
+
+  {
+    pstore::database db{store_path, pstore::database::access_mode::writable};
+    db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    pstore::extent<std::uint8_t> extent;
+    {
+      auto transaction = begin (db);
+      extent = make_extent (pstore::typed_address<std::uint8_t>::make (
+                              transaction.copy_from (file, 1U, src.size () - 1U, 1U)),
+                            src.size () - 1U);
+      transaction.commit ();
+    }
+    std::shared_ptr<std::uint8_t const> const actual = db.getro (extent);
+    EXPECT_TRUE (std::equal (std::next (std::begin (src)), std::end (src), actual.get ()));
+  }
+
+  std::string const path = file.path ();
+  file.close ();
+  pstore::file::unlink (path);
+  pstore::file::unlink (store_path);
+}
@@ -0,0 +1,314 @@
+//===- unittests/exchange/test_binary.cpp ---------------------------------===//
+//*  _     _                         *
+//* | |__ (_)_ __   __ _ _ __ _   _  *
+//* | '_ \| | '_ \ / _` | '__| | | | *
+//* | |_) | | | | | (_| | |  | |_| | *
+//* |_.__/|_|_| |_|\__,_|_|   \__, | *
+//*                           |___/  *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/exchange/import_binary.hpp"
+
+// Standard library
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/exchange/export.hpp"
+#include "pstore/exchange/import_error.hpp"
+#include "pstore/mcrepo/bss_section.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/debug_line_section.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/mcrepo/linked_definitions_section.hpp"
+#include "pstore/support/pointee_adaptor.hpp"
+
+// local includes
+#include "add_export_strings.hpp"
+
+namespace {
+
+  using transaction_lock = std::unique_lock<mock_mutex>;
+  using string_address = pstore::typed_address<pstore::indirect_string>;
+
+  class ExchangeBinary : public testing::Test {
+  public:
+    ExchangeBinary ()
+            : export_db_{export_store_.file ()}
+            , import_db_{import_store_.file ()} {
+      export_db_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+      import_db_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    }
+
+  protected:
+    /// Adds a transaction to the export database containing names, paths, a debug line header,
+    /// and fragments which between them use each of the kinds of section that the binary
+    /// format records differently.
+    void add_generation (unsigned generation);
+
+    template <typename Function>
+    static std::string export_to_string (Function fn);
+
+    std::string export_binary (pstore::database const & db) const {
+      return export_to_string ([&db] (pstore::exchange::export_ns::ostream & os) {
+        pstore::exchange::export_ns::emit_database_binary (db, os);
+      });
+    }
+    std::string export_json (pstore::database & db) const {
+      db.sync ();
+      return export_to_string ([&db] (pstore::exchange::export_ns::ostream & os) {
+        pstore::exchange::export_ns::emit_database (db, os, false);
+      });
+    }
+
+    using store_mode = pstore::exchange::import_ns::binary_parser::store_mode;
+
+    /// Imports \p binary into import_db_, presenting it to the parser in pieces of at most
+    /// \p chunk_size bytes. If \p pos is not null, it receives the parser's final position.
+    std::error_code import (std::string const & binary, std::size_t chunk_size,
+                            store_mode mode = store_mode::immediate, std::size_t max_queued = 0,
+                            std::uint64_t * pos = nullptr);
+
+    in_memory_store export_store_;
+    pstore::database export_db_;
+    in_memory_store import_store_;
+    pstore::database import_db_;
+  };
+
+  void ExchangeBinary::add_generation (unsigned const generation) {
+    using namespace pstore::repo;
+
+    auto const suffix = std::to_string (generation);
+    std::string const triple = "triple" + suffix;
+    std::string const name = "name" + suffix;
+    std::string const target = "target" + suffix;
+    std::array<pstore::gsl::czstring, 3> names{{triple.c_str (), name.c_str (), target.c_str ()}};
+    std::unordered_map<std::string, string_address> indir_strings;
+    add_export_strings<pstore::trailer::indices::name> (
+      export_db_, std::begin (names), std::end (names),
+      std::inserter (indir_strings, std::end (indir_strings)));
+
+    std::string const path = "/path/" + suffix;
+    std::array<pstore::gsl::czstring, 1> paths{{path.c_str ()}};
+    std::unordered_map<std::string, string_address> indir_paths;
+    add_export_strings<pstore::trailer::indices::path> (
+      export_db_, std::begin (paths), std::end (paths),
+      std::inserter (indir_paths, std::end (indir_paths)));
+
+    mock_mutex mutex;
+    auto transaction = begin (export_db_, transaction_lock{mutex});
+    auto const fragments =
+      pstore::index::get_index<pstore::trailer::indices::fragment> (export_db_);
+    auto const compilations =
+      pstore::index::get_index<pstore::trailer::indices::compilation> (export_db_);
+    auto const headers =
+      pstore::index::get_index<pstore::trailer::indices::debug_line_header> (export_db_);
+
+    std::array<std::uint8_t, 5> const header{{1, 2, 3, 4, static_cast<std::uint8_t> (generation)}};
+    pstore::index::digest const header_digest{generation, 1U};
+    auto [ptr, addr] = transaction.alloc_rw<std::uint8_t> (header.size ());
+    std::copy (std::begin (header), std::end (header), ptr.get ());
+    auto const header_extent = make_extent (addr, header.size ());
+    headers->insert (transaction, std::make_pair (header_digest, header_extent));
+
+    pstore::index::digest const compilation_digest{generation, 0U};
+    pstore::index::digest const first_digest{generation, 10U};
+    pstore::index::digest const second_digest{generation, 11U};
+
+    // The first fragment: text with internal and external fixups, data, and debug line.
+    section_content text{section_kind::text, std::uint8_t{16}};
+    std::string const code = "code" + suffix;
+    text.data.assign (std::begin (code), std::end (code));
+    text.ifixups.emplace_back (section_kind::data, relocation_type{3}, 1U, -2);
+    text.xfixups.emplace_back (indir_strings[target], relocation_type{5}, binding::weak, 2U, 7);
+    text.xfixups.emplace_back (indir_strings[target], relocation_type{6}, binding::strong, 3U,
+                               0);
+    section_content data{section_kind::data};
+    data.data.assign (std::begin (suffix), std::end (suffix));
+    section_content debug_line{section_kind::debug_line};
+    debug_line.data.assign ({9, 8, 7});
+
+    std::vector<std::unique_ptr<section_creation_dispatcher>> first;
+    first.emplace_back (new generic_section_creation_dispatcher (section_kind::text, &text));
+    first.emplace_back (new generic_section_creation_dispatcher (section_kind::data, &data));
+    first.emplace_back (
+      new debug_line_section_creation_dispatcher (header_digest, header_extent, &debug_line));
+    auto const first_extent = fragment::alloc (
+      transaction, pstore::make_pointee_adaptor (first.begin ()),
+      pstore::make_pointee_adaptor (first.end ()));
+    fragments->insert (transaction, std::make_pair (first_digest, first_extent));
+
+    // The second fragment: bss and a link to the first fragment's definition.
+    section_content bss{section_kind::bss, std::uint8_t{8}};
+    bss.data.resize (32U);
+    std::array<linked_definitions::value_type, 1> const links{{linked_definitions::value_type{
+      compilation_digest, 0U, pstore::typed_address<definition>::null ()}}};
+
+    std::vector<std::unique_ptr<section_creation_dispatcher>> second;
+    auto bss_dispatcher = std::make_unique<bss_section_creation_dispatcher> ();
+    bss_dispatcher->set_content (&bss);
+    second.emplace_back (std::move (bss_dispatcher));
+    second.emplace_back (
+      new linked_definitions_creation_dispatcher (links.data (), links.data () + links.size ()));
+    auto const second_extent = fragment::alloc (
+      transaction, pstore::make_pointee_adaptor (second.begin ()),
+      pstore::make_pointee_adaptor (second.end ()));
+    fragments->insert (transaction, std::make_pair (second_digest, second_extent));
+
+    std::array<definition, 2> const definitions{
+      {definition{first_digest, first_extent, indir_strings[name], linkage::external},
+       definition{second_digest, second_extent, indir_strings[target], linkage::link_once_odr,
+                  visibility::hidden_vis}}};
+    compilations->insert (
+      transaction,
+      std::make_pair (compilation_digest,
+                      compilation::alloc (transaction, indir_strings[triple],
+                                          std::begin (definitions), std::end (definitions))));
+    transaction.commit ();
+  }
+
+  template <typename Function>
+  std::string ExchangeBinary::export_to_string (Function fn) {
+    std::unique_ptr<std::FILE, decltype (&std::fclose)> file{std::tmpfile (), &std::fclose};
+    if (file == nullptr) {
+      return {};
+    }
+    {
+      pstore::exchange::export_ns::ostream os{file.get ()};
+      fn (os);
+      os.flush ();
+    }
+    std::rewind (file.get ());
+    std::string result;
+    std::array<char, 4096> buffer;
+    while (auto const n = std::fread (buffer.data (), 1U, buffer.size (), file.get ())) {
+      result.append (buffer.data (), n);
+    }
+    return result;
+  }
+
+  std::error_code ExchangeBinary::import (std::string const & binary,
+                                          std::size_t const chunk_size, store_mode const mode,
+                                          std::size_t const max_queued,
+                                          std::uint64_t * const pos) {
+    pstore::exchange::import_ns::binary_parser parser{&import_db_, mode, max_queued};
+    auto const * first = reinterpret_cast<std::byte const *> (binary.data ());
+    auto const * const last = first + binary.size ();
+    while (first != last && !parser.has_error ()) {
+      auto const * const end =
+        first + std::min (chunk_size, static_cast<std::size_t> (last - first));
+      parser.input (first, end);
+      first = end;
+    }
+    parser.eof ();
+    if (pos != nullptr) {
+      *pos = parser.pos ();
+    }
+    return parser.last_error ();
+  }
+
+} // end anonymous namespace
+
+TEST_F (ExchangeBinary, IsBinaryInput) {
+  using pstore::exchange::import_ns::is_binary_input;
+  std::string const binary = this->export_binary (export_db_);
+  auto const * const first = reinterpret_cast<std::byte const *> (binary.data ());
+  EXPECT_TRUE (is_binary_input (first, first + binary.size ()));
+  EXPECT_FALSE (is_binary_input (first, first + 3));
+
+  std::string const json = this->export_json (export_db_);
+  auto const * const jfirst = reinterpret_cast<std::byte const *> (json.data ());
+  EXPECT_FALSE (is_binary_input (jfirst, jfirst + json.size ()));
+}
+
+TEST_F (ExchangeBinary, RoundTripEmpty) {
+  std::string const binary = this->export_binary (export_db_);
+  EXPECT_EQ (this->import (binary, binary.size ()), std::error_code{});
+  EXPECT_EQ (this->export_json (export_db_), this->export_json (import_db_));
+}
+
+TEST_F (ExchangeBinary, RoundTrip) {
+  for (auto generation = 1U; generation <= 3U; ++generation) {
+    this->add_generation (generation);
+  }
+  std::string const binary = this->export_binary (export_db_);
+  ASSERT_EQ (this->import (binary, binary.size ()), std::error_code{});
+  EXPECT_EQ (this->export_json (export_db_), this->export_json (import_db_));
+  EXPECT_EQ (binary, this->export_binary (import_db_));
+}
+
+TEST_F (ExchangeBinary, RoundTripInSmallPieces) {
+  for (auto generation = 1U; generation <= 2U; ++generation) {
+    this->add_generation (generation);
+  }
+  std::string const binary = this->export_binary (export_db_);
+  // An odd-sized piece means that every item straddles at least one boundary.
+  ASSERT_EQ (this->import (binary, 7U), std::error_code{});
+  EXPECT_EQ (this->export_json (export_db_), this->export_json (import_db_));
+}
+
+TEST_F (ExchangeBinary, RoundTripBackgroundStore) {
+  for (auto generation = 1U; generation <= 3U; ++generation) {
+    this->add_generation (generation);
+  }
+  std::string const binary = this->export_binary (export_db_);
+  // A tiny limit on the queue means that the parser must regularly wait for the store.
+  ASSERT_EQ (this->import (binary, 7U, store_mode::background, 1U), std::error_code{});
+  EXPECT_EQ (this->export_json (export_db_), this->export_json (import_db_));
+}
+
+TEST_F (ExchangeBinary, BackgroundStoreError) {
+  this->add_generation (1U);
+  std::string const binary = this->export_binary (export_db_);
+  ASSERT_EQ (this->import (binary, binary.size ()), std::error_code{});
+
+  // Importing the same data a second time fails when the duplicate names are stored. The
+  // error and its position must be the same whether or not the store runs on its own thread.
+  auto const expected = make_error_code (pstore::exchange::import_ns::error::duplicate_name);
+  std::uint64_t immediate_pos = 0;
+  EXPECT_EQ (this->import (binary, binary.size (), store_mode::immediate, 0U, &immediate_pos),
+             expected);
+  std::uint64_t background_pos = 0;
+  EXPECT_EQ (this->import (binary, binary.size (), store_mode::background, 0U, &background_pos),
+             expected);
+  EXPECT_EQ (immediate_pos, background_pos);
+  EXPECT_GT (background_pos, 0U);
+}
+
+TEST_F (ExchangeBinary, BadSignature) {
+  std::string binary = this->export_binary (export_db_);
+  binary[0] = 'q';
+  EXPECT_EQ (this->import (binary, binary.size ()),
+             make_error_code (pstore::exchange::import_ns::error::bad_signature));
+}
+
+TEST_F (ExchangeBinary, Truncated) {
+  this->add_generation (1U);
+  std::string binary = this->export_binary (export_db_);
+  binary.pop_back ();
+  EXPECT_EQ (this->import (binary, binary.size ()),
+             make_error_code (pstore::exchange::import_ns::error::unexpected_end_of_input));
+}
+
+TEST_F (ExchangeBinary, MissingEnd) {
+  this->add_generation (1U);
+  std::string binary = this->export_binary (export_db_);
+  // Remove the end record entirely: the input is well-formed but incomplete.
+  binary.resize (binary.size () - 16U);
+  EXPECT_EQ (this->import (binary, binary.size ()),
+             make_error_code (pstore::exchange::import_ns::error::unexpected_end_of_input));
+}
@@ -0,0 +1,164 @@
+//===- unittests/exchange/test_export.cpp ---------------------------------===//
+//*                             _    *
+//*   _____  ___ __   ___  _ __| |_  *
+//*  / _ \ \/ / '_ \ / _ \| '__| __| *
+//* |  __/>  <| |_) | (_) | |  | |_  *
+//*  \___/_/\_\ .__/ \___/|_|   \__| *
+//*           |_|                    *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/exchange/export.hpp"
+
+// Standard library
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/mcrepo/bss_section.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+
+// local includes
+#include "add_export_strings.hpp"
+
+namespace {
+
+  using transaction_lock = std::unique_lock<mock_mutex>;
+  using string_address = pstore::typed_address<pstore::indirect_string>;
+
+  class ExchangeExport : public testing::Test {
+  public:
+    ExchangeExport ()
+            : db_{store_.file ()} {
+      db_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    }
+
+  protected:
+    /// Adds a transaction containing names, paths, and enough fragments that their export
+    /// is divided between several pieces of work.
+    void add_generation (unsigned generation);
+
+    template <typename Function>
+    static std::string export_to_string (Function fn);
+
+    in_memory_store store_;
+    pstore::database db_;
+  };
+
+  void ExchangeExport::add_generation (unsigned const generation) {
+    auto const suffix = std::to_string (generation);
+    std::string const triple = "triple" + suffix;
+    std::string const name = "name" + suffix;
+    std::array<pstore::gsl::czstring, 2> names{{triple.c_str (), name.c_str ()}};
+    std::unordered_map<std::string, string_address> indir_strings;
+    add_export_strings<pstore::trailer::indices::name> (
+      db_, std::begin (names), std::end (names),
+      std::inserter (indir_strings, std::end (indir_strings)));
+
+    std::string const path = "/path/" + suffix;
+    std::array<pstore::gsl::czstring, 1> paths{{path.c_str ()}};
+    std::unordered_map<std::string, string_address> indir_paths;
+    add_export_strings<pstore::trailer::indices::path> (
+      db_, std::begin (paths), std::end (paths),
+      std::inserter (indir_paths, std::end (indir_paths)));
+
+    mock_mutex mutex;
+    auto transaction = begin (db_, transaction_lock{mutex});
+    auto const fragments = pstore::index::get_index<pstore::trailer::indices::fragment> (db_);
+    auto const compilations =
+      pstore::index::get_index<pstore::trailer::indices::compilation> (db_);
+    auto const headers =
+      pstore::index::get_index<pstore::trailer::indices::debug_line_header> (db_);
+
+    pstore::repo::section_content content{pstore::repo::section_kind::bss};
+    content.align = 4U;
+    content.data.resize (16U);
+    std::array<pstore::repo::bss_section_creation_dispatcher, 1> dispatcher;
+    dispatcher[0].set_content (&content);
+
+    std::vector<pstore::repo::definition> definitions;
+    for (auto ctr = std::uint64_t{0}; ctr < 300U; ++ctr) {
+      pstore::index::digest const digest{generation, ctr};
+      pstore::extent<pstore::repo::fragment> const fext =
+        pstore::repo::fragment::alloc (transaction, std::begin (dispatcher), std::end (dispatcher));
+      fragments->insert (transaction, std::make_pair (digest, fext));
+      definitions.emplace_back (digest, fext, indir_strings[name],
+                                pstore::repo::linkage::external);
+    }
+    compilations->insert (transaction,
+                          std::make_pair (pstore::index::digest{generation, 0U},
+                                          pstore::repo::compilation::alloc (
+                                            transaction, indir_strings[triple],
+                                            std::begin (definitions), std::end (definitions))));
+
+    std::array<std::uint8_t, 5> const header{{1, 2, 3, 4, static_cast<std::uint8_t> (generation)}};
+    auto [ptr, addr] = transaction.alloc_rw<std::uint8_t> (header.size ());
+    std::copy (std::begin (header), std::end (header), ptr.get ());
+    headers->insert (transaction, std::make_pair (pstore::index::digest{generation, 1U},
+                                                  make_extent (addr, header.size ())));
+    transaction.commit ();
+  }
+
+  template <typename Function>
+  std::string ExchangeExport::export_to_string (Function fn) {
+    std::unique_ptr<std::FILE, decltype (&std::fclose)> file{std::tmpfile (), &std::fclose};
+    if (file == nullptr) {
+      return {};
+    }
+    {
+      pstore::exchange::export_ns::ostream os{file.get ()};
+      fn (os);
+      os.flush ();
+    }
+    std::rewind (file.get ());
+    std::string result;
+    std::array<char, 4096> buffer;
+    while (auto const n = std::fread (buffer.data (), 1U, buffer.size (), file.get ())) {
+      result.append (buffer.data (), n);
+    }
+    return result;
+  }
+
+} // end anonymous namespace
+
+TEST_F (ExchangeExport, ParallelEmptyMatchesSerial) {
+  using namespace pstore::exchange::export_ns;
+  std::string const serial =
+    export_to_string ([this] (ostream & os) { emit_database (db_, os, true); });
+  std::string const parallel =
+    export_to_string ([this] (ostream & os) { emit_database_parallel (db_, os, true); });
+  EXPECT_EQ (serial, parallel);
+}
+
+TEST_F (ExchangeExport, ParallelMatchesSerial) {
+  using namespace pstore::exchange::export_ns;
+  for (auto generation = 1U; generation <= 3U; ++generation) {
+    this->add_generation (generation);
+  }
+
+  for (bool const comments : {false, true}) {
+    db_.sync ();
+    std::string const serial =
+      export_to_string ([&] (ostream & os) { emit_database (db_, os, comments); });
+    db_.sync ();
+    std::string const parallel =
+      export_to_string ([&] (ostream & os) { emit_database_parallel (db_, os, comments); });
+    EXPECT_FALSE (serial.empty ());
+    // A transaction that adds no debug line headers must not leave an empty member behind.
+    EXPECT_EQ (serial.find (",\n,"), std::string::npos);
+    EXPECT_EQ (serial, parallel) << "comments=" << comments;
+  }
+}
@@ -17,10 +17,15 @@
 
 // Standard library includes
 #include <sstream>
+#include <string>
+#include <vector>
 
 // 3rd party includes
 #include <gtest/gtest.h>
 
+// pstore includes
+#include "pstore/support/base64.hpp"
+
 TEST (ExportEmitString, SimpleString) {
   using namespace std::string_literals;
   {
@@ -85,3 +90,41 @@ TEST (ExportEmitArray, Array) {
   auto const actual = os.str ();
   EXPECT_EQ (actual, "[\n  2,\n  3,\n  5\n]");
 }
+
+TEST (ExportEmitString, LongStrings) {
+  // Place a character needing an escape at each position of strings long enough to be
+  // searched using vector instructions.
+  for (auto length = std::size_t{1}; length <= 70U; ++length) {
+    for (auto position = std::size_t{0}; position < length; ++position) {
+      std::string str (length, 'a');
+      str[position] = position % 2U == 0U ? '"' : '\\';
+      std::string expected = "\"";
+      for (char const c : str) {
+        if (c == '"' || c == '\\') {
+          expected += '\\';
+        }
+        expected += c;
+      }
+      expected += '"';
+
+      pstore::exchange::export_ns::ostringstream os;
+      pstore::exchange::export_ns::emit_string (os, std::begin (str), std::end (str));
+      EXPECT_EQ (os.str (), expected) << "length=" << length << " position=" << position;
+    }
+  }
+}
+
+TEST (ExportEmitBase64, MatchesScalar) {
+  std::vector<std::uint8_t> data;
+  for (auto ctr = 0U; ctr < 10000U; ++ctr) {
+    data.push_back (static_cast<std::uint8_t> (ctr * 7U));
+  }
+  for (auto const size : {std::size_t{0}, std::size_t{1}, std::size_t{100}, data.size ()}) {
+    std::string expected;
+    pstore::to_base64 (data.data (), data.data () + size, std::back_inserter (expected));
+
+    pstore::exchange::export_ns::ostringstream os;
+    pstore::exchange::export_ns::emit_base64 (os, data.data (), data.data () + size);
+    EXPECT_EQ (os.str (), expected) << "size=" << size;
+  }
+}
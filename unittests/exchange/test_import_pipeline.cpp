@@ -0,0 +1,112 @@
+//===- unittests/exchange/test_import_pipeline.cpp ------------------------===//
+//*  _                            _            _            _ _             *
+//* (_)_ __ ___  _ __   ___  _ __| |_    _ __ (_)_ __   ___| (_)_ __   ___  *
+//* | | '_ ` _ \| '_ \ / _ \| '__| __|  | '_ \| | '_ \ / _ \ | | '_ \ / _ \ *
+//* | | | | | | | |_) | (_) | |  | |_   | |_) | | |_) |  __/ | | | | |  __/ *
+//* |_|_| |_| |_| .__/ \___/|_|   \__|  | .__/|_| .__/ \___|_|_|_| |_|\___| *
+//*             |_|                     |_|     |_|                         *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/exchange/import_pipeline.hpp"
+
+// Standard library
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+using pstore::exchange::import_ns::bounded_queue;
+using pstore::exchange::import_ns::read_ahead;
+
+TEST (ImportBoundedQueue, FirstInFirstOut) {
+  bounded_queue<int> queue{0U};
+  EXPECT_TRUE (queue.push (1, 1U));
+  EXPECT_TRUE (queue.push (2, 1U));
+  queue.close ();
+  EXPECT_EQ (queue.pop (), std::optional<int>{1});
+  EXPECT_EQ (queue.pop (), std::optional<int>{2});
+  EXPECT_EQ (queue.pop (), std::nullopt);
+}
+
+TEST (ImportBoundedQueue, OversizeItemAcceptedWhenEmpty) {
+  bounded_queue<int> queue{2U};
+  EXPECT_TRUE (queue.push (1, 10U));
+  EXPECT_EQ (queue.pop (), std::optional<int>{1});
+}
+
+TEST (ImportBoundedQueue, ProducerWaitsForRoom) {
+  bounded_queue<int> queue{2U};
+  EXPECT_TRUE (queue.push (1, 2U));
+
+  std::atomic<bool> pushed{false};
+  std::thread producer{[&] () {
+    queue.push (2, 1U);
+    pushed = true;
+    queue.close ();
+  }};
+  // The queue is full so the second item cannot be added until the first is removed.
+  std::this_thread::sleep_for (std::chrono::milliseconds{10});
+  EXPECT_FALSE (pushed);
+  EXPECT_EQ (queue.pop (), std::optional<int>{1});
+  EXPECT_EQ (queue.pop (), std::optional<int>{2});
+  producer.join ();
+  EXPECT_TRUE (pushed);
+  EXPECT_EQ (queue.pop (), std::nullopt);
+}
+
+TEST (ImportBoundedQueue, CancelReleasesProducer) {
+  bounded_queue<int> queue{1U};
+  EXPECT_TRUE (queue.push (1, 1U));
+  bool result = true;
+  std::thread producer{[&] () { result = queue.push (2, 1U); }};
+  queue.cancel ();
+  producer.join ();
+  EXPECT_FALSE (result);
+  EXPECT_EQ (queue.pop (), std::nullopt);
+}
+
+TEST (ImportReadAhead, ReadsEntireStream) {
+  std::unique_ptr<std::FILE, decltype (&std::fclose)> file{std::tmpfile (), &std::fclose};
+  ASSERT_NE (file, nullptr);
+  std::string expected;
+  for (auto ctr = 0U; ctr < 1000U; ++ctr) {
+    expected += std::to_string (ctr);
+  }
+  std::fwrite (expected.data (), 1U, expected.size (), file.get ());
+  std::rewind (file.get ());
+
+  std::string actual;
+  {
+    // A small chunk size and limit mean that the reader must wait for the consumer.
+    read_ahead reader{file.get (), 7U, 2U};
+    for (auto chunk = reader.next (); !chunk.empty (); chunk = reader.next ()) {
+      EXPECT_LE (chunk.size (), 7);
+      actual.append (reinterpret_cast<char const *> (chunk.data ()),
+                     static_cast<std::size_t> (chunk.size ()));
+    }
+  }
+  EXPECT_EQ (actual, expected);
+}
+
+TEST (ImportReadAhead, AbandonedEarly) {
+  std::unique_ptr<std::FILE, decltype (&std::fclose)> file{std::tmpfile (), &std::fclose};
+  ASSERT_NE (file, nullptr);
+  std::string const contents (4096U, 'a');
+  std::fwrite (contents.data (), 1U, contents.size (), file.get ());
+  std::rewind (file.get ());
+
+  // Destroying the reader while it is blocked waiting for room must not hang.
+  read_ahead reader{file.get (), 16U, 1U};
+  EXPECT_FALSE (reader.next ().empty ());
+}
@@ -83,7 +83,8 @@ TEST (SendErrorPage, A) {
 
   pstore::http::send_error_page (sender, 0, "cause", pstore::http::http_status_code::not_found,
                                  "short message", "this is a long message");
-  EXPECT_PRED_FORMAT2 (IsSubstring, "HTTP/1.1 404 OK\r\n", acc);
+  // The headers follow the status line directly.
+  EXPECT_PRED_FORMAT2 (IsSubstring, "HTTP/1.1 404 OK\r\nContent-length: ", acc);
   EXPECT_PRED_FORMAT2 (IsSubstring, "<p>404: short message</p>", acc);
   EXPECT_PRED_FORMAT2 (IsSubstring, "<p>this is a long message: cause</p>", acc);
 }
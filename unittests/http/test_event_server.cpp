@@ -0,0 +1,314 @@
+//===- unittests/http/test_event_server.cpp -------------------------------===//
+//*                       _                                    *
+//*   _____   _____ _ __ | |_    ___  ___ _ ____   _____ _ __  *
+//*  / _ \ \ / / _ \ '_ \| __|  / __|/ _ \ '__\ \ / / _ \ '__| *
+//* |  __/\ V /  __/ | | | |_   \__ \  __/ |   \ V /  __/ |    *
+//*  \___| \_/ \___|_| |_|\__|  |___/\___|_|    \_/ \___|_|    *
+//*                                                            *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/http/event_server.hpp"
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+
+// Standard library includes
+#  include <array>
+#  include <chrono>
+#  include <string>
+#  include <thread>
+#  include <vector>
+
+// OS-specific includes
+#  include <sys/socket.h>
+#  include <sys/time.h>
+
+// 3rd party includes
+#  include <gmock/gmock.h>
+
+// pstore includes
+#  include "pstore/http/server_status.hpp"
+#  include "pstore/support/array_elements.hpp"
+
+using testing::HasSubstr;
+using testing::StartsWith;
+
+namespace {
+
+  char const index_html[] = "<!DOCTYPE html><html></html>";
+  constexpr std::size_t index_size = pstore::array_elements (index_html) - 1U;
+
+  extern pstore::romfs::directory const root_dir;
+  std::array<pstore::romfs::dirent, 3> const root_dir_membs = {{
+    {".", &root_dir},
+    {"..", &root_dir},
+    {"index.html", reinterpret_cast<std::uint8_t const *> (index_html),
+     pstore::romfs::stat{index_size, pstore::romfs::mode_t::file, 1556010627}},
+  }};
+  pstore::romfs::directory const root_dir{pstore::gsl::make_span (root_dir_membs)};
+
+  constexpr auto keep_alive_timeout = std::chrono::milliseconds{200};
+
+  pstore::http::event_server_options test_options () {
+    pstore::http::event_server_options options;
+    options.keep_alive_timeout = keep_alive_timeout;
+    options.idle_check_interval = std::chrono::milliseconds{20};
+    return options;
+  }
+
+  // send all
+  // ~~~~~~~~
+  void send_all (pstore::socket_descriptor const & fd, std::string const & str) {
+    for (auto pos = std::size_t{0}; pos < str.length ();) {
+      ssize_t const nsent =
+        ::send (fd.native_handle (), str.data () + pos, str.length () - pos, MSG_NOSIGNAL);
+      ASSERT_GT (nsent, 0) << "send failed";
+      pos += static_cast<std::size_t> (nsent);
+    }
+  }
+
+  // count responses
+  // ~~~~~~~~~~~~~~~
+  /// Returns the number of complete HTTP responses at the start of \p str. Every response
+  /// sent by the server has a Content-length header.
+  unsigned count_responses (std::string const & str) {
+    static constexpr char content_length[] = "Content-length: ";
+    auto count = 0U;
+    for (auto pos = std::string::size_type{0};;) {
+      auto const headers_end = str.find ("\r\n\r\n", pos);
+      auto const cl = str.find (content_length, pos);
+      if (headers_end == std::string::npos || cl == std::string::npos || cl > headers_end) {
+        return count;
+      }
+      auto const value = cl + pstore::array_elements (content_length) - 1U;
+      auto const length = std::stoul (str.substr (value));
+      auto const next = headers_end + 4U + length;
+      if (next > str.length ()) {
+        return count;
+      }
+      ++count;
+      pos = next;
+    }
+  }
+
+  //*  ___             _     ___                      *
+  //* | __|_ _____ _ _| |_  / __| ___ _ ___ _____ _ _  *
+  //* | _|\ V / -_) ' \  _| \__ \/ -_) '_\ V / -_) '_| *
+  //* |___|\_/\___|_||_\__| |___/\___|_|  \_/\___|_|   *
+  //*                                                  *
+  class EventServer : public testing::Test {
+  public:
+    EventServer ()
+            : fs_{&root_dir}
+            , status_{0}
+            , server_{fs_, channels_, test_options ()} {}
+    ~EventServer () override { this->stop (); }
+
+  protected:
+    /// Creates a connected pair of sockets and gives one of them to the server. Returns the
+    /// other, from which reads time out after a few seconds.
+    pstore::socket_descriptor connect ();
+    /// Starts the server on a separate thread.
+    void start ();
+    void stop ();
+
+    /// Reads from \p fd until \p responses complete HTTP responses have been received or the
+    /// connection is closed.
+    static std::string receive (pstore::socket_descriptor const & fd, unsigned responses);
+    /// Returns true if the peer of \p fd closes the connection without sending more data.
+    static bool wait_for_close (pstore::socket_descriptor const & fd);
+
+  private:
+    pstore::romfs::romfs fs_;
+    pstore::http::channel_container channels_;
+    pstore::http::server_status status_;
+    pstore::http::event_server server_;
+    std::thread thread_;
+  };
+
+  // connect
+  // ~~~~~~~
+  pstore::socket_descriptor EventServer::connect () {
+    std::array<int, 2> fds{{-1, -1}};
+    if (::socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds.data ()) != 0) {
+      ADD_FAILURE () << "socketpair failed";
+      return pstore::socket_descriptor{};
+    }
+    pstore::socket_descriptor client{fds[1]};
+    timeval timeout{};
+    timeout.tv_sec = 5;
+    ::setsockopt (client.native_handle (), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+    EXPECT_FALSE (server_.add_client (pstore::socket_descriptor{fds[0]}));
+    return client;
+  }
+
+  // start
+  // ~~~~~
+  void EventServer::start () {
+    thread_ = std::thread{[this] () {
+      EXPECT_FALSE (server_.run (pstore::socket_descriptor{}, &status_));
+    }};
+  }
+
+  // stop
+  // ~~~~
+  void EventServer::stop () {
+    status_.set_state_to_shutdown ();
+    if (thread_.joinable ()) {
+      thread_.join ();
+    }
+  }
+
+  // receive
+  // ~~~~~~~
+  std::string EventServer::receive (pstore::socket_descriptor const & fd,
+                                    unsigned const responses) {
+    std::string result;
+    std::array<char, 4096> buffer;
+    while (count_responses (result) < responses) {
+      ssize_t const nread = ::recv (fd.native_handle (), buffer.data (), buffer.size (), 0);
+      if (nread <= 0) {
+        break;
+      }
+      result.append (buffer.data (), static_cast<std::size_t> (nread));
+    }
+    return result;
+  }
+
+  // wait for close
+  // ~~~~~~~~~~~~~~
+  bool EventServer::wait_for_close (pstore::socket_descriptor const & fd) {
+    char c;
+    return ::recv (fd.native_handle (), &c, sizeof (c), 0) == 0;
+  }
+
+  constexpr char get_index[] = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+} // end anonymous namespace
+
+TEST_F (EventServer, Pipelining) {
+  auto const client = this->connect ();
+  this->start ();
+
+  // Two requests in a single write. Both are answered, in order.
+  send_all (client, std::string{"GET / HTTP/1.1\r\n\r\n"} + get_index);
+  std::string const responses = receive (client, 2U);
+  EXPECT_EQ (count_responses (responses), 2U) << responses;
+  EXPECT_THAT (responses, StartsWith ("HTTP/1.1 200 OK\r\n"));
+  auto const second = responses.find ("HTTP/1.1 200 OK\r\n", 1U);
+  ASSERT_NE (second, std::string::npos);
+  EXPECT_THAT (responses.substr (0, second), HasSubstr (index_html));
+  EXPECT_THAT (responses.substr (second), HasSubstr (index_html));
+}
+
+TEST_F (EventServer, KeepAlive) {
+  auto const client = this->connect ();
+  this->start ();
+
+  send_all (client, get_index);
+  std::string const first = receive (client, 1U);
+  EXPECT_EQ (count_responses (first), 1U);
+  EXPECT_THAT (first, HasSubstr ("Connection: keep-alive\r\n"));
+
+  // The connection remains open for another request.
+  send_all (client, get_index);
+  EXPECT_EQ (count_responses (receive (client, 1U)), 1U);
+
+  // A client which asks for the connection to be closed gets its response and then EOF.
+  send_all (client, "GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+  std::string const last = receive (client, 1U);
+  EXPECT_EQ (count_responses (last), 1U);
+  EXPECT_THAT (last, HasSubstr ("Connection: close\r\n"));
+  EXPECT_TRUE (wait_for_close (client));
+}
+
+TEST_F (EventServer, Http10Closes) {
+  auto const client = this->connect ();
+  this->start ();
+
+  send_all (client, "GET / HTTP/1.0\r\n\r\n");
+  EXPECT_EQ (count_responses (receive (client, 1U)), 1U);
+  EXPECT_TRUE (wait_for_close (client));
+}
+
+TEST_F (EventServer, RequestBodyIsSkipped) {
+  auto const client = this->connect ();
+  this->start ();
+
+  // The body of the first request must not be mistaken for the start of the second.
+  send_all (client, std::string{"GET / HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"} + get_index);
+  std::string const responses = receive (client, 2U);
+  EXPECT_EQ (count_responses (responses), 2U);
+  EXPECT_THAT (responses, StartsWith ("HTTP/1.1 200 OK\r\n"));
+}
+
+TEST_F (EventServer, InvalidContentLength) {
+  auto const client = this->connect ();
+  this->start ();
+
+  // A request whose length can't be determined is rejected and the connection closed so that
+  // the bytes which follow are never interpreted as another request.
+  send_all (client, std::string{"GET / HTTP/1.1\r\nContent-Length: 5x\r\n\r\n"} + get_index);
+  std::string const responses = receive (client, 2U);
+  EXPECT_EQ (count_responses (responses), 1U);
+  EXPECT_THAT (responses, StartsWith ("HTTP/1.1 400 "));
+  EXPECT_TRUE (wait_for_close (client));
+}
+
+TEST_F (EventServer, ConflictingContentLength) {
+  auto const client = this->connect ();
+  this->start ();
+
+  send_all (client,
+            std::string{"GET / HTTP/1.1\r\nContent-Length: 0\r\nContent-Length: 45\r\n\r\n"} +
+              get_index);
+  std::string const responses = receive (client, 2U);
+  EXPECT_EQ (count_responses (responses), 1U);
+  EXPECT_THAT (responses, StartsWith ("HTTP/1.1 400 "));
+  EXPECT_TRUE (wait_for_close (client));
+}
+
+TEST_F (EventServer, IdleExpiry) {
+  auto const client = this->connect ();
+  this->start ();
+
+  send_all (client, get_index);
+  EXPECT_EQ (count_responses (receive (client, 1U)), 1U);
+
+  // The server closes a persistent connection once it has been idle for long enough.
+  auto const start = std::chrono::steady_clock::now ();
+  EXPECT_TRUE (wait_for_close (client));
+  EXPECT_GE (std::chrono::steady_clock::now () - start, keep_alive_timeout);
+}
+
+TEST_F (EventServer, SlowReaderDoesNotBlockOthers) {
+  // Several more clients than there are workers each send a large batch of pipelined
+  // requests but never read the responses. Their sockets fill up, yet a well-behaved client
+  // is still served.
+  constexpr auto num_slow = 8U;
+  std::string batch;
+  for (auto ctr = 0U; ctr < 2000U; ++ctr) {
+    batch += "GET / HTTP/1.1\r\n\r\n";
+  }
+  std::vector<pstore::socket_descriptor> slow;
+  for (auto ctr = 0U; ctr < num_slow; ++ctr) {
+    slow.push_back (this->connect ());
+  }
+  auto const client = this->connect ();
+  this->start ();
+
+  for (pstore::socket_descriptor const & fd : slow) {
+    send_all (fd, batch);
+  }
+  auto const start = std::chrono::steady_clock::now ();
+  send_all (client, get_index);
+  EXPECT_EQ (count_responses (receive (client, 1U)), 1U);
+  EXPECT_LT (std::chrono::steady_clock::now () - start, std::chrono::seconds{2});
+}
+
+#endif // PSTORE_HAVE_SYS_EPOLL_H
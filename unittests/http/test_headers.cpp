@@ -28,7 +28,9 @@ TEST (Headers, Conventional) {
                            .handler ("host", "localhost:8080")
                            .handler ("accept-Encoding", "gzip, deflate")
                            .handler ("connection", "keep-alive");
-  EXPECT_EQ (hi, header_info ());
+  header_info expected;
+  expected.connection_keep_alive = true;
+  EXPECT_EQ (hi, expected);
 }
 
 TEST (Headers, ExampleWS) {
@@ -51,9 +53,60 @@ TEST (Headers, ConnectionCommaSeparatedList) {
   header_info const hi = header_info ().handler ("connection", "Keep-Alive, Upgrade");
   header_info expected;
   expected.connection_upgrade = true;
+  expected.connection_keep_alive = true;
   EXPECT_EQ (hi, expected);
 }
 
+TEST (Headers, KeepAlive) {
+  EXPECT_TRUE (header_info ().keep_alive ("HTTP/1.1"));
+  EXPECT_FALSE (header_info ().keep_alive ("HTTP/1.0"));
+  EXPECT_FALSE (header_info ().handler ("connection", "close").keep_alive ("HTTP/1.1"));
+  EXPECT_TRUE (header_info ().handler ("connection", "keep-alive").keep_alive ("HTTP/1.0"));
+  EXPECT_FALSE (header_info ().handler ("transfer-encoding", "chunked").keep_alive ("HTTP/1.1"));
+}
+
+TEST (Headers, ContentLength) {
+  EXPECT_EQ (header_info ().handler ("content-length", "0").content_length,
+             just (std::uint64_t{0}));
+  EXPECT_EQ (header_info ().handler ("content-length", "1234").content_length,
+             just (std::uint64_t{1234}));
+  EXPECT_EQ (header_info ().handler ("content-length", "12 ").content_length,
+             just (std::uint64_t{12}));
+  EXPECT_FALSE (header_info ().handler ("content-length", "0").bad_content_length);
+  EXPECT_FALSE (header_info ().handler ("content-length", "").content_length.has_value ());
+  EXPECT_FALSE (header_info ().handler ("content-length", "12a").content_length.has_value ());
+  EXPECT_FALSE (header_info ()
+                  .handler ("content-length", "99999999999999999999999")
+                  .content_length.has_value ());
+}
+
+TEST (Headers, ContentLengthInvalid) {
+  // A malformed length must not be mistaken for an absent one.
+  EXPECT_FALSE (header_info ().bad_content_length);
+  EXPECT_TRUE (header_info ().handler ("content-length", "").bad_content_length);
+  EXPECT_TRUE (header_info ().handler ("content-length", "12a").bad_content_length);
+  EXPECT_TRUE (header_info ().handler ("content-length", "-1").bad_content_length);
+  EXPECT_TRUE (header_info ().handler ("content-length", "1, 2").bad_content_length);
+  EXPECT_TRUE (
+    header_info ().handler ("content-length", "99999999999999999999999").bad_content_length);
+}
+
+TEST (Headers, ContentLengthDuplicate) {
+  header_info const same =
+    header_info ().handler ("content-length", "5").handler ("content-length", "5");
+  EXPECT_FALSE (same.bad_content_length);
+  EXPECT_EQ (same.content_length, just (std::uint64_t{5}));
+
+  EXPECT_TRUE (header_info ()
+                 .handler ("content-length", "5")
+                 .handler ("content-length", "6")
+                 .bad_content_length);
+  EXPECT_TRUE (header_info ()
+                 .handler ("content-length", "5")
+                 .handler ("content-length", "x")
+                 .bad_content_length);
+}
+
 TEST (Headers, ExampleWSCaseInsensitive) {
   header_info const hi =
     header_info ().handler ("upgrade", "WEBSOCKET").handler ("connection", "UPGRADE");
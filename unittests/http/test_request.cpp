@@ -15,6 +15,7 @@
 //===----------------------------------------------------------------------===//
 #include "pstore/http/request.hpp"
 
+#include <cstring>
 #include <functional>
 
 #include <gmock/gmock.h>
@@ -110,3 +111,28 @@ TEST (ReadHeaders, Common) {
   EXPECT_EQ (std::get<0> (*res), 1) << "Reader state is incorrect";
   EXPECT_EQ (std::get<1> (*res), 3) << "Handler state is incorrect";
 }
+
+namespace {
+
+  pstore::maybe<std::size_t> request_size (char const * const str) {
+    return pstore::http::request_size (
+      pstore::gsl::make_span (reinterpret_cast<std::uint8_t const *> (str), std::strlen (str)));
+  }
+
+} // end anonymous namespace
+
+TEST (RequestSize, Incomplete) {
+  EXPECT_FALSE (request_size ("").has_value ());
+  EXPECT_FALSE (request_size ("GET / HTTP/1.1").has_value ());
+  EXPECT_FALSE (request_size ("GET / HTTP/1.1\r\nHost: localhost\r\n").has_value ());
+  EXPECT_FALSE (request_size ("GET / HTTP/1.1\r\nHost: localhost\r\n\r").has_value ());
+}
+
+TEST (RequestSize, Complete) {
+  EXPECT_EQ (request_size ("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"),
+             pstore::just (std::size_t{35}));
+  EXPECT_EQ (request_size ("GET / HTTP/1.1\nHost: localhost\n\n"), pstore::just (std::size_t{32}));
+  // Bytes following the empty line belong to the next request.
+  EXPECT_EQ (request_size ("GET / HTTP/1.1\r\n\r\nGET /a HTTP/1.1\r\n\r\n"),
+             pstore::just (std::size_t{18}));
+}
@@ -55,3 +55,35 @@ TEST (ServeDynamicContent, Version) {
   EXPECT_TRUE (r);
   EXPECT_THAT (output, ::testing::ContainsRegex ("\r\n\r\n\\{ *\"version\" *:"));
 }
+
+TEST (ServeDynamicContent, Metrics) {
+  std::string output;
+  auto sender = [&output] (int io, pstore::gsl::span<std::uint8_t const> const & s) {
+    std::transform (std::begin (s), std::end (s), std::back_inserter (output),
+                    [] (std::uint8_t v) { return static_cast<char> (v); });
+    return pstore::error_or<int>{io};
+  };
+
+  pstore::metrics::increment (pstore::metrics::counter::spanning_reads);
+  pstore::error_or<int> const r = pstore::http::serve_dynamic_content (
+    sender, 0, std::string{pstore::http::dynamic_path} + "metrics");
+  EXPECT_TRUE (r);
+  EXPECT_THAT (output, ::testing::HasSubstr ("Content-type: application/json\r\n"));
+  EXPECT_THAT (output, ::testing::ContainsRegex ("\r\n\r\n\\{ *\"counters\" *:"));
+  EXPECT_THAT (output, ::testing::ContainsRegex ("\"spanning_reads\": [1-9]"));
+}
+
+TEST (ServeDynamicContent, KeepAlive) {
+  std::string output;
+  auto sender = [&output] (int io, pstore::gsl::span<std::uint8_t const> const & s) {
+    std::transform (std::begin (s), std::end (s), std::back_inserter (output),
+                    [] (std::uint8_t v) { return static_cast<char> (v); });
+    return pstore::error_or<int>{io};
+  };
+
+  pstore::error_or<int> const r = pstore::http::serve_dynamic_content (
+    sender, 0, std::string{pstore::http::dynamic_path} + "version", true /*keep alive*/);
+  EXPECT_TRUE (r);
+  EXPECT_THAT (output, ::testing::HasSubstr ("Connection: keep-alive\r\n"));
+  EXPECT_THAT (output, ::testing::ContainsRegex ("Content-length: [0-9]+\r\n"));
+}
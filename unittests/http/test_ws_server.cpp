@@ -149,3 +149,33 @@ TEST (WsServer, Ping) {
   EXPECT_THAT (pstore::gsl::make_span (output),
                ::testing::ContainerEq (make_span (expected_frames)));
 }
+
+TEST (WsServer, FrameSizeIncompleteHeader) {
+  using pstore::http::frame_size;
+  std::array<std::uint8_t, 9> const bytes{{0x81, 0xFF, 0, 0, 0, 0, 0, 0, 0}};
+  EXPECT_FALSE (frame_size (pstore::gsl::make_span (bytes.data (), 0)).has_value ());
+  EXPECT_FALSE (frame_size (pstore::gsl::make_span (bytes.data (), 1)).has_value ());
+  // A 64-bit extended length needs 8 bytes after the fixed part of the header.
+  EXPECT_FALSE (frame_size (pstore::gsl::make_span (bytes.data (), 9)).has_value ());
+}
+
+TEST (WsServer, FrameSize) {
+  using pstore::http::frame_size;
+  using pstore::just;
+  // A masked text frame with a 5 byte payload. Only the fixed part of the header is needed.
+  std::array<std::uint8_t, 2> const short_frame{{0x81, 0x85}};
+  EXPECT_EQ (frame_size (pstore::gsl::make_span (short_frame)), just (std::uint64_t{2 + 4 + 5}));
+  // An unmasked frame with a 16-bit extended length (0x0100).
+  std::array<std::uint8_t, 4> const medium_frame{{0x82, 0x7E, 0x01, 0x00}};
+  EXPECT_EQ (frame_size (pstore::gsl::make_span (medium_frame)),
+             just (std::uint64_t{2 + 2 + 0x100}));
+  // A masked frame with a 64-bit extended length (0x10000).
+  std::array<std::uint8_t, 10> const long_frame{{0x82, 0xFF, 0, 0, 0, 0, 0, 0x01, 0x00, 0x00}};
+  EXPECT_EQ (frame_size (pstore::gsl::make_span (long_frame)),
+             just (std::uint64_t{2 + 8 + 4 + 0x10000}));
+  // A length which overflows is saturated.
+  std::array<std::uint8_t, 10> const huge_frame{
+    {0x82, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+  EXPECT_EQ (frame_size (pstore::gsl::make_span (huge_frame)),
+             just (std::numeric_limits<std::uint64_t>::max ()));
+}
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -406,6 +407,32 @@ TEST_F (TemporaryFileFixture, CheckTemporaryFileIsDeleted) {
   EXPECT_FALSE (pstore::file::exists (path));
 }
 
+TEST (CopyRange, CopiesWithoutMovingFilePosition) {
+  using pstore::file::file_handle;
+  std::vector<std::uint8_t> src (8192U);
+  std::iota (std::begin (src), std::end (src), std::uint8_t{0});
+
+  file_handle in;
+  in.open (file_handle::temporary{});
+  in.write_span (
+    pstore::gsl::make_span (reinterpret_cast<std::byte const *> (src.data ()), src.size ()));
+  in.seek (0U);
+  file_handle out;
+  out.open (file_handle::temporary{});
+
+  // The operating system may not support the operation for these files, in which case fewer
+  // bytes (perhaps none) are copied. Whatever it reports as copied must be correct.
+  std::uint64_t const copied = pstore::file::copy_range (in, 100U, out, 10U, 4000U);
+  EXPECT_LE (copied, 4000U);
+  EXPECT_EQ (in.tell (), 0U);
+  EXPECT_EQ (out.tell (), 0U);
+
+  std::vector<std::uint8_t> actual (copied);
+  out.seek (10U);
+  EXPECT_EQ (out.read_span (pstore::gsl::make_span (actual)), copied);
+  EXPECT_TRUE (std::equal (std::begin (actual), std::end (actual), std::begin (src) + 100));
+}
+
 
 namespace {
 
@@ -67,3 +67,28 @@ TEST (MemoryMapper, MemoryMapThenCheckFileContents) {
   std::iota (expected.begin (), expected.end (), std::uint8_t{0});
   EXPECT_THAT (expected, ContainerEq (contents));
 }
+
+TEST (MemoryMapper, MappingPolicyHints) {
+  pstore::file::file_handle file;
+  file.open (pstore::file::file_handle::temporary ());
+
+  std::size_t const size = pstore::system_page_size ().get () * 4U;
+  file.seek (size - 1U);
+  file.write (std::uint8_t{0x5A});
+
+  // The policy's hints don't change the contents of the mapped memory.
+  for (auto const access : {pstore::mapping_policy::access_pattern::normal,
+                            pstore::mapping_policy::access_pattern::random,
+                            pstore::mapping_policy::access_pattern::sequential}) {
+    pstore::mapping_policy policy;
+    policy.access = access;
+    policy.huge_pages = true;
+    policy.populate = true;
+
+    pstore::memory_mapper mm{file, false /*writable?*/, 0U /*offset*/, size, policy};
+    EXPECT_EQ (size, mm.size ());
+    auto const ptr = std::static_pointer_cast<std::uint8_t const> (mm.data ());
+    EXPECT_EQ (0U, ptr.get ()[0]);
+    EXPECT_EQ (0x5AU, ptr.get ()[size - 1U]);
+  }
+}
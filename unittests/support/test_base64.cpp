@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -168,3 +169,96 @@ TEST (Base64, RoundTrip) {
 
   EXPECT_EQ (decoded, input);
 }
+
+namespace {
+
+  // Returns a pseudo-random sequence of bytes.
+  std::vector<std::uint8_t> make_bytes (std::size_t const size) {
+    std::vector<std::uint8_t> result;
+    result.reserve (size);
+    auto seed = std::uint32_t{1};
+    std::generate_n (std::back_inserter (result), size, [&seed] () {
+      seed = seed * 1103515245U + 12345U;
+      return static_cast<std::uint8_t> (seed >> 16);
+    });
+    return result;
+  }
+
+  // Decodes the string using both from_base64() and base64_decode() and checks that the
+  // results match.
+  void check_decode (std::string const & encoded) {
+    std::vector<std::uint8_t> expected;
+    auto const expected_res =
+      pstore::from_base64 (std::begin (encoded), std::end (encoded), std::back_inserter (expected));
+
+    // Fill the buffer with a marker so that we can check for writes beyond its end.
+    auto const size = pstore::base64_decoded_size (encoded.size ());
+    std::vector<std::uint8_t> actual (size + 16U, std::uint8_t{0xCC});
+    auto const actual_res =
+      pstore::base64_decode (encoded.data (), encoded.size (), actual.data ());
+    ASSERT_EQ (expected_res.has_value (), actual_res.has_value ()) << encoded;
+    if (actual_res) {
+      EXPECT_TRUE (std::all_of (actual.data () + size, actual.data () + actual.size (),
+                                [] (std::uint8_t const v) { return v == 0xCC; }));
+      actual.resize (static_cast<std::size_t> (*actual_res - actual.data ()));
+      EXPECT_EQ (expected, actual) << encoded;
+    }
+  }
+
+} // end anonymous namespace
+
+TEST (Base64, EncodeMatchesScalar) {
+  std::vector<std::uint8_t> const input = make_bytes (300);
+  // Try each length at several alignments so that all of the vector and scalar paths are
+  // exercised.
+  for (auto offset = std::size_t{0}; offset < 4U; ++offset) {
+    for (auto length = std::size_t{0}; length <= input.size () - offset; ++length) {
+      auto const * const first = input.data () + offset;
+      std::string expected;
+      pstore::to_base64 (first, first + length, std::back_inserter (expected));
+
+      auto const size = pstore::base64_encoded_size (length);
+      ASSERT_EQ (expected.size (), size);
+      std::string actual (size + 16U, '*');
+      char * const end = pstore::base64_encode (first, length, &actual[0]);
+      EXPECT_EQ (end, actual.data () + size);
+      EXPECT_EQ (actual.substr (size), std::string (16U, '*'));
+      actual.resize (size);
+      EXPECT_EQ (expected, actual) << "offset=" << offset << " length=" << length;
+    }
+  }
+}
+
+TEST (Base64, DecodeMatchesScalar) {
+  std::vector<std::uint8_t> const input = make_bytes (300);
+  for (auto length = std::size_t{0}; length <= input.size (); ++length) {
+    std::string encoded;
+    pstore::to_base64 (input.data (), input.data () + length, std::back_inserter (encoded));
+    check_decode (encoded);
+  }
+}
+
+TEST (Base64, DecodeEveryCharacter) {
+  // A long run of valid characters is decoded by the vector code. Replacing one character
+  // with each possible value must give the same result as the scalar code.
+  std::vector<std::uint8_t> const input = make_bytes (96);
+  std::string valid;
+  pstore::to_base64 (std::begin (input), std::end (input), std::back_inserter (valid));
+  ASSERT_EQ (valid.size (), 128U);
+  for (auto const position : {std::size_t{0}, std::size_t{5}, std::size_t{17}, std::size_t{31},
+                              std::size_t{40}, std::size_t{127}}) {
+    for (auto c = 0; c < 256; ++c) {
+      std::string encoded = valid;
+      encoded[position] = static_cast<char> (c);
+      check_decode (encoded);
+    }
+  }
+}
+
+TEST (Base64, DecodeEmbeddedPadding) {
+  // Padding characters are skipped wherever they appear.
+  std::vector<std::uint8_t> const input = make_bytes (60);
+  std::string encoded = "Zg==";
+  pstore::to_base64 (std::begin (input), std::end (input), std::back_inserter (encoded));
+  check_decode (encoded);
+}
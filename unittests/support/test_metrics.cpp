@@ -0,0 +1,97 @@
+//===- unittests/support/test_metrics.cpp ---------------------------------===//
+//*                 _        _           *
+//*  _ __ ___   ___| |_ _ __(_) ___ ___  *
+//* | '_ ` _ \ / _ \ __| '__| |/ __/ __| *
+//* | | | | | |  __/ |_| |  | | (__\__ \ *
+//* |_| |_| |_|\___|\__|_|  |_|\___|___/ *
+//*                                      *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/support/metrics.hpp"
+
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+using pstore::metrics::counter;
+using pstore::metrics::histogram;
+
+// The measurements are shared by the whole process so these tests look at the changes that
+// they make rather than at absolute values.
+
+TEST (Metrics, Bucket) {
+  using pstore::metrics::details::bucket;
+  EXPECT_EQ (bucket (0U), 0U);
+  EXPECT_EQ (bucket (1U), 1U);
+  EXPECT_EQ (bucket (2U), 2U);
+  EXPECT_EQ (bucket (3U), 2U);
+  EXPECT_EQ (bucket (4U), 3U);
+  EXPECT_EQ (bucket (UINT64_MAX), 64U);
+}
+
+TEST (Metrics, Increment) {
+  auto const before = pstore::metrics::collect ();
+  pstore::metrics::increment (counter::hamt_node_loads);
+  pstore::metrics::increment (counter::hamt_node_loads, 4U);
+  auto const after = pstore::metrics::collect ();
+  EXPECT_EQ (after[counter::hamt_node_loads] - before[counter::hamt_node_loads], 5U);
+}
+
+TEST (Metrics, Record) {
+  auto const before = pstore::metrics::collect ();
+  pstore::metrics::record (histogram::allocation_bytes, 8U);
+  pstore::metrics::record (histogram::allocation_bytes, 12U);
+  pstore::metrics::record (histogram::allocation_bytes, 16U);
+  auto const after = pstore::metrics::collect ();
+
+  auto const & b = before[histogram::allocation_bytes];
+  auto const & a = after[histogram::allocation_bytes];
+  EXPECT_EQ (a.count - b.count, 3U);
+  EXPECT_EQ (a.sum - b.sum, 36U);
+  EXPECT_EQ (a.buckets[4] - b.buckets[4], 2U); // [8, 16)
+  EXPECT_EQ (a.buckets[5] - b.buckets[5], 1U); // [16, 32)
+}
+
+TEST (Metrics, ExitedThreadsAreCounted) {
+  auto const before = pstore::metrics::collect ();
+  constexpr auto num_threads = 4U;
+  constexpr auto increments = 1000U;
+  std::vector<std::thread> threads;
+  for (auto t = 0U; t < num_threads; ++t) {
+    threads.emplace_back ([] () {
+      for (auto ctr = 0U; ctr < increments; ++ctr) {
+        pstore::metrics::increment (counter::index_cache_hits);
+      }
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join ();
+  }
+  auto const after = pstore::metrics::collect ();
+  EXPECT_EQ (after[counter::index_cache_hits] - before[counter::index_cache_hits],
+             num_threads * increments);
+}
+
+TEST (Metrics, ToJson) {
+  pstore::metrics::snapshot s;
+  s.counters[static_cast<unsigned> (counter::regions_mapped)] = 3U;
+  auto & h = s.histograms[static_cast<unsigned> (histogram::commit_publish_ns)];
+  h.count = 2U;
+  h.sum = 9U;
+  h.buckets[0] = 1U;
+  h.buckets[4] = 1U;
+
+  std::string const json = pstore::metrics::to_json (s);
+  EXPECT_THAT (json, testing::StartsWith (R"({ "counters": { "regions_mapped": 3, )"));
+  EXPECT_THAT (json, testing::HasSubstr (R"("commit_publish_ns": { "count": 2, "sum": 9, )"
+                                         R"("buckets": { "0": 1, "8": 1 } })"));
+  EXPECT_THAT (json, testing::HasSubstr (
+                       R"("allocation_bytes": { "count": 0, "sum": 0, "buckets": { } })"));
+}
@@ -0,0 +1,381 @@
+//===- unittests/vacuum/test_incremental.cpp ------------------------------===//
+//*  _                                          _        _  *
+//* (_)_ __   ___ _ __ ___ _ __ ___   ___ _ __ | |_ __ _| | *
+//* | | '_ \ / __| '__/ _ \ '_ ` _ \ / _ \ '_ \| __/ _` | | *
+//* | | | | | (__| | |  __/ | | | | |  __/ | | | || (_| | | *
+//* |_|_| |_|\___|_|  \___|_| |_| |_|\___|_| |_|\__\__,_|_| *
+//*                                                         *
+//===----------------------------------------------------------------------===//
+//
+// Part of the pstore project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://github.com/paulhuggett/pstore/blob/master/LICENSE.txt for license
+// information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "pstore/vacuum/incremental.hpp"
+
+// Standard library includes
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/core/file_header.hpp"
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/hamt_set.hpp"
+#include "pstore/core/index_types.hpp"
+#include "pstore/core/indirect_string.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/support/pointee_adaptor.hpp"
+#include "pstore/vacuum/copy.hpp"
+#include "pstore/vacuum/status.hpp"
+
+// Local includes
+#include "empty_store.hpp"
+
+using namespace pstore::repo;
+
+namespace {
+
+  class Incremental : public testing::Test {
+  public:
+    Incremental ()
+            : source_{source_store_.file ()}
+            , destination_{destination_store_.file ()} {
+      source_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+      destination_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    }
+
+  protected:
+    using lock_guard = std::unique_lock<mock_mutex>;
+    using transaction_type = pstore::transaction<lock_guard>;
+
+    void add_write (std::string const & key, std::string const & value);
+    std::string read_write (pstore::database & db, std::string const & key);
+    pstore::typed_address<pstore::indirect_string> add_name (transaction_type & transaction,
+                                                             std::string const & str);
+
+    /// Brings the destination up to date with the source's current revision.
+    bool copy (vacuum::checkpoint * const cp, std::size_t const batch_size,
+               std::function<bool ()> const & interrupted = [] () { return false; }) {
+      return vacuum::copy_generations (
+        source_, destination_, cp, [] (vacuum::checkpoint const &) {}, interrupted, batch_size);
+    }
+
+    mock_mutex mutex_;
+    in_memory_store source_store_;
+    in_memory_store destination_store_;
+    pstore::database source_;
+    pstore::database destination_;
+  };
+
+  // add write
+  // ~~~~~~~~~
+  void Incremental::add_write (std::string const & key, std::string const & value) {
+    transaction_type transaction = begin (source_, lock_guard{mutex_});
+    auto const [ptr, addr] = transaction.alloc_rw<char> (value.size ());
+    std::copy (std::begin (value), std::end (value), ptr.get ());
+    pstore::index::get_index<pstore::trailer::indices::write> (source_)->insert_or_assign (
+      transaction, key, pstore::extent<char>{addr, value.size ()});
+    transaction.commit ();
+  }
+
+  // read write
+  // ~~~~~~~~~~
+  std::string Incremental::read_write (pstore::database & db, std::string const & key) {
+    auto const index = pstore::index::get_index<pstore::trailer::indices::write> (db, false);
+    if (index == nullptr) {
+      return "";
+    }
+    auto const pos = index->find (db, key);
+    if (pos == index->end (db)) {
+      return "";
+    }
+    std::shared_ptr<char const> const data = db.getro (pos->second);
+    return {data.get (), pos->second.size};
+  }
+
+  // add name
+  // ~~~~~~~~
+  pstore::typed_address<pstore::indirect_string>
+  Incremental::add_name (transaction_type & transaction, std::string const & str) {
+    pstore::raw_sstring_view const sstring = pstore::make_sstring_view (str);
+    pstore::indirect_string_adder adder;
+    auto const pos =
+      adder
+        .add (transaction, pstore::index::get_index<pstore::trailer::indices::name> (source_),
+              &sstring)
+        .first;
+    adder.flush (transaction);
+    return pstore::typed_address<pstore::indirect_string> (pos.get_address ());
+  }
+
+} // end anonymous namespace
+
+TEST_F (Incremental, CopiesWriteIndex) {
+  this->add_write ("key", "value");
+
+  vacuum::checkpoint cp{source_.get_header ().id ()};
+  vacuum::start_generation (&cp, source_, destination_);
+  EXPECT_EQ (cp.target_revision, source_.get_current_revision ());
+  EXPECT_TRUE (this->copy (&cp, vacuum::default_batch_size));
+  EXPECT_EQ (cp.stage, vacuum::phase::complete);
+  EXPECT_EQ (this->read_write (destination_, "key"), "value");
+}
+
+TEST_F (Incremental, CopiesOnlyNewGenerations) {
+  this->add_write ("first", "1");
+
+  vacuum::checkpoint cp{source_.get_header ().id ()};
+  vacuum::start_generation (&cp, source_, destination_);
+  ASSERT_TRUE (this->copy (&cp, vacuum::default_batch_size));
+
+  auto const write = pstore::index::get_index<pstore::trailer::indices::write> (destination_);
+  pstore::extent<char> const first_extent =
+    write->find (destination_, std::string{"first"})->second;
+
+  this->add_write ("second", "2");
+  vacuum::start_generation (&cp, source_, destination_);
+  EXPECT_EQ (cp.base_revision + 1U, cp.target_revision);
+  ASSERT_TRUE (this->copy (&cp, vacuum::default_batch_size));
+
+  EXPECT_EQ (this->read_write (destination_, "second"), "2");
+  // The data copied by the first generation was not copied again.
+  EXPECT_EQ (write->find (destination_, std::string{"first"})->second, first_extent);
+}
+
+TEST_F (Incremental, ResumesAfterInterruption) {
+  std::vector<std::string> keys;
+  {
+    transaction_type transaction = begin (source_, lock_guard{mutex_});
+    auto const write = pstore::index::get_index<pstore::trailer::indices::write> (source_);
+    for (auto ctr = 0U; ctr < 10U; ++ctr) {
+      keys.push_back ("key" + std::to_string (ctr));
+      auto const [ptr, addr] = transaction.alloc_rw<char> (1U);
+      *ptr = static_cast<char> ('a' + ctr);
+      write->insert_or_assign (transaction, keys.back (), pstore::extent<char>{addr, 1U});
+    }
+    transaction.commit ();
+  }
+
+  vacuum::checkpoint cp{source_.get_header ().id ()};
+  vacuum::start_generation (&cp, source_, destination_);
+
+  // Advance to the start of the write stage.
+  auto calls = 0U;
+  while (cp.stage != vacuum::phase::write) {
+    ASSERT_FALSE (this->copy (&cp, 3U, [] () { return true; }));
+  }
+  EXPECT_FALSE (this->copy (&cp, 3U, [&calls] () { return ++calls == 4U; }));
+  EXPECT_EQ (cp.stage, vacuum::phase::write);
+  EXPECT_EQ (cp.done, 4U);
+
+  EXPECT_TRUE (this->copy (&cp, 3U));
+  EXPECT_EQ (cp.stage, vacuum::phase::complete);
+  for (auto ctr = 0U; ctr < keys.size (); ++ctr) {
+    EXPECT_EQ (this->read_write (destination_, keys[ctr]), std::string (1U, 'a' + ctr))
+      << "key: " << keys[ctr];
+  }
+}
+
+TEST_F (Incremental, RelocatesFragmentsAndCompilations) {
+  pstore::index::digest const fragment_digest{7U};
+  pstore::index::digest const compilation_digest{11U};
+  pstore::index::digest const header_digest{13U};
+  {
+    transaction_type transaction = begin (source_, lock_guard{mutex_});
+    auto const name = this->add_name (transaction, "foo");
+    auto const triple = this->add_name (transaction, "triple");
+
+    std::array<std::uint8_t, 4> const header_data{{1, 2, 3, 4}};
+    auto const [header_ptr, header_addr] = transaction.alloc_rw<std::uint8_t> (header_data.size ());
+    std::copy (std::begin (header_data), std::end (header_data), header_ptr.get ());
+    pstore::extent<std::uint8_t> const header{header_addr, header_data.size ()};
+    pstore::index::get_index<pstore::trailer::indices::debug_line_header> (source_)->insert (
+      transaction, std::make_pair (header_digest, header));
+
+    section_content text{section_kind::text, std::uint8_t{1}};
+    text.data.assign ({0xC3});
+    text.xfixups.emplace_back (name, relocation_type{1}, binding::strong, UINT64_C (0),
+                               INT64_C (0));
+    section_content line{section_kind::debug_line, std::uint8_t{1}};
+    line.data.assign ({0x00});
+    std::array<linked_definitions::value_type, 1> linked{{linked_definitions::value_type{
+      compilation_digest, 0U, pstore::typed_address<definition>::null ()}}};
+
+    std::vector<std::unique_ptr<section_creation_dispatcher>> dispatchers;
+    dispatchers.emplace_back (new generic_section_creation_dispatcher (text.kind, &text));
+    dispatchers.emplace_back (
+      new debug_line_section_creation_dispatcher (header_digest, header, &line));
+    dispatchers.emplace_back (
+      new linked_definitions_creation_dispatcher (linked.data (), linked.data () + linked.size ()));
+    pstore::extent<fragment> const fext =
+      fragment::alloc (transaction, pstore::make_pointee_adaptor (dispatchers.begin ()),
+                       pstore::make_pointee_adaptor (dispatchers.end ()));
+    pstore::index::get_index<pstore::trailer::indices::fragment> (source_)->insert (
+      transaction, std::make_pair (fragment_digest, fext));
+
+    std::array<definition, 1> const definitions{
+      {definition{fragment_digest, fext, name, linkage::external}}};
+    pstore::extent<compilation> const cext = compilation::alloc (
+      transaction, triple, std::begin (definitions), std::end (definitions));
+    pstore::index::get_index<pstore::trailer::indices::compilation> (source_)->insert (
+      transaction, std::make_pair (compilation_digest, cext));
+
+    // Patch the linked definition to point at the compilation (as the importer does).
+    fragment::load (transaction, fext)->at<section_kind::linked_definitions> ()[0].pointer =
+      compilation::index_address (cext.addr, 0U);
+    transaction.commit ();
+  }
+
+  vacuum::checkpoint cp{source_.get_header ().id ()};
+  vacuum::start_generation (&cp, source_, destination_);
+  ASSERT_TRUE (this->copy (&cp, vacuum::default_batch_size));
+
+  auto const compilations =
+    pstore::index::get_index<pstore::trailer::indices::compilation> (destination_, false);
+  ASSERT_NE (compilations, nullptr);
+  auto const cpos = compilations->find (destination_, compilation_digest);
+  ASSERT_NE (cpos, compilations->end (destination_));
+  std::shared_ptr<compilation const> const c = compilation::load (destination_, cpos->second);
+  EXPECT_EQ (pstore::indirect_string::read (destination_, c->triple ()).to_string (), "triple");
+  ASSERT_EQ (c->size (), 1U);
+  definition const & def = (*c)[0];
+  EXPECT_EQ (pstore::indirect_string::read (destination_, def.name).to_string (), "foo");
+
+  auto const fragments =
+    pstore::index::get_index<pstore::trailer::indices::fragment> (destination_, false);
+  ASSERT_NE (fragments, nullptr);
+  auto const fpos = fragments->find (destination_, fragment_digest);
+  ASSERT_NE (fpos, fragments->end (destination_));
+  EXPECT_EQ (def.fext, fpos->second);
+
+  std::shared_ptr<fragment const> const f = fragment::load (destination_, fpos->second);
+  auto const & xfixups = f->at<section_kind::text> ().xfixups ();
+  ASSERT_EQ (xfixups.size (), 1U);
+  EXPECT_EQ (pstore::indirect_string::read (destination_, xfixups.begin ()->name).to_string (),
+             "foo");
+
+  auto const headers =
+    pstore::index::get_index<pstore::trailer::indices::debug_line_header> (destination_, false);
+  ASSERT_NE (headers, nullptr);
+  EXPECT_EQ (f->at<section_kind::debug_line> ().header_extent (),
+             headers->find (destination_, header_digest)->second);
+
+  auto const & ld = f->at<section_kind::linked_definitions> ();
+  ASSERT_EQ (ld.size (), 1U);
+  EXPECT_EQ (ld.begin ()->pointer, compilation::index_address (cpos->second.addr, 0U));
+}
+
+TEST_F (Incremental, ResumeAndReplaceSource) {
+  using pstore::file::file_handle;
+  file_handle file;
+  file.open (file_handle::unique{}, file_handle::get_temporary_directory ());
+  std::string const path = file.path ();
+  file.close ();
+  pstore::file::unlink (path);
+  std::string const destination_path = path + ".gc";
+
+  auto const add = [] (pstore::database & db, std::string const & key, std::string const & value) {
+    auto transaction = begin (db);
+    auto const [ptr, addr] = transaction.alloc_rw<char> (value.size ());
+    std::copy (std::begin (value), std::end (value), ptr.get ());
+    pstore::index::get_index<pstore::trailer::indices::write> (db)->insert_or_assign (
+      transaction, key, pstore::extent<char>{addr, value.size ()});
+    transaction.commit ();
+  };
+  auto const open = [&path] () {
+    auto db = std::make_shared<pstore::database> (path, pstore::database::access_mode::writable);
+    db->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    return db;
+  };
+
+  std::shared_ptr<pstore::database> source = open ();
+  std::unique_lock<pstore::file::range_lock> * lock = source->upgrade_to_write_lock ();
+  add (*source, "a", "1");
+
+  // The first pass is interrupted before it reaches its target revision.
+  vacuum::status st;
+  st.done = true;
+  vacuum::checkpoint cp;
+  EXPECT_FALSE (vacuum::copy_incremental (source, destination_path, &st, &cp));
+  EXPECT_NE (cp.stage, vacuum::phase::complete);
+
+  // A revision is added whilst the vacuum is interrupted. Resuming must copy it as well as
+  // finishing the interrupted generation.
+  add (*source, "b", "2");
+  st.done = false;
+  ASSERT_TRUE (vacuum::copy_incremental (source, destination_path, &st, &cp));
+  ASSERT_TRUE (vacuum::replace_source_incremental (source, *lock, destination_path, cp, &st));
+  EXPECT_EQ (source, nullptr);
+
+  // The next vacuum copies only the revisions which follow those of the replaced store.
+  source = open ();
+  lock = source->upgrade_to_write_lock ();
+  unsigned const replaced_revision = source->get_current_revision ();
+  add (*source, "c", "3");
+  vacuum::status st2;
+  ASSERT_TRUE (vacuum::copy_incremental (source, destination_path, &st2, &cp));
+  EXPECT_EQ (cp.base_revision, replaced_revision);
+  EXPECT_EQ (cp.target_revision, source->get_current_revision ());
+
+  // A revision added after the copy completed prevents the swap.
+  add (*source, "d", "4");
+  EXPECT_FALSE (vacuum::replace_source_incremental (source, *lock, destination_path, cp, &st2));
+  ASSERT_NE (source, nullptr);
+  ASSERT_TRUE (vacuum::copy_incremental (source, destination_path, &st2, &cp));
+  ASSERT_TRUE (vacuum::replace_source_incremental (source, *lock, destination_path, cp, &st2));
+
+  {
+    pstore::database db{path, pstore::database::access_mode::read_only};
+    EXPECT_EQ (this->read_write (db, "a"), "1");
+    EXPECT_EQ (this->read_write (db, "b"), "2");
+    EXPECT_EQ (this->read_write (db, "c"), "3");
+    EXPECT_EQ (this->read_write (db, "d"), "4");
+  }
+
+  pstore::file::unlink (path);
+  pstore::file::unlink (destination_path);
+  pstore::file::unlink (vacuum::checkpoint_path (destination_path));
+}
+
+TEST (IncrementalCheckpoint, RoundTrip) {
+  using pstore::file::file_handle;
+  file_handle file;
+  file.open (file_handle::unique{}, file_handle::get_temporary_directory ());
+  std::string const path = file.path ();
+  file.close ();
+
+  pstore::uuid const id;
+  vacuum::checkpoint cp{id};
+  cp.base_revision = 3U;
+  cp.target_revision = 5U;
+  cp.stage = vacuum::phase::fragments;
+  cp.done = 17U;
+  vacuum::write_checkpoint (path, cp);
+
+  std::optional<vacuum::checkpoint> const actual = vacuum::read_checkpoint (path, id);
+  ASSERT_TRUE (actual.has_value ());
+  EXPECT_EQ (actual->base_revision, 3U);
+  EXPECT_EQ (actual->target_revision, 5U);
+  EXPECT_EQ (actual->stage, vacuum::phase::fragments);
+  EXPECT_EQ (actual->done, 17U);
+
+  // A checkpoint for a different store is ignored.
+  EXPECT_FALSE (vacuum::read_checkpoint (path, pstore::uuid{}).has_value ());
+
+  // As is one that has been corrupted.
+  file.open (file_handle::create_mode::open_existing, file_handle::writable_mode::read_write);
+  file.seek (offsetof (vacuum::checkpoint, done));
+  file.write (std::uint64_t{18});
+  file.close ();
+  EXPECT_FALSE (vacuum::read_checkpoint (path, id).has_value ());
+
+  pstore::file::unlink (path);
+}